@@ -19,6 +19,9 @@ static inline HRESULT ConvertBoolToHRESULT(bool result)
 }
 
 
+int (*g_p7za_stdin_read)(void *data, UInt32 size, UInt32 *processedSize) = NULL;
+int (*g_p7za_stdout_write)(const void *data, UInt32 size, UInt32 *processedSize) = NULL;
+
 static const UInt32 kClusterSize = 1 << 18;
 CInFileStream::CInFileStream(bool b):
   #ifdef SUPPORT_DEVICE_FILE
@@ -196,6 +199,15 @@ STDMETHODIMP CStdInFileStream::Read(void *data, UInt32 size, UInt32 *processedSi
 {
   if (processedSize)
     *processedSize = 0;
+  if (g_p7za_stdin_read)
+  {
+    UInt32 processedLoc = 0;
+    if (g_p7za_stdin_read(data, size, &processedLoc) != 0)
+      return E_FAIL;
+    if (processedSize)
+      *processedSize = processedLoc;
+    return S_OK;
+  }
   ssize_t res;
   do
   {
@@ -364,6 +376,16 @@ STDMETHODIMP CStdOutFileStream::Write(const void *data, UInt32 size, UInt32 *pro
 {
   if (processedSize)
     *processedSize = 0;
+  if (g_p7za_stdout_write)
+  {
+    UInt32 processedLoc = 0;
+    if (g_p7za_stdout_write(data, size, &processedLoc) != 0)
+      return E_FAIL;
+    _size += processedLoc;
+    if (processedSize)
+      *processedSize = processedLoc;
+    return S_OK;
+  }
   ssize_t res;
 
   do
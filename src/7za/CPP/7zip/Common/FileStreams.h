@@ -87,6 +87,11 @@ public:
   STDMETHOD(GetSize)(UInt64 *size);
 };
 
+// cherrytree: when set, the -si/-so streams go through these instead of the file descriptors 0/1
+// so that an archive can be read or written from memory; they return 0 on success
+extern int (*g_p7za_stdin_read)(void *data, UInt32 size, UInt32 *processedSize);
+extern int (*g_p7za_stdout_write)(const void *data, UInt32 size, UInt32 *processedSize);
+
 class CStdInFileStream:
   public ISequentialInStream,
   public CMyUnknownImp
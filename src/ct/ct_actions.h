@@ -79,6 +79,7 @@ private:
 private:
     CtSearchOptions _s_options;
     CtSearchState _s_state;
+    std::optional<std::vector<Glib::ustring>> _s_indexLiterals; // literals required by the current search, for the search index
 
 public:
     CtMainWin*   getCtMainWin() { return _pCtMainWin; }
@@ -228,6 +229,8 @@ private:
                                         const bool all_matches);
     bool _is_node_within_time_filter(const CtTreeIter& node_iter);
     Glib::RefPtr<Glib::Regex> _create_re_pattern(Glib::ustring pattern);
+    std::optional<std::vector<Glib::ustring>> _get_search_index_literals(const Glib::ustring& pattern);
+    bool _node_content_may_match(const CtTreeIter& node_iter);
     bool _find_pattern(CtTreeIter tree_iter,
                        Glib::RefPtr<Gtk::TextBuffer> text_buffer,
                        Glib::RefPtr<Glib::Regex> re_pattern,
@@ -370,7 +373,8 @@ private:
     // helper for edit actions
     void _image_edit_dialog(Glib::RefPtr<Gdk::Pixbuf> rPixbuf,
                             Gtk::TextIter insertIter,
-                            Gtk::TextIter* pIterBound);
+                            Gtk::TextIter* pIterBound,
+                            std::shared_ptr<const std::string> pRawBlob = nullptr);
     void _latex_edit_dialog(const Glib::ustring& latex_text,
                             Gtk::TextIter insertIter,
                             Gtk::TextIter* pIterBound);
@@ -383,7 +387,8 @@ public:
     void image_insert_png(Gtk::TextIter iter_insert,
                           Glib::RefPtr<Gdk::Pixbuf> pixbuf,
                           const Glib::ustring& link,
-                          const Glib::ustring& image_justification);
+                          const Glib::ustring& image_justification,
+                          std::shared_ptr<const std::string> pRawBlob = nullptr);
     void image_insert_anchor(Gtk::TextIter iter_insert,
                              const Glib::ustring& name,
                              const CtAnchorExpCollState expCollState,
@@ -514,7 +519,8 @@ private:
     // helper for import actions
     void _import_from_file(CtImporterInterface* importer, const bool dummy_root = false);
     void _import_from_dir(CtImporterInterface* importer, const std::string& custom_dir);
-    void _create_imported_nodes(CtImportedNode* imported_nodes, const bool dummy_root = false);
+    void _create_imported_nodes(CtImportedNode* imported_nodes, const bool dummy_root = false, const bool show_progress = false);
+    void _import_progress_events();
 
 public:
     // import actions
@@ -544,7 +550,7 @@ private:
     void _export_to_txt(const fs::path& auto_path, bool auto_overwrite);
 
     fs::path _get_pdf_filepath(const fs::path& proposed_name);
-    fs::path _get_txt_filepath(const fs::path& dir_place, const fs::path& proposed_name);
+    fs::path _get_txt_filepath(const fs::path& dir_place, const fs::path& proposed_name, const bool export_overwrite);
     fs::path _get_txt_folder(fs::path dir_place, fs::path new_folder, bool export_overwrite);
 
 public:
@@ -28,6 +28,7 @@
 #include "ct_logging.h"
 #include "ct_storage_control.h"
 #include <gtkmm/dialog.h>
+#include <cstring>
 #ifdef HAVE_LIBSPELLING
 #include <libspelling.h>
 #endif
@@ -1095,10 +1096,21 @@ void CtActions::image_insert_latex(Gtk::TextIter iter_insert,
 // Insert/Edit Image Dialog
 void CtActions::_image_edit_dialog(Glib::RefPtr<Gdk::Pixbuf> rPixbuf,
                                    Gtk::TextIter insert_iter,
-                                   Gtk::TextIter* pIterBound)
+                                   Gtk::TextIter* pIterBound,
+                                   std::shared_ptr<const std::string> pRawBlob/*= nullptr*/)
 {
     Glib::RefPtr<Gdk::Pixbuf> ret_pixbuf = CtDialogs::image_handle_dialog(*_pCtMainWin, rPixbuf);
     if (not ret_pixbuf) return;
+    if (pRawBlob) {
+        // the png is still good only if the dialog left the pixels as they were
+        const bool samePixels = ret_pixbuf->get_width() == rPixbuf->get_width() and
+                                ret_pixbuf->get_height() == rPixbuf->get_height() and
+                                ret_pixbuf->get_byte_length() == rPixbuf->get_byte_length() and
+                                0 == memcmp(ret_pixbuf->get_pixels(), rPixbuf->get_pixels(), rPixbuf->get_byte_length());
+        if (not samePixels) {
+            pRawBlob.reset();
+        }
+    }
     Glib::ustring image_justification;
     if (pIterBound) { // only in case of modify
         image_justification = CtTextIterUtil::get_text_iter_alignment(insert_iter, _pCtMainWin);
@@ -1106,17 +1118,18 @@ void CtActions::_image_edit_dialog(Glib::RefPtr<Gdk::Pixbuf> rPixbuf,
         _curr_buffer()->erase(insert_iter, *pIterBound);
         insert_iter = _curr_buffer()->get_iter_at_offset(image_offset);
     }
-    image_insert_png(insert_iter, ret_pixbuf, ""/*link*/, image_justification);
+    image_insert_png(insert_iter, ret_pixbuf, ""/*link*/, image_justification, pRawBlob);
 }
 
 void CtActions::image_insert_png(Gtk::TextIter iter_insert,
                                  Glib::RefPtr<Gdk::Pixbuf> rPixbuf,
                                  const Glib::ustring& link,
-                                 const Glib::ustring& image_justification)
+                                 const Glib::ustring& image_justification,
+                                 std::shared_ptr<const std::string> pRawBlob/*= nullptr*/)
 {
     if (not rPixbuf) return;
     const int charOffset = iter_insert.get_offset();
-    CtAnchoredWidget* pAnchoredWidget = new CtImagePng{_pCtMainWin, rPixbuf, link, charOffset, image_justification};
+    CtAnchoredWidget* pAnchoredWidget = new CtImagePng{_pCtMainWin, rPixbuf, link, charOffset, image_justification, pRawBlob};
     pAnchoredWidget->insertInTextBuffer(_curr_buffer());
     _pCtMainWin->get_tree_store().addAnchoredWidgets(_pCtMainWin->curr_tree_iter(),
                                                      {pAnchoredWidget},
@@ -260,7 +260,7 @@ void CtActions::_export_to_html(const fs::path& auto_path, bool auto_overwrite)
         if (not _is_there_selected_node_or_error()) return;
         export_type = CtDialogs::selnode_selnodeandsub_alltree_dialog(
             *_pCtMainWin, true, &_export_options.include_node_name,
-            nullptr, &_export_options.index_in_page, &_export_options.single_file);
+            nullptr, &_export_options.index_in_page, &_export_options.single_file, &_export_options.dedup_assets);
     }
     if (export_type == CtExporting::NONESAVE) return;
 
@@ -332,13 +332,13 @@ void CtActions::_export_to_txt(const fs::path& auto_path, bool auto_overwrite)
     try {
         if (export_type == CtExporting::CURRENT_NODE) {
             fs::path txt_filepath = CtMiscUtil::get_node_hierarchical_name(_pCtMainWin->curr_tree_iter());
-            txt_filepath = _get_txt_filepath("", txt_filepath);
+            txt_filepath = _get_txt_filepath("", txt_filepath, true/*export_overwrite*/);
             if (txt_filepath.empty()) return;
             CtExport2Txt{_pCtMainWin}.node_export_to_txt(_pCtMainWin->curr_tree_iter(), txt_filepath, _export_options, -1, -1);
         }
         else if (export_type == CtExporting::CURRENT_NODE_AND_SUBNODES) {
             if (_export_options.single_file) {
-               fs::path txt_filepath = _get_txt_filepath("", _pCtMainWin->get_ct_storage()->get_file_name());
+               fs::path txt_filepath = _get_txt_filepath("", _pCtMainWin->get_ct_storage()->get_file_name(), true/*export_overwrite*/);
                if (txt_filepath.empty()) return;
                CtExport2Txt{_pCtMainWin}.nodes_all_export_to_txt(false, "", txt_filepath, _export_options);
             }
@@ -350,7 +350,7 @@ void CtActions::_export_to_txt(const fs::path& auto_path, bool auto_overwrite)
         }
         else if (export_type == CtExporting::ALL_TREE) {
             if (_export_options.single_file) {
-                fs::path txt_filepath = _get_txt_filepath(auto_path, _pCtMainWin->get_ct_storage()->get_file_name());
+                fs::path txt_filepath = _get_txt_filepath(auto_path, _pCtMainWin->get_ct_storage()->get_file_name(), auto_overwrite);
                 if (txt_filepath.empty()) return;
                 CtExport2Txt{_pCtMainWin}.nodes_all_export_to_txt(true, "", txt_filepath, _export_options);
             }
@@ -366,7 +366,7 @@ void CtActions::_export_to_txt(const fs::path& auto_path, bool auto_overwrite)
             _curr_buffer()->get_selection_bounds(iter_start, iter_end);
 
             fs::path txt_filepath = CtMiscUtil::get_node_hierarchical_name(_pCtMainWin->curr_tree_iter());
-            txt_filepath = _get_txt_filepath("", txt_filepath);
+            txt_filepath = _get_txt_filepath("", txt_filepath, true/*export_overwrite*/);
             if (txt_filepath.empty()) return;
             CtExport2Txt{_pCtMainWin}.node_export_to_txt(_pCtMainWin->curr_tree_iter(), txt_filepath, _export_options, iter_start.get_offset(), iter_end.get_offset());
         }
@@ -395,7 +395,7 @@ fs::path CtActions::_get_pdf_filepath(const fs::path& proposed_name)
 }
 
 // Prepare for the txt file save
-fs::path CtActions::_get_txt_filepath(const fs::path& dir_place, const fs::path& proposed_name)
+fs::path CtActions::_get_txt_filepath(const fs::path& dir_place, const fs::path& proposed_name, const bool export_overwrite)
 {
     fs::path filename;
     if (dir_place.empty())
@@ -418,7 +418,8 @@ fs::path CtActions::_get_txt_filepath(const fs::path& dir_place, const fs::path&
         if (filename.extension() != ".txt") filename += ".txt";
         _pCtConfig->pickDirExport = filename.parent_path().string();
 
-        if (fs::is_regular_file(filename)) fs::remove(filename);
+        // the file dialog already asked to confirm the overwrite
+        filename = filename.parent_path() / fs::prepare_export_file(filename.parent_path(), filename.filename(), export_overwrite);
     }
     return filename;
 }
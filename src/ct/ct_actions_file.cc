@@ -253,6 +253,7 @@ void CtActions::preferences_import()
     _pCtConfig->embfileShowFileName = ctConfigImported.embfileShowFileName;
     _pCtConfig->objectNoSelOnClick = ctConfigImported.objectNoSelOnClick;
     _pCtConfig->embfileMFNameOnDisk = ctConfigImported.embfileMFNameOnDisk;
+    _pCtConfig->sqliteRichTextBin = ctConfigImported.sqliteRichTextBin;
     _pCtConfig->embfileMaxSize = ctConfigImported.embfileMaxSize;
     _pCtConfig->lineWrapping = ctConfigImported.lineWrapping;
     _pCtConfig->autoSmartQuotes = ctConfigImported.autoSmartQuotes;
@@ -403,6 +404,8 @@ void CtActions::preferences_import()
     _pCtConfig->customBackupDirOn = ctConfigImported.customBackupDirOn;
     _pCtConfig->customBackupDir = ctConfigImported.customBackupDir;
     _pCtConfig->limitUndoableSteps = ctConfigImported.limitUndoableSteps;
+    _pCtConfig->limitUndoableMemMb = ctConfigImported.limitUndoableMemMb;
+    _pCtConfig->loadedNodesMemMb = ctConfigImported.loadedNodesMemMb;
     _pCtConfig->proxyUrlColonPort = ctConfigImported.proxyUrlColonPort;
     _pCtConfig->proxyUsername = ctConfigImported.proxyUsername;
     _pCtConfig->proxyPassword = ctConfigImported.proxyPassword;
@@ -27,7 +27,9 @@
 #include <regex>
 #include "ct_image.h"
 #include "ct_dialogs.h"
+#include "ct_storage_control.h"
 #include "ct_logging.h"
+#include "ct_trace.h"
 
 void CtActions::find_matches_store_reset()
 {
@@ -189,6 +191,7 @@ void CtActions::find_in_multiple_nodes_ok_clicked()
 {
     Glib::RefPtr<Glib::Regex> re_pattern = _create_re_pattern(_s_state.curr_find_pattern);
     if (not re_pattern) return;
+    _s_indexLiterals = _get_search_index_literals(_s_state.curr_find_pattern);
 
     CtStatusBar& ctStatusBar = _pCtMainWin->get_status_bar();
     CtTreeStore& ctTreeStore = _pCtMainWin->get_tree_store();
@@ -238,11 +241,11 @@ void CtActions::find_in_multiple_nodes_ok_clicked()
         while (app_context->pending()) app_context->iteration(false);
 #endif
     }
-    std::time_t search_start_time = std::time(nullptr);
+    CtTrace::Span ctTraceSpan{"search"};
     while (node_iter) {
         _s_state.all_matches_first_in_node = true;
         CtTreeIter ct_node_iter = ctTreeStore.to_ct_tree_iter(node_iter);
-        if (_s_options.node_content) {
+        if (_s_options.node_content and _node_content_may_match(ct_node_iter)) {
             Glib::RefPtr<Gtk::TextBuffer> pTextBuffer = ct_node_iter.get_node_text_buffer();
             if (not pTextBuffer) {
                 CtDialogs::error_dialog(str::format(_("Failed to retrieve the content of the node '%s'"), ct_node_iter.get_node_name().raw()), *_pCtMainWin);
@@ -281,8 +284,7 @@ void CtActions::find_in_multiple_nodes_ok_clicked()
             _update_all_matches_progress();
         }
     }
-    std::time_t search_end_time = std::time(nullptr);
-    spdlog::debug("Search took {} sec", search_end_time - search_start_time);
+    ctTraceSpan.end();
 
     _pCtMainWin->user_active() = user_active_restore;
     if (0 == _s_state.matches_num) {
@@ -424,7 +426,7 @@ CtMatchType CtActions::_parse_given_node_content(CtTreeIter node_iter,
         optFirstNode = false;
     }
     if (optFirstNode.has_value() and (not node_iter.get_node_is_excluded_from_search() or _s_options.override_exclusions)) {
-        if (_s_options.node_content) {
+        if (_s_options.node_content and _node_content_may_match(node_iter)) {
             if (_parse_node_content_iter(node_iter,
                                          node_iter.get_node_text_buffer(),
                                          re_pattern,
@@ -464,7 +466,7 @@ CtMatchType CtActions::_parse_given_node_content(CtTreeIter node_iter,
             while (child_iter and not _pCtMainWin->get_status_bar().is_progress_stop()) {
                 _s_state.all_matches_first_in_node = true;
                 CtTreeIter ct_node_iter = ctTreeStore.to_ct_tree_iter(child_iter);
-                if (_s_options.node_content) {
+                if (_s_options.node_content and _node_content_may_match(ct_node_iter)) {
                     Glib::RefPtr<Gtk::TextBuffer> pTextBuffer = ct_node_iter.get_node_text_buffer();
                     if (not pTextBuffer) {
                         CtDialogs::error_dialog(str::format(_("Failed to retrieve the content of the node '%s'"), ct_node_iter.get_node_name().raw()), *_pCtMainWin);
@@ -677,6 +679,46 @@ Glib::RefPtr<Glib::Regex> CtActions::_create_re_pattern(Glib::ustring pattern)
     }
 }
 
+// Returns the literals that any match must contain, std::nullopt if the search index can't be used
+std::optional<std::vector<Glib::ustring>> CtActions::_get_search_index_literals(const Glib::ustring& pattern)
+{
+    if (_s_options.accent_insensitive) {
+        // the index is built on the original text
+        return std::nullopt;
+    }
+    if (_s_options.reg_exp) {
+        return CtSearchIndex::regex_get_required_literals(pattern);
+    }
+    if (0 != *_s_options.pMultipleWordsSearchType) {
+        std::vector<Glib::ustring> splitted = str::split(pattern, " ", true/*compress*/);
+        if (splitted.size() > 1u) {
+            if (1 == *_s_options.pMultipleWordsSearchType) {
+                // AND, every word must be there
+                return splitted;
+            }
+            // OR
+            return std::nullopt;
+        }
+    }
+    return std::vector<Glib::ustring>{pattern};
+}
+
+// Returns False only if the search index excludes that the node content can match
+bool CtActions::_node_content_may_match(const CtTreeIter& node_iter)
+{
+    if (not _s_indexLiterals.has_value() or node_iter.get_node_buffer_already_loaded()) {
+        return true;
+    }
+    CtSearchIndex& searchIndex = _pCtMainWin->get_ct_storage()->get_search_index();
+    const std::optional<bool> mayContain = searchIndex.node_may_contain(node_iter, _s_indexLiterals.value());
+    if (mayContain.has_value()) {
+        return mayContain.value();
+    }
+    // no up to date entry: the buffer is going to be loaded anyway so index it now
+    searchIndex.update_from_tree_iter(node_iter);
+    return true;
+}
+
 bool CtActions::_find_pattern(CtTreeIter tree_iter,
                               Glib::RefPtr<Gtk::TextBuffer> text_buffer,
                               Glib::RefPtr<Glib::Regex> re_pattern,
@@ -301,16 +301,49 @@ void CtActions::_import_from_dir(CtImporterInterface* importer, const std::strin
     if (custom_dir.empty()) {
         _pCtConfig->pickDirImport = import_dir;
     }
+    CtStatusBar& ctStatusBar = _pCtMainWin->get_status_bar();
+    ctStatusBar.progressBar.set_fraction(0);
+    ctStatusBar.progressBar.set_text("0");
+    ctStatusBar.progressBar.show();
+    ctStatusBar.stopButton.show();
+    ctStatusBar.set_progress_stop(false);
+    auto on_scope_exit = scope_guard([&ctStatusBar](void*) {
+        ctStatusBar.progressBar.hide();
+        ctStatusBar.stopButton.hide();
+        ctStatusBar.set_progress_stop(false);
+    });
     try {
-        auto dir_node = CtImports::traverse_dir(import_dir, importer);
-        _create_imported_nodes(dir_node.get());
+        auto dir_node = CtImports::traverse_dir(import_dir, importer, [this, &ctStatusBar](const size_t files_done, const size_t files_total){
+            ctStatusBar.progressBar.set_fraction(files_total > 0 ? static_cast<double>(files_done)/files_total : 1.0);
+            ctStatusBar.progressBar.set_text(std::to_string(files_done) + "/" + std::to_string(files_total));
+            _import_progress_events();
+            return not ctStatusBar.is_progress_stop();
+        });
+        if (not ctStatusBar.is_progress_stop()) {
+            _create_imported_nodes(dir_node.get(), false/*dummy_root*/, true/*show_progress*/);
+        }
     }
     catch (std::exception& ex) {
         spdlog::error("import exception: {}", ex.what());
     }
 }
 
-void CtActions::_create_imported_nodes(CtImportedNode* imported_nodes, const bool dummy_root)
+void CtActions::_import_progress_events()
+{
+#if GTKMM_MAJOR_VERSION < 4
+    #if GTKMM_MAJOR_VERSION < 4 && !defined(GTKMM_DISABLE_DEPRECATED)
+    while (gtk_events_pending()) gtk_main_iteration();
+    #else
+    while (g_main_context_pending(nullptr)) g_main_context_iteration(nullptr, false);
+    #endif
+#else
+    // GTK4 event loop processing
+    auto app_context = Glib::MainContext::get_default();
+    while (app_context->pending()) app_context->iteration(false);
+#endif
+}
+
+void CtActions::_create_imported_nodes(CtImportedNode* imported_nodes, const bool dummy_root, const bool show_progress)
 {
     if (not imported_nodes) {
         return;
@@ -329,6 +362,7 @@ void CtActions::_create_imported_nodes(CtImportedNode* imported_nodes, const boo
     std::map<Glib::ustring, gint64> node_ids;
     CtTreeStore& ct_treestore = _pCtMainWin->get_tree_store();
     gint64 max_node_id = ct_treestore.node_id_get();
+    const gint64 first_node_id = max_node_id;
     f_foreach_node(imported_nodes, [&](CtImportedNode* node) {
         node->node_id = max_node_id++;
         node_ids[node->node_name] = node->node_id;
@@ -385,12 +419,26 @@ void CtActions::_create_imported_nodes(CtImportedNode* imported_nodes, const boo
     };
 
     // just create nodes
+    size_t nodes_created{0};
     std::function<void(Gtk::TreeModel::iterator, CtImportedNode*)> f_create_nodes;
     f_create_nodes = [&](Gtk::TreeModel::iterator curr_iter, CtImportedNode* imported_node) {
         auto iter = f_create_node(imported_node, curr_iter, true);
+        ++nodes_created;
         for (auto& child : imported_node->children)
             f_create_nodes(iter, child.get());
     };
+    // the top level subtrees are added in batches, with the window responsive in between
+    CtStatusBar& ctStatusBar = _pCtMainWin->get_status_bar();
+    const size_t nodes_total = static_cast<size_t>(max_node_id - first_node_id - 1); // but the top
+    auto f_batch_done = [&]()->bool{
+        if (show_progress) {
+            ctStatusBar.progressBar.set_fraction(static_cast<double>(nodes_created)/nodes_total);
+            ctStatusBar.progressBar.set_text(std::to_string(nodes_created) + "/" + std::to_string(nodes_total));
+            _import_progress_events();
+            return not ctStatusBar.is_progress_stop();
+        }
+        return true;
+    };
 
     std::optional<Gtk::TreeModel::iterator> parent_iter = select_parent_dialog(_pCtMainWin);
     if (not parent_iter.has_value()) {
@@ -402,6 +450,9 @@ void CtActions::_create_imported_nodes(CtImportedNode* imported_nodes, const boo
     else { // skip top if it's dir
         for (auto& child : imported_nodes->children) {
             f_create_nodes(parent_iter.value(), child.get());
+            if (not f_batch_done()) {
+                break;
+            }
         }
     }
 
@@ -302,7 +302,7 @@ void CtActions::image_save()
     _pCtConfig->pickDirImg = Glib::path_get_dirname(filename);
     if (not str::endswith(filename, ".png")) filename += ".png";
     try {
-       curr_image_anchor->save(filename, "png");
+       curr_image_anchor->save_raw_blob(filename);
     }
     catch (...) {
         CtDialogs::error_dialog(str::format(_("Write to %s Failed"), str::xml_escape(filename)), *_pCtMainWin);
@@ -315,7 +315,7 @@ void CtActions::image_edit()
     Gtk::TextIter iter_insert = _curr_buffer()->get_iter_at_child_anchor(curr_image_anchor->getTextChildAnchor());
     Gtk::TextIter iter_bound = iter_insert;
     iter_bound.forward_char();
-    _image_edit_dialog(curr_image_anchor->get_pixbuf(), iter_insert, &iter_bound);
+    _image_edit_dialog(curr_image_anchor->get_pixbuf(), iter_insert, &iter_bound, curr_image_anchor->get_raw_blob_ptr());
 }
 
 void CtActions::image_cut()
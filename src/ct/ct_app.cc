@@ -29,8 +29,10 @@
 #endif
 #include "ct_pref_dlg.h"
 #include "ct_storage_control.h"
+#include "ct_export_headless.h"
 #include "config.h"
 #include "ct_logging.h"
+#include "ct_trace.h"
 #include <iostream>
 
 namespace {
@@ -343,13 +345,34 @@ void CtApp::on_open(const Gio::Application::type_vec_files& files, const Glib::u
     {
         _no_gui = true;
         spdlog::debug("export arguments are detected");
+        // the txt export does not need a window, the documents are read and exported in parallel
+        std::vector<fs::path> headlessTxtPaths;
+        if (not _export_to_txt_dir.empty()) {
+            CtExportHeadless ctExportHeadless{_pCtConfig->hRule, _password};
+            for (const Glib::RefPtr<Gio::File>& r_file : files) {
+                const fs::path canonicalPath = fs::canonical(r_file->get_path());
+                if (ctExportHeadless.is_supported(canonicalPath)) {
+                    headlessTxtPaths.push_back(canonicalPath);
+                }
+            }
+            if (not headlessTxtPaths.empty()) {
+                // the documents that failed go through the window, as before
+                for (const fs::path& failedPath : ctExportHeadless.files_export_to_txt(headlessTxtPaths, _export_to_txt_dir, _export_overwrite, _export_single_file)) {
+                    vec::remove(headlessTxtPaths, failedPath);
+                }
+            }
+        }
         for (const Glib::RefPtr<Gio::File>& r_file : files) {
             spdlog::debug("file to export: {}", r_file->get_path());
-            CtMainWin* pWin = _create_window(true/*no_gui*/);
             const std::string canonicalPath = fs::canonical(r_file->get_path()).string();
+            const bool txtDone = vec::exists(headlessTxtPaths, fs::path{canonicalPath});
+            if (txtDone and _export_to_html_dir.empty() and _export_to_pdf_dir.empty()) {
+                continue;
+            }
+            CtMainWin* pWin = _create_window(true/*no_gui*/);
             if (pWin->file_open(canonicalPath, ""/*node*/, ""/*anchor*/, _password)) {
                 try {
-                    if (not _export_to_txt_dir.empty()) {
+                    if (not _export_to_txt_dir.empty() and not txtDone) {
                         pWin->get_ct_actions()->export_to_txt_auto(_export_to_txt_dir, _export_overwrite, _export_single_file);
                     }
                     if (not _export_to_html_dir.empty()) {
@@ -619,6 +642,7 @@ void CtApp::_add_main_option_entries()
     add_main_option_entry(Gio::Application::OptionType::STRING,   "password",           'P', _("Password to open document"));
     add_main_option_entry(Gio::Application::OptionType::BOOL,     "new_window",         'N', _("Create a new window"));
     add_main_option_entry(Gio::Application::OptionType::BOOL,     "secondary_session",  'S', _("Run in secondary session, independent from main session"));
+    add_main_option_entry(Gio::Application::OptionType::FILENAME, "trace",              'T', _("Write a performance trace (Chrome trace json) to the specified file path"));
 #else
     add_main_option_entry(Gio::Application::OPTION_TYPE_BOOL,     "version",            'V', _("Print CherryTree version"));
     add_main_option_entry(Gio::Application::OPTION_TYPE_STRING,   "node",               'n', _("Node name to focus"));
@@ -631,6 +655,7 @@ void CtApp::_add_main_option_entries()
     add_main_option_entry(Gio::Application::OPTION_TYPE_STRING,   "password",           'P', _("Password to open document"));
     add_main_option_entry(Gio::Application::OPTION_TYPE_BOOL,     "new_window",         'N', _("Create a new window"));
     add_main_option_entry(Gio::Application::OPTION_TYPE_BOOL,     "secondary_session",  'S', _("Run in secondary session, independent from main session"));
+    add_main_option_entry(Gio::Application::OPTION_TYPE_FILENAME, "trace",              'T', _("Write a performance trace (Chrome trace json) to the specified file path"));
 #endif
 }
 
@@ -674,6 +699,10 @@ int CtApp::_on_handle_local_options(const Glib::RefPtr<Glib::VariantDict>& rOpti
     rOptions->lookup_value("export_single_file", _export_single_file);
     rOptions->lookup_value("password", _password);
     rOptions->lookup_value("new_window", new_window);
+    std::string trace_filepath;
+    if (rOptions->lookup_value("trace", trace_filepath) and not trace_filepath.empty()) {
+        CtTrace::start(trace_filepath);
+    }
 
     if (is_remote() && (not _node_to_focus.empty() || not _anchor_to_focus.empty())) {
         // Forward node focus request from remote to primary instance via action
@@ -909,6 +909,12 @@ void CtClipboard::on_received_to_image(const Gtk::SelectionData& selection_data,
             spdlog::debug("image decode fallback failed for target '{}': {}", selection_data.get_target(), ex.what().raw());
         }
     }
+    std::shared_ptr<const std::string> pRawBlob;
+    if (rPixbuf and "image/png" == selection_data.get_target() and selection_data.get_length() > 0) {
+        // the pasted png is kept as it is, no need to encode the pixbuf again on save
+        pRawBlob = std::make_shared<const std::string>(reinterpret_cast<const char*>(selection_data.get_data()),
+                                                       static_cast<size_t>(selection_data.get_length()));
+    }
     if (not rPixbuf) {
         // On macOS, some image selections expose empty payload for a specific target
         // but still allow image retrieval from the clipboard object.
@@ -917,7 +923,7 @@ void CtClipboard::on_received_to_image(const Gtk::SelectionData& selection_data,
     }
     if (rPixbuf) {
         Glib::ustring link = "";
-        _pCtMainWin->get_ct_actions()->image_insert_png(pTextView->get_buffer()->get_insert()->get_iter(), rPixbuf->copy(), link, "");
+        _pCtMainWin->get_ct_actions()->image_insert_png(pTextView->get_buffer()->get_insert()->get_iter(), rPixbuf->copy(), link, "", pRawBlob);
         pTextView->scroll_to(pTextView->get_buffer()->get_insert());
     }
     else {
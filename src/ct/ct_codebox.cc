@@ -327,12 +327,12 @@ void CtCodebox::to_xml(xmlpp::Element* p_node_parent, const int offset_adjustmen
     p_codebox_node->add_child_text(get_text_content());
 }
 
-bool CtCodebox::to_sqlite(sqlite3* pDb, const gint64 node_id, const int offset_adjustment, CtStorageCache*)
+bool CtCodebox::to_sqlite(CtSqliteStmtCache* pStmtCache, const gint64 node_id, const int offset_adjustment, CtStorageCache*)
 {
     bool retVal{true};
-    sqlite3_stmt *p_stmt;
-    if (sqlite3_prepare_v2(pDb, CtStorageSqlite::TABLE_CODEBOX_INSERT, -1, &p_stmt, nullptr) != SQLITE_OK) {
-        spdlog::error("{}: {}", CtStorageSqlite::ERR_SQLITE_PREPV2, sqlite3_errmsg(pDb));
+    sqlite3_stmt* p_stmt = pStmtCache->get(CtStorageSqlite::TABLE_CODEBOX_INSERT);
+    if (not p_stmt) {
+        spdlog::error("{}: {}", CtStorageSqlite::ERR_SQLITE_PREPV2, sqlite3_errmsg(pStmtCache->get_db()));
         retVal = false;
     }
     else {
@@ -348,10 +348,9 @@ bool CtCodebox::to_sqlite(sqlite3* pDb, const gint64 node_id, const int offset_a
         sqlite3_bind_int64(p_stmt, 9, _highlightBrackets);
         sqlite3_bind_int64(p_stmt, 10, _showLineNumbers);
         if (sqlite3_step(p_stmt) != SQLITE_DONE) {
-            spdlog::error("{}: {}", CtStorageSqlite::ERR_SQLITE_STEP, sqlite3_errmsg(pDb));
+            spdlog::error("{}: {}", CtStorageSqlite::ERR_SQLITE_STEP, sqlite3_errmsg(pStmtCache->get_db()));
             retVal = false;
         }
-        sqlite3_finalize(p_stmt);
     }
     return retVal;
 }
@@ -320,6 +320,7 @@ void CtConfig::_populate_keyfile_from_data()
     _uKeyFile->set_boolean(_currentGroup, "embfile_show_filename", embfileShowFileName);
     _uKeyFile->set_integer(_currentGroup, "object_click_no_sel", objectNoSelOnClick);
     _uKeyFile->set_boolean(_currentGroup, "embfile_mfname_ondisk", embfileMFNameOnDisk);
+    _uKeyFile->set_boolean(_currentGroup, "sqlite_rich_text_bin", sqliteRichTextBin);
     _uKeyFile->set_integer(_currentGroup, "embfile_max_size", embfileMaxSize);
     _uKeyFile->set_boolean(_currentGroup, "line_wrapping", lineWrapping);
     _uKeyFile->set_boolean(_currentGroup, "auto_smart_quotes", autoSmartQuotes);
@@ -450,6 +451,8 @@ void CtConfig::_populate_keyfile_from_data()
     _uKeyFile->set_boolean(_currentGroup, "enable_custom_backup_dir", customBackupDirOn);
     _uKeyFile->set_string(_currentGroup, "custom_backup_dir", customBackupDir);
     _uKeyFile->set_integer(_currentGroup, "limit_undoable_steps", limitUndoableSteps);
+    _uKeyFile->set_integer(_currentGroup, "limit_undoable_mem_mb", limitUndoableMemMb);
+    _uKeyFile->set_integer(_currentGroup, "loaded_nodes_mem_mb", loadedNodesMemMb);
 
     // [proxy]
     _currentGroup = "proxy";
@@ -656,6 +659,7 @@ void CtConfig::_populate_data_from_keyfile()
     _populate_bool_from_keyfile("embfile_show_filename", &embfileShowFileName);
     _populate_int_from_keyfile("object_click_no_sel", &objectNoSelOnClick);
     _populate_bool_from_keyfile("embfile_mfname_ondisk", &embfileMFNameOnDisk);
+    _populate_bool_from_keyfile("sqlite_rich_text_bin", &sqliteRichTextBin);
     _populate_int_from_keyfile("embfile_max_size", &embfileMaxSize);
     _populate_bool_from_keyfile("line_wrapping", &lineWrapping);
     _populate_bool_from_keyfile("auto_smart_quotes", &autoSmartQuotes);
@@ -814,6 +818,8 @@ void CtConfig::_populate_data_from_keyfile()
     _populate_bool_from_keyfile("enable_custom_backup_dir", &customBackupDirOn);
     _populate_string_from_keyfile("custom_backup_dir", &customBackupDir);
     _populate_int_from_keyfile("limit_undoable_steps", &limitUndoableSteps);
+    _populate_int_from_keyfile("limit_undoable_mem_mb", &limitUndoableMemMb);
+    _populate_int_from_keyfile("loaded_nodes_mem_mb", &loadedNodesMemMb);
 
     // [proxy]
     _currentGroup = "proxy";
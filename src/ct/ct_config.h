@@ -137,6 +137,7 @@ public:
     int8_t                                      objectNoSelOnClick{-1};
 #endif
     bool                                        embfileMFNameOnDisk{false};
+    bool                                        sqliteRichTextBin{false};
     int                                         embfileMaxSize{10};
     bool                                        lineWrapping{true};
     bool                                        autoSmartQuotes{true};
@@ -274,6 +275,8 @@ public:
     bool                                        customBackupDirOn{false};
     std::string                                 customBackupDir{""};
     int                                         limitUndoableSteps{10};
+    int                                         limitUndoableMemMb{64};
+    int                                         loadedNodesMemMb{0};
 
     // [proxy]
     std::string                                 proxyUrlColonPort;
@@ -111,7 +111,8 @@ CtExporting selnode_selnodeandsub_alltree_dialog(Gtk::Window& parent,
                                                  bool* last_include_node_name,
                                                  bool* last_new_node_page,
                                                  bool* last_index_in_page,
-                                                 bool* last_single_file);
+                                                 bool* last_single_file,
+                                                 bool* last_dedup_assets = nullptr);
 
 // Dialog to select a color, featuring a palette
 enum class CtPickDlgState {SELECTED, CANCEL, REMOVE_COLOR, CALL_AGAIN };
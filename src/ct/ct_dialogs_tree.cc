@@ -727,7 +727,8 @@ CtExporting CtDialogs::selnode_selnodeandsub_alltree_dialog(Gtk::Window& parent,
                                                             bool* last_include_node_name,
                                                             bool* last_new_node_page,
                                                             bool* last_index_in_page,
-                                                            bool* last_single_file)
+                                                            bool* last_single_file,
+                                                            bool* last_dedup_assets/*= nullptr*/)
 {
     Gtk::Dialog dialog{_("Involved Nodes"),
                        parent,
@@ -779,6 +780,20 @@ CtExporting CtDialogs::selnode_selnodeandsub_alltree_dialog(Gtk::Window& parent,
         checkbutton_single_file.set_active(*last_single_file);
         content_area->pack_start(checkbutton_single_file);
     }
+    auto checkbutton_dedup_assets = Gtk::CheckButton(_("Write Identical Images and Files Once"));
+    if (last_dedup_assets != nullptr) {
+        checkbutton_dedup_assets.set_active(*last_dedup_assets);
+        content_area->pack_start(checkbutton_dedup_assets);
+        // only the multiple pages of more than one node share the images and files
+        auto f_dedup_assets_sensitive = [&](){
+            checkbutton_dedup_assets.set_sensitive(not checkbutton_single_file.get_active() and
+                                                   (radiobutton_selnodeandsub.get_active() or radiobutton_alltree.get_active()));
+        };
+        f_dedup_assets_sensitive();
+        checkbutton_single_file.signal_toggled().connect(f_dedup_assets_sensitive);
+        radiobutton_selnodeandsub.signal_toggled().connect(f_dedup_assets_sensitive);
+        radiobutton_alltree.signal_toggled().connect(f_dedup_assets_sensitive);
+    }
     content_area->show_all();
     const int response = dialog.run();
 
@@ -786,6 +801,7 @@ CtExporting CtDialogs::selnode_selnodeandsub_alltree_dialog(Gtk::Window& parent,
     if (last_index_in_page != nullptr) *last_index_in_page = checkbutton_index_in_page.get_active();
     if (last_new_node_page != nullptr) *last_new_node_page = checkbutton_new_node_page.get_active();
     if (last_single_file != nullptr) *last_single_file = checkbutton_single_file.get_active();
+    if (last_dedup_assets != nullptr) *last_dedup_assets = checkbutton_dedup_assets.get_active();
 
     if (response != Gtk::RESPONSE_ACCEPT) return CtExporting::NONESAVE;
     if (radiobutton_selnode.get_active()) return CtExporting::CURRENT_NODE;
@@ -799,7 +815,8 @@ CtExporting CtDialogs::selnode_selnodeandsub_alltree_dialog(Gtk::Window& parent,
                                                             bool* last_include_node_name,
                                                             bool* last_new_node_page,
                                                             bool* last_index_in_page,
-                                                            bool* last_single_file)
+                                                            bool* last_single_file,
+                                                            bool* last_dedup_assets/*= nullptr*/)
 {
     Gtk::Dialog dialog{_("Involved Nodes"), parent, true/*modal*/, true/*use_header_bar*/};
     dialog.add_button(_("Cancel"), Gtk::ResponseType::REJECT);
@@ -845,12 +862,27 @@ CtExporting CtDialogs::selnode_selnodeandsub_alltree_dialog(Gtk::Window& parent,
         checkbutton_single_file.set_active(*last_single_file);
         content_area->append(checkbutton_single_file);
     }
+    auto checkbutton_dedup_assets = Gtk::CheckButton(_("Write Identical Images and Files Once"));
+    if (last_dedup_assets != nullptr) {
+        checkbutton_dedup_assets.set_active(*last_dedup_assets);
+        content_area->append(checkbutton_dedup_assets);
+        // only the multiple pages of more than one node share the images and files
+        auto f_dedup_assets_sensitive = [&](){
+            checkbutton_dedup_assets.set_sensitive(not checkbutton_single_file.get_active() and
+                                                   (radiobutton_selnodeandsub.get_active() or radiobutton_alltree.get_active()));
+        };
+        f_dedup_assets_sensitive();
+        checkbutton_single_file.signal_toggled().connect(f_dedup_assets_sensitive);
+        radiobutton_selnodeandsub.signal_toggled().connect(f_dedup_assets_sensitive);
+        radiobutton_alltree.signal_toggled().connect(f_dedup_assets_sensitive);
+    }
 
     const int response = _run_dialog_blocking(dialog);
     if (last_include_node_name != nullptr) *last_include_node_name = checkbutton_node_name.get_active();
     if (last_index_in_page != nullptr) *last_index_in_page = checkbutton_index_in_page.get_active();
     if (last_new_node_page != nullptr) *last_new_node_page = checkbutton_new_node_page.get_active();
     if (last_single_file != nullptr) *last_single_file = checkbutton_single_file.get_active();
+    if (last_dedup_assets != nullptr) *last_dedup_assets = checkbutton_dedup_assets.get_active();
 
     if (response != Gtk::ResponseType::ACCEPT) return CtExporting::NONESAVE;
     if (radiobutton_selnode.get_active()) return CtExporting::CURRENT_NODE;
@@ -26,7 +26,9 @@
 #include "ct_main_win.h"
 #include "ct_dialogs.h"
 #include "ct_storage_control.h"
+#include "ct_storage_multifile.h"
 #include "ct_logging.h"
+#include "ct_trace.h"
 #include "ct_filesystem.h"
 #include "ct_list.h"
 
@@ -83,6 +85,7 @@ void CtExport2Html::node_export_to_html(CtTreeIter tree_iter,
                                         int sel_start,
                                         int sel_end)
 {
+    CtTrace::Span ctTraceSpan{"export_html_node"};
     Glib::RefPtr<Gtk::TextBuffer> pTextBuffer = tree_iter.get_node_text_buffer();
     if (not pTextBuffer) {
         throw std::runtime_error(str::format(_("Failed to retrieve the content of the node '%s'"), tree_iter.get_node_name().raw()));
@@ -105,8 +108,9 @@ void CtExport2Html::node_export_to_html(CtTreeIter tree_iter,
     }
     std::vector<Glib::ustring> html_slots;
     std::vector<CtAnchoredWidget*> widgets;
+    Glib::ustring node_html_text;
+    Glib::ustring node_text;
     if (tree_iter.get_node_is_text()) {
-        Glib::ustring node_html_text;
         _html_get_from_treestore_node(tree_iter, sel_start, sel_end, html_slots, widgets, false/*single_file*/);
         int images_count{0};
         for (size_t i = 0; i < html_slots.size(); ++i) {
@@ -132,36 +136,95 @@ void CtExport2Html::node_export_to_html(CtTreeIter tree_iter,
         }
         Gtk::TextIter start_iter = pTextBuffer->get_iter_at_offset(sel_start == -1 ? 0 : sel_start);
         Gtk::TextIter end_iter = sel_end == -1 ? pTextBuffer->end() : pTextBuffer->get_iter_at_offset(sel_end);
-        std::vector<Glib::ustring> node_lines = str::split(node_html_text, "\n");
-        if (node_lines.size() > 0) {
-            std::vector<bool> rtl_for_lines = CtStrUtil::get_rtl_for_lines(start_iter.get_text(end_iter));
-            while (rtl_for_lines.size() < node_lines.size()) { rtl_for_lines.push_back(false); }
-            const size_t lastIdx = node_lines.size() - 1;
-            for (size_t i = 0; i <= lastIdx; ++i) {
-                if (i < lastIdx or not node_lines.at(i).empty()) {
-                    if (rtl_for_lines.at(i)) html_text += "<p dir=\"rtl\">" + node_lines.at(i) + "</p>";
-                    else html_text += "<p>" + node_lines.at(i) + "</p>";
-                }
-            }
-        }
+        node_text = start_iter.get_text(end_iter);
     }
     else {
         html_text += _html_get_from_code_buffer(pTextBuffer, sel_start, sel_end, tree_iter.get_node_syntax_highlighting());
     }
+    Glib::ustring html_tail;
     if (not index.empty() and not options.index_in_page) {
-        html_text += Glib::ustring("<p align=\"center\">") + "<img src=\"" + Glib::build_filename("images", "home.svg") + "\" height=\"22\" width=\"22\">" +
+        html_tail += Glib::ustring("<p align=\"center\">") + "<img src=\"" + Glib::build_filename("images", "home.svg") + "\" height=\"22\" width=\"22\">" +
                 CtConst::CHAR_SPACE + CtConst::CHAR_SPACE + "<a href=\"index.html\">" + _("Index") + "</a></p>";
     }
-    html_text += "</div>"; // div class='page'
-    html_text += HTML_FOOTER;
+    html_tail += "</div>"; // div class='page'
+    html_tail += HTML_FOOTER;
 
-    fs::path node_html_filepath = _export_dir / _get_html_filename(tree_iter);
-    g_file_set_contents(node_html_filepath.c_str(), html_text.c_str(), (gssize)html_text.bytes(), nullptr);
+    const fs::path node_html_filepath = _export_dir / _get_html_filename(tree_iter);
+    // from here on the text buffer is not needed
+    _run_or_defer([html_text = std::move(html_text),
+                   node_html_text = std::move(node_html_text),
+                   node_text = std::move(node_text),
+                   html_tail = std::move(html_tail),
+                   node_html_filepath,
+                   is_text = tree_iter.get_node_is_text()]() mutable {
+        if (is_text) {
+            html_text += _get_html_paragraphs(node_html_text, node_text);
+        }
+        html_text += html_tail;
+        _write_file(node_html_filepath, html_text.c_str(), html_text.bytes());
+    });
+}
+
+/*static*/Glib::ustring CtExport2Html::_get_html_paragraphs(const Glib::ustring& node_html_text, const Glib::ustring& node_text)
+{
+    Glib::ustring html_text;
+    std::vector<Glib::ustring> node_lines = str::split(node_html_text, "\n");
+    if (node_lines.size() > 0) {
+        std::vector<bool> rtl_for_lines = CtStrUtil::get_rtl_for_lines(node_text);
+        while (rtl_for_lines.size() < node_lines.size()) { rtl_for_lines.push_back(false); }
+        const size_t lastIdx = node_lines.size() - 1;
+        for (size_t i = 0; i <= lastIdx; ++i) {
+            if (i < lastIdx or not node_lines.at(i).empty()) {
+                if (rtl_for_lines.at(i)) html_text += "<p dir=\"rtl\">" + node_lines.at(i) + "</p>";
+                else html_text += "<p>" + node_lines.at(i) + "</p>";
+            }
+        }
+    }
+    return html_text;
+}
+
+void CtExport2Html::_run_or_defer(std::function<void()> f)
+{
+    if (not _pWriteTaskGroup) {
+        f();
+        return;
+    }
+    _pWriteTaskGroup->run([this, f = std::move(f)]() {
+        std::string error;
+        try {
+            f();
+        }
+        catch (std::exception& ex) {
+            error = ex.what();
+        }
+        catch (Glib::Error& ex) {
+            error = ex.what();
+        }
+        catch (...) {
+            error = "unknown ex";
+        }
+        if (not error.empty()) {
+            spdlog::error("{} {}", __FUNCTION__, error);
+            std::lock_guard<std::mutex> lock{_writeErrorsMutex};
+            _writeErrors.push_back(std::move(error));
+        }
+    });
+}
+
+/*static*/void CtExport2Html::_write_file(const fs::path& file_path, const char* pData, const size_t dataSize)
+{
+    GError* pError{nullptr};
+    if (not g_file_set_contents(file_path.c_str(), pData, (gssize)dataSize, &pError)) {
+        const std::string error = fmt::format("{} {}", file_path.string(), pError ? pError->message : "");
+        if (pError) g_error_free(pError);
+        throw std::runtime_error(error);
+    }
 }
 
 void CtExport2Html::nodes_all_export_to_multiple_html(bool all_tree,
                                                       const CtExportOptions& options)
 {
+    CtTrace::Span ctTraceSpan{"export_html"};
     fs::path home_svg = fs::get_cherrytree_datadir() / fs::path("icons") / "ct_home.svg";
     fs::copy_file(home_svg, _images_dir / "home.svg");
 
@@ -198,7 +261,17 @@ void CtExport2Html::nodes_all_export_to_multiple_html(bool all_tree,
     fs::path node_html_filepath = _export_dir / "index.html";
     g_file_set_contents(node_html_filepath.c_str(), html_text.c_str(), (gssize)html_text.bytes(), nullptr);
 
-    // create html pages
+    // create html pages, the gtk thread serializes the nodes while the pool writes pages and images
+    CtThreadPool::TaskGroup writeTaskGroup{CtThreadPool::get_global()};
+    _pWriteTaskGroup = &writeTaskGroup;
+    _dedupAssets = options.dedup_assets;
+    auto on_scope_exit = scope_guard([this](void*) {
+        _pWriteTaskGroup = nullptr;
+        _dedupAssets = false;
+        _writtenAssets.clear();
+        std::lock_guard<std::mutex> lock{_writeErrorsMutex};
+        _writeErrors.clear();
+    });
     // function to iterate nodes
     std::function<void(CtTreeIter)> f_traverseFunc;
     f_traverseFunc = [this, &f_traverseFunc, &options, &tree_links_text](CtTreeIter tree_iter) {
@@ -213,10 +286,15 @@ void CtExport2Html::nodes_all_export_to_multiple_html(bool all_tree,
         f_traverseFunc(tree_iter);
         if (not all_tree) break;
     }
+    writeTaskGroup.wait();
+    if (not _writeErrors.empty()) {
+        throw std::runtime_error(str::join(_writeErrors, "\n"));
+    }
 }
 
 void CtExport2Html::nodes_all_export_to_single_html(bool all_tree, const CtExportOptions&)
 {
+    CtTrace::Span ctTraceSpan{"export_html_single"};
     fs::path index_html_filepath = _export_dir / "index.html";
     Glib::RefPtr<Gio::File> rFile = Gio::File::create_for_path(index_html_filepath.string());
     Glib::RefPtr<Gio::FileOutputStream> rFileStream = rFile->append_to();
@@ -256,18 +334,7 @@ void CtExport2Html::nodes_all_export_to_single_html(bool all_tree, const CtExpor
                     }
                 }
             }
-            std::vector<Glib::ustring> node_lines = str::split(node_html_text, "\n");
-            if (node_lines.size() > 0) {
-                std::vector<bool> rtl_for_lines = CtStrUtil::get_rtl_for_lines(tree_iter.get_node_text_buffer()->get_text());
-                while (rtl_for_lines.size() < node_lines.size()) { rtl_for_lines.push_back(false); }
-                const size_t lastIdx = node_lines.size() - 1;
-                for (size_t i = 0; i <= lastIdx; ++i) {
-                    if (i < lastIdx or not node_lines.at(i).empty()) {
-                        if (rtl_for_lines.at(i)) html_text += "<p dir=\"rtl\">" + node_lines.at(i) + "</p>";
-                        else html_text += "<p>" + node_lines.at(i) + "</p>";
-                    }
-                }
-            }
+            html_text += _get_html_paragraphs(node_html_text, tree_iter.get_node_text_buffer()->get_text());
         }
         else {
             Glib::RefPtr<Gtk::TextBuffer> pTextBuffer = tree_iter.get_node_text_buffer();
@@ -347,18 +414,7 @@ Glib::ustring CtExport2Html::selection_export_to_html(Glib::RefPtr<Gtk::TextBuff
         }
         node_html_text += html_process_slot(_pCtConfig, _pCtMainWin, start_offset, end_iter.get_offset(), text_buffer, false/*single_file*/);
 
-        std::vector<Glib::ustring> node_lines = str::split(node_html_text, "\n");
-        if (node_lines.size() > 0) {
-            std::vector<bool> rtl_for_lines = CtStrUtil::get_rtl_for_lines(start_iter.get_text(end_iter));
-            while (rtl_for_lines.size() < node_lines.size()) { rtl_for_lines.push_back(false); }
-            const size_t lastIdx = node_lines.size() - 1;
-            for (size_t i = 0; i <= lastIdx; ++i) {
-                if (i < lastIdx or not node_lines.at(i).empty()) {
-                    if (rtl_for_lines.at(i)) html_text += "<p dir=\"rtl\">" + node_lines.at(i) + "</p>";
-                    else html_text += "<p>" + node_lines.at(i) + "</p>";
-                }
-            }
-        }
+        html_text += _get_html_paragraphs(node_html_text, start_iter.get_text(end_iter));
     }
     else {
         html_text += _html_get_from_code_buffer(text_buffer,
@@ -392,12 +448,26 @@ Glib::ustring CtExport2Html::_get_embfile_html(CtImageEmbFile* embfile,
                                                fs::path embed_dir)
 {
     Glib::ustring embfile_align_text = _get_object_alignment_string(embfile->getJustification());
-    fs::path embfile_name = std::to_string(tree_iter.get_node_id_data_holder()) + "-" +  embfile->get_file_name().string();
+    fs::path embfile_name;
+    Glib::ustring download_attr;
+    if (_dedupAssets) {
+        // the browser saves it with the original name
+        embfile_name = CtStorageMultiFile::get_blob_sha256sum(embfile->get_raw_blob()) + embfile->get_file_name().extension();
+        download_attr = " download=\"" + str::xml_escape(embfile->get_file_name().string()) + "\"";
+    }
+    else {
+        embfile_name = std::to_string(tree_iter.get_node_id_data_holder()) + "-" +  embfile->get_file_name().string();
+    }
     fs::path embfile_rel_path = "EmbeddedFiles" / embfile_name;
     Glib::ustring embfile_html = "<table style=\"" + embfile_align_text + "\"><tr><td><a href=\"" +
-            embfile_rel_path.string_unix() + "\">Linked file: " + embfile->get_file_name().string() + " </a></td></tr></table>";
+            embfile_rel_path.string_unix() + "\"" + download_attr + ">Linked file: " + embfile->get_file_name().string() + " </a></td></tr></table>";
 
-    g_file_set_contents((embed_dir / embfile_name).c_str(), embfile->get_raw_blob().c_str(), (gssize)embfile->get_raw_blob().size(), nullptr);
+    if (not _dedupAssets or _writtenAssets.insert(embfile_rel_path.string()).second) {
+        // the widget can be deleted while the task is pending, the task owns a copy of the data
+        _run_or_defer([rawBlob = embfile->get_raw_blob(), embfile_filepath = embed_dir / embfile_name](){
+            _write_file(embfile_filepath, rawBlob.c_str(), rawBlob.size());
+        });
+    }
 
     return embfile_html;
 }
@@ -412,8 +482,24 @@ Glib::ustring CtExport2Html::_get_image_html(CtImage* image,
         return "<a name=\"" + imageAnchor->get_anchor_name() + "\"></a>";
     }
     images_count += 1;
+    CtImagePng* png = dynamic_cast<CtImagePng*>(image);
+    const bool dedup_asset = pCtTreeIter and _dedupAssets;
+    std::shared_ptr<const std::string> pEncodedBlob; // the png bytes to write, null to encode the pixbuf on the worker
     Glib::ustring image_name, image_rel_path;
-    if (pCtTreeIter) {
+    if (dedup_asset) {
+        if (png) {
+            image_name = png->get_raw_blob_sha256sum() + ".png";
+        }
+        else {
+            g_autofree gchar* pBuffer{NULL};
+            gsize buffer_size;
+            image->get_pixbuf()->save_to_buffer(pBuffer, buffer_size, "png");
+            pEncodedBlob = std::make_shared<const std::string>(pBuffer, buffer_size);
+            image_name = CtStorageMultiFile::get_blob_sha256sum(*pEncodedBlob) + ".png";
+        }
+        image_rel_path = (fs::path{"images"} / image_name).string_unix();
+    }
+    else if (pCtTreeIter) {
         image_name = std::to_string(pCtTreeIter->get_node_id_data_holder()) + "-" + std::to_string(images_count) + ".png";
         image_rel_path = (fs::path{"images"} / image_name).string_unix();
     }
@@ -423,13 +509,31 @@ Glib::ustring CtExport2Html::_get_image_html(CtImage* image,
     }
 
     Glib::ustring image_html = "<img src=\"" + image_rel_path + "\" alt=\"" + image_rel_path + "\" />";
-    CtImagePng* png = dynamic_cast<CtImagePng*>(image);
     if (png and not png->get_link().empty()) {
         Glib::ustring href = _get_href_from_link_prop_val(_pCtMainWin, png->get_link(), single_file);
         image_html = "<a href=\"" + href + "\">" + image_html + "</a>";
     }
 
-    image->save(images_dir / image_name, "png");
+    if (dedup_asset and not _writtenAssets.insert(image_rel_path.raw()).second) {
+        // the same content was already written
+    }
+    else {
+        // the tasks own the image data rather than the widget, that can be deleted while they are pending
+        if (png and not pEncodedBlob) {
+            // the png loaded is written as is, otherwise encoded on the worker
+            pEncodedBlob = png->get_raw_blob_ptr();
+        }
+        if (pEncodedBlob) {
+            _run_or_defer([pEncodedBlob, image_filepath = images_dir / image_name](){
+                _write_file(image_filepath, pEncodedBlob->c_str(), pEncodedBlob->size());
+            });
+        }
+        else {
+            _run_or_defer([rPixbuf = image->get_pixbuf(), image_filepath = images_dir / image_name](){
+                rPixbuf->save(image_filepath.string(), "png");
+            });
+        }
+    }
     return image_html;
 }
 
@@ -482,61 +586,20 @@ Glib::ustring CtExport2Html::_html_get_from_code_buffer(const Glib::RefPtr<Gtk::
     gtk_source_buffer_ensure_highlight(GTK_SOURCE_BUFFER(code_buffer->gobj()), curr_iter.gobj(), end_iter.gobj());
 
     Glib::ustring html_text;
-    Glib::ustring former_tag_str = CtConst::COLOR_48_BLACK;
-    bool span_opened = false;
-    for (;;) {
-        std::vector<Glib::RefPtr<Gtk::TextTag>> curr_tags = curr_iter.get_tags();
-        if (curr_tags.size() > 0) {
-            Glib::ustring curr_tag_str{CtConst::COLOR_48_BLACK};
-            int font_weight = curr_tags[0]->property_weight().get_value();
-            for (auto& curr_tag : curr_tags) {
-                if (curr_tag->property_foreground_set()) {
-                    Glib::ustring tmpTagStr = curr_tag->property_foreground_rgba().get_value().to_string();
-                    if (tmpTagStr != curr_tag_str) {
-                        curr_tag_str = tmpTagStr;
-                        font_weight = curr_tag->property_weight().get_value();
-                        break;
-                    }
-#if 0
-                    spdlog::debug("{} TAG FG={} BG={} WEIGHT={}", curr_iter.get_offset(),
-                        curr_tag->property_foreground_rgba().get_value().to_string().c_str(),
-                        curr_tag->property_background_rgba().get_value().to_string().c_str(),
-                        curr_tag->property_weight().get_value());
-#endif
-                }
+    Glib::ustring former_foreground;
+    CtTextIterUtil::code_buffer_foreach_run(curr_iter, end_iter, [&](const Glib::ustring& run_text, const CtTextIterUtil::CodeRunStyle& run_style){
+        if (run_style.foreground != former_foreground) {
+            // end of tag
+            if (not former_foreground.empty()) html_text += "</span>";
+            // start of tag
+            if (run_style.hasForeground) {
+                html_text += "<span style=\"color:" + run_style.rgb24 + ";font-weight:" + std::to_string(run_style.fontWeight) + "\">";
             }
-            if (curr_tag_str == CtConst::COLOR_48_BLACK) {
-                if (former_tag_str != curr_tag_str) {
-                    former_tag_str = curr_tag_str;
-                    // end of tag
-                    html_text += "</span>";
-                    span_opened = false;
-                }
-            }
-            else {
-                if (former_tag_str != curr_tag_str) {
-                    former_tag_str = curr_tag_str;
-                    if (span_opened) html_text += "</span>";
-                    // start of tag
-                    Glib::ustring color = CtRgbUtil::rgb_to_no_white(curr_tag_str);
-                    color = CtRgbUtil::get_rgb24str_from_str_any(color);
-                    html_text += "<span style=\"color:" + color + ";font-weight:" + std::to_string(font_weight) + "\">";
-                    span_opened = true;
-                }
-            }
-        }
-        else if (span_opened) {
-            span_opened = false;
-            former_tag_str = CtConst::COLOR_48_BLACK;
-            html_text += "</span>";
+            former_foreground = run_style.foreground;
         }
-        Glib::ustring sym = str::xml_escape(Glib::ustring(1, curr_iter.get_char()));
-        html_text += sym;
-        if (not curr_iter.forward_char() || (sel_end >= 0 && curr_iter.get_offset() >= sel_end)) {
-            if (span_opened) html_text += "</span>";
-            break;
-        }
-    }
+        html_text += str::xml_escape(run_text);
+    });
+    if (not former_foreground.empty()) html_text += "</span>";
 
     html_text = str::replace(html_text, CtConst::CHAR_NEWLINE, "<br />");
     if (from_selection) html_text = "<pre style=\"display:inline;\">" + html_text + "</pre>";
@@ -729,7 +792,7 @@ void CtExport2Html::_html_get_from_treestore_node(CtTreeIter tree_iter,
     std::list<CtListType> nested_list_types;
     CtTextIterUtil::SerializeFunc f_html_serialise = [&](Gtk::TextIter& start_iter,
                                                          Gtk::TextIter& curr_iter,
-                                                         CtCurrAttributesMap& curr_attributes,
+                                                         CtCurrAttributes& curr_attributes,
                                                          CtListInfo* pCurrListInfo)
     {
         //spdlog::debug("'{}' t={} s={} l={} c={} n={}", start_iter.get_text(curr_iter), static_cast<int>(pCurrListInfo->type),
@@ -764,7 +827,7 @@ void CtExport2Html::_html_get_from_treestore_node(CtTreeIter tree_iter,
 /*static*/Glib::ustring CtExport2Html::_html_text_serialize(CtMainWin* const pCtMainWin, // the unit tests may pass nullptr here!
                                                             Gtk::TextIter start_iter,
                                                             Gtk::TextIter end_iter,
-                                                            const CtCurrAttributesMap& curr_attributes,
+                                                            const CtCurrAttributes& curr_attributes,
                                                             const bool single_file)
 {
     Glib::ustring html_attrs;
@@ -29,6 +29,8 @@
 #include "ct_treestore.h"
 #include "ct_dialogs.h" // CtExportOptions
 #include "ct_misc_utils.h"
+#include <unordered_set>
+#include <mutex>
 
 class CtExport2Html
 {
@@ -95,7 +97,7 @@ private:
     static Glib::ustring _html_text_serialize(CtMainWin* const pCtMainWin, // the unit tests may pass nullptr here!
                                               Gtk::TextIter start_iter,
                                               Gtk::TextIter end_iter,
-                                              const CtCurrAttributesMap& curr_attributes,
+                                              const CtCurrAttributes& curr_attributes,
                                               const bool single_file);
     static std::string _get_href_from_link_prop_val(CtMainWin* const pCtMainWin,
                                                     const Glib::ustring& link_prop_val,
@@ -105,6 +107,12 @@ private:
     void _tree_links_text_iter(CtTreeIter tree_iter, Glib::ustring& tree_links_text, int tree_count_level, bool index_in_page);
 
     static Glib::ustring _get_html_filename(CtTreeIter tree_iter);
+    static Glib::ustring _get_html_paragraphs(const Glib::ustring& node_html_text, const Glib::ustring& node_text);
+
+    // on the export task group while exporting multiple pages, right away otherwise
+    // the deferred failures are thrown at the end of the export
+    void _run_or_defer(std::function<void()> f);
+    static void _write_file(const fs::path& file_path, const char* pData, const size_t dataSize);
 
 public:
     static std::string link_process_filepath(const std::string& filepath_raw, const std::string& relative_to, const bool forHtml);
@@ -117,4 +125,9 @@ private:
     fs::path _images_dir;
     fs::path _embed_dir;
     fs::path _res_dir;
+    CtThreadPool::TaskGroup* _pWriteTaskGroup{nullptr};
+    bool _dedupAssets{false};
+    std::unordered_set<std::string> _writtenAssets; // relative paths, only used by the gtk thread
+    std::vector<std::string> _writeErrors;
+    std::mutex _writeErrorsMutex;
 };
@@ -23,6 +23,7 @@
 
 #include "ct_export2pdf.h"
 #include "ct_dialogs.h"
+#include "ct_trace.h"
 #include <utility>
 
 namespace {
@@ -55,12 +56,14 @@ void CtExport2Pango::pango_get_from_treestore_node(CtTreeIter node_iter, int sel
         _pango_process_slot(start_text_offset, widgetOffset, curr_buffer, out_slots);
 
         int widget_indent{0};
-        CtCurrAttributesMap emtpy_attributes, iter_attributes;
+        CtCurrAttributes emtpy_attributes;
+        CtTextIterUtil::RichTextDelta iter_attributes;
+        CtTextIterUtil::RichTextTagsAttrs tagsAttrs;
         const Gtk::TextIter widgetTextIter = curr_buffer->get_iter_at_offset(widgetOffset);
-        if (CtTextIterUtil::rich_text_attributes_update(widgetTextIter, emtpy_attributes, iter_attributes)) {
-            auto attr_iter = iter_attributes.find(CtConst::TAG_INDENT);
-            if (attr_iter != iter_attributes.end()) {
-                widget_indent = not attr_iter->second.empty() ? CtConst::INDENT_MARGIN * std::stoi(attr_iter->second) : 0;
+        if (CtTextIterUtil::rich_text_attributes_update(widgetTextIter, emtpy_attributes, iter_attributes, tagsAttrs)) {
+            const std::string* pIndent = iter_attributes[static_cast<size_t>(CtTagAttr::Indent)];
+            if (pIndent) {
+                widget_indent = not pIndent->empty() ? CtConst::INDENT_MARGIN * std::stoi(*pIndent) : 0;
             }
         }
         const PangoDirection pango_dir = CtTextIterUtil::get_pango_direction(widgetTextIter);
@@ -90,7 +93,7 @@ Glib::ustring CtExport2Pango::pango_get_from_code_buffer(Glib::RefPtr<Gtk::TextB
                                                          const std::string& syntax_highlighting)
 {
     Gtk::TextIter curr_iter = sel_start < 0 ? code_buffer->begin() : code_buffer->get_iter_at_offset(sel_start);
-    Gtk::TextIter end_iter = sel_start < 0 ? code_buffer->end() : code_buffer->get_iter_at_offset(sel_end);
+    Gtk::TextIter end_iter = sel_end < 0 ? code_buffer->end() : code_buffer->get_iter_at_offset(sel_end);
     Glib::ustring indentation;
     bool indentation_force_spaces{false};
     if (syntax_highlighting != CtConst::PLAIN_TEXT_ID) {
@@ -100,80 +103,40 @@ Glib::ustring CtExport2Pango::pango_get_from_code_buffer(Glib::RefPtr<Gtk::TextB
         indentation_force_spaces = true;
     }
     Glib::ustring pango_text;
-    Glib::ustring former_tag_str = CtConst::COLOR_48_BLACK;
-    bool span_opened{false};
+    Glib::ustring former_foreground;
     bool is_indentation{true};
-    for (;;) {
-        std::vector<Glib::RefPtr<Gtk::TextTag>> curr_tags = curr_iter.get_tags();
-        if (curr_tags.size() > 0) {
-            Glib::ustring curr_tag_str{CtConst::COLOR_48_BLACK};
-            int font_weight = curr_tags[0]->property_weight().get_value();
-            for (Glib::RefPtr<Gtk::TextTag>& curr_tag : curr_tags) {
-                if (curr_tag->property_foreground_set()) {
-                    Glib::ustring tmpTagStr = curr_tag->property_foreground_rgba().get_value().to_string();
-                    if (tmpTagStr != curr_tag_str) {
-                        curr_tag_str = tmpTagStr;
-                        font_weight = curr_tag->property_weight().get_value();
-                        break;
-                    }
-#if 0
-                    spdlog::debug("{} TAG FG={} BG={} WEIGHT={}", curr_iter.get_offset(),
-                        curr_tag->property_foreground_rgba().get_value().to_string().c_str(),
-                        curr_tag->property_background_rgba().get_value().to_string().c_str(),
-                        curr_tag->property_weight().get_value());
-#endif
-                }
-            }
-            if (curr_tag_str == CtConst::COLOR_48_BLACK) {
-                if (former_tag_str != curr_tag_str) {
-                    former_tag_str = curr_tag_str;
-                    // end of tag
-                    pango_text += "</span>";
-                    span_opened = false;
-                }
-            }
-            else {
-                if (former_tag_str != curr_tag_str) {
-                    former_tag_str = curr_tag_str;
-                    if (span_opened) pango_text += "</span>";
-                    // start of tag
-                    Glib::ustring color = CtRgbUtil::rgb_to_no_white(curr_tag_str);
-                    color = CtRgbUtil::get_rgb24str_from_str_any(color);
-                    pango_text += "<span foreground=\"" + color + "\" font_weight=\"" + std::to_string(font_weight) + "\">";
-                    span_opened = true;
-                }
+    CtTextIterUtil::code_buffer_foreach_run(curr_iter, end_iter, [&](const Glib::ustring& run_text, const CtTextIterUtil::CodeRunStyle& run_style){
+        if (run_style.foreground != former_foreground) {
+            // end of tag
+            if (not former_foreground.empty()) pango_text += "</span>";
+            // start of tag
+            if (run_style.hasForeground) {
+                pango_text += "<span foreground=\"" + run_style.rgb24 + "\" font_weight=\"" + std::to_string(run_style.fontWeight) + "\">";
             }
+            former_foreground = run_style.foreground;
         }
-        else if (span_opened) {
-            span_opened = false;
-            former_tag_str = CtConst::COLOR_48_BLACK;
-            pango_text += "</span>";
+        if (not indentation_force_spaces) {
+            pango_text += str::xml_escape(run_text);
+            return;
         }
-        const auto curr_char = curr_iter.get_char();
-        if (indentation_force_spaces) {
+        // the tabs at the start of the lines, ascii so the bytes can be scanned
+        std::string run_indented;
+        for (const char curr_char : run_text.raw()) {
             if (is_indentation) {
                 if ('\t' == curr_char) {
-                    pango_text += indentation;
-                }
-                else {
-                    is_indentation = false;
+                    run_indented += indentation.raw();
+                    continue;
                 }
+                is_indentation = false;
             }
-            if (not is_indentation) {
-                pango_text += str::xml_escape(Glib::ustring{1, curr_char});
-                if ('\n' == curr_char) {
-                    is_indentation = true;
-                }
+            run_indented += curr_char;
+            if ('\n' == curr_char) {
+                is_indentation = true;
             }
         }
-        else {
-            pango_text += str::xml_escape(Glib::ustring{1, curr_char});
-        }
-        if (not curr_iter.forward_char() or (sel_end >= 0 && curr_iter.get_offset() > sel_end)) {
-            if (span_opened) pango_text += "</span>";
-            break;
-        }
-    }
+        pango_text += str::xml_escape(run_indented);
+    });
+    if (not former_foreground.empty()) pango_text += "</span>";
     //if (pango_text.empty() || pango_text[pango_text.size()-1] != g_utf8_get_char(CtConst::CHAR_NEWLINE))
     //    pango_text += CtConst::CHAR_NEWLINE;
     return pango_text;
@@ -187,7 +150,7 @@ void CtExport2Pango::_pango_process_slot(int start_offset,
 {
     CtTextIterUtil::SerializeFunc f_pango_serialize = [&](Gtk::TextIter& start_iter,
                                                           Gtk::TextIter& end_iter,
-                                                          CtCurrAttributesMap& curr_attributes,
+                                                          CtCurrAttributes& curr_attributes,
                                                           CtListInfo*/*pCurrListInfo*/)
     {
         _pango_text_serialize(start_iter, end_iter, curr_attributes, out_slots);
@@ -202,7 +165,7 @@ void CtExport2Pango::_pango_process_slot(int start_offset,
 // Adds a slice to the Pango Text
 void CtExport2Pango::_pango_text_serialize(const Gtk::TextIter& start_iter,
                                            Gtk::TextIter end_iter,
-                                           const CtCurrAttributesMap& curr_attributes,
+                                           const CtCurrAttributes& curr_attributes,
                                            std::vector<CtPangoObjectPtr>& out_slots)
 {
     Glib::ustring pango_attrs;
@@ -378,6 +341,7 @@ std::shared_ptr<CtPangoText> CtExport2Pango::_pango_link_url(const Glib::ustring
 
 void CtExport2Pdf::node_export_print(const fs::path& pdf_filepath, CtTreeIter tree_iter, const CtExportOptions& options, int sel_start, int sel_end)
 {
+    CtTrace::Span ctTraceSpan{"export_pdf_node"};
     Glib::RefPtr<Gtk::TextBuffer> pTextBuffer = tree_iter.get_node_text_buffer();
     if (not pTextBuffer) {
         throw std::runtime_error(str::format(_("Failed to retrieve the content of the node '%s'"), tree_iter.get_node_name().raw()));
@@ -400,6 +364,7 @@ void CtExport2Pdf::node_export_print(const fs::path& pdf_filepath, CtTreeIter tr
 
 void CtExport2Pdf::node_and_subnodes_export_print(const fs::path& pdf_filepath, CtTreeIter tree_iter, const CtExportOptions& options)
 {
+    CtTrace::Span ctTraceSpan{"export_pdf_subnodes"};
     std::vector<CtPangoObjectPtr> tree_pango_slots;
     _nodes_all_export_print_iter(tree_iter, options, tree_pango_slots);
 
@@ -408,6 +373,7 @@ void CtExport2Pdf::node_and_subnodes_export_print(const fs::path& pdf_filepath,
 
 void CtExport2Pdf::tree_export_print(const fs::path& pdf_filepath, CtTreeIter tree_iter, const CtExportOptions& options)
 {
+    CtTrace::Span ctTraceSpan{"export_pdf_tree"};
     std::vector<CtPangoObjectPtr> tree_pango_slots;
     while (tree_iter) {
         _nodes_all_export_print_iter(tree_iter, options, tree_pango_slots);
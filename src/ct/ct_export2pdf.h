@@ -111,7 +111,7 @@ private:
                                                      std::vector<CtPangoObjectPtr>& out_slots);
     void                         _pango_text_serialize(const Gtk::TextIter& start_iter,
                                                        Gtk::TextIter end_iter,
-                                                       const CtCurrAttributesMap& curr_attributes,
+                                                       const CtCurrAttributes& curr_attributes,
                                                        std::vector<CtPangoObjectPtr>& out_slots);
     std::shared_ptr<CtPangoText> _pango_link_url(const Glib::ustring& tagged_text, const Glib::ustring& link, const int indent, const PangoDirection pango_dir);
 
@@ -23,6 +23,7 @@
 
 #include "ct_export2txt.h"
 #include "ct_main_win.h"
+#include "ct_trace.h"
 
 CtExport2Txt::CtExport2Txt(CtMainWin* pCtMainWin)
  : _pCtMainWin(pCtMainWin)
@@ -32,16 +33,14 @@ CtExport2Txt::CtExport2Txt(CtMainWin* pCtMainWin)
 // Export the Selected Node To Txt
 Glib::ustring CtExport2Txt::node_export_to_txt(CtTreeIter tree_iter, fs::path filepath, CtExportOptions export_options, int sel_start, int sel_end)
 {
+    CtTrace::Span ctTraceSpan{"export_txt_node"};
     Glib::RefPtr<Gtk::TextBuffer> pTextBuffer = tree_iter.get_node_text_buffer();
     if (not pTextBuffer) {
         throw std::runtime_error(str::format(_("Failed to retrieve the content of the node '%s'"), tree_iter.get_node_name().raw()));
     }
     Glib::ustring plain_text;
     if (export_options.include_node_name) {
-        for (int i = 0; i < 1+_pCtMainWin->get_tree_store().get_store()->iter_depth(tree_iter); ++i) {
-            plain_text += "#";
-        }
-        plain_text += CtConst::CHAR_SPACE + tree_iter.get_node_name() + CtConst::CHAR_NEWLINE;
+        plain_text += get_node_name_plain(tree_iter.get_node_name(), _pCtMainWin->get_tree_store().get_store()->iter_depth(tree_iter));
     }
     plain_text += selection_export_to_txt(tree_iter, pTextBuffer, sel_start, sel_end, false);
     plain_text += str::repeat(CtConst::CHAR_NEWLINE, 2);
@@ -54,6 +53,7 @@ Glib::ustring CtExport2Txt::node_export_to_txt(CtTreeIter tree_iter, fs::path fi
 // Export All Nodes To Txt
 void CtExport2Txt::nodes_all_export_to_txt(bool all_tree, fs::path export_dir, fs::path single_txt_filepath, CtExportOptions export_options)
 {
+    CtTrace::Span ctTraceSpan{"export_txt"};
     // function to iterate nodes
     Glib::ustring tree_plain_text;
     std::function<void(CtTreeIter)> f_traverseFunc;
@@ -106,6 +106,31 @@ Glib::ustring CtExport2Txt::get_table_plain(CtTableCommon* table_orig)
 {
     std::vector<std::vector<Glib::ustring>> rows;
     table_orig->write_strings_matrix(rows);
+    return get_table_plain(rows);
+}
+
+Glib::ustring CtExport2Txt::get_codebox_plain(CtCodebox* codebox)
+{
+    return get_codebox_plain(codebox->get_text_content(), _pCtMainWin->get_ct_config()->hRule);
+}
+
+Glib::ustring CtExport2Txt::get_latex_plain(CtImageLatex* latex)
+{
+    return get_latex_plain(latex->get_latex_text(), _pCtMainWin->get_ct_config()->hRule);
+}
+
+/*static*/Glib::ustring CtExport2Txt::get_node_name_plain(const Glib::ustring& node_name, const int depth)
+{
+    Glib::ustring name_plain;
+    for (int i = 0; i < 1+depth; ++i) {
+        name_plain += "#";
+    }
+    name_plain += CtConst::CHAR_SPACE + node_name + CtConst::CHAR_NEWLINE;
+    return name_plain;
+}
+
+/*static*/Glib::ustring CtExport2Txt::get_table_plain(const std::vector<std::vector<Glib::ustring>>& rows)
+{
     Glib::ustring table_plain = CtConst::CHAR_NEWLINE;
     for (const auto& row : rows) {
         table_plain += CtConst::CHAR_PIPE;
@@ -117,18 +142,17 @@ Glib::ustring CtExport2Txt::get_table_plain(CtTableCommon* table_orig)
     return table_plain;
 }
 
-Glib::ustring CtExport2Txt::get_codebox_plain(CtCodebox* codebox)
+/*static*/Glib::ustring CtExport2Txt::get_codebox_plain(const Glib::ustring& text, const Glib::ustring& hRule)
 {
-    Glib::ustring codebox_plain = CtConst::CHAR_NEWLINE + _pCtMainWin->get_ct_config()->hRule + CtConst::CHAR_NEWLINE;
-    codebox_plain += codebox->get_text_content();
-    codebox_plain += CtConst::CHAR_NEWLINE + _pCtMainWin->get_ct_config()->hRule + CtConst::CHAR_NEWLINE;
+    Glib::ustring codebox_plain = CtConst::CHAR_NEWLINE + hRule + CtConst::CHAR_NEWLINE;
+    codebox_plain += text;
+    codebox_plain += CtConst::CHAR_NEWLINE + hRule + CtConst::CHAR_NEWLINE;
     return codebox_plain;
 }
 
-Glib::ustring CtExport2Txt::get_latex_plain(CtImageLatex* latex)
+/*static*/Glib::ustring CtExport2Txt::get_latex_plain(const Glib::ustring& latex_text_orig, const Glib::ustring& hRule)
 {
-    Glib::ustring latex_plain = CtConst::CHAR_NEWLINE + _pCtMainWin->get_ct_config()->hRule + CtConst::CHAR_NEWLINE;
-    Glib::ustring latex_text = latex->get_latex_text();
+    Glib::ustring latex_text = latex_text_orig;
     const Glib::ustring::size_type begin_doc = latex_text.find("\\begin{document}");
     if (std::string::npos != begin_doc) {
         const Glib::ustring::size_type end_doc = latex_text.rfind("\\end{document}");
@@ -137,9 +161,7 @@ Glib::ustring CtExport2Txt::get_latex_plain(CtImageLatex* latex)
             latex_text = latex_text.substr(begin_doc2, end_doc - begin_doc2 - 1);
         }
     }
-    latex_plain += latex_text;
-    latex_plain += CtConst::CHAR_NEWLINE + _pCtMainWin->get_ct_config()->hRule + CtConst::CHAR_NEWLINE;
-    return latex_plain;
+    return get_codebox_plain(latex_text, hRule);
 }
 
 // Process a Single plain Slot
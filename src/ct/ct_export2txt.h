@@ -44,6 +44,12 @@ public:
     Glib::ustring get_codebox_plain(CtCodebox* codebox);
     Glib::ustring get_latex_plain(CtImageLatex* latex);
 
+    // the plain text formatting, shared with the export without a window
+    static Glib::ustring get_node_name_plain(const Glib::ustring& node_name, const int depth);
+    static Glib::ustring get_table_plain(const std::vector<std::vector<Glib::ustring>>& rows);
+    static Glib::ustring get_codebox_plain(const Glib::ustring& text, const Glib::ustring& hRule);
+    static Glib::ustring get_latex_plain(const Glib::ustring& latex_text, const Glib::ustring& hRule);
+
 private:
     Glib::ustring _plain_process_slot(int start_offset, int end_offset, Glib::RefPtr<Gtk::TextBuffer> curr_buffer, bool check_link_target);
     Glib::ustring _tag_link_in_given_iter(Gtk::TextIter iter);
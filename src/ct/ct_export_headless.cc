@@ -0,0 +1,483 @@
+/*
+ * ct_export_headless.cc
+ *
+ * Copyright 2009-2026
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "ct_export_headless.h"
+#include "ct_export2txt.h"
+#include "ct_const.h"
+#include "ct_misc_utils.h"
+#include "ct_image.h"
+#include "ct_storage_xml.h"
+#include "ct_rich_text_bin.h"
+#include "ct_storage_sqlite.h"
+#include "ct_p7za_iface.h"
+#include "ct_logging.h"
+#include <libxml++/libxml++.h>
+#include <libxml2/libxml/parser.h>
+#include <sqlite3.h>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+
+// serializes the check and creation of the export folders/files of documents exported in parallel
+std::mutex s_exportFolderMutex;
+
+Glib::ustring element_text(xmlpp::Element* pElement)
+{
+    xmlpp::TextNode* pTextNode = pElement->get_child_text();
+    return pTextNode ? pTextNode->get_content() : Glib::ustring{};
+}
+
+// the rows as stored have the header row last
+std::vector<std::vector<Glib::ustring>> table_rows_from_xml(xmlpp::Element* pTableElement)
+{
+    std::vector<std::vector<Glib::ustring>> rows;
+    for (xmlpp::Node* pNodeRow : pTableElement->get_children("row")) {
+        rows.emplace_back();
+        for (xmlpp::Node* pNodeCell : pNodeRow->get_children("cell")) {
+            rows.back().push_back(element_text(static_cast<xmlpp::Element*>(pNodeCell)));
+        }
+    }
+    if (not rows.empty()) {
+        std::rotate(rows.rbegin(), rows.rbegin() + 1, rows.rend());
+    }
+    return rows;
+}
+
+// the rich text and anchored widgets slots of a <node> element, the child nodes are skipped
+void slots_from_xml(xmlpp::Element* pNodeElement, CtHeadlessNode& node)
+{
+    for (xmlpp::Node* pChild : pNodeElement->get_children()) {
+        auto pSlotElement = dynamic_cast<xmlpp::Element*>(pChild);
+        if (not pSlotElement) continue;
+        const Glib::ustring slotName = pSlotElement->get_name();
+        if (slotName == "rich_text") {
+            node.text += element_text(pSlotElement);
+            continue;
+        }
+        CtHeadlessWidget widget;
+        if (slotName == "codebox") {
+            widget.type = CtHeadlessWidget::Type::Codebox;
+            widget.text = element_text(pSlotElement);
+        }
+        else if (slotName == "table") {
+            widget.type = CtHeadlessWidget::Type::Table;
+            widget.rows = table_rows_from_xml(pSlotElement);
+        }
+        else if (slotName == "encoded_png") {
+            if (pSlotElement->get_attribute_value("filename").raw() == CtImageLatex::LatexSpecialFilename) {
+                widget.type = CtHeadlessWidget::Type::Latex;
+                widget.text = element_text(pSlotElement);
+            }
+        }
+        else {
+            continue;
+        }
+        widget.charOffset = std::stoi(pSlotElement->get_attribute_value("char_offset"));
+        node.widgets.push_back(std::move(widget));
+    }
+}
+
+void nodes_from_xml_element(xmlpp::Element* pParentElement, const int parentIdx, const int depth, std::vector<CtHeadlessNode>& nodes)
+{
+    for (xmlpp::Node* pChild : pParentElement->get_children("node")) {
+        auto pNodeElement = static_cast<xmlpp::Element*>(pChild);
+        const int nodeIdx = static_cast<int>(nodes.size());
+        {
+            CtHeadlessNode& node = nodes.emplace_back();
+            node.nodeId = CtStrUtil::gint64_from_gstring(pNodeElement->get_attribute_value("unique_id").c_str());
+            node.sharedNodesMasterId = CtStrUtil::gint64_from_gstring(pNodeElement->get_attribute_value("master_id").c_str());
+            node.name = pNodeElement->get_attribute_value("name");
+            node.syntax = pNodeElement->get_attribute_value("prog_lang");
+            node.depth = depth;
+            node.parentIdx = parentIdx;
+            slots_from_xml(pNodeElement, node);
+        }
+        nodes_from_xml_element(pNodeElement, nodeIdx, depth + 1, nodes);
+    }
+}
+
+void nodes_from_xml_data(const std::string& doc_data, std::vector<CtHeadlessNode>& nodes)
+{
+    xmlpp::DomParser parser;
+    if (not CtXmlHelper::safe_parse_memory(parser, doc_data)) {
+        throw std::runtime_error("xml parse failed");
+    }
+    nodes_from_xml_element(parser.get_document()->get_root_node(), -1/*parentIdx*/, 0/*depth*/, nodes);
+
+    // the shared non master nodes only have the id of the master in the xml
+    std::unordered_map<gint64, size_t> idxById;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        idxById[nodes[i].nodeId] = i;
+    }
+    for (CtHeadlessNode& node : nodes) {
+        if (node.sharedNodesMasterId <= 0) continue;
+        const auto it = idxById.find(node.sharedNodesMasterId);
+        if (it == idxById.end()) {
+            spdlog::warn("!! {} missing master {} of node {}", __FUNCTION__, node.sharedNodesMasterId, node.nodeId);
+            continue;
+        }
+        const CtHeadlessNode& masterNode = nodes[it->second];
+        node.name = masterNode.name;
+        node.syntax = masterNode.syntax;
+        node.text = masterNode.text;
+        node.widgets = masterNode.widgets;
+    }
+}
+
+using SqliteStmtPtr = std::unique_ptr<sqlite3_stmt, decltype(&sqlite3_finalize)>;
+
+SqliteStmtPtr sqlite_prepare(sqlite3* pDb, const char* sql, const bool throwOnError = true)
+{
+    sqlite3_stmt* pStmt{nullptr};
+    if (SQLITE_OK != sqlite3_prepare_v2(pDb, sql, -1, &pStmt, nullptr)) {
+        sqlite3_finalize(pStmt);
+        pStmt = nullptr;
+        if (throwOnError) {
+            throw std::runtime_error(CtStorageSqlite::ERR_SQLITE_PREPV2 + sqlite3_errmsg(pDb));
+        }
+    }
+    return SqliteStmtPtr{pStmt, &sqlite3_finalize};
+}
+
+void nodes_from_sqlite(const fs::path& db_path, std::vector<CtHeadlessNode>& nodes)
+{
+    sqlite3* pDb{nullptr};
+    auto on_scope_exit = scope_guard([&pDb](void*) { sqlite3_close(pDb); });
+    if (SQLITE_OK != sqlite3_open_v2(db_path.c_str(), &pDb, SQLITE_OPEN_READONLY, nullptr)) {
+        throw std::runtime_error(fmt::format("sqlite3_open_v2 {}: {}", db_path.string(), sqlite3_errmsg(pDb)));
+    }
+
+    // the node contents by id, the tree is walked later through the children table
+    std::unordered_map<gint64, CtHeadlessNode> nodeById;
+    {
+        SqliteStmtPtr stmt = sqlite_prepare(pDb, "SELECT node_id, name, syntax, txt FROM node");
+        while (SQLITE_ROW == sqlite3_step(stmt.get())) {
+            CtHeadlessNode& node = nodeById[sqlite3_column_int64(stmt.get(), 0)];
+            node.name = CtStorageSqlite::safe_sqlite3_column_text(stmt.get(), 1);
+            node.syntax = CtStorageSqlite::safe_sqlite3_column_text(stmt.get(), 2);
+            if (CtConst::RICH_TEXT_ID != node.syntax) {
+                node.text = CtStorageSqlite::safe_sqlite3_column_text(stmt.get(), 3);
+                continue;
+            }
+            // the slots of a binary body are read through its xml form
+            std::string binXml;
+            if (SQLITE_BLOB == sqlite3_column_type(stmt.get(), 3)) {
+                const auto pBlob = static_cast<const char*>(sqlite3_column_blob(stmt.get(), 3));
+                const int blobSize = sqlite3_column_bytes(stmt.get(), 3);
+                if (CtRichTextBin::is_bin(pBlob, blobSize)) {
+                    binXml = CtRichTextBin::to_xml(std::string_view{pBlob, static_cast<size_t>(blobSize)});
+                }
+            }
+            const char* textContent = binXml.empty() ? CtStorageSqlite::safe_sqlite3_column_text(stmt.get(), 3) : binXml.c_str();
+            xmlpp::DomParser parser;
+            if (CtXmlHelper::safe_parse_memory(parser, textContent)) {
+                slots_from_xml(parser.get_document()->get_root_node(), node);
+            }
+            else {
+                spdlog::error("!! xml read: {}", textContent);
+            }
+        }
+    }
+    auto f_node_widgets = [&nodeById](const gint64 node_id)->std::vector<CtHeadlessWidget>* {
+        const auto it = nodeById.find(node_id);
+        return it != nodeById.end() ? &it->second.widgets : nullptr;
+    };
+    {
+        SqliteStmtPtr stmt = sqlite_prepare(pDb, "SELECT node_id, offset, txt FROM codebox");
+        while (SQLITE_ROW == sqlite3_step(stmt.get())) {
+            if (auto pWidgets = f_node_widgets(sqlite3_column_int64(stmt.get(), 0))) {
+                CtHeadlessWidget& widget = pWidgets->emplace_back();
+                widget.type = CtHeadlessWidget::Type::Codebox;
+                widget.charOffset = sqlite3_column_int64(stmt.get(), 1);
+                widget.text = CtStorageSqlite::safe_sqlite3_column_text(stmt.get(), 2);
+            }
+        }
+    }
+    {
+        SqliteStmtPtr stmt = sqlite_prepare(pDb, "SELECT node_id, offset, txt FROM grid");
+        while (SQLITE_ROW == sqlite3_step(stmt.get())) {
+            if (auto pWidgets = f_node_widgets(sqlite3_column_int64(stmt.get(), 0))) {
+                CtHeadlessWidget& widget = pWidgets->emplace_back();
+                widget.type = CtHeadlessWidget::Type::Table;
+                widget.charOffset = sqlite3_column_int64(stmt.get(), 1);
+                const char* textContent = CtStorageSqlite::safe_sqlite3_column_text(stmt.get(), 2);
+                xmlpp::DomParser parser;
+                if (CtXmlHelper::safe_parse_memory(parser, textContent)) {
+                    widget.rows = table_rows_from_xml(parser.get_document()->get_root_node());
+                }
+                else {
+                    spdlog::error("!! table xml read: {}", textContent);
+                }
+            }
+        }
+    }
+    {
+        // the anchors and images have no text but take their place in the buffer offsets
+        SqliteStmtPtr stmt = sqlite_prepare(pDb, "SELECT node_id, offset, anchor, filename, png FROM image");
+        while (SQLITE_ROW == sqlite3_step(stmt.get())) {
+            if (auto pWidgets = f_node_widgets(sqlite3_column_int64(stmt.get(), 0))) {
+                CtHeadlessWidget& widget = pWidgets->emplace_back();
+                widget.charOffset = sqlite3_column_int64(stmt.get(), 1);
+                const char* anchorName = CtStorageSqlite::safe_sqlite3_column_text(stmt.get(), 2);
+                const char* fileName = CtStorageSqlite::safe_sqlite3_column_text(stmt.get(), 3);
+                if (not *anchorName and CtImageLatex::LatexSpecialFilename == fileName) {
+                    widget.type = CtHeadlessWidget::Type::Latex;
+                    const void* pBlob = sqlite3_column_blob(stmt.get(), 4);
+                    const int blobSize = sqlite3_column_bytes(stmt.get(), 4);
+                    if (pBlob) {
+                        widget.text = std::string(reinterpret_cast<const char*>(pBlob), static_cast<size_t>(blobSize));
+                    }
+                }
+            }
+        }
+    }
+
+    // older databases have no master_id
+    SqliteStmtPtr stmt = sqlite_prepare(pDb, "SELECT node_id, father_id, master_id FROM children ORDER BY father_id ASC, sequence ASC", false/*throwOnError*/);
+    if (not stmt) {
+        stmt = sqlite_prepare(pDb, "SELECT node_id, father_id, 0 FROM children ORDER BY father_id ASC, sequence ASC");
+    }
+    std::unordered_map<gint64, std::vector<std::pair<gint64, gint64>>> childrenByFather;
+    while (SQLITE_ROW == sqlite3_step(stmt.get())) {
+        childrenByFather[sqlite3_column_int64(stmt.get(), 1)].emplace_back(sqlite3_column_int64(stmt.get(), 0),
+                                                                           sqlite3_column_int64(stmt.get(), 2));
+    }
+    std::function<void(const gint64, const int, const int)> f_add_children;
+    f_add_children = [&](const gint64 father_id, const int parentIdx, const int depth) {
+        const auto itChildren = childrenByFather.find(father_id);
+        if (itChildren == childrenByFather.end()) return;
+        for (const auto& [node_id, master_id] : itChildren->second) {
+            const auto itNode = nodeById.find(master_id > 0 ? master_id : node_id);
+            if (itNode == nodeById.end()) {
+                spdlog::warn("!! {} missing node properties for id {}", __FUNCTION__, master_id > 0 ? master_id : node_id);
+                continue;
+            }
+            nodes.push_back(itNode->second);
+            nodes.back().nodeId = node_id;
+            nodes.back().sharedNodesMasterId = master_id;
+            nodes.back().depth = depth;
+            nodes.back().parentIdx = parentIdx;
+            f_add_children(node_id, static_cast<int>(nodes.size()) - 1, depth + 1);
+        }
+    };
+    f_add_children(0/*father_id*/, -1/*parentIdx*/, 0/*depth*/);
+}
+
+} // namespace
+
+CtExportHeadless::CtExportHeadless(const Glib::ustring& hRule, const Glib::ustring& password)
+ : _hRule{hRule}
+ , _password{password}
+{
+}
+
+bool CtExportHeadless::is_supported(const fs::path& file_path) const
+{
+    const CtDocType docType = fs::get_doc_type_from_file_ext(file_path);
+    if (CtDocType::XML != docType and CtDocType::SQLite != docType) {
+        return false;
+    }
+    if (_password.empty() and CtDocEncrypt::True == fs::get_doc_encrypt_from_file_ext(file_path)) {
+        return false; // the password dialog needs the window
+    }
+    return fs::is_regular_file(file_path);
+}
+
+std::vector<CtHeadlessNode> CtExportHeadless::read_document(const fs::path& file_path) const
+{
+    std::vector<CtHeadlessNode> nodes;
+    const CtDocType docType = fs::get_doc_type_from_file_ext(file_path);
+    const bool isEncrypted = CtDocEncrypt::True == fs::get_doc_encrypt_from_file_ext(file_path);
+    if (CtDocType::XML == docType) {
+        std::string docData;
+        if (isEncrypted) {
+            const int retVal = CtP7zaIface::p7za_extract_to_stream(file_path.c_str(), _password.c_str(), true/*suppress_error*/,
+                [&docData](const char* pData, const size_t dataSize){
+                    docData.append(pData, dataSize);
+                    return true;
+                });
+            if (0 != retVal or docData.empty()) {
+                throw std::runtime_error(fmt::format("p7za_extract_to_stream retVal={}", retVal));
+            }
+        }
+        else {
+            gchar* pContents{nullptr};
+            gsize contentsSize{0};
+            if (not g_file_get_contents(file_path.c_str(), &pContents, &contentsSize, nullptr)) {
+                throw std::runtime_error("g_file_get_contents failed");
+            }
+            docData.assign(pContents, contentsSize);
+            g_free(pContents);
+        }
+        nodes_from_xml_data(docData, nodes);
+    }
+    else if (CtDocType::SQLite == docType) {
+        if (isEncrypted) {
+            gchar* pTmpDir = g_dir_make_tmp("ct_headless_XXXXXX", nullptr);
+            if (not pTmpDir) {
+                throw std::runtime_error("g_dir_make_tmp failed");
+            }
+            const fs::path tmp_dir{pTmpDir};
+            g_free(pTmpDir);
+            auto on_scope_exit = scope_guard([&tmp_dir](void*) { (void)fs::remove_all(tmp_dir); });
+            const int retVal = CtP7zaIface::p7za_extract(file_path.c_str(), tmp_dir.c_str(), _password.c_str(), true/*suppress_error*/);
+            const std::list<fs::path> filesInTmpDir = fs::get_dir_entries(tmp_dir);
+            if (0 != retVal or filesInTmpDir.size() != 1u) {
+                throw std::runtime_error(fmt::format("p7za_extract retVal={}", retVal));
+            }
+            nodes_from_sqlite(filesInTmpDir.front(), nodes);
+        }
+        else {
+            nodes_from_sqlite(file_path, nodes);
+        }
+    }
+    else {
+        throw std::runtime_error("unsupported document type");
+    }
+    for (CtHeadlessNode& node : nodes) {
+        std::stable_sort(node.widgets.begin(), node.widgets.end(), [](const CtHeadlessWidget& w1, const CtHeadlessWidget& w2){
+            return w1.charOffset < w2.charOffset;
+        });
+    }
+    return nodes;
+}
+
+// same output as CtExport2Txt::node_export_to_txt with the node name included
+Glib::ustring CtExportHeadless::node_export_to_txt(const CtHeadlessNode& node) const
+{
+    Glib::ustring plain_text = CtExport2Txt::get_node_name_plain(node.name, node.depth);
+
+    // the text has no anchors, so every widget before shifts the offset of the next one by one
+    const long textLen = static_cast<long>(node.text.size());
+    const char* pSlotStart = node.text.c_str();
+    long slotStartOffset{0};
+    for (size_t i = 0; i < node.widgets.size(); ++i) {
+        const CtHeadlessWidget& widget = node.widgets[i];
+        const long slotEndOffset = std::clamp(static_cast<long>(widget.charOffset) - static_cast<long>(i), slotStartOffset, textLen);
+        const char* pSlotEnd = g_utf8_offset_to_pointer(pSlotStart, slotEndOffset - slotStartOffset);
+        plain_text += Glib::ustring{pSlotStart, pSlotEnd};
+        switch (widget.type) {
+            case CtHeadlessWidget::Type::Table: plain_text += CtExport2Txt::get_table_plain(widget.rows); break;
+            case CtHeadlessWidget::Type::Codebox: plain_text += CtExport2Txt::get_codebox_plain(widget.text, _hRule); break;
+            case CtHeadlessWidget::Type::Latex: plain_text += CtExport2Txt::get_latex_plain(widget.text, _hRule); break;
+            default: break;
+        }
+        pSlotStart = pSlotEnd;
+        slotStartOffset = slotEndOffset;
+    }
+    plain_text += Glib::ustring{pSlotStart, node.text.c_str() + node.text.bytes()};
+    plain_text += str::repeat(CtConst::CHAR_NEWLINE, 2);
+    return plain_text;
+}
+
+void CtExportHeadless::nodes_all_export_to_txt(const std::vector<CtHeadlessNode>& nodes,
+                                               const fs::path& export_dir,
+                                               const fs::path& single_txt_filepath) const
+{
+    Glib::ustring tree_plain_text;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (export_dir.empty()) {
+            tree_plain_text += node_export_to_txt(nodes[i]);
+        }
+        else {
+            const fs::path filepath = export_dir / get_node_hierarchical_name(nodes, i);
+            CtMiscUtil::text_file_set_contents_add_cr_on_win(filepath.string(), node_export_to_txt(nodes[i]));
+        }
+    }
+    if (not single_txt_filepath.empty()) {
+        CtMiscUtil::text_file_set_contents_add_cr_on_win(single_txt_filepath.string(), tree_plain_text);
+    }
+}
+
+std::vector<fs::path> CtExportHeadless::files_export_to_txt(const std::vector<fs::path>& file_paths,
+                                                            const fs::path& dir,
+                                                            const bool overwrite,
+                                                            const bool single_file) const
+{
+    xmlInitParser(); // before parsing from multiple threads
+    std::vector<fs::path> failedPaths;
+    std::mutex failedPathsMutex;
+    CtThreadPool::TaskGroup taskGroup{CtThreadPool::get_global()};
+    for (const fs::path& file_path : file_paths) {
+        taskGroup.run([this, &failedPaths, &failedPathsMutex, file_path, &dir, overwrite, single_file](){
+            try {
+                _file_export_to_txt(file_path, dir, overwrite, single_file);
+            }
+            catch (std::exception& e) {
+                spdlog::error("!! txt export {}: {}", file_path.string(), e.what());
+                std::lock_guard<std::mutex> lock{failedPathsMutex};
+                failedPaths.push_back(file_path);
+            }
+        });
+    }
+    taskGroup.wait();
+    return failedPaths;
+}
+
+// the file name of CtExport2Txt::nodes_all_export_to_txt
+/*static*/std::string CtExportHeadless::get_node_hierarchical_name(const std::vector<CtHeadlessNode>& nodes, const size_t idx)
+{
+    std::vector<std::string> names_leaf_to_root{nodes[idx].name};
+    for (int parentIdx = nodes[idx].parentIdx; parentIdx >= 0; parentIdx = nodes[parentIdx].parentIdx) {
+        names_leaf_to_root.push_back(nodes[parentIdx].name);
+    }
+    return CtMiscUtil::get_node_hierarchical_name(names_leaf_to_root, nodes[idx].nodeId, "--"/*separator*/,
+                                                  true/*for_filename*/, true/*root_to_leaf*/, true/*trail_node_id*/, ".txt"/*trailer*/);
+}
+
+void CtExportHeadless::_file_export_to_txt(const fs::path& file_path,
+                                           const fs::path& dir,
+                                           const bool overwrite,
+                                           const bool single_file) const
+{
+    const std::vector<CtHeadlessNode> nodes = read_document(file_path);
+    const std::string file_name = file_path.filename().string();
+    if (single_file) {
+        fs::path txt_filepath;
+        {
+            std::lock_guard<std::mutex> lock{s_exportFolderMutex};
+            fs::path new_file = file_name;
+            if (new_file.extension() != ".txt") new_file += ".txt";
+            new_file = fs::prepare_export_file(dir, new_file, overwrite);
+            txt_filepath = dir / new_file;
+            // reserves the name against the documents exported in parallel
+            g_file_set_contents(txt_filepath.c_str(), "", 0, nullptr);
+        }
+        nodes_all_export_to_txt(nodes, ""/*export_dir*/, txt_filepath);
+    }
+    else {
+        fs::path export_dir;
+        {
+            std::lock_guard<std::mutex> lock{s_exportFolderMutex};
+            fs::path new_folder = CtMiscUtil::clean_from_chars_not_for_filename(file_name) + "_TXT";
+            new_folder = fs::prepare_export_folder(dir, new_folder, overwrite);
+            export_dir = dir / new_folder;
+            g_mkdir_with_parents(export_dir.c_str(), 0777);
+        }
+        nodes_all_export_to_txt(nodes, export_dir, ""/*single_txt_filepath*/);
+    }
+    spdlog::debug("txt export of {} done, {} nodes", file_path.string(), nodes.size());
+}
@@ -0,0 +1,83 @@
+/*
+ * ct_export_headless.h
+ *
+ * Copyright 2009-2026
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#pragma once
+
+#include "ct_filesystem.h"
+#include <glibmm/ustring.h>
+#include <vector>
+
+/**
+ * @brief Anchored widget of a node as plain data, no Gtk widget behind it
+ */
+struct CtHeadlessWidget
+{
+    enum class Type { Codebox, Table, Latex, Other };
+    Type                                    type{Type::Other};
+    int                                     charOffset{0}; // in the text buffer, that has one char per widget anchor
+    Glib::ustring                           text;          // codebox or latex text
+    std::vector<std::vector<Glib::ustring>> rows;          // table cells, header row first
+};
+
+/**
+ * @brief Node of a document as plain data, no tree store nor text buffer behind it
+ */
+struct CtHeadlessNode
+{
+    gint64                        nodeId{0};
+    gint64                        sharedNodesMasterId{0};
+    Glib::ustring                 name;
+    std::string                   syntax;
+    Glib::ustring                 text; // the text buffer content without the widget anchors
+    std::vector<CtHeadlessWidget> widgets; // sorted by offset
+    int                           depth{0};
+    int                           parentIdx{-1};
+};
+
+/**
+ * @brief Export of documents without a CtMainWin, for the command line batch export
+ * The documents are read straight into CtHeadlessNode, in pre-order, and many documents can be exported in parallel.
+ */
+class CtExportHeadless
+{
+public:
+    CtExportHeadless(const Glib::ustring& hRule, const Glib::ustring& password);
+
+    // multifile documents and encrypted ones without a password are not handled here
+    bool is_supported(const fs::path& file_path) const;
+    // throws on a document that cannot be read
+    std::vector<CtHeadlessNode> read_document(const fs::path& file_path) const;
+
+    Glib::ustring node_export_to_txt(const CtHeadlessNode& node) const;
+    void          nodes_all_export_to_txt(const std::vector<CtHeadlessNode>& nodes, const fs::path& export_dir, const fs::path& single_txt_filepath) const;
+    // returns the documents that could not be exported
+    std::vector<fs::path> files_export_to_txt(const std::vector<fs::path>& file_paths, const fs::path& dir, const bool overwrite, const bool single_file) const;
+
+    static std::string get_node_hierarchical_name(const std::vector<CtHeadlessNode>& nodes, const size_t idx);
+
+private:
+    void _file_export_to_txt(const fs::path& file_path, const fs::path& dir, const bool overwrite, const bool single_file) const;
+
+    const Glib::ustring _hRule;
+    const Glib::ustring _password;
+};
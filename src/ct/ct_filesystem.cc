@@ -463,6 +463,26 @@ path prepare_export_folder(const path& dir_place, path new_folder, bool overwrit
     return new_folder;
 }
 
+path prepare_export_file(const path& dir_place, path new_file, bool overwrite_existing)
+{
+    const fs::path dir_place_new_file = dir_place / new_file;
+    if (fs::is_regular_file(dir_place_new_file)) {
+        if (overwrite_existing) {
+            spdlog::debug("fs::prepare_export_file: removing file {}", dir_place_new_file.string());
+            remove(dir_place_new_file);
+        }
+        else {
+            const std::string stem = new_file.stem();
+            const std::string ext = new_file.extension();
+            int n = 2;
+            while (fs::is_regular_file(dir_place / (stem + fmt::format("{:03d}", n) + ext)))
+                n += 1;
+            new_file = stem + fmt::format("{:03d}", n) + ext;
+        }
+    }
+    return new_file;
+}
+
 std::uintmax_t remove_all(const path& dir)
 {
     std::uintmax_t count{0u};
@@ -533,6 +553,14 @@ fs::path get_cherrytree_configdir()
     return Glib::build_filename(Glib::get_user_config_dir(), CtConst::APP_NAME);
 }
 
+fs::path get_cherrytree_cachedir()
+{
+    if (not _portableConfigDir.empty()) {
+        return _portableConfigDir / "cache";
+    }
+    return Glib::build_filename(Glib::get_user_cache_dir(), CtConst::APP_NAME);
+}
+
 std::optional<fs::path> get_cherrytree_logdir()
 {
     const fs::path logcfgFilepath = fs::get_cherrytree_logcfg_filepath();
@@ -607,7 +635,7 @@ std::string download_file(const std::string& filepath)
     buffer.reserve(3 * 1024 * 1024); // preallocate 3mb
 
     // from https://curl.haxx.se/libcurl/c/getinmemory.html
-    curl_global_init(CURL_GLOBAL_ALL);
+    // curl_global_init() is not thread safe, it is called once at startup in main()
     CURL* pCurlHandle = curl_easy_init();
 
     curl_easy_setopt(pCurlHandle, CURLOPT_URL, filepath.c_str());
@@ -626,7 +654,6 @@ std::string download_file(const std::string& filepath)
     curl_easy_setopt(pCurlHandle, CURLOPT_USERAGENT, "libcurl-agent/1.0");
     const CURLcode res = curl_easy_perform(pCurlHandle);
     curl_easy_cleanup(pCurlHandle);
-    curl_global_cleanup();
 
     if (res != CURLE_OK) {
         spdlog::error("fs::download_file: curl_easy_perform() failed, {}", curl_easy_strerror(res));
@@ -86,6 +86,7 @@ void open_filepath(const path& filepath, bool open_folder_if_file_not_exists, Ct
 void open_folderpath(const path& folderpath, CtConfig* config);
 
 path prepare_export_folder(const path& dir_place, path new_folder, bool overwrite_existing);
+path prepare_export_file(const path& dir_place, path new_file, bool overwrite_existing);
 
 CtDocType get_doc_type_from_file_ext(const path& fileName);
 CtDocEncrypt get_doc_encrypt_from_file_ext(const path& fileName);
@@ -106,6 +107,8 @@ bool remove(const path& p);
 path get_cherrytree_datadir();
 path get_cherrytree_localedir();
 path get_cherrytree_configdir();
+// data that can be regenerated, inside the config dir if portable
+path get_cherrytree_cachedir();
 path get_cherrytree_print_page_setup_cfg_filepath();
 path get_cherrytree_langcfg_filepath();
 path get_cherrytree_logcfg_filepath();
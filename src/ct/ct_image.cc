@@ -26,9 +26,11 @@
 #include "ct_actions.h"
 #include "ct_storage_sqlite.h"
 #include "ct_logging.h"
+#include "ct_trace.h"
 #include "ct_storage_control.h"
 #include "ct_storage_multifile.h"
 #include <regex>
+#include <glib/gstdio.h>
 
 CtImage::CtImage(CtMainWin* pCtMainWin,
                  const std::string& rawBlob,
@@ -106,6 +108,7 @@ CtImagePng::CtImagePng(CtMainWin* pCtMainWin,
                        const std::string& justification)
  : CtImage{pCtMainWin, rawBlob, "image/png", charOffset, justification}
  , _link{link}
+ , _pRawBlob{rawBlob.empty() ? nullptr : std::make_shared<const std::string>(rawBlob)}
 {
 #if GTKMM_MAJOR_VERSION < 4
     signal_button_press_event().connect(sigc::mem_fun(*this, &CtImagePng::_on_button_press_event), false);
@@ -117,9 +120,11 @@ CtImagePng::CtImagePng(CtMainWin* pCtMainWin,
                        Glib::RefPtr<Gdk::Pixbuf> pixBuf,
                        const Glib::ustring& link,
                        const int charOffset,
-                       const std::string& justification)
+                       const std::string& justification,
+                       std::shared_ptr<const std::string> pRawBlob/*= nullptr*/)
  : CtImage{pCtMainWin, pixBuf, charOffset, justification}
  , _link{link}
+ , _pRawBlob{std::move(pRawBlob)}
 {
 #if GTKMM_MAJOR_VERSION < 4
     signal_button_press_event().connect(sigc::mem_fun(*this, &CtImagePng::_on_button_press_event), false);
@@ -127,13 +132,40 @@ CtImagePng::CtImagePng(CtMainWin* pCtMainWin,
     update_label_widget();
 }
 
-const std::string CtImagePng::get_raw_blob()
+const std::string& CtImagePng::get_raw_blob()
 {
-    g_autofree gchar* pBuffer{NULL};
-    gsize buffer_size;
-    _rPixbuf->save_to_buffer(pBuffer, buffer_size, "png");
-    const std::string rawBlob = std::string(pBuffer, buffer_size);
-    return rawBlob;
+    std::lock_guard<std::mutex> lock{_rawBlobMutex};
+    if (not _pRawBlob) {
+        g_autofree gchar* pBuffer{NULL};
+        gsize buffer_size;
+        _rPixbuf->save_to_buffer(pBuffer, buffer_size, "png");
+        _pRawBlob = std::make_shared<const std::string>(pBuffer, buffer_size);
+    }
+    return *_pRawBlob;
+}
+
+const std::string& CtImagePng::get_raw_blob_sha256sum()
+{
+    const std::string& rawBlob = get_raw_blob();
+    std::lock_guard<std::mutex> lock{_rawBlobMutex};
+    if (_rawBlobSha256sum.empty()) {
+        _rawBlobSha256sum = CtStorageMultiFile::get_blob_sha256sum(rawBlob);
+    }
+    return _rawBlobSha256sum;
+}
+
+std::shared_ptr<const std::string> CtImagePng::get_raw_blob_ptr() const
+{
+    std::lock_guard<std::mutex> lock{_rawBlobMutex};
+    return _pRawBlob;
+}
+
+void CtImagePng::save_raw_blob(const fs::path& file_path)
+{
+    const std::string& rawBlob = get_raw_blob();
+    if (not g_file_set_contents(file_path.c_str(), rawBlob.c_str(), (gssize)rawBlob.size(), nullptr)) {
+        throw std::runtime_error(fmt::format("g_file_set_contents {} failed", file_path.string()));
+    }
 }
 
 void CtImagePng::to_xml(xmlpp::Element* p_node_parent,
@@ -153,28 +185,21 @@ void CtImagePng::to_xml(xmlpp::Element* p_node_parent,
         p_image_node->add_child_text(encodedBlob);
     }
     else {
-        std::string rawBlob;
-        if (not storage_cache or not storage_cache->get_cached_image(this, rawBlob)) {
-            rawBlob = get_raw_blob();
-        }
-        const std::string sha256sum = CtStorageMultiFile::save_blob(rawBlob, multifile_dir, ".png");
+        const std::string sha256sum = CtStorageMultiFile::save_blob(get_raw_blob(), multifile_dir, ".png", get_raw_blob_sha256sum());
         p_image_node->set_attribute("sha256sum", sha256sum);
     }
 }
 
-bool CtImagePng::to_sqlite(sqlite3* pDb, const gint64 node_id, const int offset_adjustment, CtStorageCache* storage_cache)
+bool CtImagePng::to_sqlite(CtSqliteStmtCache* pStmtCache, const gint64 node_id, const int offset_adjustment, CtStorageCache* /*storage_cache*/)
 {
     bool retVal{true};
-    sqlite3_stmt *p_stmt;
-    if (sqlite3_prepare_v2(pDb, CtStorageSqlite::TABLE_IMAGE_INSERT, -1, &p_stmt, nullptr) != SQLITE_OK) {
-        spdlog::error("{}: {}", CtStorageSqlite::ERR_SQLITE_PREPV2, sqlite3_errmsg(pDb));
+    sqlite3_stmt* p_stmt = pStmtCache->get(CtStorageSqlite::TABLE_IMAGE_INSERT);
+    if (not p_stmt) {
+        spdlog::error("{}: {}", CtStorageSqlite::ERR_SQLITE_PREPV2, sqlite3_errmsg(pStmtCache->get_db()));
         retVal = false;
     }
     else {
-        std::string rawBlob;
-        if (not storage_cache or not storage_cache->get_cached_image(this, rawBlob)) {
-            rawBlob = get_raw_blob();
-        }
+        const std::string& rawBlob = get_raw_blob();
         const std::string link = _link;
 
         sqlite3_bind_int64(p_stmt, 1, node_id);
@@ -186,10 +211,9 @@ bool CtImagePng::to_sqlite(sqlite3* pDb, const gint64 node_id, const int offset_
         sqlite3_bind_text(p_stmt, 7, link.c_str(), link.size(), SQLITE_STATIC);
         sqlite3_bind_int64(p_stmt, 8, 0); // time
         if (sqlite3_step(p_stmt) != SQLITE_DONE) {
-            spdlog::error("{}: {}", CtStorageSqlite::ERR_SQLITE_STEP, sqlite3_errmsg(pDb));
+            spdlog::error("{}: {}", CtStorageSqlite::ERR_SQLITE_STEP, sqlite3_errmsg(pStmtCache->get_db()));
             retVal = false;
         }
-        sqlite3_finalize(p_stmt);
     }
     return retVal;
 }
@@ -292,12 +316,12 @@ void CtImageAnchor::to_xml(xmlpp::Element* p_node_parent, const int offset_adjus
     }
 }
 
-bool CtImageAnchor::to_sqlite(sqlite3* pDb, const gint64 node_id, const int offset_adjustment, CtStorageCache*)
+bool CtImageAnchor::to_sqlite(CtSqliteStmtCache* pStmtCache, const gint64 node_id, const int offset_adjustment, CtStorageCache*)
 {
     bool retVal{true};
-    sqlite3_stmt *p_stmt;
-    if (sqlite3_prepare_v2(pDb, CtStorageSqlite::TABLE_IMAGE_INSERT, -1, &p_stmt, nullptr) != SQLITE_OK) {
-        spdlog::error("{}: {}", CtStorageSqlite::ERR_SQLITE_PREPV2, sqlite3_errmsg(pDb));
+    sqlite3_stmt* p_stmt = pStmtCache->get(CtStorageSqlite::TABLE_IMAGE_INSERT);
+    if (not p_stmt) {
+        spdlog::error("{}: {}", CtStorageSqlite::ERR_SQLITE_PREPV2, sqlite3_errmsg(pStmtCache->get_db()));
         retVal = false;
     }
     else {
@@ -316,10 +340,9 @@ bool CtImageAnchor::to_sqlite(sqlite3* pDb, const gint64 node_id, const int offs
         }
         sqlite3_bind_int64(p_stmt, 8, 0); // time
         if (sqlite3_step(p_stmt) != SQLITE_DONE) {
-            spdlog::error("{}: {}", CtStorageSqlite::ERR_SQLITE_STEP, sqlite3_errmsg(pDb));
+            spdlog::error("{}: {}", CtStorageSqlite::ERR_SQLITE_STEP, sqlite3_errmsg(pStmtCache->get_db()));
             retVal = false;
         }
-        sqlite3_finalize(p_stmt);
     }
     return retVal;
 }
@@ -409,6 +432,9 @@ bool CtImageAnchor::_on_button_press_event(GdkEventButton* event)
 #endif
 
 /*static*/const int CtImageLatex::PrintZoom{4};
+/*static*/const size_t CtImageLatex::MaxConcurrentRenders{2};
+/*static*/const size_t CtImageLatex::MaxBatchedRenders{32};
+/*static*/const std::uintmax_t CtImageLatex::MaxCacheBytes{64u * 1024u * 1024u};
 /*static*/const std::string CtImageLatex::LatexSpecialFilename{"__ct_special.tex"};
 /*static*/const Glib::ustring CtImageLatex::LatexTextDefault{"\\documentclass{article}\n"
                                                              "\\pagestyle{empty}\n"
@@ -424,21 +450,63 @@ bool CtImageAnchor::_on_button_press_event(GdkEventButton* event)
 /*static*/bool CtImageLatex::_renderingBinariesLatexOk{true};
 /*static*/bool CtImageLatex::_renderingBinariesDviPngOk{true};
 
+struct CtImageLatex::RenderRequest
+{
+    std::shared_ptr<CtImageLatex*> pImageLatex; // only dereferenced in the main thread
+    Glib::ustring latexText;
+    int dpi{0};
+    fs::path cacheFilepath;
+    std::string preamble;
+    RenderResult result{RenderResult::LatexFailed};
+};
+
+/*static*/std::vector<CtImageLatex::RenderRequest> CtImageLatex::_pendingRenders;
+
 CtImageLatex::CtImageLatex(CtMainWin* pCtMainWin,
                            const Glib::ustring& latexText,
                            const int charOffset,
                            const std::string& justification,
                            const size_t uniqueId)
- : CtImage{pCtMainWin, _get_latex_image(pCtMainWin, latexText, uniqueId), charOffset, justification}
+ : CtImage{pCtMainWin, "ct_latex", 48, charOffset, justification}
  , _latexText{latexText}
  , _uniqueId{uniqueId}
+ , _pSelf{std::make_shared<CtImageLatex*>(this)}
 {
 #if GTKMM_MAJOR_VERSION < 4
     signal_button_press_event().connect(sigc::mem_fun(*this, &CtImageLatex::_on_button_press_event), false);
 #endif
+    const int dpi = pCtMainWin->get_ct_config()->latexSizeDpi;
+    Glib::RefPtr<Gdk::Pixbuf> rPixbuf;
+    if (_get_latex_image_no_render(pCtMainWin, latexText, dpi, rPixbuf)) {
+        _rPixbuf = rPixbuf;
+        _image.set(_rPixbuf);
+    }
+    else {
+        // the placeholder stays until the background render is done
+        _renderPending = true;
+        if (_pendingRenders.empty()) {
+            Glib::signal_idle().connect_once([](){
+                _flush_pending_renders();
+            });
+        }
+        _pendingRenders.push_back(RenderRequest{_pSelf, latexText, dpi, _get_cache_filepath(pCtMainWin, latexText, dpi)});
+    }
     update_tooltip();
 }
 
+CtImageLatex::~CtImageLatex()
+{
+    *_pSelf = nullptr;
+}
+
+Glib::RefPtr<Gdk::Pixbuf> CtImageLatex::get_pixbuf() const
+{
+    if (_renderPending) {
+        return _get_latex_image(_pCtMainWin, _latexText, 1/*zoom*/);
+    }
+    return _rPixbuf;
+}
+
 void CtImageLatex::to_xml(xmlpp::Element* p_node_parent, const int offset_adjustment, CtStorageCache*, const std::string&/*multifile_dir*/)
 {
     xmlpp::Element* p_image_node = p_node_parent->add_child("encoded_png");
@@ -448,12 +516,12 @@ void CtImageLatex::to_xml(xmlpp::Element* p_node_parent, const int offset_adjust
     p_image_node->add_child_text(_latexText);
 }
 
-bool CtImageLatex::to_sqlite(sqlite3* pDb, const gint64 node_id, const int offset_adjustment, CtStorageCache*)
+bool CtImageLatex::to_sqlite(CtSqliteStmtCache* pStmtCache, const gint64 node_id, const int offset_adjustment, CtStorageCache*)
 {
     bool retVal{true};
-    sqlite3_stmt *p_stmt;
-    if (sqlite3_prepare_v2(pDb, CtStorageSqlite::TABLE_IMAGE_INSERT, -1, &p_stmt, nullptr) != SQLITE_OK) {
-        spdlog::error("{}: {}", CtStorageSqlite::ERR_SQLITE_PREPV2, sqlite3_errmsg(pDb));
+    sqlite3_stmt* p_stmt = pStmtCache->get(CtStorageSqlite::TABLE_IMAGE_INSERT);
+    if (not p_stmt) {
+        spdlog::error("{}: {}", CtStorageSqlite::ERR_SQLITE_PREPV2, sqlite3_errmsg(pStmtCache->get_db()));
         retVal = false;
     }
     else {
@@ -466,10 +534,9 @@ bool CtImageLatex::to_sqlite(sqlite3* pDb, const gint64 node_id, const int offse
         sqlite3_bind_text(p_stmt, 7, "", -1, SQLITE_STATIC); // link
         sqlite3_bind_int64(p_stmt, 8, 0); // time
         if (sqlite3_step(p_stmt) != SQLITE_DONE) {
-            spdlog::error("{}: {}", CtStorageSqlite::ERR_SQLITE_STEP, sqlite3_errmsg(pDb));
+            spdlog::error("{}: {}", CtStorageSqlite::ERR_SQLITE_STEP, sqlite3_errmsg(pStmtCache->get_db()));
             retVal = false;
         }
-        sqlite3_finalize(p_stmt);
     }
     return retVal;
 }
@@ -558,33 +625,48 @@ static const char* get_dvipng_bin_cmd()
     return true;
 }
 
-/*static*/Glib::RefPtr<Gdk::Pixbuf> CtImageLatex::_get_latex_image(CtMainWin* pCtMainWin, const Glib::ustring& latexText, const size_t uniqueId, const int zoom)
+static const std::string LatexBeginDocument{"\\begin{document}"};
+static const std::string LatexEndDocument{"\\end{document}"};
+
+// up to \begin{document} included, empty if missing
+static std::string get_latex_preamble(const std::string& latexText)
 {
-    CtImageLatex::ensureRenderingBinariesTested();
-    if (not _renderingBinariesLatexOk or not _renderingBinariesDviPngOk) {
-        // fallback
-        #if GTKMM_MAJOR_VERSION < 4
-        return pCtMainWin->get_icon_theme()->load_icon("ct_warning", 48);
-        #else
-        return Glib::RefPtr<Gdk::Pixbuf>{};
-        #endif
+    const size_t pos = latexText.find(LatexBeginDocument);
+    return std::string::npos == pos ? std::string{} : latexText.substr(0, pos + LatexBeginDocument.size());
+}
+
+// between \begin{document} and \end{document}, false if missing or blank
+static bool get_latex_body(const std::string& latexText, std::string& body)
+{
+    const size_t posBegin = latexText.find(LatexBeginDocument);
+    const size_t posEnd = latexText.rfind(LatexEndDocument);
+    if (std::string::npos == posBegin or std::string::npos == posEnd or posEnd < posBegin + LatexBeginDocument.size()) {
+        return false;
     }
-    if (not _is_latex_text_safe(latexText)) {
-        // blocked: dangerous file I/O commands detected
-        return pCtMainWin->get_icon_theme()->load_icon("ct_warning", 48);
+    body = latexText.substr(posBegin + LatexBeginDocument.size(), posEnd - posBegin - LatexBeginDocument.size());
+    return not str::trim(body).empty();
+}
+
+// a tmp dir per render, the renders run in parallel
+static fs::path make_latex_tmp_dirpath()
+{
+    gchar* pTmpDir = g_dir_make_tmp("ct_latex_XXXXXX", nullptr);
+    if (not pTmpDir) {
+        spdlog::error("{} g_dir_make_tmp failed", __FUNCTION__);
+        return fs::path{};
     }
-    const fs::path filename = std::to_string(uniqueId) +
-                              CtConst::CHAR_MINUS + std::to_string(getpid()) +
-                              CtConst::CHAR_MINUS + std::to_string(zoom) +
-                              CtConst::CHAR_MINUS + CtImageLatex::LatexSpecialFilename;
-    const fs::path tmp_filepath_tex = pCtMainWin->get_ct_tmp()->getHiddenFilePath(filename);
-    Glib::file_set_contents(tmp_filepath_tex.string(), latexText);
+    const fs::path tmp_dirpath{pTmpDir};
+    g_free(pTmpDir);
+    return tmp_dirpath;
+}
+
+static bool run_latex(const fs::path& tmp_filepath_tex, std::string& cmd)
+{
     const fs::path tmp_dirpath = tmp_filepath_tex.parent_path();
     const fs::path tex_basename = tmp_filepath_tex.filename();
     // https://github.com/giuspen/cherrytree/issues/2846
     // Enforce TeX-level file access restrictions even if macro-based regex filtering is bypassed.
     // openin_any/openout_any are set to paranoid mode and shell escape is disabled.
-    std::string cmd;
     bool success = false;
 #ifdef _WIN32
     cmd = fmt::sprintf("%s --interaction=batchmode -no-shell-escape --cnf-line=openin_any=p --cnf-line=openout_any=p -output-directory=%s %s"
@@ -647,50 +729,315 @@ static const char* get_dvipng_bin_cmd()
 #endif
     }
 #endif /* _WIN32 */
+    return success;
+}
+
+static bool run_dvipng(const fs::path& tmp_filepath_dvi, const fs::path& tmp_filepath_png, const int dpi, std::string& cmd)
+{
+    cmd = fmt::sprintf("%s -q -T tight -D %d %s -o %s"
+#ifndef _WIN32
+                       CONSOLE_SILENCE_OUTPUT
+#endif /* !_WIN32 */
+                       , get_dvipng_bin_cmd(), dpi, tmp_filepath_dvi.c_str(), tmp_filepath_png.c_str());
+    return CtMiscUtil::system_cmd(cmd.c_str(), CONSOLE_BIN_PREFIX);
+}
+
+/*static*/Glib::RefPtr<Gdk::Pixbuf> CtImageLatex::_get_latex_image(CtMainWin* pCtMainWin, const Glib::ustring& latexText, const int zoom)
+{
+    const int dpi = zoom * pCtMainWin->get_ct_config()->latexSizeDpi;
+    Glib::RefPtr<Gdk::Pixbuf> rPixbuf;
+    if (_get_latex_image_no_render(pCtMainWin, latexText, dpi, rPixbuf)) {
+        return rPixbuf;
+    }
+    const fs::path cacheFilepath = _get_cache_filepath(pCtMainWin, latexText, dpi);
+    RenderResult result{RenderResult::LatexFailed};
+    try {
+        result = _render_one(latexText, dpi, cacheFilepath);
+    }
+    catch (Glib::Error& error) {
+        spdlog::error("{} {}", __FUNCTION__, std::string(error.what()));
+    }
+    return _get_rendered_image(pCtMainWin, result, cacheFilepath);
+}
+
+/*static*/bool CtImageLatex::_get_latex_image_no_render(CtMainWin* pCtMainWin,
+                                                        const Glib::ustring& latexText,
+                                                        const int dpi,
+                                                        Glib::RefPtr<Gdk::Pixbuf>& rPixbuf)
+{
+    CtImageLatex::ensureRenderingBinariesTested();
+    if (not _renderingBinariesLatexOk or not _renderingBinariesDviPngOk) {
+        rPixbuf = _get_fallback_image(pCtMainWin, "ct_warning");
+        return true;
+    }
+    if (not _is_latex_text_safe(latexText)) {
+        // blocked: dangerous file I/O commands detected
+        rPixbuf = _get_fallback_image(pCtMainWin, "ct_warning");
+        return true;
+    }
+    const fs::path cacheFilepath = _get_cache_filepath(pCtMainWin, latexText, dpi);
+    if (fs::is_regular_file(cacheFilepath)) {
+        try {
+            rPixbuf = Gdk::Pixbuf::create_from_file(cacheFilepath.string());
+            return true;
+        }
+        catch (Glib::Error& error) {
+            // rendered again, overwriting it
+            spdlog::debug("{} {}", __FUNCTION__, std::string(error.what()));
+        }
+    }
+    return false;
+}
+
+/*static*/fs::path CtImageLatex::_get_cache_filepath(CtMainWin* pCtMainWin, const Glib::ustring& latexText, const int dpi)
+{
+    // the preamble is part of the latex text, the zoom of the dpi
+    const std::string cacheFilename = CtStorageMultiFile::get_blob_sha256sum(std::to_string(dpi) + "\n" + latexText.raw()) + ".png";
+    if (pCtMainWin->curr_doc_is_encrypted()) {
+        // no plain renders of an encrypted document outlive the session
+        return pCtMainWin->get_ct_tmp()->getHiddenDirPath("latex") / cacheFilename;
+    }
+    static const fs::path cacheDirpath = [](){
+        const fs::path dirpath = fs::get_cherrytree_cachedir() / "latex";
+        (void)g_mkdir_with_parents(dirpath.c_str(), 0700);
+        (void)g_chmod(dirpath.c_str(), 0700);
+        _evict_cache(dirpath);
+        return dirpath;
+    }();
+    return cacheDirpath / cacheFilename;
+}
+
+/*static*/void CtImageLatex::_evict_cache(const fs::path& cacheDirpath)
+{
+    // the oldest renders are dropped once per session, down to the cap
+    std::vector<std::pair<time_t, fs::path>> cacheFiles;
+    std::uintmax_t totBytes{0};
+    for (const fs::path& filepath : fs::get_dir_entries(cacheDirpath)) {
+        if (fs::is_regular_file(filepath)) {
+            totBytes += fs::file_size(filepath);
+            cacheFiles.emplace_back(fs::getmtime(filepath), filepath);
+        }
+    }
+    if (totBytes <= MaxCacheBytes) {
+        return;
+    }
+    std::sort(cacheFiles.begin(), cacheFiles.end());
+    for (const auto& cacheFile : cacheFiles) {
+        if (totBytes <= MaxCacheBytes) {
+            break;
+        }
+        const std::uintmax_t fileBytes = fs::file_size(cacheFile.second);
+        if (fs::remove(cacheFile.second)) {
+            totBytes -= std::min(fileBytes, totBytes);
+        }
+    }
+    spdlog::debug("{} {} down to {} bytes", __FUNCTION__, cacheDirpath.string(), totBytes);
+}
+
+/*static*/Glib::RefPtr<Gdk::Pixbuf> CtImageLatex::_get_fallback_image(CtMainWin* pCtMainWin, const char* stockImage)
+{
+#if GTKMM_MAJOR_VERSION < 4
+    return pCtMainWin->get_icon_theme()->load_icon(stockImage, 48);
+#else
+    (void)pCtMainWin;
+    (void)stockImage;
+    return Glib::RefPtr<Gdk::Pixbuf>{};
+#endif
+}
+
+/*static*/Glib::RefPtr<Gdk::Pixbuf> CtImageLatex::_get_rendered_image(CtMainWin* pCtMainWin, const RenderResult result, const fs::path& cacheFilepath)
+{
+    if (RenderResult::LatexFailed == result) {
+        return _get_fallback_image(pCtMainWin, "ct_bug");
+    }
+    if (RenderResult::DviPngFailed == result) {
+        _renderingBinariesDviPngOk = false;
+        return _get_fallback_image(pCtMainWin, "ct_warning");
+    }
+    try {
+        return Gdk::Pixbuf::create_from_file(cacheFilepath.string());
+    }
+    catch (Glib::Error& error) {
+        spdlog::error("{} {}", __FUNCTION__, std::string(error.what()));
+    }
+    return _get_fallback_image(pCtMainWin, "ct_warning");
+}
+
+/*static*/std::vector<CtImageLatex::RenderResult> CtImageLatex::_render_to_cache(const std::vector<Glib::ustring>& latexTexts,
+                                                                                 const int dpi,
+                                                                                 const std::vector<fs::path>& cacheFilepaths)
+{
+    std::vector<RenderResult> results(latexTexts.size(), RenderResult::Ok);
+    // the synchronous render may have been first
+    std::vector<size_t> toRender;
+    for (size_t i = 0; i < latexTexts.size(); ++i) {
+        if (not fs::is_regular_file(cacheFilepaths.at(i))) {
+            toRender.push_back(i);
+        }
+    }
+    if (toRender.size() > 1u) {
+        std::vector<Glib::ustring> batchTexts;
+        std::vector<fs::path> batchFilepaths;
+        for (const size_t i : toRender) {
+            batchTexts.push_back(latexTexts.at(i));
+            batchFilepaths.push_back(cacheFilepaths.at(i));
+        }
+        if (_render_batch(batchTexts, dpi, batchFilepaths)) {
+            return results;
+        }
+    }
+    // a single formula, or a batch that did not give one page per formula
+    for (const size_t i : toRender) {
+        results.at(i) = _render_one(latexTexts.at(i), dpi, cacheFilepaths.at(i));
+    }
+    return results;
+}
+
+/*static*/CtImageLatex::RenderResult CtImageLatex::_render_one(const Glib::ustring& latexText, const int dpi, const fs::path& cacheFilepath)
+{
+    CtTrace::Span ctTraceSpan{"latex_render"};
+    const fs::path tmp_dirpath = make_latex_tmp_dirpath();
+    if (tmp_dirpath.empty()) {
+        return RenderResult::LatexFailed;
+    }
+    auto on_scope_exit = scope_guard([&tmp_dirpath](void*) { (void)fs::remove_all(tmp_dirpath); });
+    const fs::path tmp_filepath_tex = tmp_dirpath / CtImageLatex::LatexSpecialFilename;
+    Glib::file_set_contents(tmp_filepath_tex.string(), latexText);
+    std::string cmd;
+    bool success = run_latex(tmp_filepath_tex, cmd);
     std::string tmp_filepath_noext = tmp_filepath_tex.string();
     tmp_filepath_noext = tmp_filepath_noext.substr(0, tmp_filepath_noext.size() - 3);
     const fs::path tmp_filepath_dvi = tmp_filepath_noext + "dvi";
     if (not success or not fs::is_regular_file(tmp_filepath_dvi)) {
         if (success) spdlog::debug("!! cmd '{}' ok but missing {}", cmd, tmp_filepath_dvi.c_str());
-        // fallback
-        #if GTKMM_MAJOR_VERSION < 4
-        return pCtMainWin->get_icon_theme()->load_icon("ct_bug", 48);
-        #else
-        return Glib::RefPtr<Gdk::Pixbuf>{};
-        #endif
+        return RenderResult::LatexFailed;
     }
     const fs::path tmp_filepath_png = tmp_filepath_noext + "png";
-    const int latexSizeDpi = zoom * pCtMainWin->get_ct_config()->latexSizeDpi;
-    cmd = fmt::sprintf("%s -q -T tight -D %d %s -o %s"
-#ifndef _WIN32
-                       CONSOLE_SILENCE_OUTPUT
-#endif /* !_WIN32 */
-                       , get_dvipng_bin_cmd(), latexSizeDpi, tmp_filepath_dvi.c_str(), tmp_filepath_png.c_str());
-    success = CtMiscUtil::system_cmd(cmd.c_str(), CONSOLE_BIN_PREFIX);
+    success = run_dvipng(tmp_filepath_dvi, tmp_filepath_png, dpi, cmd);
     if (not success or not fs::is_regular_file(tmp_filepath_png)) {
         if (success) spdlog::debug("!! cmd '{}' ok but missing {}", cmd, tmp_filepath_png.c_str());
-        _renderingBinariesDviPngOk = false;
-        // fallback
-        #if GTKMM_MAJOR_VERSION < 4
-        return pCtMainWin->get_icon_theme()->load_icon("ct_warning", 48);
-        #else
-        return Glib::RefPtr<Gdk::Pixbuf>{};
-        #endif
+        return RenderResult::DviPngFailed;
     }
-    Glib::RefPtr<Gdk::Pixbuf> rPixbuf;
-    try {
-        rPixbuf = Gdk::Pixbuf::create_from_file(tmp_filepath_png.c_str());
-        return rPixbuf;
+    (void)fs::move_file(tmp_filepath_png, cacheFilepath);
+    return RenderResult::Ok;
+}
+
+/*static*/bool CtImageLatex::_render_batch(const std::vector<Glib::ustring>& latexTexts, const int dpi, const std::vector<fs::path>& cacheFilepaths)
+{
+    CtTrace::Span ctTraceSpan{"latex_render_batch"};
+    std::string batchText = get_latex_preamble(latexTexts.front().raw());
+    for (const Glib::ustring& latexText : latexTexts) {
+        std::string body;
+        if (not get_latex_body(latexText.raw(), body)) {
+            return false;
+        }
+        // every formula on its own page, numbered as if rendered alone
+        batchText += "\n\\clearpage\\setcounter{page}{1}\\ifcsname c@equation\\endcsname\\setcounter{equation}{0}\\fi\n\\begingroup";
+        batchText += body;
+        batchText += "\\endgroup\n";
     }
-    catch (Glib::Error& error) {
-        spdlog::error("{} {}", __FUNCTION__, std::string(error.what()));
+    batchText += "\\clearpage\n" + LatexEndDocument + "\n";
+
+    const fs::path tmp_dirpath = make_latex_tmp_dirpath();
+    if (tmp_dirpath.empty()) {
+        return false;
     }
-    // fallback
-    #if GTKMM_MAJOR_VERSION < 4
-    return pCtMainWin->get_icon_theme()->load_icon("ct_warning", 48);
-    #else
-    return Glib::RefPtr<Gdk::Pixbuf>{};
-    #endif
+    auto on_scope_exit = scope_guard([&tmp_dirpath](void*) { (void)fs::remove_all(tmp_dirpath); });
+    const fs::path tmp_filepath_tex = tmp_dirpath / CtImageLatex::LatexSpecialFilename;
+    Glib::file_set_contents(tmp_filepath_tex.string(), batchText);
+    std::string cmd;
+    std::string tmp_filepath_noext = tmp_filepath_tex.string();
+    tmp_filepath_noext = tmp_filepath_noext.substr(0, tmp_filepath_noext.size() - 4);
+    const fs::path tmp_filepath_dvi = tmp_filepath_noext + ".dvi";
+    if (not run_latex(tmp_filepath_tex, cmd) or not fs::is_regular_file(tmp_filepath_dvi)) {
+        return false;
+    }
+    // dvipng writes one png per page, numbered from 1
+    if (not run_dvipng(tmp_filepath_dvi, tmp_filepath_noext + "%d.png", dpi, cmd)) {
+        return false;
+    }
+    auto f_page_filepath = [&](const size_t pageNum) { return fs::path{tmp_filepath_noext + std::to_string(pageNum) + ".png"}; };
+    for (size_t i = 0; i < latexTexts.size(); ++i) {
+        if (not fs::is_regular_file(f_page_filepath(i + 1))) {
+            return false;
+        }
+    }
+    if (fs::is_regular_file(f_page_filepath(latexTexts.size() + 1))) {
+        return false;
+    }
+    for (size_t i = 0; i < latexTexts.size(); ++i) {
+        (void)fs::move_file(f_page_filepath(i + 1), cacheFilepaths.at(i));
+    }
+    return true;
+}
+
+/*static*/void CtImageLatex::_flush_pending_renders()
+{
+    // the latex processes are heavy, only a few at a time and on threads of their own, so that
+    // the tasks of the global pool that the gui thread waits for never queue behind a render
+    static CtThreadPool renderThreadPool{MaxConcurrentRenders};
+    static CtThreadPool::TaskGroup renderTaskGroup{renderThreadPool};
+
+    std::vector<RenderRequest> pendingRenders;
+    std::swap(pendingRenders, _pendingRenders);
+    // one batch per preamble and resolution, the formulas without a preamble on their own
+    std::vector<std::vector<RenderRequest>> batches;
+    for (RenderRequest& request : pendingRenders) {
+        if (not *request.pImageLatex) {
+            continue; // destroyed meanwhile
+        }
+        request.preamble = get_latex_preamble(request.latexText.raw());
+        auto itBatch = std::find_if(batches.begin(), batches.end(), [&request](const std::vector<RenderRequest>& batch){
+            return not request.preamble.empty() and
+                   batch.size() < MaxBatchedRenders and
+                   batch.front().dpi == request.dpi and
+                   batch.front().preamble == request.preamble;
+        });
+        if (itBatch != batches.end()) {
+            itBatch->push_back(std::move(request));
+        }
+        else {
+            batches.push_back(std::vector<RenderRequest>{});
+            batches.back().push_back(std::move(request));
+        }
+    }
+    for (std::vector<RenderRequest>& batch : batches) {
+        renderTaskGroup.run([batch = std::move(batch)]() mutable {
+            std::vector<Glib::ustring> latexTexts;
+            std::vector<fs::path> cacheFilepaths;
+            for (const RenderRequest& request : batch) {
+                latexTexts.push_back(request.latexText);
+                cacheFilepaths.push_back(request.cacheFilepath);
+            }
+            try {
+                const std::vector<RenderResult> results = _render_to_cache(latexTexts, batch.front().dpi, cacheFilepaths);
+                for (size_t i = 0; i < batch.size(); ++i) {
+                    batch.at(i).result = results.at(i);
+                }
+            }
+            catch (Glib::Error& error) {
+                spdlog::error("{} {}", __FUNCTION__, std::string(error.what()));
+            }
+            catch (std::exception& e) {
+                spdlog::error("{} {}", __FUNCTION__, e.what());
+            }
+            // back to the main thread for the widgets
+            g_idle_add(&CtImageLatex::_on_renders_done, new std::vector<RenderRequest>(std::move(batch)));
+        });
+    }
+}
+
+/*static*/gboolean CtImageLatex::_on_renders_done(gpointer pData)
+{
+    std::unique_ptr<std::vector<RenderRequest>> pRequests{static_cast<std::vector<RenderRequest>*>(pData)};
+    for (const RenderRequest& request : *pRequests) {
+        if (CtImageLatex* pImageLatex = *request.pImageLatex) {
+            pImageLatex->_rPixbuf = _get_rendered_image(pImageLatex->_pCtMainWin, request.result, request.cacheFilepath);
+            pImageLatex->_image.set(pImageLatex->_rPixbuf);
+            pImageLatex->_renderPending = false;
+        }
+    }
+    return G_SOURCE_REMOVE;
 }
 
 /*static*/void CtImageLatex::ensureRenderingBinariesTested()
@@ -831,7 +1178,7 @@ void CtImageEmbFile::_checkNonEmptyRawBlob(const char* multifile_dir)
 
 void CtImageEmbFile::to_xml(xmlpp::Element* p_node_parent,
                             const int offset_adjustment,
-                            CtStorageCache*,
+                            CtStorageCache* storage_cache,
                             const std::string& multifile_dir)
 {
     xmlpp::Element* p_image_node = p_node_parent->add_child("encoded_png");
@@ -841,8 +1188,11 @@ void CtImageEmbFile::to_xml(xmlpp::Element* p_node_parent,
     p_image_node->set_attribute("time", std::to_string(_timeSeconds));
     if (multifile_dir.empty()) {
         // target is not multifile
-        _checkNonEmptyRawBlob(nullptr/*multifile_dir*/);
-        const std::string encodedBlob = Glib::Base64::encode(_rawBlob);
+        std::string encodedBlob;
+        if (not storage_cache or not storage_cache->get_cached_embfile(this, encodedBlob)) {
+            _checkNonEmptyRawBlob(nullptr/*multifile_dir*/);
+            encodedBlob = Glib::Base64::encode(_rawBlob);
+        }
         p_image_node->add_child_text(encodedBlob);
     }
     else {
@@ -866,19 +1216,22 @@ void CtImageEmbFile::to_xml(xmlpp::Element* p_node_parent,
         }
         else {
             // save as multifile with sha256 as name
-            _checkNonEmptyRawBlob(multifile_dir.c_str());
-            const std::string sha256sum = CtStorageMultiFile::save_blob(_rawBlob, multifile_dir, _fileName.extension());
+            std::string sha256sum;
+            if (not storage_cache or not storage_cache->get_cached_sha256sum(this, sha256sum)) {
+                _checkNonEmptyRawBlob(multifile_dir.c_str());
+            }
+            sha256sum = CtStorageMultiFile::save_blob(_rawBlob, multifile_dir, _fileName.extension(), sha256sum);
             p_image_node->set_attribute("sha256sum", sha256sum);
         }
     }
 }
 
-bool CtImageEmbFile::to_sqlite(sqlite3* pDb, const gint64 node_id, const int offset_adjustment, CtStorageCache*)
+bool CtImageEmbFile::to_sqlite(CtSqliteStmtCache* pStmtCache, const gint64 node_id, const int offset_adjustment, CtStorageCache*)
 {
     bool retVal{true};
-    sqlite3_stmt *p_stmt;
-    if (sqlite3_prepare_v2(pDb, CtStorageSqlite::TABLE_IMAGE_INSERT, -1, &p_stmt, nullptr) != SQLITE_OK) {
-        spdlog::error("{}: {}", CtStorageSqlite::ERR_SQLITE_PREPV2, sqlite3_errmsg(pDb));
+    sqlite3_stmt* p_stmt = pStmtCache->get(CtStorageSqlite::TABLE_IMAGE_INSERT);
+    if (not p_stmt) {
+        spdlog::error("{}: {}", CtStorageSqlite::ERR_SQLITE_PREPV2, sqlite3_errmsg(pStmtCache->get_db()));
         retVal = false;
     }
     else {
@@ -893,10 +1246,9 @@ bool CtImageEmbFile::to_sqlite(sqlite3* pDb, const gint64 node_id, const int off
         sqlite3_bind_text(p_stmt, 7, "", -1, SQLITE_STATIC); // link
         sqlite3_bind_int64(p_stmt, 8, _timeSeconds);
         if (sqlite3_step(p_stmt) != SQLITE_DONE) {
-            spdlog::error("{}: {}", CtStorageSqlite::ERR_SQLITE_STEP, sqlite3_errmsg(pDb));
+            spdlog::error("{}: {}", CtStorageSqlite::ERR_SQLITE_STEP, sqlite3_errmsg(pStmtCache->get_db()));
             retVal = false;
         }
-        sqlite3_finalize(p_stmt);
     }
     return retVal;
 }
@@ -27,6 +27,9 @@
 #include "ct_const.h"
 #include "ct_codebox.h"
 #include "ct_widgets.h"
+#include <memory>
+#include <mutex>
+#include <vector>
 
 class CtImage : public CtAnchoredWidget
 {
@@ -52,7 +55,7 @@ public:
     void set_modified_false() override {}
 
     void save(const fs::path& file_name, const Glib::ustring& type);
-    Glib::RefPtr<Gdk::Pixbuf> get_pixbuf() const { return _rPixbuf; }
+    virtual Glib::RefPtr<Gdk::Pixbuf> get_pixbuf() const { return _rPixbuf; }
 
 protected:
     Gtk::Image _image;
@@ -71,15 +74,22 @@ public:
                Glib::RefPtr<Gdk::Pixbuf> pixBuf,
                const Glib::ustring& link,
                const int charOffset,
-               const std::string& justification);
+               const std::string& justification,
+               std::shared_ptr<const std::string> pRawBlob = nullptr/*the png of pixBuf if at hand*/);
     ~CtImagePng() override {}
 
     void to_xml(xmlpp::Element* p_node_parent, const int offset_adjustment, CtStorageCache* cache, const std::string& multifile_dir) override;
-    bool to_sqlite(sqlite3* pDb, const gint64 node_id, const int offset_adjustment, CtStorageCache* cache) override;
+    bool to_sqlite(CtSqliteStmtCache* pStmtCache, const gint64 node_id, const int offset_adjustment, CtStorageCache* cache) override;
     CtAnchWidgType get_type() const override { return CtAnchWidgType::ImagePng; }
     std::shared_ptr<CtAnchoredWidgetState> get_state() override;
 
-    const std::string get_raw_blob();
+    // the png as loaded or pasted, the pixbuf is encoded only if there was none
+    const std::string& get_raw_blob();
+    const std::string& get_raw_blob_sha256sum();
+    // nullptr if the png is not at hand yet
+    std::shared_ptr<const std::string> get_raw_blob_ptr() const;
+    // writes the png as it is, throws on failure
+    void save_raw_blob(const fs::path& file_path);
     void update_label_widget();
     const Glib::ustring& get_link() const { return _link; }
     void set_link(const Glib::ustring& link) { _link = link; }
@@ -91,6 +101,10 @@ private:
 
 protected:
     Glib::ustring _link;
+    // the pixels of a CtImagePng never change, an edited image is a new widget
+    std::shared_ptr<const std::string> _pRawBlob;
+    std::string _rawBlobSha256sum;
+    mutable std::mutex _rawBlobMutex; // the storage cache encodes on the thread pool
 };
 
 class CtImageAnchor : public CtImage
@@ -104,7 +118,7 @@ public:
     ~CtImageAnchor() override {}
 
     void to_xml(xmlpp::Element* p_node_parent, const int offset_adjustment, CtStorageCache* cache, const std::string& multifile_dir) override;
-    bool to_sqlite(sqlite3* pDb, const gint64 node_id, const int offset_adjustment, CtStorageCache* cache) override;
+    bool to_sqlite(CtSqliteStmtCache* pStmtCache, const gint64 node_id, const int offset_adjustment, CtStorageCache* cache) override;
     CtAnchWidgType get_type() const override { return CtAnchWidgType::ImageAnchor; }
     std::shared_ptr<CtAnchoredWidgetState> get_state() override;
 
@@ -124,6 +138,12 @@ protected:
     CtAnchorExpCollState _expCollState;
 };
 
+/**
+ * @brief LaTeX formula shown as the png rendered by latex and dvipng
+ * The pngs are cached on disk by hash of the latex text and resolution; on a cache miss the widget
+ * shows a placeholder while the formulas created in the same main loop iteration, i.e. of the same node,
+ * are rendered in the background, batched in one latex run when they share the preamble.
+ */
 class CtImageLatex : public CtImage
 {
 public:
@@ -132,30 +152,55 @@ public:
                  const int charOffset,
                  const std::string& justification,
                  const size_t uniqueId);
-    ~CtImageLatex() override {}
+    ~CtImageLatex() override;
 
     static const std::string LatexSpecialFilename;
     static const Glib::ustring LatexTextDefault;
     static const int PrintZoom;
+    static const size_t MaxConcurrentRenders;
+    static const size_t MaxBatchedRenders;
+    static const std::uintmax_t MaxCacheBytes;
 
     static void ensureRenderingBinariesTested();
     static Glib::ustring getRenderingErrorMessage(const Glib::ustring* pLatexText = nullptr);
 
     void to_xml(xmlpp::Element* p_node_parent, const int offset_adjustment, CtStorageCache* cache, const std::string& multifile_dir) override;
-    bool to_sqlite(sqlite3* pDb, const gint64 node_id, const int offset_adjustment, CtStorageCache* cache) override;
+    bool to_sqlite(CtSqliteStmtCache* pStmtCache, const gint64 node_id, const int offset_adjustment, CtStorageCache* cache) override;
     CtAnchWidgType get_type() const override { return CtAnchWidgType::ImageLatex; }
     std::shared_ptr<CtAnchoredWidgetState> get_state() override;
 
+    // while the background render is pending, the formula is rendered now rather than the placeholder returned
+    Glib::RefPtr<Gdk::Pixbuf> get_pixbuf() const override;
     const Glib::ustring& get_latex_text() { return _latexText; }
     size_t               get_unique_id() { return _uniqueId; }
     Glib::RefPtr<Gdk::Pixbuf> get_image_for_print() const {
-        return _get_latex_image(_pCtMainWin, _latexText, _uniqueId, PrintZoom);
+        return _get_latex_image(_pCtMainWin, _latexText, PrintZoom);
     }
 
     void update_tooltip();
 
 private:
-    static Glib::RefPtr<Gdk::Pixbuf> _get_latex_image(CtMainWin* pCtMainWin, const Glib::ustring& latexText, const size_t uniqueId, const int zoom = 1);
+    enum class RenderResult { Ok, LatexFailed, DviPngFailed };
+    struct RenderRequest;
+
+    static Glib::RefPtr<Gdk::Pixbuf> _get_latex_image(CtMainWin* pCtMainWin, const Glib::ustring& latexText, const int zoom);
+    // true if the image is known without rendering: cached, or a fallback icon
+    static bool _get_latex_image_no_render(CtMainWin* pCtMainWin,
+                                           const Glib::ustring& latexText,
+                                           const int dpi,
+                                           Glib::RefPtr<Gdk::Pixbuf>& rPixbuf);
+    static fs::path _get_cache_filepath(CtMainWin* pCtMainWin, const Glib::ustring& latexText, const int dpi);
+    static void _evict_cache(const fs::path& cacheDirpath);
+    static Glib::RefPtr<Gdk::Pixbuf> _get_fallback_image(CtMainWin* pCtMainWin, const char* stockImage);
+    static Glib::RefPtr<Gdk::Pixbuf> _get_rendered_image(CtMainWin* pCtMainWin, const RenderResult result, const fs::path& cacheFilepath);
+    // thread safe, the latex texts are expected to share the preamble
+    static std::vector<RenderResult> _render_to_cache(const std::vector<Glib::ustring>& latexTexts,
+                                                      const int dpi,
+                                                      const std::vector<fs::path>& cacheFilepaths);
+    static RenderResult _render_one(const Glib::ustring& latexText, const int dpi, const fs::path& cacheFilepath);
+    static bool _render_batch(const std::vector<Glib::ustring>& latexTexts, const int dpi, const std::vector<fs::path>& cacheFilepaths);
+    static void _flush_pending_renders();
+    static gboolean _on_renders_done(gpointer pData);
     static bool _is_latex_text_safe(const Glib::ustring& latexText);
 
 private:
@@ -167,8 +212,12 @@ protected:
     static bool   _renderingBinariesTested;
     static bool   _renderingBinariesLatexOk;
     static bool   _renderingBinariesDviPngOk;
+    static std::vector<RenderRequest> _pendingRenders;
     Glib::ustring _latexText;
     const size_t  _uniqueId;
+    bool          _renderPending{false};
+    // shared with the background renders, reset on destruction
+    std::shared_ptr<CtImageLatex*> _pSelf;
 };
 
 class CtImageEmbFile : public CtImage
@@ -185,7 +234,7 @@ public:
     ~CtImageEmbFile() override {}
 
     void to_xml(xmlpp::Element* p_node_parent, const int offset_adjustment, CtStorageCache* cache, const std::string& multifile_dir) override;
-    bool to_sqlite(sqlite3* pDb, const gint64 node_id, const int offset_adjustment, CtStorageCache* cache) override;
+    bool to_sqlite(CtSqliteStmtCache* pStmtCache, const gint64 node_id, const int offset_adjustment, CtStorageCache* cache) override;
     CtAnchWidgType get_type() const override { return CtAnchWidgType::ImageEmbFile; }
     std::shared_ptr<CtAnchoredWidgetState> get_state() override;
 
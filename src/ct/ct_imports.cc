@@ -28,6 +28,7 @@
 #include "ct_export2html.h"
 #include "ct_logging.h"
 #include <libxml2/libxml/SAX.h>
+#include <chrono>
 
 namespace {
 
@@ -170,17 +171,90 @@ std::vector<std::pair<size_t, size_t>> CtImports::get_web_links_offsets_from_pla
     return web_links;
 }
 
-std::unique_ptr<CtImportedNode> CtImports::traverse_dir(const fs::path& dir, CtImporterInterface* importer)
+namespace {
+
+// a directory with its entries in order, a file entry gets its node from the importer
+struct CtScannedDir
+{
+    struct Entry
+    {
+        fs::path                        path;
+        std::unique_ptr<CtScannedDir>   pSubdir;
+        std::unique_ptr<CtImportedNode> pNode;
+    };
+    fs::path           path;
+    std::vector<Entry> entries;
+};
+
+void scan_dir(CtScannedDir& scannedDir, std::vector<CtScannedDir::Entry*>& fileEntries)
+{
+    for (const auto& dir_item : fs::get_dir_entries(scannedDir.path)) {
+        CtScannedDir::Entry& entry = scannedDir.entries.emplace_back();
+        entry.path = dir_item;
+        if (fs::is_directory(dir_item)) {
+            entry.pSubdir = std::make_unique<CtScannedDir>();
+            entry.pSubdir->path = dir_item;
+        }
+    }
+    for (CtScannedDir::Entry& entry : scannedDir.entries) {
+        if (entry.pSubdir) scan_dir(*entry.pSubdir, fileEntries);
+        else fileEntries.push_back(&entry);
+    }
+}
+
+// children with the same names, one with content and other as dir, join them
+void join_subdir_subnote(std::unique_ptr<CtImportedNode>& node)
+{
+    // the dir nodes by name in order, so that a note joins the first dir with its name
+    std::unordered_map<std::string, std::deque<std::list<std::unique_ptr<CtImportedNode>>::iterator>> dirsByName;
+    for (auto iter = node->children.begin(); iter != node->children.end(); ++iter) {
+        if (!(*iter)->has_content()) {
+            dirsByName[(*iter)->node_name.raw()].push_back(iter);
+        }
+    }
+    if (!dirsByName.empty()) {
+        for (auto& child : node->children) {
+            if (child->has_content() && child->children.empty()) // node with content
+            {
+                auto iterDirs = dirsByName.find(child->node_name.raw());
+                if (iterDirs != dirsByName.end() && !iterDirs->second.empty()) {
+                    auto iterDir = iterDirs->second.front();
+                    iterDirs->second.pop_front();
+                    std::swap(child->children, (*iterDir)->children);
+                    node->children.erase(iterDir);
+                }
+            }
+        }
+    }
+    for (auto& child : node->children)
+        join_subdir_subnote(child);
+}
+
+// dir contains note with the same name, join them (from keepnote)
+void join_parent_dir_subnote(std::unique_ptr<CtImportedNode>& node)
 {
-    auto dir_node = std::make_unique<CtImportedNode>(dir, dir.filename().string());
-    for (const auto& dir_item: fs::get_dir_entries(dir))
+    if (!node->has_content())
     {
-        if (fs::is_directory(dir_item))
+        for (auto iter = node->children.begin(); iter != node->children.end(); ++iter)
         {
-            if (auto node = traverse_dir(dir_item, importer))
-                dir_node->children.emplace_back(std::move(node));
+            if ((*iter)->has_content() && (*iter)->children.empty() && node->node_name == (*iter)->node_name)
+            {
+                node->copy_content((*iter));
+                node->children.erase(iter);
+                break;
+            }
         }
-        else if (auto node = importer->import_file(dir_item))
+    }
+    for (auto& child : node->children)
+        join_parent_dir_subnote(child);
+}
+
+std::unique_ptr<CtImportedNode> assemble_dir(CtScannedDir& scannedDir)
+{
+    auto dir_node = std::make_unique<CtImportedNode>(scannedDir.path, scannedDir.path.filename().string());
+    for (CtScannedDir::Entry& entry : scannedDir.entries)
+    {
+        if (auto node = entry.pSubdir ? assemble_dir(*entry.pSubdir) : std::move(entry.pNode))
             dir_node->children.emplace_back(std::move(node));
     }
 
@@ -188,58 +262,100 @@ std::unique_ptr<CtImportedNode> CtImports::traverse_dir(const fs::path& dir, CtI
     if (dir_node->children.empty())
         return nullptr;
 
-    // not the best place but
-    // two cases:
-    // 1. children with the same names, one with content and other as dir, join them
-    // 2. dir contains  note with the same name, join them (from keepnote)
+    join_subdir_subnote(dir_node);
+    join_parent_dir_subnote(dir_node);
 
-    std::function<void(std::unique_ptr<CtImportedNode>&)> join_subdir_subnote;
-    join_subdir_subnote = [&](std::unique_ptr<CtImportedNode>& node) {
-        for (auto iter1 = node->children.begin(); iter1 != node->children.end(); ++iter1)
-        {
-            if ((*iter1)->has_content() && (*iter1)->children.empty()) // node with content
-            {
-                for (auto iter2 = node->children.begin(); iter2 != node->children.end(); ++iter2)
+    return dir_node;
+}
+
+} // namespace (anonymous)
+
+std::unique_ptr<CtImportedNode> CtImports::traverse_dir(const fs::path& dir,
+                                                        CtImporterInterface* importer,
+                                                        const std::function<bool(const size_t, const size_t)>& f_progress/*= nullptr*/)
+{
+    CtScannedDir scannedDir{dir, {}};
+    std::vector<CtScannedDir::Entry*> fileEntries;
+    scan_dir(scannedDir, fileEntries);
+
+    // the importers keep the state of the file being parsed, one for each worker
+    std::vector<std::unique_ptr<CtImporterInterface>> threadImporters;
+    const size_t numWorkers = std::min(CtThreadPool::get_global().get_num_threads(), fileEntries.size());
+    for (size_t i = 0; numWorkers > 1u and i < numWorkers; ++i) {
+        std::unique_ptr<CtImporterInterface> pThreadImporter = importer->clone_for_thread();
+        if (not pThreadImporter) {
+            threadImporters.clear();
+            break;
+        }
+        threadImporters.push_back(std::move(pThreadImporter));
+    }
+
+    if (threadImporters.empty()) {
+        for (size_t i = 0; i < fileEntries.size(); ++i) {
+            if (f_progress and not f_progress(i, fileEntries.size())) {
+                return nullptr;
+            }
+            fileEntries[i]->pNode = importer->import_file(fileEntries[i]->path);
+        }
+    }
+    else {
+        std::mutex mutex;
+        std::condition_variable condVar;
+        size_t filesDone{0};
+        bool progressCancelled{false};
+        std::vector<CtImporterInterface*> freeImporters;
+        for (auto& pThreadImporter : threadImporters) {
+            freeImporters.push_back(pThreadImporter.get());
+        }
+        CtThreadPool::TaskGroup taskGroup{CtThreadPool::get_global(), threadImporters.size()};
+        for (CtScannedDir::Entry* pEntry : fileEntries) {
+            taskGroup.run([&, pEntry](){
+                CtImporterInterface* pThreadImporter{nullptr};
                 {
-                    if (!(*iter2)->has_content()) // dir node
+                    // no more tasks than importers are running
+                    std::lock_guard<std::mutex> lock{mutex};
+                    pThreadImporter = freeImporters.back();
+                    freeImporters.pop_back();
+                }
+                auto on_scope_exit = scope_guard([&](void*) {
                     {
-                        if (iter1->get() == iter2->get()) continue; // same node?
-                        if ((*iter1)->node_name == (*iter2)->node_name)
-                        {
-                            std::swap((*iter1)->children, (*iter2)->children);
-                            node->children.erase(iter2);
-                            break;
-                        }
+                        std::lock_guard<std::mutex> lock{mutex};
+                        freeImporters.push_back(pThreadImporter);
+                        ++filesDone;
                     }
+                    condVar.notify_all();
+                });
+                if (not taskGroup.is_cancelled()) {
+                    pEntry->pNode = pThreadImporter->import_file(pEntry->path);
                 }
-            }
+            });
         }
-        for (auto& child: node->children)
-            join_subdir_subnote(child);
-    };
-
-    std::function<void(std::unique_ptr<CtImportedNode>&)> join_parent_dir_subnote;
-    join_parent_dir_subnote = [&](std::unique_ptr<CtImportedNode>& node) {
-        if (!node->has_content())
         {
-            for (auto iter = node->children.begin(); iter != node->children.end(); ++iter)
-            {
-                if ((*iter)->has_content() && (*iter)->children.empty() && node->node_name == (*iter)->node_name)
-                {
-                    node->copy_content((*iter));
-                    node->children.erase(iter);
-                    break;
+            std::unique_lock<std::mutex> lock{mutex};
+            while (filesDone < fileEntries.size() and not taskGroup.is_cancelled()) {
+                condVar.wait_for(lock, std::chrono::milliseconds{100});
+                if (f_progress) {
+                    const size_t currFilesDone = filesDone;
+                    lock.unlock();
+                    progressCancelled = not f_progress(currFilesDone, fileEntries.size());
+                    lock.lock();
+                    if (progressCancelled) {
+                        taskGroup.cancel();
+                    }
                 }
             }
         }
-        for (auto& child: node->children)
-            join_parent_dir_subnote(child);
-    };
-
-    join_subdir_subnote(dir_node);
-    join_parent_dir_subnote(dir_node);
+        // rethrows the first exception of a file import
+        taskGroup.wait();
+        if (progressCancelled) {
+            return nullptr;
+        }
+    }
+    if (f_progress and not f_progress(fileEntries.size(), fileEntries.size())) {
+        return nullptr;
+    }
 
-    return dir_node;
+    return assemble_dir(scannedDir);
 }
 
 CtHtmlImport::CtHtmlImport(CtConfig* config) : _config{config}
@@ -423,7 +539,7 @@ xmlpp::Element* CtTomboyImport::_rich_text_serialize(const Glib::ustring& text_d
     return dom_iter;
 }
 
-CtZimImport::CtZimImport(CtConfig* config) : _zim_parser{std::make_unique<CtZimParser>(config)} {}
+CtZimImport::CtZimImport(CtConfig* config) : _config{config}, _zim_parser{std::make_unique<CtZimParser>(config)} {}
 
 std::unique_ptr<CtImportedNode> CtZimImport::import_file(const fs::path& file)
 {
@@ -466,7 +582,7 @@ std::unique_ptr<CtImportedNode> CtPlainTextImport::import_file(const fs::path& f
     return nullptr;
 }
 
-CtMDImport::CtMDImport(CtConfig* config) : _parser{std::make_unique<CtMDParser>(config)}
+CtMDImport::CtMDImport(CtConfig* config) : _config{config}, _parser{std::make_unique<CtMDParser>(config)}
 {
 }
 
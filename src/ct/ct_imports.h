@@ -29,6 +29,7 @@
 #include <glibmm/ustring.h>
 #include <libxml2/libxml/HTMLparser.h>
 #include <libxml++/libxml++.h>
+#include <functional>
 #include <queue>
 #include <utility>
 #include <glibmm/i18n.h>
@@ -68,7 +69,11 @@ struct CtImportedNode
 class CtImporterInterface
 {
 public:
+    virtual ~CtImporterInterface() = default;
+
     virtual std::unique_ptr<CtImportedNode> import_file(const fs::path& file) = 0;
+    // a new importer for a worker thread, nullptr if the files are to be imported one at a time by this one
+    virtual std::unique_ptr<CtImporterInterface> clone_for_thread() const { return nullptr; }
     virtual std::string                     file_pattern_name() { return ""; }
     virtual std::vector<Glib::ustring>      file_patterns() { return {}; }
     virtual std::vector<Glib::ustring>      file_mime_types() { return {}; }
@@ -89,7 +94,14 @@ public:
 namespace CtImports {
 
 std::vector<std::pair<size_t, size_t>> get_web_links_offsets_from_plain_text(const Glib::ustring& plain_text);
-std::unique_ptr<CtImportedNode> traverse_dir(const fs::path& dir, CtImporterInterface* importer);
+/**
+ * @brief Import the files of a directory tree, parsed in parallel by the importer clones on the thread pool
+ * @param f_progress called on this thread while waiting, with the files done and total, returns false to cancel
+ * @return nullptr if no file was imported or on cancel
+ */
+std::unique_ptr<CtImportedNode> traverse_dir(const fs::path& dir,
+                                             CtImporterInterface* importer,
+                                             const std::function<bool(const size_t, const size_t)>& f_progress = nullptr);
 
 } // namespace CtImports
 
@@ -121,6 +133,7 @@ public:
 
     // virtuals of CtImporterInterface
     std::unique_ptr<CtImportedNode> import_file(const fs::path& file) override;
+    std::unique_ptr<CtImporterInterface> clone_for_thread() const override { return std::make_unique<CtHtmlImport>(_config); }
 
 private:
     CtConfig* _config;
@@ -134,6 +147,7 @@ public:
 public:
     // virtuals of CtImporterInterface
     std::unique_ptr<CtImportedNode> import_file(const fs::path& file) override;
+    std::unique_ptr<CtImporterInterface> clone_for_thread() const override { return std::make_unique<CtTomboyImport>(_config); }
 
 private:
     void            _iterate_tomboy_note(xmlpp::Element* iter, std::unique_ptr<CtImportedNode>& node);
@@ -161,10 +175,12 @@ public:
 
     // virtuals of CtImporterInterface
     std::unique_ptr<CtImportedNode> import_file(const fs::path& file) override;
+    std::unique_ptr<CtImporterInterface> clone_for_thread() const override { return std::make_unique<CtZimImport>(_config); }
 
     ~CtZimImport();
 
 private:
+    CtConfig*                    _config;
     std::unique_ptr<CtZimParser> _zim_parser;
 };
 
@@ -175,6 +191,7 @@ public:
 
     // virtuals of CtImporterInterface
     std::unique_ptr<CtImportedNode> import_file(const fs::path& file) override;
+    std::unique_ptr<CtImporterInterface> clone_for_thread() const override { return std::make_unique<CtPlainTextImport>(nullptr); }
     std::string                     file_pattern_name() override { return _("Plain Text Document"); }
 #ifdef _WIN32
     std::vector<Glib::ustring>      file_patterns() override { return {"*.txt"}; }
@@ -192,10 +209,12 @@ public:
 
     // virtuals of CtImporterInterface
     std::unique_ptr<CtImportedNode> import_file(const fs::path& file) override;
+    std::unique_ptr<CtImporterInterface> clone_for_thread() const override { return std::make_unique<CtMDImport>(_config); }
     std::vector<Glib::ustring>        file_patterns() override { return {"*.md"}; };
     std::string                       file_pattern_name() override { return _("Markdown Document"); }
 
 private:
+    CtConfig*                   _config;
     std::unique_ptr<CtMDParser> _parser;
 };
 
@@ -204,6 +223,7 @@ class CtKeepnoteImport : public CtImporterInterface
 public:
     explicit CtKeepnoteImport(CtConfig* config) : _config(config) {}
     std::unique_ptr<CtImportedNode> import_file(const fs::path& file) override;
+    std::unique_ptr<CtImporterInterface> clone_for_thread() const override { return std::make_unique<CtKeepnoteImport>(_config); }
 
 private:
     CtConfig* _config;
@@ -25,8 +25,10 @@
 #include "ct_misc_utils.h"
 #include "config.h"
 #include "ct_logging.h"
+#include "ct_trace.h"
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/sinks/rotating_file_sink.h>
+#include <curl/curl.h>
 #if defined(_WIN32)
 #include <locale>
 #include <codecvt>
@@ -143,6 +145,17 @@ int main(int argc, char *argv[])
         }
     }
 
+    const std::string trace_filepath = Glib::getenv("CHERRYTREE_TRACE");
+    if (not trace_filepath.empty()) {
+        CtTrace::start(trace_filepath); // the command line option --trace overrides
+    }
+
+    // before any thread, fs::download_file() runs in the pool threads
+    curl_global_init(CURL_GLOBAL_ALL);
+
     Glib::RefPtr<CtApp> r_app = CtApp::create(is_secondary_session ? "_2" : "");
-    return r_app->run(argc, argv);
+    const int ret_val = r_app->run(argc, argv);
+    CtTrace::stop();
+    curl_global_cleanup();
+    return ret_val;
 }
@@ -1455,6 +1455,7 @@ void CtMainWin::reset()
     _ctStateMachine.reset();
 
     _uCtStorage.reset(CtStorageControl::create_dummy_storage(this));
+    _currDocIsEncrypted = false;
 
     _reset_CtTreestore_CtTreeview();
 
@@ -1542,6 +1543,12 @@ void CtMainWin::update_selected_node_statusbar_info()
         if (direct_children_count != total_children_count) {
             statusbar_text += CtConst::CHAR_SLASH + std::to_string(total_children_count);
         }
+        if (_pCtConfig->loadedNodesMemMb > 0) {
+            statusbar_text += separator_text + _("Loaded Nodes") + _(": ") + fmt::format("{} ({:.1f}/{} MB)",
+                _uCtTreestore->loaded_buffers_count(),
+                static_cast<double>(_uCtTreestore->loaded_buffers_bytes())/(1024*1024),
+                _pCtConfig->loadedNodesMemMb);
+        }
     }
     _ctStatusBar.update_status(statusbar_text);
 }
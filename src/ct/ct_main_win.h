@@ -166,6 +166,7 @@ public:
     bool&         user_active()      { return _userActive; } // use as a function, because it's easier to put breakpoint
     bool&         force_exit()       { return _forceExit; }
     bool          no_gui()           { return _no_gui; }
+    bool          curr_doc_is_encrypted() { return _currDocIsEncrypted; } // already while it is loaded
     int&          cursor_key_press() { return _cursorKeyPress; }
     int&          hovering_link_iter_offset() { return _hovering_link_iter_offset; }
     void          tree_clear_expanded_nodes() { _treeExpandedNodeIds.clear(); }
@@ -272,6 +273,8 @@ private:
 #endif
 
     void _on_treeview_cursor_changed(); // pygtk: on_node_changed
+    // read in background the bodies of the nodes likely selected next
+    void _prefetch_neighbour_nodes(const CtTreeIter& treeIter);
 #if GTKMM_MAJOR_VERSION < 4
     bool _on_treeview_button_release_event(GdkEventButton* event);
     void _on_treeview_event_after(GdkEvent* event); // pygtk: on_event_after_tree
@@ -391,6 +394,7 @@ private:
     bool                _userActive{true}; // pygtk: user_active
     bool                _isUpdatingStatusbarInfo{false};
     bool                _forceExit{false};
+    bool                _currDocIsEncrypted{false};
     int                 _cursorKeyPress{-1};
     int                 _autoSaveCounter{0};
     int                 _hovering_link_iter_offset{-1};
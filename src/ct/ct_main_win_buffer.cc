@@ -523,9 +523,12 @@ void CtMainWin::load_buffer_from_state(std::shared_ptr<CtNodeState> state, CtTre
     }
     tree_iter.remove_all_embedded_widgets();
     std::list<CtAnchoredWidget*> widgets;
-    for (xmlpp::Node* text_node : state->buffer_xml.get_root_node()->get_children()) {
-        CtStorageXmlHelper{this}.get_text_buffer_one_slot_from_xml(pTextBuffer, text_node, widgets, nullptr, -1, "");
+    if (xmlpp::Element* pBufferXmlRoot = state->get_buffer_xml_root()) {
+        for (xmlpp::Node* text_node : pBufferXmlRoot->get_children()) {
+            CtStorageXmlHelper{this}.get_text_buffer_one_slot_from_xml(pTextBuffer, text_node, widgets, nullptr, -1, "");
+        }
     }
+    state->buffer_xml_release();
 
     // xml storage doesn't have widgets, so load them separately
     for (auto widgetState : state->widgetStates) {
@@ -538,6 +541,7 @@ void CtMainWin::load_buffer_from_state(std::shared_ptr<CtNodeState> state, CtTre
 
     CT_SOURCE_BUFFER_END_NOT_UNDOABLE(pGtkSourceBuffer);
     pTextBuffer->set_modified(false);
+    _ctStateMachine.buffer_loaded_from_state(tree_iter.get_node_id_data_holder(), pTextBuffer);
 
     _uCtTreestore->text_view_apply_textbuffer(tree_iter, &_ctTextview);
     _ctTextview.mm().grab_focus();
@@ -24,6 +24,7 @@
 #include "ct_main_win.h"
 #include "ct_actions.h"
 #include "ct_list.h"
+#include "ct_storage_control.h"
 
 void CtMainWin::_on_treeview_cursor_changed()
 {
@@ -85,14 +86,52 @@ void CtMainWin::_on_treeview_cursor_changed()
         window_header_update_lock_icon(treeIter.get_node_read_only());
         window_header_update_ghost_icon(treeIter.get_node_is_excluded_from_search() or treeIter.get_node_children_are_excluded_from_search());
         window_header_update_bookmark_icon(is_bookmarked);
+        // the cursor and scroll positions of the released nodes are kept to be restored after loading again
+        _uCtTreestore->loaded_buffer_touch(treeIter);
+        _uCtTreestore->loaded_buffers_limit();
         update_selected_node_statusbar_info();
     }
 
     _ctStateMachine.node_selected_changed(nodeIdDataHolder);
+    if (user_active()) {
+        _prefetch_neighbour_nodes(treeIter);
+    }
 
     _prevTreeIter = treeIter;
 }
 
+void CtMainWin::_prefetch_neighbour_nodes(const CtTreeIter& treeIter)
+{
+    // the nodes that are likely selected next: the siblings, the first child and the visited back and forward
+    std::vector<gint64> candidateIds;
+    for (const CtTreeIter& candidateIter : {_uCtTreestore->to_ct_tree_iter(--Gtk::TreeModel::iterator{treeIter}),
+                                            _uCtTreestore->to_ct_tree_iter(++Gtk::TreeModel::iterator{treeIter}),
+                                            treeIter.first_child()})
+    {
+        if (candidateIter) {
+            candidateIds.push_back(candidateIter.get_node_id_data_holder());
+        }
+    }
+    for (const gint64 visitedId : _ctStateMachine.get_visited_adjacent()) {
+        candidateIds.push_back(visitedId);
+    }
+
+    const gint64 nodeIdDataHolder = treeIter.get_node_id_data_holder();
+    std::vector<std::pair<gint64, bool/*isRichText*/>> nodes;
+    for (const gint64 candidateId : candidateIds) {
+        if (candidateId == nodeIdDataHolder or
+            nodes.end() != std::find_if(nodes.begin(), nodes.end(), [candidateId](const auto& node){ return node.first == candidateId; }))
+        {
+            continue;
+        }
+        CtTreeIter dataHolderIter = _uCtTreestore->get_node_from_node_id(candidateId);
+        if (dataHolderIter and not dataHolderIter.get_node_buffer_already_loaded()) {
+            nodes.emplace_back(candidateId, dataHolderIter.get_node_is_rich_text());
+        }
+    }
+    _uCtStorage->prefetch_text_buffers(nodes);
+}
+
 // GTK3 event handlers (not used in GTK4)
 #if GTKMM_MAJOR_VERSION < 4
 bool CtMainWin::_on_treeview_button_release_event(GdkEventButton* event)
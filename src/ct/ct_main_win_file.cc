@@ -197,6 +197,7 @@ bool CtMainWin::file_open(const fs::path& filepath,
 
     _ensure_curr_doc_in_recent_docs();
     reset(); // cannot reset after load_from because load_from fill tree store
+    _currDocIsEncrypted = CtDocType::MultiFile != doc_type and CtDocEncrypt::True == fs::get_doc_encrypt_from_file_ext(filepath);
 
     Glib::ustring error_or_warning;
     CtStorageControl* new_storage = CtStorageControl::load_from(this, filepath, doc_type, error_or_warning, password);
@@ -449,8 +450,13 @@ void CtMainWin::file_autosave_restart()
         if (++_autoSaveCounter >= _pCtConfig->autosaveMinutes) {
             resetAutoSaveCounter();
             if (get_file_save_needed()) {
-                spdlog::debug("autosave needed");
-                _uCtActions->file_save();
+                if (_uCtStorage->save_coalesce_if_in_progress()) {
+                    spdlog::debug("autosave after the save in progress");
+                }
+                else {
+                    spdlog::debug("autosave needed");
+                    _uCtActions->file_save();
+                }
             }
             else {
                 spdlog::debug("autosave no need");
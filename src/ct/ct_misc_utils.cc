@@ -40,8 +40,6 @@
 #else
 #include <uchardet.h>
 #endif // __APPLE__
-#include <thread> // for parallel_for
-#include <future> // parallel_for
 
 #ifdef _WIN32
 #include <windows.h>
@@ -175,18 +173,28 @@ std::string CtMiscUtil::get_node_hierarchical_name(const CtTreeIter tree_iter, c
                                                    const bool for_filename/*=true*/, const bool root_to_leaf/*=true*/,
                                                    const bool trail_node_id/*=false*/, const char* trailer/*=""*/)
 {
-    std::string hierarchical_name = str::trim(tree_iter.get_node_name());
-    CtTreeIter father_iter = tree_iter.parent();
-    while (father_iter) {
-        std::string father_name = str::trim(father_iter.get_node_name());
+    std::vector<std::string> names_leaf_to_root{tree_iter.get_node_name()};
+    for (CtTreeIter father_iter = tree_iter.parent(); father_iter; father_iter = father_iter.parent()) {
+        names_leaf_to_root.push_back(father_iter.get_node_name());
+    }
+    return get_node_hierarchical_name(names_leaf_to_root, tree_iter.get_node_id(), separator, for_filename, root_to_leaf, trail_node_id, trailer);
+}
+
+std::string CtMiscUtil::get_node_hierarchical_name(const std::vector<std::string>& names_leaf_to_root, const gint64 node_id,
+                                                   const char* separator/*="--"*/,
+                                                   const bool for_filename/*=true*/, const bool root_to_leaf/*=true*/,
+                                                   const bool trail_node_id/*=false*/, const char* trailer/*=""*/)
+{
+    std::string hierarchical_name = str::trim(names_leaf_to_root.front());
+    for (size_t i = 1; i < names_leaf_to_root.size(); ++i) {
+        std::string father_name = str::trim(names_leaf_to_root[i]);
         if (root_to_leaf)
             hierarchical_name = father_name + separator + hierarchical_name;
         else
             hierarchical_name = hierarchical_name + separator + father_name;
-        father_iter = father_iter.parent();
     }
     if (trail_node_id) {
-        hierarchical_name += fmt::format("_{:d}", tree_iter.get_node_id());
+        hierarchical_name += fmt::format("_{:d}", node_id);
     }
     if (trailer) {
         hierarchical_name += trailer;
@@ -449,42 +457,267 @@ bool CtMiscUtil::system_cmd(const char* shell_cmd, const char* cwd)
     return success;
 }
 
-// analog to tbb::parallel_for
 void CtMiscUtil::parallel_for(size_t first, size_t last, std::function<void(size_t)> f)
 {
-    size_t concur_num = std::thread::hardware_concurrency();
-    if (concur_num == 0) concur_num = 4;
-    if (first == last) return;
-    if (last < first) return;
-    if (last - first < concur_num) // to make slice calc simpler
-        concur_num = last - first;
-    size_t slice_item_num = (last - first) / concur_num;
-    size_t slice_leftover = (last - first) % concur_num;
-
-    std::list<std::thread> td_tasks;
-    size_t td_first = first;
-    for  (size_t thread_index = 0; thread_index < concur_num; ++thread_index)
+    CtThreadPool::get_global().parallel_for(first, last, f);
+}
+
+namespace {
+
+// set on the pool threads, the tasks they spawn go to their own queue
+thread_local CtThreadPool* tl_pThreadPool{nullptr};
+thread_local size_t tl_workerIdx{0};
+
+} // namespace
+
+CtThreadPool::TaskGroup::TaskGroup(CtThreadPool& threadPool, const size_t max_concurrency/*= 0*/)
+ : _threadPool{threadPool}
+ , _maxConcurrency{max_concurrency > 0 ? max_concurrency : threadPool.get_num_threads()}
+{
+}
+
+CtThreadPool::TaskGroup::~TaskGroup()
+{
+    // the tasks may refer to the caller stack
+    try {
+        wait();
+    }
+    catch (std::exception& e) {
+        spdlog::error("{} {}", __FUNCTION__, e.what());
+    }
+    catch (...) {
+        spdlog::error("{} unknown exception", __FUNCTION__);
+    }
+}
+
+void CtThreadPool::TaskGroup::run(std::function<void()> f)
+{
+    std::unique_lock<std::mutex> lock{_mutex};
+    if (_cancelled) {
+        return;
+    }
+    if (_inFlight >= _maxConcurrency) {
+        _heldBack.push_back(std::move(f));
+        return;
+    }
+    ++_inFlight;
+    lock.unlock();
+    _submit(std::move(f));
+}
+
+void CtThreadPool::TaskGroup::wait()
+{
+    if (tl_pThreadPool == &_threadPool) {
+        while (true) {
+            {
+                std::lock_guard<std::mutex> lock{_mutex};
+                if (0 == _inFlight) {
+                    break;
+                }
+            }
+            // help rather than block, a task waiting for its own sub tasks must not starve the pool
+            if (not _threadPool._try_run_one()) {
+                std::unique_lock<std::mutex> lock{_mutex};
+                _condVar.wait_for(lock, std::chrono::milliseconds{1}, [this](){ return 0 == _inFlight; });
+            }
+        }
+    }
+    else {
+        // e.g. the gui thread, which must not pick up any long task of the pool
+        std::unique_lock<std::mutex> lock{_mutex};
+        _condVar.wait(lock, [this](){ return 0 == _inFlight; });
+    }
+    std::exception_ptr exception;
     {
-        std::packaged_task<void(size_t, size_t)> task([f](size_t slice_start, size_t slice_end)
-        {
-            for (size_t index = slice_start; index < slice_end; ++index)
+        std::lock_guard<std::mutex> lock{_mutex};
+        std::swap(exception, _exception);
+    }
+    if (exception) {
+        std::rethrow_exception(exception);
+    }
+}
+
+void CtThreadPool::TaskGroup::cancel()
+{
+    _cancelled = true;
+    std::lock_guard<std::mutex> lock{_mutex};
+    _heldBack.clear();
+}
+
+void CtThreadPool::TaskGroup::_submit(std::function<void()> f)
+{
+    _threadPool._submit([this, f = std::move(f)]() {
+        if (not _cancelled) {
+            try {
+                f();
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock{_mutex};
+                if (not _exception) {
+                    _exception = std::current_exception();
+                }
+                _cancelled = true;
+            }
+        }
+        _on_task_done();
+    });
+}
+
+void CtThreadPool::TaskGroup::_on_task_done()
+{
+    std::unique_lock<std::mutex> lock{_mutex};
+    if (not _cancelled and not _heldBack.empty()) {
+        // the slot of the finished task passes to the oldest held back one
+        std::function<void()> f = std::move(_heldBack.front());
+        _heldBack.pop_front();
+        lock.unlock();
+        _submit(std::move(f));
+        return;
+    }
+    _heldBack.clear();
+    if (0 == --_inFlight) {
+        // notified with the lock held as the group can be destroyed as soon as the waiter wakes up
+        _condVar.notify_all();
+    }
+}
+
+/*static*/CtThreadPool& CtThreadPool::get_global()
+{
+    static CtThreadPool threadPool{std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 4u};
+    return threadPool;
+}
+
+CtThreadPool::CtThreadPool(const size_t num_threads)
+{
+    const size_t numThreads = std::max<size_t>(1u, num_threads);
+    for (size_t i = 0; i < numThreads; ++i) {
+        _workerQueues.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (size_t i = 0; i < numThreads; ++i) {
+        _workers.emplace_back(&CtThreadPool::_worker_loop, this, i);
+    }
+}
+
+CtThreadPool::~CtThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock{_wakeMutex};
+        _stop = true;
+    }
+    _wakeCondVar.notify_all();
+    for (std::thread& worker : _workers) {
+        worker.join();
+    }
+}
+
+void CtThreadPool::parallel_for(const size_t first, const size_t last, const std::function<void(size_t)>& f)
+{
+    if (last <= first) {
+        return;
+    }
+    // a few slices per thread so that stealing evens out slices slower than others
+    const size_t numItems = last - first;
+    const size_t numSlices = std::min(numItems, get_num_threads() * 4u);
+    const size_t sliceItems = numItems / numSlices;
+    size_t sliceLeftover = numItems % numSlices;
+    TaskGroup taskGroup{*this};
+    size_t sliceFirst = first;
+    for (size_t i = 0; i < numSlices; ++i) {
+        size_t sliceLast = sliceFirst + sliceItems;
+        if (sliceLeftover > 0) {
+            ++sliceLast;
+            --sliceLeftover;
+        }
+        taskGroup.run([&f, sliceFirst, sliceLast](){
+            for (size_t index = sliceFirst; index < sliceLast; ++index) {
                 f(index);
+            }
         });
+        sliceFirst = sliceLast;
+    }
+    taskGroup.wait();
+}
 
-        size_t td_slice = slice_item_num;
-        if (slice_leftover != 0) {
-            td_slice += 1;
-            slice_leftover -= 1;
+void CtThreadPool::_submit(std::function<void()> f)
+{
+    WorkerQueue& queue = tl_pThreadPool == this ? *_workerQueues[tl_workerIdx] : _injectQueue;
+    {
+        std::lock_guard<std::mutex> lock{queue.mutex};
+        queue.tasks.push_back(std::move(f));
+    }
+    {
+        // under the mutex not to lose the wake up of a worker about to sleep
+        std::lock_guard<std::mutex> lock{_wakeMutex};
+        ++_numQueued;
+    }
+    _wakeCondVar.notify_one();
+}
+
+bool CtThreadPool::_try_pop(std::function<void()>& f)
+{
+    auto f_pop = [&](WorkerQueue& queue, const bool from_back)->bool{
+        std::lock_guard<std::mutex> lock{queue.mutex};
+        if (queue.tasks.empty()) {
+            return false;
+        }
+        if (from_back) {
+            f = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        else {
+            f = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        --_numQueued;
+        return true;
+    };
+    const bool isWorker = tl_pThreadPool == this;
+    // own queue last in first out, the data of the latest task is likely still in cache
+    if (isWorker and f_pop(*_workerQueues[tl_workerIdx], true/*from_back*/)) {
+        return true;
+    }
+    if (f_pop(_injectQueue, false/*from_back*/)) {
+        return true;
+    }
+    // steal the oldest task of another worker
+    const size_t numQueues = _workerQueues.size();
+    const size_t startIdx = isWorker ? tl_workerIdx + 1 : 0;
+    for (size_t i = 0; i < numQueues; ++i) {
+        const size_t victimIdx = (startIdx + i) % numQueues;
+        if (isWorker and victimIdx == tl_workerIdx) {
+            continue;
+        }
+        if (f_pop(*_workerQueues[victimIdx], false/*from_back*/)) {
+            return true;
         }
-        if (td_first + td_slice > last)
-            td_slice = last - td_first;
+    }
+    return false;
+}
 
-        td_tasks.emplace_back(std::thread(std::move(task), td_first, td_first + td_slice));
-        td_first += td_slice;
+bool CtThreadPool::_try_run_one()
+{
+    std::function<void()> f;
+    if (not _try_pop(f)) {
+        return false;
     }
+    f();
+    return true;
+}
 
-    for (auto& task: td_tasks)
-        task.join();
+void CtThreadPool::_worker_loop(const size_t worker_idx)
+{
+    tl_pThreadPool = this;
+    tl_workerIdx = worker_idx;
+    while (true) {
+        if (_try_run_one()) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock{_wakeMutex};
+        _wakeCondVar.wait(lock, [this](){ return _stop or _numQueued > 0; });
+        if (_stop) {
+            return;
+        }
+    }
 }
 
 std::optional<Glib::ustring> CtTextIterUtil::iter_get_tag_startingwith(const Gtk::TextIter& iter, const Glib::ustring& tag_startwith)
@@ -620,66 +853,67 @@ bool CtTextIterUtil::startswith_url(Gtk::TextIter text_iter)
     return false;
 }
 
-bool CtTextIterUtil::rich_text_attributes_update(const Gtk::TextIter& text_iter,
-                                                 const CtCurrAttributesMap& curr_attributes,
-                                                 CtCurrAttributesMap& delta_attributes)
-{
-    delta_attributes.clear();
-#if GTKMM_MAJOR_VERSION >= 4
-    auto toggled_off = text_iter.get_toggled_tags(false/*toggled_on*/);
-#else
-    std::vector<Glib::RefPtr<const Gtk::TextTag>> toggled_off = text_iter.get_toggled_tags(false/*toggled_on*/);
-#endif
-    for (const auto& r_curr_tag : toggled_off) {
-        const Glib::ustring tag_name = r_curr_tag->property_name();
-        if (tag_name.empty() or CtConst::GTKSPELLCHECK_TAG_NAME == tag_name) {
-            continue;
+const CtTextIterUtil::RichTextTagsAttrs::TagAttr& CtTextIterUtil::RichTextTagsAttrs::get(GtkTextTag* pTag)
+{
+    auto it = _tagsAttrs.find(pTag);
+    if (it != _tagsAttrs.end()) {
+        return it->second;
+    }
+    TagAttr tagAttr{CtTagAttr::None, ""};
+    g_autofree gchar* pTagName{NULL};
+    g_object_get(G_OBJECT(pTag), "name", &pTagName, NULL);
+    const std::string_view tag_name{pTagName ? pTagName : ""};
+    if (not tag_name.empty() and CtConst::GTKSPELLCHECK_TAG_NAME != tag_name) {
+        static const std::array<std::pair<CtTagAttr, const Glib::ustring*>, CtCurrAttributes::Size> prefixes{{
+            {CtTagAttr::Weight, &CtConst::TAG_WEIGHT_PREFIX},
+            {CtTagAttr::Foreground, &CtConst::TAG_FOREGROUND_PREFIX},
+            {CtTagAttr::Background, &CtConst::TAG_BACKGROUND_PREFIX},
+            {CtTagAttr::Style, &CtConst::TAG_STYLE_PREFIX},
+            {CtTagAttr::Underline, &CtConst::TAG_UNDERLINE_PREFIX},
+            {CtTagAttr::Strikethrough, &CtConst::TAG_STRIKETHROUGH_PREFIX},
+            {CtTagAttr::Scale, &CtConst::TAG_SCALE_PREFIX},
+            {CtTagAttr::Invisible, &CtConst::TAG_INVISIBLE_PREFIX},
+            {CtTagAttr::Family, &CtConst::TAG_FAMILY_PREFIX},
+            {CtTagAttr::Justification, &CtConst::TAG_JUSTIFICATION_PREFIX},
+            {CtTagAttr::Link, &CtConst::TAG_LINK_PREFIX},
+            {CtTagAttr::Indent, &CtConst::TAG_INDENT_PREFIX},
+        }};
+        for (const auto& prefix : prefixes) {
+            const std::string& prefixRaw = prefix.second->raw();
+            if (0 == tag_name.compare(0, prefixRaw.size(), prefixRaw)) {
+                tagAttr.first = prefix.first;
+                tagAttr.second = std::string{tag_name.substr(prefixRaw.size())};
+                break;
+            }
         }
-        if (str::startswith(tag_name, CtConst::TAG_WEIGHT_PREFIX)) delta_attributes[CtConst::TAG_WEIGHT].clear();
-        else if (str::startswith(tag_name, CtConst::TAG_FOREGROUND_PREFIX)) delta_attributes[CtConst::TAG_FOREGROUND].clear();
-        else if (str::startswith(tag_name, CtConst::TAG_BACKGROUND_PREFIX)) delta_attributes[CtConst::TAG_BACKGROUND].clear();
-        else if (str::startswith(tag_name, CtConst::TAG_STYLE_PREFIX)) delta_attributes[CtConst::TAG_STYLE].clear();
-        else if (str::startswith(tag_name, CtConst::TAG_UNDERLINE_PREFIX)) delta_attributes[CtConst::TAG_UNDERLINE].clear();
-        else if (str::startswith(tag_name, CtConst::TAG_STRIKETHROUGH_PREFIX)) delta_attributes[CtConst::TAG_STRIKETHROUGH].clear();
-        else if (str::startswith(tag_name, CtConst::TAG_INDENT_PREFIX)) delta_attributes[CtConst::TAG_INDENT].clear();
-        else if (str::startswith(tag_name, CtConst::TAG_SCALE_PREFIX)) delta_attributes[CtConst::TAG_SCALE].clear();
-        else if (str::startswith(tag_name, CtConst::TAG_INVISIBLE_PREFIX)) delta_attributes[CtConst::TAG_INVISIBLE].clear();
-        else if (str::startswith(tag_name, CtConst::TAG_JUSTIFICATION_PREFIX)) delta_attributes[CtConst::TAG_JUSTIFICATION].clear();
-        else if (str::startswith(tag_name, CtConst::TAG_LINK_PREFIX)) delta_attributes[CtConst::TAG_LINK].clear();
-        else if (str::startswith(tag_name, CtConst::TAG_FAMILY_PREFIX)) delta_attributes[CtConst::TAG_FAMILY].clear();
     }
-#if GTKMM_MAJOR_VERSION >= 4
-    auto toggled_on = text_iter.get_toggled_tags(true/*toggled_on*/);
-#else
-    std::vector<Glib::RefPtr<const Gtk::TextTag>> toggled_on = text_iter.get_toggled_tags(true/*toggled_on*/);
-#endif
-    for (const auto& r_curr_tag : toggled_on) {
-        const Glib::ustring tag_name = r_curr_tag->property_name();
-        if (tag_name.empty() or CtConst::GTKSPELLCHECK_TAG_NAME == tag_name) {
-            continue;
+    return _tagsAttrs.emplace(pTag, std::move(tagAttr)).first->second;
+}
+
+bool CtTextIterUtil::rich_text_attributes_update(const Gtk::TextIter& text_iter,
+                                                 const CtCurrAttributes& curr_attributes,
+                                                 RichTextDelta& delta_attributes,
+                                                 RichTextTagsAttrs& tagsAttrs)
+{
+    static const std::string emptyValue;
+    delta_attributes.fill(nullptr);
+    // the tags toggled off first, so that a tag toggled on at the same iter wins
+    for (const gboolean toggled_on : {FALSE, TRUE}) {
+        GSList* pTagsList = gtk_text_iter_get_toggled_tags(text_iter.gobj(), toggled_on);
+        for (GSList* pTagItem = pTagsList; pTagItem; pTagItem = pTagItem->next) {
+            const RichTextTagsAttrs::TagAttr& tagAttr = tagsAttrs.get(static_cast<GtkTextTag*>(pTagItem->data));
+            if (CtTagAttr::None != tagAttr.first) {
+                delta_attributes[static_cast<size_t>(tagAttr.first)] = toggled_on ? &tagAttr.second : &emptyValue;
+            }
         }
-        if (str::startswith(tag_name, CtConst::TAG_WEIGHT_PREFIX)) delta_attributes[CtConst::TAG_WEIGHT] = tag_name.substr(7);
-        else if (str::startswith(tag_name, CtConst::TAG_FOREGROUND_PREFIX)) delta_attributes[CtConst::TAG_FOREGROUND] = tag_name.substr(11);
-        else if (str::startswith(tag_name, CtConst::TAG_BACKGROUND_PREFIX)) delta_attributes[CtConst::TAG_BACKGROUND] = tag_name.substr(11);
-        else if (str::startswith(tag_name, CtConst::TAG_SCALE_PREFIX)) delta_attributes[CtConst::TAG_SCALE] = tag_name.substr(6);
-        else if (str::startswith(tag_name, CtConst::TAG_INVISIBLE_PREFIX)) delta_attributes[CtConst::TAG_INVISIBLE] = tag_name.substr(10);
-        else if (str::startswith(tag_name, CtConst::TAG_JUSTIFICATION_PREFIX)) delta_attributes[CtConst::TAG_JUSTIFICATION] = tag_name.substr(14);
-        else if (str::startswith(tag_name, CtConst::TAG_STYLE_PREFIX)) delta_attributes[CtConst::TAG_STYLE] = tag_name.substr(6);
-        else if (str::startswith(tag_name, CtConst::TAG_UNDERLINE_PREFIX)) delta_attributes[CtConst::TAG_UNDERLINE] = tag_name.substr(10);
-        else if (str::startswith(tag_name, CtConst::TAG_STRIKETHROUGH_PREFIX)) delta_attributes[CtConst::TAG_STRIKETHROUGH] = tag_name.substr(14);
-        else if (str::startswith(tag_name, CtConst::TAG_INDENT_PREFIX)) delta_attributes[CtConst::TAG_INDENT] = tag_name.substr(7);
-        else if (str::startswith(tag_name, CtConst::TAG_LINK_PREFIX)) delta_attributes[CtConst::TAG_LINK] = tag_name.substr(5);
-        else if (str::startswith(tag_name, CtConst::TAG_FAMILY_PREFIX)) delta_attributes[CtConst::TAG_FAMILY] = tag_name.substr(7);
-    }
-    bool anyDelta{false};
-    for (const auto& currDelta : delta_attributes) {
-        auto keyFound = curr_attributes.find(currDelta.first);
-        if (keyFound == curr_attributes.end() or keyFound->second != currDelta.second) {
-            anyDelta = true;
-            break;
+        g_slist_free(pTagsList);
+    }
+    for (size_t i = 0; i < CtCurrAttributes::Size; ++i) {
+        if (delta_attributes[i] and *delta_attributes[i] != curr_attributes[i]) {
+            return true;
         }
     }
-    return anyDelta;
+    return false;
 }
 
 void CtTextIterUtil::generic_process_slot(const CtConfig* const pCtConfig,
@@ -689,19 +923,20 @@ void CtTextIterUtil::generic_process_slot(const CtConfig* const pCtConfig,
                                           SerializeFunc f_serialize_func,
                                           const bool list_info/*= false*/)
 {
-    CtCurrAttributesMap curr_attributes;
-    CtCurrAttributesMap delta_attributes;
-    for (const auto& tag_property : CtConst::TAG_PROPERTIES) {
-        curr_attributes[tag_property].clear();
-    }
+    CtCurrAttributes curr_attributes;
+    RichTextDelta delta_attributes;
+    RichTextTagsAttrs tagsAttrs;
+    auto f_apply_delta = [&](){
+        for (size_t i = 0; i < CtCurrAttributes::Size; ++i) {
+            if (delta_attributes[i]) curr_attributes[i] = *delta_attributes[i];
+        }
+    };
     Gtk::TextIter curr_start_iter = pTextBuffer->get_iter_at_offset(start_offset);
     Gtk::TextIter curr_end_iter = curr_start_iter;
     Gtk::TextIter real_end_iter = end_offset == -1 ? pTextBuffer->end() : pTextBuffer->get_iter_at_offset(end_offset);
 
-    if (CtTextIterUtil::rich_text_attributes_update(curr_end_iter, curr_attributes, delta_attributes)) {
-        for (auto& currDelta : delta_attributes) {
-            curr_attributes[currDelta.first] = currDelta.second;
-        }
+    if (CtTextIterUtil::rich_text_attributes_update(curr_end_iter, curr_attributes, delta_attributes, tagsAttrs)) {
+        f_apply_delta();
     }
 
     CtListInfo curr_list_info;
@@ -714,10 +949,25 @@ void CtTextIterUtil::generic_process_slot(const CtConfig* const pCtConfig,
         curr_end_iter.forward_char();
     }
 
-    while (curr_end_iter.forward_char()) {
-        if (curr_end_iter.compare(real_end_iter) >= 0) {
+    for (;;) {
+        // the attributes change only at a tag toggle, the list info also at a newline and the char after it
+        Gtk::TextIter next_iter = curr_end_iter;
+        if (list_info and last_was_newline) {
+            next_iter.forward_char();
+        }
+        else {
+            (void)next_iter.forward_to_tag_toggle(Glib::RefPtr<Gtk::TextTag>{});
+            if (list_info) {
+                Gtk::TextIter newline_iter = curr_end_iter;
+                if (newline_iter.forward_find_char([](gunichar ch){ return '\n' == ch; }, next_iter)) {
+                    next_iter = newline_iter;
+                }
+            }
+        }
+        if (next_iter.compare(real_end_iter) >= 0) {
             break;
         }
+        curr_end_iter = next_iter;
 
         if (list_info and last_was_newline) {
             curr_list_info = CtList{pCtConfig, pTextBuffer}.get_paragraph_list_info(curr_end_iter);
@@ -725,11 +975,11 @@ void CtTextIterUtil::generic_process_slot(const CtConfig* const pCtConfig,
 
         last_was_newline = '\n' == curr_end_iter.get_char();
 
-        if (CtTextIterUtil::rich_text_attributes_update(curr_end_iter, curr_attributes, delta_attributes) or
+        if (CtTextIterUtil::rich_text_attributes_update(curr_end_iter, curr_attributes, delta_attributes, tagsAttrs) or
             (list_info and last_was_newline))
         {
             f_serialize_func(curr_start_iter, curr_end_iter, curr_attributes, &curr_list_info);
-            for (auto& currDelta : delta_attributes) curr_attributes[currDelta.first] = currDelta.second;
+            f_apply_delta();
             curr_start_iter = curr_end_iter;
         }
     }
@@ -739,6 +989,49 @@ void CtTextIterUtil::generic_process_slot(const CtConfig* const pCtConfig,
     }
 }
 
+void CtTextIterUtil::code_buffer_foreach_run(const Gtk::TextIter& start_iter,
+                                             const Gtk::TextIter& end_iter,
+                                             const CodeRunFunc& f_run_func)
+{
+    std::unordered_map<GtkTextTag*, CodeRunStyle> tagsStyles;
+    auto f_get_tag_style = [&tagsStyles](const Glib::RefPtr<Gtk::TextTag>& rTag)->const CodeRunStyle& {
+        auto it = tagsStyles.find(rTag->gobj());
+        if (it == tagsStyles.end()) {
+            CodeRunStyle tagStyle;
+            tagStyle.fontWeight = rTag->property_weight().get_value();
+            if (rTag->property_foreground_set()) {
+                tagStyle.hasForeground = true;
+                tagStyle.foreground = rTag->property_foreground_rgba().get_value().to_string();
+                tagStyle.rgb24 = CtRgbUtil::get_rgb24str_from_str_any(CtRgbUtil::rgb_to_no_white(tagStyle.foreground));
+            }
+            it = tagsStyles.emplace(rTag->gobj(), std::move(tagStyle)).first;
+        }
+        return it->second;
+    };
+    Gtk::TextIter curr_iter = start_iter;
+    while (curr_iter.compare(end_iter) < 0) {
+        Gtk::TextIter next_iter = curr_iter;
+        if (not next_iter.forward_to_tag_toggle(Glib::RefPtr<Gtk::TextTag>{}) or next_iter.compare(end_iter) > 0) {
+            next_iter = end_iter;
+        }
+        // the first tag with a foreground wins, the weight is of the first tag if none
+        CodeRunStyle runStyle;
+        const std::vector<Glib::RefPtr<Gtk::TextTag>> curr_tags = curr_iter.get_tags();
+        for (const Glib::RefPtr<Gtk::TextTag>& rTag : curr_tags) {
+            const CodeRunStyle& tagStyle = f_get_tag_style(rTag);
+            if (tagStyle.hasForeground) {
+                runStyle = tagStyle;
+                break;
+            }
+        }
+        if (not runStyle.hasForeground and not curr_tags.empty()) {
+            runStyle.fontWeight = f_get_tag_style(curr_tags.front()).fontWeight;
+        }
+        f_run_func(curr_iter.get_slice(next_iter), runStyle);
+        curr_iter = next_iter;
+    }
+}
+
 bool CtTextIterUtil::extend_selection_if_collapsed_text(Gtk::TextIter& iter_sel_end, const CtTreeIter& ctTreeIter, CtMainWin* pCtMainWin)
 {
     if ('\n' == iter_sel_end.get_char()) {
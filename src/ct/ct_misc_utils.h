@@ -33,6 +33,10 @@
 #include <gtkmm/treestore.h>
 #include <gtksourceview/gtksource.h>
 #include <numeric>
+#include <atomic>
+#include <thread>
+#include <deque>
+#include <exception>
 
 /*
  * Compatibility shim: gtkmm4 removed the BuiltinIconSize enum that existed in
@@ -264,6 +268,10 @@ bool node_siblings_sort(Glib::RefPtr<TreeOrListStore> model,
 std::string get_node_hierarchical_name(const CtTreeIter tree_iter, const char* separator="--",
                                        const bool for_filename=true, const bool root_to_leaf=true,
                                        const bool trail_node_id=false, const char* trailer="");
+// the names from the node up to its top level ancestor
+std::string get_node_hierarchical_name(const std::vector<std::string>& names_leaf_to_root, const gint64 node_id, const char* separator="--",
+                                       const bool for_filename=true, const bool root_to_leaf=true,
+                                       const bool trail_node_id=false, const char* trailer="");
 
 std::string clean_from_chars_not_for_filename(std::string filename);
 
@@ -285,12 +293,92 @@ bool mime_type_contains(const std::string& filepath, const char* type);
 enum class URI_TYPE { LOCAL_FILEPATH, WEB_URL, UNKNOWN };
 URI_TYPE get_uri_type(const std::string& uri);
 
+// analog to tbb::parallel_for, runs on the process-wide CtThreadPool
 void parallel_for(size_t first, size_t last, std::function<void(size_t)> f);
 
 bool text_file_set_contents_add_cr_on_win(const std::string& filepath, const std::string& text_content);
 
 } // namespace CtMiscUtil
 
+/**
+ * @brief Work-stealing thread pool
+ * Each worker pops the tasks it spawns from the back of its own queue and, once empty,
+ * steals from the front of the other workers queues; tasks submitted from any other
+ * thread go to a shared injection queue.
+ */
+class CtThreadPool
+{
+public:
+    /**
+     * @brief Set of tasks that can be waited for and cancelled together
+     * The tasks of a group run at most max_concurrency at a time, the others are held back.
+     */
+    class TaskGroup
+    {
+    public:
+        TaskGroup(CtThreadPool& threadPool, const size_t max_concurrency = 0/*the pool threads*/);
+        ~TaskGroup();
+        TaskGroup(const TaskGroup&) = delete;
+        TaskGroup& operator=(const TaskGroup&) = delete;
+
+        void run(std::function<void()> f);
+        /**
+         * @brief Wait for all the tasks of the group
+         * On a pool thread it runs tasks of the pool meanwhile, any other thread just blocks.
+         * Rethrows the first exception thrown by a task, which also cancelled the group.
+         */
+        void wait();
+        // the tasks not started yet are dropped, the running ones can check is_cancelled()
+        void cancel();
+        bool is_cancelled() const { return _cancelled; }
+
+    private:
+        void _submit(std::function<void()> f);
+        void _on_task_done();
+
+        CtThreadPool&                   _threadPool;
+        const size_t                    _maxConcurrency;
+        std::mutex                      _mutex;
+        std::condition_variable         _condVar;
+        size_t                          _inFlight{0};
+        std::deque<std::function<void()>> _heldBack;
+        std::exception_ptr              _exception;
+        std::atomic<bool>               _cancelled{false};
+    };
+
+    // shared by the whole process, sized to the hardware concurrency
+    static CtThreadPool& get_global();
+
+    explicit CtThreadPool(const size_t num_threads);
+    ~CtThreadPool();
+    CtThreadPool(const CtThreadPool&) = delete;
+    CtThreadPool& operator=(const CtThreadPool&) = delete;
+
+    size_t get_num_threads() const { return _workers.size(); }
+
+    void parallel_for(const size_t first, const size_t last, const std::function<void(size_t)>& f);
+
+private:
+    struct WorkerQueue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void _submit(std::function<void()> f);
+    bool _try_run_one();
+    bool _try_pop(std::function<void()>& f);
+    void _worker_loop(const size_t worker_idx);
+
+    std::vector<std::unique_ptr<WorkerQueue>> _workerQueues;
+    WorkerQueue                               _injectQueue;
+    std::vector<std::thread>                  _workers;
+    std::mutex                                _wakeMutex;
+    std::condition_variable                   _wakeCondVar;
+    std::atomic<size_t>                       _numQueued{0};
+    bool                                      _stop{false};
+};
+
 namespace CtTextIterUtil {
 
 bool extend_selection_if_collapsed_text(Gtk::TextIter& iter_sel_end, const CtTreeIter& ctTreeIter, CtMainWin* pCtMainWin);
@@ -326,12 +414,30 @@ bool startswith_any(Gtk::TextIter text_iter, const container& str_list)
     return false;
 }
 
-bool rich_text_attributes_update(const Gtk::TextIter& text_iter, const CtCurrAttributesMap& curr_attributes, CtCurrAttributesMap& delta_attributes);
+// rich text tags resolved once, from the tag name, to the attribute they set and its value
+class RichTextTagsAttrs
+{
+public:
+    using TagAttr = std::pair<CtTagAttr, std::string>;
+    const TagAttr& get(GtkTextTag* pTag);
+
+private:
+    std::unordered_map<GtkTextTag*, TagAttr> _tagsAttrs;
+};
+// the attributes toggled at a text iter, nullptr where not toggled
+using RichTextDelta = std::array<const std::string*, CtCurrAttributes::Size>;
+
+// returns true if any of the attributes toggled at text_iter differs from curr_attributes
+bool rich_text_attributes_update(const Gtk::TextIter& text_iter,
+                                 const CtCurrAttributes& curr_attributes,
+                                 RichTextDelta& delta_attributes,
+                                 RichTextTagsAttrs& tagsAttrs);
 
 using SerializeFunc = std::function<void(Gtk::TextIter& start_iter,
                                          Gtk::TextIter& end_iter,
-                                         CtCurrAttributesMap& curr_attributes,
+                                         CtCurrAttributes& curr_attributes,
                                          CtListInfo* pCurrListInfo)>;
+// calls serialize_func on the slots of same attributes, jumping from a tag toggle to the next
 void generic_process_slot(const CtConfig* const pCtConfig,
                           const int start_offset,
                           const int end_offset,
@@ -339,6 +445,23 @@ void generic_process_slot(const CtConfig* const pCtConfig,
                           SerializeFunc serialize_func,
                           const bool list_info = false);
 
+// foreground of a code buffer run as the exporters render it, from the highlighting tags
+struct CodeRunStyle
+{
+    bool          hasForeground{false};
+    Glib::ustring foreground;   // as the tag property, to tell runs apart
+    Glib::ustring rgb24;        // not white, for the html/pango spans
+    int           fontWeight{PANGO_WEIGHT_NORMAL};
+};
+using CodeRunFunc = std::function<void(const Glib::ustring& run_text, const CodeRunStyle& run_style)>;
+/**
+ * @brief Call f_run_func for every run of text between tag toggles in [start_iter, end_iter)
+ * The style of each Gtk::TextTag is read once per call rather than once per character.
+ */
+void code_buffer_foreach_run(const Gtk::TextIter& start_iter,
+                             const Gtk::TextIter& end_iter,
+                             const CodeRunFunc& f_run_func);
+
 const gchar* get_text_iter_alignment(const Gtk::TextIter& textIter, CtMainWin* pCtMainWin);
 
 PangoDirection get_pango_direction(const Gtk::TextIter& textIter);
@@ -29,8 +29,11 @@
 #include <vector>
 #include <algorithm>
 #include <thread>
+#include <mutex>
 
 extern int p7za_exec(int numArgs, char *args[]);
+extern int (*g_p7za_stdin_read)(void* data, unsigned int size, unsigned int* processedSize);
+extern int (*g_p7za_stdout_write)(const void* data, unsigned int size, unsigned int* processedSize);
 extern void cherrytree_register_7zaes();
 extern void cherrytree_register_crc32();
 extern void cherrytree_register_crc_table();
@@ -39,6 +42,36 @@ extern void cherrytree_register_7z();
 extern void cherrytree_register_lzma2();
 extern void cherrytree_register_lzma();
 
+// 7za keeps global state, one command at a time
+static std::mutex s_p7za_mutex;
+static const std::function<bool(const char*, size_t)>* s_p_f_write{nullptr};
+static const std::function<size_t(char*, size_t)>* s_p_f_read{nullptr};
+
+static int stdout_write_to_f_write(const void* data, unsigned int size, unsigned int* processedSize)
+{
+    try {
+        if (not (*s_p_f_write)(static_cast<const char*>(data), size)) {
+            return 1;
+        }
+    }
+    catch (...) {
+        return 1;
+    }
+    *processedSize = size;
+    return 0;
+}
+
+static int stdin_read_from_f_read(void* data, unsigned int size, unsigned int* processedSize)
+{
+    try {
+        *processedSize = static_cast<unsigned int>((*s_p_f_read)(static_cast<char*>(data), size));
+    }
+    catch (...) {
+        return 1;
+    }
+    return 0;
+}
+
 static void register_codecs()
 {
     // to fix linker and remove '-whole-archive'
@@ -70,6 +103,7 @@ int CtP7zaIface::p7za_extract(const gchar* input_path, const gchar* out_dir, con
     };
     gchar** pp_args = CtStrUtil::vector_to_array(args);
 
+    std::lock_guard<std::mutex> lock{s_p7za_mutex};
     register_codecs();
     int ret_val = p7za_exec((int)args.size(), pp_args);
     g_strfreev(pp_args);
@@ -103,8 +137,80 @@ int CtP7zaIface::p7za_archive(const gchar* input_path, const gchar* output_path,
     };
     gchar** pp_args = CtStrUtil::vector_to_array(args);
 
+    std::lock_guard<std::mutex> lock{s_p7za_mutex};
+    register_codecs();
+    int ret_val = p7za_exec(args.size(), pp_args);
+    g_strfreev(pp_args);
+    return ret_val;
+}
+
+int CtP7zaIface::p7za_extract_to_stream(const gchar* input_path,
+                                        const gchar* passwd,
+                                        bool suppress_error,
+                                        const std::function<bool(const char* pData, size_t dataSize)>& f_write)
+{
+    std::vector<std::string> args {
+                "7za",
+                "e",
+                "-p" + std::string{passwd},
+                "-w" + fs::path{g_get_tmp_dir()}.string_unix(),
+                "-bd",   // Disable progress indicator
+                "-bso0", // Disable standard output, error output is turn on
+                "-bsp0", // Disable progress output
+                suppress_error ? "-bse0" : "-bse2", // standard output is the data
+                "-y",
+                "-so",
+                fs::path{input_path}.string_unix()
+    };
+    gchar** pp_args = CtStrUtil::vector_to_array(args);
+
+    std::lock_guard<std::mutex> lock{s_p7za_mutex};
+    register_codecs();
+    s_p_f_write = &f_write;
+    g_p7za_stdout_write = stdout_write_to_f_write;
+    int ret_val = p7za_exec((int)args.size(), pp_args);
+    g_p7za_stdout_write = nullptr;
+    s_p_f_write = nullptr;
+    g_strfreev(pp_args);
+    return ret_val;
+}
+
+int CtP7zaIface::p7za_archive_from_stream(const std::function<size_t(char* pBuf, size_t bufSize)>& f_read,
+                                          const gchar* file_name,
+                                          const gchar* output_path,
+                                          const gchar* passwd)
+{
+    size_t concur_num = std::thread::hardware_concurrency();
+    if (concur_num == 0) concur_num = 4;
+
+    g_autofree gchar* p_workspace_dir = g_path_get_dirname(output_path);
+    std::vector<std::string> args {
+                "7za",
+                "a",
+                "-p" + std::string{passwd},
+                "-w" + fs::path{p_workspace_dir}.string_unix(),
+                "-t7z",
+                "-m0=LZMA2:d64k:fb32",
+                "-ms=8m",
+                "-mmt=" + std::to_string(concur_num),
+                "-mx=1",
+                "-bd",   // Disable progress indicator
+                "-bso0", // Disable standard output, error output is turn on
+                "-bsp0", // Disable progress output
+                "-y",
+                "-si" + std::string{file_name},
+                "--",
+                fs::path{output_path}.string_unix()
+    };
+    gchar** pp_args = CtStrUtil::vector_to_array(args);
+
+    std::lock_guard<std::mutex> lock{s_p7za_mutex};
     register_codecs();
+    s_p_f_read = &f_read;
+    g_p7za_stdin_read = stdin_read_from_f_read;
     int ret_val = p7za_exec(args.size(), pp_args);
+    g_p7za_stdin_read = nullptr;
+    s_p_f_read = nullptr;
     g_strfreev(pp_args);
     return ret_val;
 }
@@ -22,6 +22,7 @@
 #pragma once
 #include <glib.h>
 #include <glib/gtypes.h>
+#include <functional>
 
 namespace CtP7zaIface {
 
@@ -29,5 +30,19 @@ int p7za_extract(const gchar* input_path, const gchar* out_dir, const gchar* pas
 
 int p7za_archive(const gchar* input_path, const gchar* output_path, const gchar* passwd);
 
+// extract the (single file) archive passing the decrypted data to f_write, nothing touches the disk
+// f_write returns false to abort the extraction
+int p7za_extract_to_stream(const gchar* input_path,
+                           const gchar* passwd,
+                           bool suppress_error,
+                           const std::function<bool(const char* pData, size_t dataSize)>& f_write);
+
+// create the archive output_path containing the file file_name whose data is pulled from f_read
+// f_read fills up to bufSize bytes and returns how many, 0 at the end of the data
+int p7za_archive_from_stream(const std::function<size_t(char* pBuf, size_t bufSize)>& f_read,
+                             const gchar* file_name,
+                             const gchar* output_path,
+                             const gchar* passwd);
+
 } // namespace CtP7zaIface
 
@@ -176,13 +176,17 @@ public:
     const std::vector<token_schema>& token_schemas() const { return _token_schemas; }
     const pos_tokens_t& pos_tokens() const { return _possible_tokens; }
      /**
-     * @brief Transform an input string into a token stream
+     * @brief Transform a token stream into the tags with their contents
      * @param tokens
      * @return
      */
-    std::vector<std::pair<const token_schema*, std::string>> parse_tokens(const std::vector<std::string>& tokens) const;
-
-    std::vector<std::string> tokenize(const std::string& text) const;
+    std::vector<std::pair<const token_schema*, std::string>> parse_tokens(const std::vector<std::string_view>& tokens) const;
+    /**
+     * @brief Split an input string into tokens
+     * @param text
+     * @return the tokens, views into the text that must outlive them
+     */
+    std::vector<std::string_view> tokenize(std::string_view text) const;
 
 private:
     /// Tokens to be cached by the parser
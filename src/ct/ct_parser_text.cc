@@ -55,6 +55,17 @@ std::optional<STR_T> branch_token(ITER_T begin, ITER_T end, const std::vector<ST
     return largest;
 }
 
+// the length of the longest of the tokens at the start of the text, 0 if none
+size_t longest_token_at(std::string_view text, const std::vector<std::string_view>& tokens) {
+    size_t largest_len = 0;
+    for (const auto& token : tokens) {
+        if (token.length() > largest_len && text.compare(0, token.length(), token) == 0) {
+            largest_len = token.length();
+        }
+    }
+    return largest_len;
+}
+
 void build_pos_tokens(const CtTextParser::tags_map_t& in, CtTextParser::pos_tokens_t& out) {
     for (const auto& token : in) {
         if (!token.first.empty()) {
@@ -99,48 +110,43 @@ CtTextParser::CtTextParser(std::vector<token_schema>&& token_schemas) : _token_s
 
 
 
-std::vector<std::string> CtTextParser::tokenize(const std::string& text) const
+std::vector<std::string_view> CtTextParser::tokenize(std::string_view text) const
 {
+    std::vector<std::string_view> tokens;
+    size_t last_pos{0};
+    for (size_t pos = 0; pos < text.size(); ++pos) {
 
-    std::vector<std::string> tokens;
-    std::string::const_iterator last_pos = text.begin();
-    for (auto ch = text.begin(); ch != text.end(); ++ch) {
-
-        if (*ch == ' ') {
-            if (last_pos != ch) tokens.emplace_back(last_pos, ch);
-            last_pos = ch;
+        if (text[pos] == ' ') {
+            if (last_pos != pos) tokens.push_back(text.substr(last_pos, pos - last_pos));
+            last_pos = pos;
             continue;
         }
-        if (*ch == '\\') {
+        if (text[pos] == '\\') {
             // Escape next char
-            if (last_pos != ch) tokens.emplace_back(last_pos, ch);
-            ++ch;
-            last_pos = ch;
-            if (ch == text.end()) break;
+            if (last_pos != pos) tokens.push_back(text.substr(last_pos, pos - last_pos));
+            ++pos;
+            last_pos = pos;
             continue;
         }
 
-        auto pos_token = _possible_tokens.find(*ch);
-        if (pos_token != _possible_tokens.end()){
-            auto found_token = branch_token(ch, text.end(), pos_token->second);
-            if (found_token) {
-                spdlog::debug("TOKEN: {}", *found_token);
-                tokens.emplace_back(last_pos, ch);
-                tokens.emplace_back(*found_token);
-                ch += found_token->length() - 1;
-                last_pos = ch + 1;
+        auto pos_token = _possible_tokens.find(text[pos]);
+        if (pos_token != _possible_tokens.end()) {
+            const size_t token_len = longest_token_at(text.substr(pos), pos_token->second);
+            if (token_len > 0) {
+                tokens.push_back(text.substr(last_pos, pos - last_pos));
+                tokens.push_back(text.substr(pos, token_len));
+                pos += token_len - 1;
+                last_pos = pos + 1;
             }
-
-            if (ch == text.end()) break;
         }
     }
-    if (last_pos != text.end()) {
-        tokens.emplace_back(last_pos, text.end());
+    if (last_pos < text.size()) {
+        tokens.push_back(text.substr(last_pos));
     }
     return tokens;
 }
 
-std::vector<std::pair<const CtTextParser::token_schema *, std::string>> CtTextParser::parse_tokens(const std::vector<std::string>& tokens) const
+std::vector<std::pair<const CtTextParser::token_schema *, std::string>> CtTextParser::parse_tokens(const std::vector<std::string_view>& tokens) const
 {
     std::vector<std::pair<const token_schema *, std::string>> token_stream;
     std::unordered_map<std::string_view, bool>                open_tags;
@@ -169,21 +175,20 @@ std::vector<std::pair<const CtTextParser::token_schema *, std::string>> CtTextPa
 
                 if (!tokens_iter->second->has_closetag) {
                     // Token will go till end of stream
-                    ++token;
                     if (keep_parsing) {
-                        // Parse the other data in the stream
+                        // Parse the other data in the stream as a new stream
                         token_stream.emplace_back(tokens_iter->second, "");
-                        std::vector<std::string> rem_tokens(token, tokens.end());
-                        auto tokonised_stream = parse_tokens(rem_tokens);
-                        token_stream.insert(token_stream.end(), tokonised_stream.begin(), tokonised_stream.end());
-                    } else {
-                        std::string buff;
-                        while (token != tokens.end()) {
-                            buff += *token;
-                            ++token;
-                        }
-                        token_stream.emplace_back(tokens_iter->second, buff);
+                        open_tags.clear();
+                        curr_open_tags.first.clear();
+                        curr_open_tags.second.clear();
+                        nb_open_tags = 0;
+                        continue;
+                    }
+                    std::string buff;
+                    for (++token; token != tokens.end(); ++token) {
+                        buff += *token;
                     }
+                    token_stream.emplace_back(tokens_iter->second, buff);
                     return token_stream;
                 }
                 open_tags[tokens_iter->first] = true;
@@ -472,7 +477,7 @@ std::pair<Gtk::TextIter, Gtk::TextIter> CtTextParser::find_formatting_boundaries
 
     Glib::ustring token_str(start_bounds, word_end);
 
-    auto tokens = tokenize(token_str);
+    auto tokens = tokenize(token_str.raw());
     auto& close_tags = close_tokens_map();
 
     // Forward match
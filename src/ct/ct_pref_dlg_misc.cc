@@ -59,6 +59,7 @@ Gtk::Widget* CtPrefDlg::build_tab_misc()
 #endif
     auto hbox_custom_backup_dir = Gtk::manage(new Gtk::Box{Gtk::ORIENTATION_HORIZONTAL, 4/*spacing*/});
     auto checkbutton_mfname_on_disk = Gtk::manage(new Gtk::CheckButton{_("Multiple Files Storage, Use Embedded File Name On Disk")});
+    auto checkbutton_sqlite_rich_text_bin = Gtk::manage(new Gtk::CheckButton{_("SQLite Storage, Compact Binary Rich Text (Not Readable by Older Versions)")});
 
 #if GTKMM_MAJOR_VERSION < 4
     hbox_num_backups->pack_start(*label_num_backups, false, false);
@@ -71,6 +72,7 @@ Gtk::Widget* CtPrefDlg::build_tab_misc()
     vbox_saving->pack_start(*hbox_num_backups, false, false);
     vbox_saving->pack_start(*hbox_custom_backup_dir, false, false);
     vbox_saving->pack_start(*checkbutton_mfname_on_disk, false, false);
+    vbox_saving->pack_start(*checkbutton_sqlite_rich_text_bin, false, false);
 #else
     hbox_num_backups->append(*label_num_backups);
     hbox_num_backups->append(*spinbutton_num_backups);
@@ -82,6 +84,7 @@ Gtk::Widget* CtPrefDlg::build_tab_misc()
     vbox_saving->append(*hbox_num_backups);
     vbox_saving->append(*hbox_custom_backup_dir);
     vbox_saving->append(*checkbutton_mfname_on_disk);
+    vbox_saving->append(*checkbutton_sqlite_rich_text_bin);
 #endif
 
     checkbutton_autosave->set_active(_pConfig->autosaveOn);
@@ -100,6 +103,7 @@ Gtk::Widget* CtPrefDlg::build_tab_misc()
 #endif
     file_chooser_button_backup_dir->set_sensitive(_pConfig->backupCopy and _pConfig->customBackupDirOn);
     checkbutton_mfname_on_disk->set_active(_pConfig->embfileMFNameOnDisk);
+    checkbutton_sqlite_rich_text_bin->set_active(_pConfig->sqliteRichTextBin);
 
     Gtk::Frame* frame_saving = new_managed_frame_with_align(_("Saving"), vbox_saving);
 
@@ -399,6 +403,9 @@ Gtk::Widget* CtPrefDlg::build_tab_misc()
     checkbutton_mfname_on_disk->signal_toggled().connect([this, pCheckbutton_mfname_on_disk=checkbutton_mfname_on_disk](){
         _pConfig->embfileMFNameOnDisk = pCheckbutton_mfname_on_disk->get_active();
     });
+    checkbutton_sqlite_rich_text_bin->signal_toggled().connect([this, pCheckbutton_sqlite_rich_text_bin=checkbutton_sqlite_rich_text_bin](){
+        _pConfig->sqliteRichTextBin = pCheckbutton_sqlite_rich_text_bin->get_active();
+    });
     checkbutton_reload_doc_last->signal_toggled().connect([this, pCheckbutton_reload_doc_last=checkbutton_reload_doc_last](){
         _pConfig->reloadDocLast = pCheckbutton_reload_doc_last->get_active();
     });
@@ -190,12 +190,32 @@ Gtk::Widget* CtPrefDlg::build_tab_rich_text()
     auto label_limit_undoable_steps = Gtk::manage(new Gtk::Label{_("Limit of Undoable Steps Per Node")});
     Glib::RefPtr<Gtk::Adjustment> adj_limit_undoable_steps = Gtk::Adjustment::create(_pConfig->limitUndoableSteps, 1, 10000, 1);
     auto spinbutton_limit_undoable_steps = Gtk::manage(new Gtk::SpinButton{adj_limit_undoable_steps});
+    auto label_limit_undoable_mem = Gtk::manage(new Gtk::Label{_("Memory (MB)")});
+    Glib::RefPtr<Gtk::Adjustment> adj_limit_undoable_mem = Gtk::Adjustment::create(_pConfig->limitUndoableMemMb, 1, 4096, 1);
+    auto spinbutton_limit_undoable_mem = Gtk::manage(new Gtk::SpinButton{adj_limit_undoable_mem});
+    spinbutton_limit_undoable_mem->set_tooltip_text(_("Limit of the memory used by the undoable steps of a single node"));
 #if GTKMM_MAJOR_VERSION >= 4
     hbox_misc_text->append(*label_limit_undoable_steps);
     hbox_misc_text->append(*spinbutton_limit_undoable_steps);
+    hbox_misc_text->append(*label_limit_undoable_mem);
+    hbox_misc_text->append(*spinbutton_limit_undoable_mem);
 #else
     hbox_misc_text->pack_start(*label_limit_undoable_steps, false, false);
     hbox_misc_text->pack_start(*spinbutton_limit_undoable_steps, false, false);
+    hbox_misc_text->pack_start(*label_limit_undoable_mem, false, false);
+    hbox_misc_text->pack_start(*spinbutton_limit_undoable_mem, false, false);
+#endif
+    auto hbox_loaded_nodes_mem = Gtk::manage(new Gtk::Box{Gtk::ORIENTATION_HORIZONTAL, 4/*spacing*/});
+    auto label_loaded_nodes_mem = Gtk::manage(new Gtk::Label{_("Memory for Loaded Nodes (MB)")});
+    Glib::RefPtr<Gtk::Adjustment> adj_loaded_nodes_mem = Gtk::Adjustment::create(_pConfig->loadedNodesMemMb, 0, 65536, 16);
+    auto spinbutton_loaded_nodes_mem = Gtk::manage(new Gtk::SpinButton{adj_loaded_nodes_mem});
+    spinbutton_loaded_nodes_mem->set_tooltip_text(_("Above this, the least recently viewed unmodified nodes are unloaded and read again from the document when needed, 0 for no limit"));
+#if GTKMM_MAJOR_VERSION >= 4
+    hbox_loaded_nodes_mem->append(*label_loaded_nodes_mem);
+    hbox_loaded_nodes_mem->append(*spinbutton_loaded_nodes_mem);
+#else
+    hbox_loaded_nodes_mem->pack_start(*label_loaded_nodes_mem, false, false);
+    hbox_loaded_nodes_mem->pack_start(*spinbutton_loaded_nodes_mem, false, false);
 #endif
     auto checkbutton_camelcase_autolink = Gtk::manage(new Gtk::CheckButton{_("Auto Link CamelCase Text to Node With Same Name")});
     checkbutton_camelcase_autolink->set_active(_pConfig->camelCaseAutoLink);
@@ -226,6 +246,7 @@ Gtk::Widget* CtPrefDlg::build_tab_rich_text()
     vbox_misc_text->append(*hbox_embfile_max_size);
     vbox_misc_text->append(*checkbutton_embfile_show_filename);
     vbox_misc_text->append(*hbox_misc_text);
+    vbox_misc_text->append(*hbox_loaded_nodes_mem);
     vbox_misc_text->append(*checkbutton_url_autolink);
     vbox_misc_text->append(*checkbutton_camelcase_autolink);
     vbox_misc_text->append(*checkbutton_triple_click_sel_paragraph);
@@ -241,6 +262,7 @@ Gtk::Widget* CtPrefDlg::build_tab_rich_text()
     vbox_misc_text->pack_start(*checkbutton_embfile_show_filename, false, false);
     vbox_misc_text->pack_start(*checkbutton_object_no_sel_on_click, false, false);
     vbox_misc_text->pack_start(*hbox_misc_text, false, false);
+    vbox_misc_text->pack_start(*hbox_loaded_nodes_mem, false, false);
     vbox_misc_text->pack_start(*checkbutton_url_autolink, false, false);
     vbox_misc_text->pack_start(*checkbutton_camelcase_autolink, false, false);
     vbox_misc_text->pack_start(*checkbutton_triple_click_sel_paragraph, false, false);
@@ -335,6 +357,14 @@ Gtk::Widget* CtPrefDlg::build_tab_rich_text()
     spinbutton_limit_undoable_steps->signal_value_changed().connect([this, spinbutton_limit_undoable_steps](){
         _pConfig->limitUndoableSteps = spinbutton_limit_undoable_steps->get_value_as_int();
     });
+    spinbutton_limit_undoable_mem->signal_value_changed().connect([this, spinbutton_limit_undoable_mem](){
+        _pConfig->limitUndoableMemMb = spinbutton_limit_undoable_mem->get_value_as_int();
+    });
+    spinbutton_loaded_nodes_mem->signal_value_changed().connect([this, spinbutton_loaded_nodes_mem](){
+        _pConfig->loadedNodesMemMb = spinbutton_loaded_nodes_mem->get_value_as_int();
+        _pCtMainWin->get_tree_store().loaded_buffers_limit();
+        _pCtMainWin->update_selected_node_statusbar_info();
+    });
     checkbutton_camelcase_autolink->signal_toggled().connect([this, checkbutton_camelcase_autolink]{
         _pConfig->camelCaseAutoLink = checkbutton_camelcase_autolink->get_active();
     });
@@ -0,0 +1,318 @@
+/*
+ * ct_rich_text_bin.cc
+ *
+ * Copyright 2009-2026
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "ct_rich_text_bin.h"
+#include "ct_main_win.h"
+#include "ct_misc_utils.h"
+#include "ct_storage_xml.h"
+#include "ct_logging.h"
+#include <libxml++/libxml++.h>
+#include <cstring>
+
+// GtkSourceView 5 removed begin/end_not_undoable_action
+#if GTK_SOURCE_CHECK_VERSION(5, 0, 0)
+#define CT_SOURCE_BUFFER_BEGIN_NOT_UNDOABLE(buf) /* no-op */
+#define CT_SOURCE_BUFFER_END_NOT_UNDOABLE(buf)   /* no-op */
+#else
+#define CT_SOURCE_BUFFER_BEGIN_NOT_UNDOABLE(buf) gtk_source_buffer_begin_not_undoable_action(buf)
+#define CT_SOURCE_BUFFER_END_NOT_UNDOABLE(buf)   gtk_source_buffer_end_not_undoable_action(buf)
+#endif
+
+/*
+ * MAGIC, VERSION byte
+ * varint number of attribute sets, each: varint number of attributes, each: CtTagAttr byte, varint size, value
+ * varint number of runs, each: varint attribute set id, varint text size in bytes
+ * the text of all the runs
+ */
+/*static*/const char CtRichTextBin::MAGIC[]{"CTRTB"};
+/*static*/const uint8_t CtRichTextBin::VERSION{1u};
+
+namespace {
+
+const size_t MagicLen{sizeof(CtRichTextBin::MAGIC) - 1u};
+
+void write_varint(std::string& out, uint64_t val)
+{
+    while (val >= 0x80u) {
+        out.push_back(static_cast<char>((val & 0x7fu) | 0x80u));
+        val >>= 7;
+    }
+    out.push_back(static_cast<char>(val));
+}
+
+bool read_varint(std::string_view data, size_t& pos, uint64_t& val)
+{
+    val = 0u;
+    for (unsigned shift = 0u; shift < 64u; shift += 7u) {
+        if (pos >= data.size()) return false;
+        const auto byte = static_cast<uint8_t>(data[pos++]);
+        val |= static_cast<uint64_t>(byte & 0x7fu) << shift;
+        if (0u == (byte & 0x80u)) return true;
+    }
+    return false;
+}
+
+// interns the attribute sets while the runs are added
+class BinEncoder
+{
+public:
+    void add_run(CtRichTextBin::AttrSet attrSet, const std::string& text) {
+        std::string key;
+        for (const auto& attr : attrSet) {
+            key.push_back(static_cast<char>(attr.first));
+            write_varint(key, attr.second.size());
+            key += attr.second;
+        }
+        auto it = _attrSetIds.find(key);
+        if (it == _attrSetIds.end()) {
+            it = _attrSetIds.emplace(std::move(key), static_cast<uint32_t>(_attrSets.size())).first;
+            _attrSets.push_back(std::move(attrSet));
+        }
+        _runs.push_back(CtRichTextBin::Run{it->second, static_cast<uint32_t>(text.size())});
+        _text += text;
+    }
+    std::string get_data() const {
+        std::string data{CtRichTextBin::MAGIC, MagicLen};
+        data.push_back(static_cast<char>(CtRichTextBin::VERSION));
+        write_varint(data, _attrSets.size());
+        for (const CtRichTextBin::AttrSet& attrSet : _attrSets) {
+            write_varint(data, attrSet.size());
+            for (const auto& attr : attrSet) {
+                data.push_back(static_cast<char>(attr.first));
+                write_varint(data, attr.second.size());
+                data += attr.second;
+            }
+        }
+        write_varint(data, _runs.size());
+        for (const CtRichTextBin::Run& run : _runs) {
+            write_varint(data, run.attrSetId);
+            write_varint(data, run.textBytes);
+        }
+        return data + _text;
+    }
+
+private:
+    std::unordered_map<std::string, uint32_t> _attrSetIds;
+    std::vector<CtRichTextBin::AttrSet>         _attrSets;
+    std::vector<CtRichTextBin::Run>             _runs;
+    std::string                                 _text;
+};
+
+} // namespace
+
+/*static*/bool CtRichTextBin::is_bin(const char* pData, const size_t dataSize)
+{
+    return pData and dataSize > MagicLen and 0 == memcmp(pData, MAGIC, MagicLen);
+}
+
+/*static*/bool CtRichTextBin::decode(std::string_view data, Body& body)
+{
+    body = Body{};
+    if (not is_bin(data.data(), data.size())) {
+        return false;
+    }
+    const auto version = static_cast<uint8_t>(data[MagicLen]);
+    if (version > VERSION) {
+        spdlog::error("!! rich text bin version {} > {}", static_cast<unsigned>(version), static_cast<unsigned>(VERSION));
+        return false;
+    }
+    size_t pos{MagicLen + 1u};
+    uint64_t numAttrSets;
+    if (not read_varint(data, pos, numAttrSets) or numAttrSets > data.size()) {
+        return false;
+    }
+    body.attrSets.resize(numAttrSets);
+    for (AttrSet& attrSet : body.attrSets) {
+        uint64_t numAttrs;
+        if (not read_varint(data, pos, numAttrs) or numAttrs > CtCurrAttributes::Size) {
+            return false;
+        }
+        for (uint64_t i = 0; i < numAttrs; ++i) {
+            if (pos >= data.size()) return false;
+            const auto attrIdx = static_cast<uint8_t>(data[pos++]);
+            uint64_t valueSize;
+            if (attrIdx >= CtCurrAttributes::Size or not read_varint(data, pos, valueSize) or valueSize > data.size() - pos) {
+                return false;
+            }
+            attrSet.emplace_back(static_cast<CtTagAttr>(attrIdx), std::string{data.substr(pos, valueSize)});
+            pos += valueSize;
+        }
+    }
+    uint64_t numRuns;
+    if (not read_varint(data, pos, numRuns) or numRuns > data.size()) {
+        return false;
+    }
+    body.runs.resize(numRuns);
+    uint64_t textBytes{0u};
+    for (Run& run : body.runs) {
+        uint64_t attrSetId, runBytes;
+        if (not read_varint(data, pos, attrSetId) or attrSetId >= numAttrSets or
+            not read_varint(data, pos, runBytes) or runBytes > data.size())
+        {
+            return false;
+        }
+        run.attrSetId = static_cast<uint32_t>(attrSetId);
+        run.textBytes = static_cast<uint32_t>(runBytes);
+        textBytes += runBytes;
+    }
+    if (textBytes != data.size() - pos) {
+        return false;
+    }
+    body.text = data.substr(pos);
+    // every run is inserted on its own
+    size_t textPos{0u};
+    for (const Run& run : body.runs) {
+        if (not g_utf8_validate(body.text.data() + textPos, run.textBytes, nullptr)) {
+            return false;
+        }
+        textPos += run.textBytes;
+    }
+    return true;
+}
+
+/*static*/std::string CtRichTextBin::from_buffer(const CtConfig* pCtConfig,
+                                                 const Glib::RefPtr<Gtk::TextBuffer>& pTextBuffer,
+                                                 const int start_offset,
+                                                 const int end_offset)
+{
+    BinEncoder binEncoder;
+    CtTextIterUtil::SerializeFunc f_bin_serialize = [&binEncoder](Gtk::TextIter& start_iter,
+                                                                  Gtk::TextIter& end_iter,
+                                                                  CtCurrAttributes& curr_attributes,
+                                                                  CtListInfo*/*pCurrListInfo*/)
+    {
+        AttrSet attrSet;
+        for (size_t i = 0; i < CtCurrAttributes::Size; ++i) {
+            if (not curr_attributes[i].empty()) {
+                attrSet.emplace_back(static_cast<CtTagAttr>(i), curr_attributes[i]);
+            }
+        }
+        binEncoder.add_run(std::move(attrSet), start_iter.get_text(end_iter).raw());
+    };
+    CtTextIterUtil::generic_process_slot(pCtConfig, start_offset, end_offset, pTextBuffer, f_bin_serialize);
+    return binEncoder.get_data();
+}
+
+/*static*/std::string CtRichTextBin::from_xml(const Glib::ustring& xml_content)
+{
+    xmlpp::DomParser parser;
+    if (not CtXmlHelper::safe_parse_memory(parser, xml_content)) {
+        throw std::runtime_error("rich text xml parse failed");
+    }
+    return from_xml_element(parser.get_document()->get_root_node());
+}
+
+/*static*/std::string CtRichTextBin::from_xml_element(const xmlpp::Element* pNodeElement)
+{
+    BinEncoder binEncoder;
+    for (const xmlpp::Node* pChild : pNodeElement->get_children()) {
+        auto pSlotElement = dynamic_cast<const xmlpp::Element*>(pChild);
+        if (not pSlotElement) {
+            continue;
+        }
+        if ("rich_text" != pSlotElement->get_name()) {
+            throw std::runtime_error("unexp slot " + pSlotElement->get_name());
+        }
+        AttrSet attrSet;
+        for (size_t i = 0; i < CtCurrAttributes::Size; ++i) {
+            const Glib::ustring value = pSlotElement->get_attribute_value(CtConst::TAG_PROPERTIES[i].data());
+            if (not value.empty()) {
+                attrSet.emplace_back(static_cast<CtTagAttr>(i), value.raw());
+            }
+        }
+        const xmlpp::TextNode* pTextNode = pSlotElement->get_child_text();
+        binEncoder.add_run(std::move(attrSet), pTextNode ? pTextNode->get_content().raw() : "");
+    }
+    return binEncoder.get_data();
+}
+
+/*static*/std::string CtRichTextBin::to_xml(std::string_view data)
+{
+    Body body;
+    if (not decode(data, body)) {
+        return "";
+    }
+    xmlpp::Document xml_doc;
+    xmlpp::Element* p_node_elem = xml_doc.create_root_node("node");
+    size_t textPos{0u};
+    for (const Run& run : body.runs) {
+        xmlpp::Element* p_rich_text_elem = p_node_elem->add_child("rich_text");
+        for (const auto& attr : body.attrSets[run.attrSetId]) {
+            p_rich_text_elem->set_attribute(CtConst::TAG_PROPERTIES[static_cast<size_t>(attr.first)].data(), attr.second);
+        }
+        if (run.textBytes > 0u) {
+            p_rich_text_elem->add_child_text(std::string{body.text.substr(textPos, run.textBytes)});
+        }
+        textPos += run.textBytes;
+    }
+    return xml_doc.write_to_string();
+}
+
+/*static*/Glib::RefPtr<Gtk::TextBuffer> CtRichTextBin::create_buffer(CtMainWin* pCtMainWin, std::string_view data)
+{
+    Body body;
+    if (not decode(data, body)) {
+        return Glib::RefPtr<Gtk::TextBuffer>{};
+    }
+    // the text tags of every attribute set, resolved once
+    Glib::RefPtr<Gtk::TextTagTable> rTagTable = pCtMainWin->get_text_tag_table();
+    std::vector<std::vector<GtkTextTag*>> attrSetsTags(body.attrSets.size());
+    for (size_t setId = 0; setId < body.attrSets.size(); ++setId) {
+        for (const auto& attr : body.attrSets[setId]) {
+            const std::string tagName = pCtMainWin->get_text_tag_name_exist_or_create(
+                CtConst::TAG_PROPERTIES[static_cast<size_t>(attr.first)].data(), attr.second);
+            if (Glib::RefPtr<Gtk::TextTag> rTag = rTagTable->lookup(tagName)) {
+                attrSetsTags[setId].push_back(rTag->gobj());
+            }
+        }
+    }
+
+    Glib::RefPtr<Gtk::TextBuffer> pBuffer = pCtMainWin->get_new_text_buffer();
+    GtkTextBuffer* pGtkTextBuffer = pBuffer->gobj();
+    #if !GTK_SOURCE_CHECK_VERSION(5, 0, 0)
+    auto pGtkSourceBuffer = GTK_SOURCE_BUFFER(pGtkTextBuffer);
+    #endif
+    CT_SOURCE_BUFFER_BEGIN_NOT_UNDOABLE(pGtkSourceBuffer);
+    GtkTextIter iterEnd;
+    gtk_text_buffer_get_end_iter(pGtkTextBuffer, &iterEnd);
+    size_t textPos{0u};
+    for (const Run& run : body.runs) {
+        if (0u == run.textBytes) {
+            continue;
+        }
+        const int startOffset = gtk_text_iter_get_offset(&iterEnd);
+        gtk_text_buffer_insert(pGtkTextBuffer, &iterEnd, body.text.data() + textPos, static_cast<gint>(run.textBytes));
+        textPos += run.textBytes;
+        const std::vector<GtkTextTag*>& runTags = attrSetsTags[run.attrSetId];
+        if (not runTags.empty()) {
+            GtkTextIter iterStart;
+            gtk_text_buffer_get_iter_at_offset(pGtkTextBuffer, &iterStart, startOffset);
+            for (GtkTextTag* pTag : runTags) {
+                gtk_text_buffer_apply_tag(pGtkTextBuffer, pTag, &iterStart, &iterEnd);
+            }
+        }
+    }
+    CT_SOURCE_BUFFER_END_NOT_UNDOABLE(pGtkSourceBuffer);
+    pBuffer->set_modified(false);
+    return pBuffer;
+}
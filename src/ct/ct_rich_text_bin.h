@@ -0,0 +1,77 @@
+/*
+ * ct_rich_text_bin.h
+ *
+ * Copyright 2009-2026
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#pragma once
+
+#include "ct_types.h"
+#include <gtkmm/textbuffer.h>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+class CtConfig;
+class CtMainWin;
+namespace xmlpp {
+class Element;
+}
+
+/**
+ * @brief Compact binary form of the rich text of a node body, alternative to the <rich_text> xml slots
+ * The UTF-8 text is preceded by a table of runs, each referring to an interned set of attributes,
+ * so that loading resolves the text tags once per set instead of once per run.
+ * The body starts with MAGIC and the format version; it converts to and from the xml form losslessly.
+ */
+class CtRichTextBin
+{
+public:
+    static const char    MAGIC[];
+    static const uint8_t VERSION;
+
+    using AttrSet = std::vector<std::pair<CtTagAttr, std::string>>; // sorted by CtTagAttr
+    struct Run {
+        uint32_t attrSetId{0};
+        uint32_t textBytes{0};
+    };
+    struct Body {
+        std::vector<AttrSet> attrSets;
+        std::vector<Run>     runs;
+        std::string_view     text; // into the decoded data
+    };
+
+    static bool is_bin(const char* pData, const size_t dataSize);
+    // returns false on a body that is truncated, corrupted or of a newer version
+    static bool decode(std::string_view data, Body& body);
+
+    static std::string from_buffer(const CtConfig* pCtConfig,
+                                   const Glib::RefPtr<Gtk::TextBuffer>& pTextBuffer,
+                                   const int start_offset,
+                                   const int end_offset);
+    // throws std::runtime_error on an xml that is not rich text slots only
+    static std::string from_xml(const Glib::ustring& xml_content);
+    static std::string from_xml_element(const xmlpp::Element* pNodeElement);
+    // returns an empty string on a bad body
+    static std::string to_xml(std::string_view data);
+
+    // returns a null RefPtr on a bad body
+    static Glib::RefPtr<Gtk::TextBuffer> create_buffer(CtMainWin* pCtMainWin, std::string_view data);
+};
@@ -0,0 +1,461 @@
+/*
+ * ct_search_index.cc
+ *
+ * Copyright 2009-2026
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "ct_search_index.h"
+#include "ct_treestore.h"
+#include "ct_image.h"
+#include "ct_codebox.h"
+#include "ct_table.h"
+#include "ct_misc_utils.h"
+#include "ct_logging.h"
+#include <glib/gstdio.h>
+#include <algorithm>
+#include <cstring>
+
+/*static*/const char CtSearchIndex::SIDECAR_MAGIC[]{"CTIDX2\n"};
+
+namespace {
+
+constexpr unsigned BloomNumHashes{4u};
+constexpr size_t BloomBitsPerTrigram{8u};
+constexpr size_t BloomMinBits{256u};
+constexpr size_t BloomMaxBits{1u << 20};
+
+guint64 splitmix64(guint64 x)
+{
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+template<typename F>
+void bloom_for_each_bit(const guint64 trigram, const size_t numBits, F f)
+{
+    const guint64 h1 = splitmix64(trigram);
+    const guint64 h2 = splitmix64(h1 ^ 0x5851f42d4c957f2dULL) | 1u;
+    for (unsigned i = 0; i < BloomNumHashes; ++i) {
+        f((h1 + i*h2) & (numBits - 1u));
+    }
+}
+
+// the chars that can follow a backslash without consuming further chars of the pattern
+// and without matching a literal sequence, they just interrupt the current literal run
+bool is_simple_class_escape(const gunichar ch)
+{
+    return ch < 128u and nullptr != strchr("bBdDwWsShHvVRXKAzZGnrtfae", static_cast<char>(ch));
+}
+
+} // namespace (anonymous)
+
+/*static*/std::vector<guint64> CtSearchIndex::text_to_trigrams(const Glib::ustring& text)
+{
+    std::vector<guint64> retTrigrams;
+    guint64 window{0};
+    size_t numChars{0};
+    for (const gunichar ch : text) {
+        window = ((window << 21) | (g_unichar_tolower(ch) & 0x1fffffu)) & 0x7fffffffffffffffULL;
+        if (++numChars >= TrigramLen) {
+            retTrigrams.push_back(window);
+        }
+    }
+    std::sort(retTrigrams.begin(), retTrigrams.end());
+    retTrigrams.erase(std::unique(retTrigrams.begin(), retTrigrams.end()), retTrigrams.end());
+    return retTrigrams;
+}
+
+/*static*/CtSearchIndex::Entry CtSearchIndex::entry_from_text(const Glib::ustring& text, const gint64 tsLastSave)
+{
+    const std::vector<guint64> trigrams = text_to_trigrams(text);
+    size_t numBits{BloomMinBits};
+    while (numBits < trigrams.size()*BloomBitsPerTrigram and numBits < BloomMaxBits) {
+        numBits <<= 1;
+    }
+    Entry retEntry;
+    retEntry.tsLastSave = tsLastSave;
+    retEntry.bloom.assign(numBits/64u, 0u);
+    for (const guint64 trigram : trigrams) {
+        bloom_for_each_bit(trigram, numBits, [&](const guint64 bit){
+            retEntry.bloom[bit/64u] |= (1ULL << (bit%64u));
+        });
+    }
+    return retEntry;
+}
+
+/*static*/bool CtSearchIndex::entry_may_contain(const Entry& entry, const std::vector<Glib::ustring>& literals)
+{
+    const size_t numBits = entry.bloom.size()*64u;
+    if (0u == numBits or 0u != (numBits & (numBits - 1u))) {
+        return true; // corrupted entry, cannot exclude
+    }
+    for (const Glib::ustring& literal : literals) {
+        for (const guint64 trigram : text_to_trigrams(literal)) {
+            bool allBitsSet{true};
+            bloom_for_each_bit(trigram, numBits, [&](const guint64 bit){
+                if (0u == (entry.bloom[bit/64u] & (1ULL << (bit%64u)))) {
+                    allBitsSet = false;
+                }
+            });
+            if (not allBitsSet) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/*static*/std::optional<std::vector<Glib::ustring>> CtSearchIndex::regex_get_required_literals(const Glib::ustring& pattern)
+{
+    const std::vector<gunichar> chars(pattern.begin(), pattern.end());
+    const size_t numChars = chars.size();
+    std::vector<Glib::ustring> retLiterals;
+    Glib::ustring currRun;
+    auto f_flush = [&](){
+        if (currRun.size() >= TrigramLen) {
+            retLiterals.push_back(currRun);
+        }
+        currRun.clear();
+    };
+    auto f_dropLast = [&](){
+        if (not currRun.empty()) {
+            currRun.erase(currRun.size() - 1u);
+        }
+    };
+    // returns the index of the closing ']' or numChars if not found
+    auto f_skipCharClass = [&](size_t i)->size_t{
+        ++i; // '['
+        if (i < numChars and '^' == chars[i]) ++i;
+        if (i < numChars and ']' == chars[i]) ++i; // literal ']' at start of class
+        while (i < numChars and ']' != chars[i]) {
+            if ('\\' == chars[i]) {
+                i += 2u;
+            }
+            else if ('[' == chars[i] and i+1u < numChars and ':' == chars[i+1u]) {
+                // posix class [:alpha:]
+                i += 2u;
+                while (i+1u < numChars and not (':' == chars[i] and ']' == chars[i+1u])) ++i;
+                i += 2u;
+            }
+            else {
+                ++i;
+            }
+        }
+        return i;
+    };
+    // returns true if at i there is a valid {n}, {n,}, {n,m}, {,m} quantifier, setting the closing brace index
+    auto f_isQuantifier = [&](const size_t i, size_t& closeIdx)->bool{
+        size_t j = i + 1u;
+        bool hasDigits{false};
+        bool hasComma{false};
+        for (; j < numChars and '}' != chars[j]; ++j) {
+            if (g_unichar_isdigit(chars[j])) hasDigits = true;
+            else if (',' == chars[j] and not hasComma) hasComma = true;
+            else return false;
+        }
+        if (j >= numChars or not hasDigits) return false;
+        closeIdx = j;
+        return true;
+    };
+
+    for (size_t i = 0; i < numChars; ++i) {
+        const gunichar ch = chars[i];
+        switch (ch) {
+            case '\\': {
+                if (i+1u >= numChars) return std::nullopt;
+                const gunichar nextCh = chars[++i];
+                if (g_unichar_isalnum(nextCh)) {
+                    // \x.. \p{..} \Q..\E back references etc. are not worth the effort
+                    if (not is_simple_class_escape(nextCh)) return std::nullopt;
+                    f_flush();
+                }
+                else {
+                    currRun += nextCh;
+                }
+            } break;
+            case '[': {
+                i = f_skipCharClass(i);
+                if (i >= numChars) return std::nullopt;
+                f_flush();
+            } break;
+            case '(': {
+                if (i+1u < numChars and '?' == chars[i+1u]) {
+                    // inline options, (?x) would make white spaces meaningless
+                    for (size_t j = i+2u; j < numChars and g_unichar_isalpha(chars[j]); ++j) {
+                        if ('x' == chars[j]) return std::nullopt;
+                    }
+                }
+                int depth{0};
+                for (; i < numChars; ++i) {
+                    if ('\\' == chars[i]) { ++i; }
+                    else if ('[' == chars[i]) { i = f_skipCharClass(i); }
+                    else if ('(' == chars[i]) { ++depth; }
+                    else if (')' == chars[i]) { if (0 == --depth) break; }
+                }
+                if (i >= numChars) return std::nullopt;
+                f_flush();
+            } break;
+            case ')':
+            case '|':
+                return std::nullopt;
+            case '.':
+            case '^':
+            case '$':
+            case '+':
+                f_flush();
+                break;
+            case '?':
+            case '*':
+                f_dropLast();
+                f_flush();
+                break;
+            case '{': {
+                size_t closeIdx{0};
+                if (f_isQuantifier(i, closeIdx)) {
+                    f_dropLast();
+                    f_flush();
+                    i = closeIdx;
+                }
+                else {
+                    currRun += ch;
+                }
+            } break;
+            default:
+                currRun += ch;
+                break;
+        }
+    }
+    f_flush();
+    if (retLiterals.empty()) {
+        return std::nullopt;
+    }
+    return retLiterals;
+}
+
+/*static*/std::string CtSearchIndex::bloom_to_blob(const std::vector<guint64>& bloom)
+{
+    return std::string{reinterpret_cast<const char*>(bloom.data()), bloom.size()*sizeof(guint64)};
+}
+
+/*static*/bool CtSearchIndex::bloom_from_blob(const void* pData, const size_t dataSize, std::vector<guint64>& bloom)
+{
+    if (not pData or 0u == dataSize or 0u != (dataSize % sizeof(guint64))) {
+        return false;
+    }
+    bloom.resize(dataSize/sizeof(guint64));
+    memcpy(bloom.data(), pData, dataSize);
+    return true;
+}
+
+/*static*/fs::path CtSearchIndex::get_sidecar_path(const fs::path& doc_file_path)
+{
+    return doc_file_path.parent_path() / ("." + doc_file_path.filename().string() + ".ctidx");
+}
+
+/*static*/CtSearchIndex::DocStamp CtSearchIndex::get_doc_stamp(const std::vector<fs::path>& file_paths)
+{
+    DocStamp docStamp{0, 0};
+    for (const fs::path& file_path : file_paths) {
+        GStatBuf st;
+        if (g_stat(file_path.c_str(), &st) != 0) {
+            return DocStamp{};
+        }
+        docStamp.size += static_cast<gint64>(st.st_size);
+        docStamp.mtime = std::max(docStamp.mtime, static_cast<gint64>(st.st_mtime));
+    }
+    return docStamp;
+}
+
+void CtSearchIndex::set_entry(const gint64 node_id, Entry entry)
+{
+    _entries[node_id] = std::move(entry);
+    _dirtyIds.insert(node_id);
+    _removedIds.erase(node_id);
+}
+
+void CtSearchIndex::remove_entry(const gint64 node_id)
+{
+    _entries.erase(node_id);
+    _dirtyIds.erase(node_id);
+    _removedIds.insert(node_id);
+}
+
+const CtSearchIndex::Entry* CtSearchIndex::get_entry(const gint64 node_id) const
+{
+    auto it = _entries.find(node_id);
+    return it != _entries.end() ? &it->second : nullptr;
+}
+
+void CtSearchIndex::clear()
+{
+    _entries.clear();
+    clear_dirty();
+}
+
+void CtSearchIndex::update_from_tree_iter(const CtTreeIter& ctTreeIter)
+{
+    Glib::RefPtr<Gtk::TextBuffer> pTextBuffer = ctTreeIter.get_node_text_buffer();
+    if (not pTextBuffer) {
+        return;
+    }
+    Glib::ustring text = pTextBuffer->get_text();
+    std::list<CtAnchoredWidget*> widgets = ctTreeIter.get_anchored_widgets(-1, -1, true/*also_links*/);
+    for (CtAnchoredWidget* pAnchWidg : widgets) {
+        switch (pAnchWidg->get_type()) {
+            case CtAnchWidgType::ImageEmbFile: {
+                if (auto pImageEmbFile = dynamic_cast<CtImageEmbFile*>(pAnchWidg)) {
+                    text += "\n" + pImageEmbFile->get_file_name().string();
+                }
+            } break;
+            case CtAnchWidgType::ImageAnchor: {
+                if (auto pImageAnchor = dynamic_cast<CtImageAnchor*>(pAnchWidg)) {
+                    text += "\n" + pImageAnchor->get_anchor_name();
+                }
+            } break;
+            case CtAnchWidgType::ImagePng: {
+                if (auto pImagePng = dynamic_cast<CtImagePng*>(pAnchWidg)) {
+                    CtLinkEntry link_entry = CtMiscUtil::get_link_entry_from_property(pImagePng->get_link());
+                    if (CtLinkType::None != link_entry.type) {
+                        text += "\n" + link_entry.get_target_searchable();
+                    }
+                }
+            } break;
+            case CtAnchWidgType::Link: {
+                if (auto pAnchWidgLink = dynamic_cast<CtAnchWidgLink*>(pAnchWidg)) {
+                    text += "\n" + pAnchWidgLink->get_target_searchable();
+                }
+            } break;
+            case CtAnchWidgType::CodeBox: {
+                if (auto pCodebox = dynamic_cast<CtCodebox*>(pAnchWidg)) {
+                    text += "\n" + pCodebox->get_text_content();
+                }
+            } break;
+            case CtAnchWidgType::TableHeavy:
+            case CtAnchWidgType::TableLight: {
+                if (auto pTable = dynamic_cast<CtTableCommon*>(pAnchWidg)) {
+                    std::vector<std::vector<Glib::ustring>> rows;
+                    pTable->write_strings_matrix(rows);
+                    for (const auto& row : rows) {
+                        for (const Glib::ustring& cell : row) {
+                            text += "\n" + cell;
+                        }
+                    }
+                }
+            } break;
+            default:
+                break;
+        }
+    }
+    // cleanup for get_anchored_widgets with also_links!
+    for (CtAnchoredWidget* pAnchWidg : widgets) {
+        if (CtAnchWidgType::Link == pAnchWidg->get_type()) {
+            delete pAnchWidg;
+        }
+    }
+    set_entry(ctTreeIter.get_node_id_data_holder(), entry_from_text(text, ctTreeIter.get_node_modification_time()));
+}
+
+std::optional<bool> CtSearchIndex::node_may_contain(const CtTreeIter& ctTreeIter, const std::vector<Glib::ustring>& literals) const
+{
+    const Entry* pEntry = get_entry(ctTreeIter.get_node_id_data_holder());
+    if (not pEntry or pEntry->tsLastSave != ctTreeIter.get_node_modification_time()) {
+        return std::nullopt;
+    }
+    return entry_may_contain(*pEntry, literals);
+}
+
+// sidecar layout: magic, doc_size(gint64), doc_mtime(gint64),
+// then for each entry: node_id(gint64), ts_lastsave(gint64), num_words(guint64), words(guint64[])
+bool CtSearchIndex::load_from_sidecar(const fs::path& sidecar_path, const DocStamp& docStamp)
+{
+    _entries.clear();
+    clear_dirty();
+    if (not fs::is_regular_file(sidecar_path)) {
+        return false;
+    }
+    gchar* pContents{nullptr};
+    gsize contentsSize{0};
+    if (not g_file_get_contents(sidecar_path.c_str(), &pContents, &contentsSize, nullptr)) {
+        spdlog::warn("{} failed reading {}", __FUNCTION__, sidecar_path.string());
+        return false;
+    }
+    auto on_scope_exit = scope_guard([pContents](void*) { g_free(pContents); });
+    const size_t magicLen = strlen(SIDECAR_MAGIC);
+    if (contentsSize < magicLen or 0 != memcmp(pContents, SIDECAR_MAGIC, magicLen)) {
+        spdlog::warn("{} unexpected format {}", __FUNCTION__, sidecar_path.string());
+        return false;
+    }
+    size_t pos{magicLen};
+    auto f_read64 = [&](guint64& val)->bool{
+        if (pos + sizeof(guint64) > contentsSize) return false;
+        memcpy(&val, pContents + pos, sizeof(guint64));
+        pos += sizeof(guint64);
+        return true;
+    };
+    guint64 docSize, docMtime;
+    if (not f_read64(docSize) or not f_read64(docMtime)) {
+        spdlog::warn("{} truncated {}", __FUNCTION__, sidecar_path.string());
+        return false;
+    }
+    if (DocStamp{static_cast<gint64>(docSize), static_cast<gint64>(docMtime)} != docStamp or docStamp.size < 0) {
+        spdlog::debug("{} outdated {}", __FUNCTION__, sidecar_path.string());
+        return false;
+    }
+    while (pos < contentsSize) {
+        guint64 nodeId, tsLastSave, numWords;
+        if (not f_read64(nodeId) or not f_read64(tsLastSave) or not f_read64(numWords) or
+            numWords > (contentsSize - pos)/sizeof(guint64))
+        {
+            spdlog::warn("{} truncated {}", __FUNCTION__, sidecar_path.string());
+            _entries.clear();
+            return false;
+        }
+        Entry& entry = _entries[static_cast<gint64>(nodeId)];
+        entry.tsLastSave = static_cast<gint64>(tsLastSave);
+        (void)bloom_from_blob(pContents + pos, numWords*sizeof(guint64), entry.bloom);
+        pos += numWords*sizeof(guint64);
+    }
+    return true;
+}
+
+bool CtSearchIndex::save_to_sidecar(const fs::path& sidecar_path, const DocStamp& docStamp) const
+{
+    std::string contents{SIDECAR_MAGIC};
+    auto f_write64 = [&contents](const guint64 val){
+        contents.append(reinterpret_cast<const char*>(&val), sizeof(guint64));
+    };
+    f_write64(static_cast<guint64>(docStamp.size));
+    f_write64(static_cast<guint64>(docStamp.mtime));
+    for (const auto& currPair : _entries) {
+        f_write64(static_cast<guint64>(currPair.first));
+        f_write64(static_cast<guint64>(currPair.second.tsLastSave));
+        f_write64(currPair.second.bloom.size());
+        contents += bloom_to_blob(currPair.second.bloom);
+    }
+    GError* pError{nullptr};
+    if (not g_file_set_contents(sidecar_path.c_str(), contents.c_str(), (gssize)contents.size(), &pError)) {
+        spdlog::warn("{} {} {}", __FUNCTION__, sidecar_path.string(), pError ? pError->message : "");
+        if (pError) g_error_free(pError);
+        return false;
+    }
+    return true;
+}
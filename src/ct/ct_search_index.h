@@ -0,0 +1,110 @@
+/*
+ * ct_search_index.h
+ *
+ * Copyright 2009-2026
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#pragma once
+
+#include "ct_filesystem.h"
+#include <glibmm/ustring.h>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class CtTreeIter;
+
+/**
+ * @brief Per node trigram index of the searchable text
+ * Every node is summarised by a bloom filter of the lowercase trigrams of its text
+ * (plus the searchable strings of its anchored widgets), so that a search across
+ * the whole tree can skip the nodes that cannot contain the pattern without
+ * loading their text buffer. An entry is valid only while the node modification
+ * time matches the one recorded at indexing time.
+ */
+class CtSearchIndex
+{
+public:
+    struct Entry {
+        gint64 tsLastSave{0};
+        std::vector<guint64> bloom;
+    };
+
+    static constexpr size_t TrigramLen{3u};
+    static const char SIDECAR_MAGIC[];
+
+    static std::vector<guint64> text_to_trigrams(const Glib::ustring& text);
+    static Entry entry_from_text(const Glib::ustring& text, const gint64 tsLastSave);
+    static bool entry_may_contain(const Entry& entry, const std::vector<Glib::ustring>& literals);
+
+    /**
+     * @brief Get the literal substrings that every match of the regular expression must contain
+     * @param pattern: The regular expression as entered by the user
+     * @return std::nullopt if no literal can be safely extracted (e.g. alternation)
+     */
+    static std::optional<std::vector<Glib::ustring>> regex_get_required_literals(const Glib::ustring& pattern);
+
+    static std::string bloom_to_blob(const std::vector<guint64>& bloom);
+    static bool bloom_from_blob(const void* pData, const size_t dataSize, std::vector<guint64>& bloom);
+
+    static fs::path get_sidecar_path(const fs::path& doc_file_path);
+
+    // the total size and the latest modification time of the files of the document when indexed;
+    // the modification time alone misses an external change within the same second as the save
+    struct DocStamp {
+        gint64 size{-1};
+        gint64 mtime{-1};
+        bool operator==(const DocStamp& other) const { return size == other.size and mtime == other.mtime; }
+        bool operator!=(const DocStamp& other) const { return not (*this == other); }
+    };
+    static DocStamp get_doc_stamp(const std::vector<fs::path>& file_paths);
+
+    void set_entry(const gint64 node_id, Entry entry);
+    void remove_entry(const gint64 node_id);
+    const Entry* get_entry(const gint64 node_id) const;
+    const std::unordered_map<gint64, Entry>& get_entries() const { return _entries; }
+    size_t size() const { return _entries.size(); }
+    void clear();
+
+    /**
+     * @brief (Re)index the node, loading its text buffer if not already loaded
+     */
+    void update_from_tree_iter(const CtTreeIter& ctTreeIter);
+    /**
+     * @brief Check the node against the index without loading its text buffer
+     * @return std::nullopt if there is no up to date entry for the node
+     */
+    std::optional<bool> node_may_contain(const CtTreeIter& ctTreeIter, const std::vector<Glib::ustring>& literals) const;
+
+    // entries changed/removed since the latest persist, for the storages that can write incrementally
+    const std::unordered_set<gint64>& get_dirty_ids() const { return _dirtyIds; }
+    const std::unordered_set<gint64>& get_removed_ids() const { return _removedIds; }
+    void clear_dirty() { _dirtyIds.clear(); _removedIds.clear(); }
+
+    // a sidecar saved with a different document stamp is discarded
+    bool load_from_sidecar(const fs::path& sidecar_path, const DocStamp& docStamp);
+    bool save_to_sidecar(const fs::path& sidecar_path, const DocStamp& docStamp) const;
+
+private:
+    std::unordered_map<gint64, Entry> _entries;
+    std::unordered_set<gint64> _dirtyIds;
+    std::unordered_set<gint64> _removedIds;
+};
@@ -24,12 +24,14 @@
 #include "ct_state_machine.h"
 #include "ct_main_win.h"
 #include "ct_storage_xml.h"
+#include "ct_trace.h"
 
 // ImagePng
 CtAnchoredWidgetState_ImagePng::CtAnchoredWidgetState_ImagePng(CtImagePng* image)
  : CtAnchoredWidgetState{image->getOffset(), image->getJustification()}
  , link{image->get_link()}
  , pixbuf{image->get_pixbuf()->copy()}
+ , pRawBlob{image->get_raw_blob_ptr()}
 {
 }
 
@@ -46,7 +48,7 @@ bool CtAnchoredWidgetState_ImagePng::equal(std::shared_ptr<CtAnchoredWidgetState
 
 CtAnchoredWidget* CtAnchoredWidgetState_ImagePng::to_widget(CtMainWin* pCtMainWin)
 {
-    return new CtImagePng{pCtMainWin, pixbuf->copy(), link, charOffset, justification};
+    return new CtImagePng{pCtMainWin, pixbuf->copy(), link, charOffset, justification, pRawBlob};
 }
 
 // ImageAnchor
@@ -232,6 +234,71 @@ CtTableHeavy* CtAnchoredWidgetState_TableCommon::to_widget_heavy(CtMainWin* pCtM
                             currCol};
 }
 
+CtNodeState::CtNodeState() = default;
+CtNodeState::~CtNodeState() = default;
+
+xmlpp::Element* CtNodeState::get_buffer_xml_root()
+{
+    if (not _pBufferXmlParser) {
+        std::string xml_str{"<?xml version=\"1.0\" encoding=\"UTF-8\"?><buffer>"};
+        for (const auto& chunk : bufferChunks) {
+            xml_str += *chunk.rXml;
+        }
+        xml_str += "</buffer>";
+        _pBufferXmlParser.reset(new xmlpp::DomParser{});
+        if (not CtXmlHelper::safe_parse_memory(*_pBufferXmlParser, xml_str)) {
+            spdlog::error("!! {} parse", __FUNCTION__);
+            return nullptr;
+        }
+    }
+    xmlpp::Document* pDocument = _pBufferXmlParser->get_document();
+    return pDocument ? pDocument->get_root_node() : nullptr;
+}
+
+void CtNodeState::buffer_xml_release()
+{
+    _pBufferXmlParser.reset();
+}
+
+namespace {
+
+void dirty_add(CtNodeStates& node_states, const int start_offset, const int end_offset)
+{
+    if (node_states.dirtyStart < 0) {
+        node_states.dirtyStart = start_offset;
+        node_states.dirtyEnd = end_offset;
+    }
+    else {
+        node_states.dirtyStart = std::min(node_states.dirtyStart, start_offset);
+        node_states.dirtyEnd = std::max(node_states.dirtyEnd, end_offset);
+    }
+}
+
+void dirty_on_insert(CtNodeStates& node_states, const int offset, const int num_chars)
+{
+    if (node_states.dirtyStart >= 0) {
+        if (node_states.dirtyStart > offset) node_states.dirtyStart += num_chars;
+        if (node_states.dirtyEnd >= offset) node_states.dirtyEnd += num_chars;
+    }
+    dirty_add(node_states, offset, offset + num_chars);
+}
+
+void dirty_on_erase(CtNodeStates& node_states, const int start_offset, const int end_offset)
+{
+    if (node_states.dirtyStart >= 0) {
+        auto f_map_offset = [start_offset, end_offset](const int offset) {
+            if (offset <= start_offset) return offset;
+            if (offset >= end_offset) return offset - (end_offset - start_offset);
+            return start_offset;
+        };
+        node_states.dirtyStart = f_map_offset(node_states.dirtyStart);
+        node_states.dirtyEnd = f_map_offset(node_states.dirtyEnd);
+    }
+    dirty_add(node_states, start_offset, start_offset);
+}
+
+} // namespace (anonymous)
+
 CtStateMachine::CtStateMachine(CtMainWin *pCtMainWin)
  : _pCtMainWin{pCtMainWin}
 {
@@ -241,11 +308,19 @@ CtStateMachine::CtStateMachine(CtMainWin *pCtMainWin)
     _visited_nodes_idx = -1;
 }
 
+CtStateMachine::~CtStateMachine()
+{
+    reset();
+}
+
 // State Machine Reset
 void CtStateMachine::reset()
 {
     _visited_nodes_list.clear();
     _visited_nodes_idx = -1;
+    for (auto& pairNodeStates : _node_states) {
+        _buffer_untrack(pairNodeStates.second);
+    }
     _node_states.clear();
 }
 
@@ -269,6 +344,18 @@ gint64 CtStateMachine::requested_visited_next()
     return -1;
 }
 
+std::vector<gint64> CtStateMachine::get_visited_adjacent() const
+{
+    std::vector<gint64> adjacentIds;
+    if (_visited_nodes_idx > 0 and _visited_nodes_idx <= (int)_visited_nodes_list.size()) {
+        adjacentIds.push_back(_visited_nodes_list[_visited_nodes_idx - 1]);
+    }
+    if (_visited_nodes_idx != -1 and _visited_nodes_idx < (int)_visited_nodes_list.size() - 1) {
+        adjacentIds.push_back(_visited_nodes_list[_visited_nodes_idx + 1]);
+    }
+    return adjacentIds;
+}
+
 // When a New Node is Selected
 void CtStateMachine::node_selected_changed(const gint64 node_id_data_holder)
 {
@@ -286,19 +373,18 @@ void CtStateMachine::node_selected_changed(const gint64 node_id_data_holder)
     }
     if (not map::exists(_node_states, node_id_data_holder)) {
         CtTreeIter node = _pCtMainWin->curr_tree_iter();
+        Glib::RefPtr<Gtk::TextBuffer> rTextBuffer = node.get_node_text_buffer();
+        CtNodeStates& node_states = _node_states[node_id_data_holder];
+        _buffer_track(node_states, rTextBuffer);
         auto state = std::shared_ptr<CtNodeState>(new CtNodeState{});
-        CtStorageXmlHelper{_pCtMainWin}.save_buffer_no_widgets_to_xml(state->buffer_xml.get_root_node(),
-                                                                      node.get_node_text_buffer(), 0, -1, 'n');
-        state->buffer_xml_string = state->buffer_xml.write_to_string();
+        state->bufferChunks = _buffer_to_chunks(rTextBuffer, 0, rTextBuffer->get_char_count());
         for (auto widget : node.get_anchored_widgets()) {
             state->widgetStates.push_back(widget->get_state());
         }
 
-        CtNodeStates states;
-        states.states.push_back(state);
-        states.index = 0;     // first state
-        states.indicator = 0; // the current buffer state is saved
-        _node_states.insert(std::make_pair(node_id_data_holder, states));
+        _state_push(node_states, state);
+        node_states.index = 0;     // first state
+        node_states.indicator = 0; // the current buffer state is saved
     }
 }
 
@@ -363,13 +449,32 @@ std::shared_ptr<CtNodeState> CtStateMachine::requested_state_subsequent(const gi
 // Delete the states for the given node_id
 void CtStateMachine::delete_states(const gint64 node_id_data_holder)
 {
-    _node_states.erase(node_id_data_holder);
+    const auto iterStates = _node_states.find(node_id_data_holder);
+    if (iterStates != _node_states.end()) {
+        _buffer_untrack(iterStates->second);
+        _node_states.erase(iterStates);
+    }
     if (vec::exists(_visited_nodes_list, node_id_data_holder)) {
         vec::remove(_visited_nodes_list, node_id_data_holder);
         _visited_nodes_idx = _visited_nodes_list.size()-1;
     }
 }
 
+bool CtStateMachine::has_undoable_states(const gint64 node_id_data_holder) const
+{
+    const auto iterStates = _node_states.find(node_id_data_holder);
+    return iterStates != _node_states.end() and iterStates->second.states.size() > 1u;
+}
+
+void CtStateMachine::buffer_released(const gint64 node_id_data_holder)
+{
+    const auto iterStates = _node_states.find(node_id_data_holder);
+    if (iterStates != _node_states.end()) {
+        _buffer_untrack(iterStates->second);
+        _node_states.erase(iterStates);
+    }
+}
+
 // Are we in the last state?
 bool CtStateMachine::curr_index_is_last_index(const gint64 node_id_data_holder)
 {
@@ -401,41 +506,68 @@ void CtStateMachine::update_state(CtTreeIter tree_iter)
     if (not tree_iter) return;
     if (not tree_iter.get_node_is_rich_text()) return;
 
+    CtTrace::Span ctTraceSpan{"undo_snapshot"};
     const gint64 node_id_data_holder = tree_iter.get_node_id_data_holder();
     auto& node_states = _node_states[node_id_data_holder];
     if (not node_states.states.empty() and not curr_index_is_last_index(node_id_data_holder)) {
-        node_states.states.erase(node_states.states.begin() + node_states.index + 1, node_states.states.end());
+        _states_erase(node_states, node_states.index + 1, node_states.states.size());
     }
 
+    Glib::RefPtr<Gtk::TextBuffer> rTextBuffer = tree_iter.get_node_text_buffer();
+    std::shared_ptr<CtNodeState> last_state = node_states.states.empty() ? nullptr : node_states.states.back();
     auto new_state = std::shared_ptr<CtNodeState>(new CtNodeState{});
-    CtStorageXmlHelper{_pCtMainWin}.save_buffer_no_widgets_to_xml(new_state->buffer_xml.get_root_node(),
-                                                                  tree_iter.get_node_text_buffer(), 0, -1, 'n');
-    new_state->buffer_xml_string = new_state->buffer_xml.write_to_string();
-    for (auto widget : tree_iter.get_anchored_widgets()) {
-        new_state->widgetStates.push_back(widget->get_state());
+    bool state_needed{true};
+    if (last_state and node_states.rTrackedBuffer == rTextBuffer) {
+        // only the range modified since the latest state is serialized again
+        state_needed = _buffer_to_chunks_from_dirty(node_states, last_state->bufferChunks, new_state->bufferChunks);
+    }
+    else {
+        _buffer_track(node_states, rTextBuffer);
+        new_state->bufferChunks = _buffer_to_chunks(rTextBuffer, 0, rTextBuffer->get_char_count());
+        if (last_state) {
+            auto f_chunks_to_string = [](const std::vector<CtNodeStateChunk>& chunks) {
+                std::string xml_str;
+                for (const auto& chunk : chunks) xml_str += *chunk.rXml;
+                return xml_str;
+            };
+            state_needed = f_chunks_to_string(new_state->bufferChunks) != f_chunks_to_string(last_state->bufferChunks);
+        }
     }
 
-    if (node_states.states.size() > 0) {
-        auto compare_widgets = [](const std::list<std::shared_ptr<CtAnchoredWidgetState>> lhs,
-                                  const std::list<std::shared_ptr<CtAnchoredWidgetState>> rhs){
-            return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](std::shared_ptr<CtAnchoredWidgetState> lhs, std::shared_ptr<CtAnchoredWidgetState> rhs) {
-                return lhs->equal(rhs);
-            });
-        };
-        auto last_state = node_states.states.back();
-        if (new_state->buffer_xml_string == last_state->buffer_xml_string and
-            compare_widgets(new_state->widgetStates, last_state->widgetStates))
-        {
-            return; // #print "update_state not needed"
+    auto iterLastWidgetState = last_state ? last_state->widgetStates.begin() : new_state->widgetStates.end();
+    for (auto widget : tree_iter.get_anchored_widgets()) {
+        std::shared_ptr<CtAnchoredWidgetState> widgetState = widget->get_state();
+        if (last_state and iterLastWidgetState != last_state->widgetStates.end()) {
+            if ((*iterLastWidgetState)->equal(widgetState)) {
+                widgetState = *iterLastWidgetState; // unchanged, shared with the previous state
+            }
+            else {
+                state_needed = true;
+            }
+            ++iterLastWidgetState;
         }
+        else {
+            state_needed = true;
+        }
+        new_state->widgetStates.push_back(widgetState);
+    }
+    if (last_state and iterLastWidgetState != last_state->widgetStates.end()) {
+        state_needed = true; // widgets removed
+    }
+    if (not state_needed) {
+        return; // #print "update_state not needed"
     }
 
     new_state->cursor_pos = _pCtMainWin->curr_buffer()->property_cursor_position();
     new_state->v_adj_val = round(_pCtMainWin->getScrolledwindowText().get_vadjustment()->get_value());
 
-    node_states.states.push_back(new_state);
-    while ((int)node_states.states.size() > _pCtMainWin->get_ct_config()->limitUndoableSteps) {
-        node_states.states.erase(node_states.states.begin());
+    _state_push(node_states, new_state);
+    const size_t limitUndoableBytes = static_cast<size_t>(_pCtMainWin->get_ct_config()->limitUndoableMemMb) * 1024u * 1024u;
+    while (node_states.states.size() > 1u and
+           ((int)node_states.states.size() > _pCtMainWin->get_ct_config()->limitUndoableSteps or
+            node_states.chunksBytes - node_states.lastStateBytes > limitUndoableBytes))
+    {
+        _states_erase(node_states, 0u, 1u);
     }
     node_states.index = node_states.states.size() - 1;
     node_states.indicator = 0; // the current buffer state is saved
@@ -464,3 +596,160 @@ void CtStateMachine::update_curr_state_v_adj_val(const gint64 node_id_data_holde
         iterStates->second.get_state()->v_adj_val = v_adj_val;
     }
 }
+
+void CtStateMachine::buffer_loaded_from_state(const gint64 node_id_data_holder, Glib::RefPtr<Gtk::TextBuffer> rTextBuffer)
+{
+    const auto iterStates = _node_states.find(node_id_data_holder);
+    if (iterStates == _node_states.end()) return;
+    if (iterStates->second.rTrackedBuffer == rTextBuffer) {
+        // the buffer now matches the current state
+        iterStates->second.dirtyStart = -1;
+        iterStates->second.dirtyEnd = -1;
+    }
+}
+
+void CtStateMachine::_buffer_track(CtNodeStates& node_states, Glib::RefPtr<Gtk::TextBuffer> rTextBuffer)
+{
+    _buffer_untrack(node_states);
+    node_states.rTrackedBuffer = rTextBuffer;
+    if (not rTextBuffer) return;
+    // connected before the default handlers, while the iterators still refer to the unmodified buffer
+    CtNodeStates* pNodeStates = &node_states;
+    node_states.trackedBufferConns.push_back(rTextBuffer->signal_insert().connect(
+        [pNodeStates](const Gtk::TextIter& pos, const Glib::ustring& text, int/*bytes*/) {
+            dirty_on_insert(*pNodeStates, pos.get_offset(), text.size());
+        }, false));
+    node_states.trackedBufferConns.push_back(rTextBuffer->signal_insert_child_anchor().connect(
+        [pNodeStates](const Gtk::TextIter& pos, const Glib::RefPtr<Gtk::TextChildAnchor>&/*anchor*/) {
+            dirty_on_insert(*pNodeStates, pos.get_offset(), 1);
+        }, false));
+    node_states.trackedBufferConns.push_back(rTextBuffer->signal_erase().connect(
+        [pNodeStates](const Gtk::TextIter& range_start, const Gtk::TextIter& range_end) {
+            dirty_on_erase(*pNodeStates, range_start.get_offset(), range_end.get_offset());
+        }, false));
+    node_states.trackedBufferConns.push_back(rTextBuffer->signal_apply_tag().connect(
+        [pNodeStates](const Glib::RefPtr<Gtk::TextTag>&/*tag*/, const Gtk::TextIter& range_start, const Gtk::TextIter& range_end) {
+            dirty_add(*pNodeStates, range_start.get_offset(), range_end.get_offset());
+        }, false));
+    node_states.trackedBufferConns.push_back(rTextBuffer->signal_remove_tag().connect(
+        [pNodeStates](const Glib::RefPtr<Gtk::TextTag>&/*tag*/, const Gtk::TextIter& range_start, const Gtk::TextIter& range_end) {
+            dirty_add(*pNodeStates, range_start.get_offset(), range_end.get_offset());
+        }, false));
+}
+
+void CtStateMachine::_buffer_untrack(CtNodeStates& node_states)
+{
+    for (auto& conn : node_states.trackedBufferConns) {
+        conn.disconnect();
+    }
+    node_states.trackedBufferConns.clear();
+    node_states.rTrackedBuffer.reset();
+    node_states.dirtyStart = -1;
+    node_states.dirtyEnd = -1;
+}
+
+std::vector<CtNodeStateChunk> CtStateMachine::_buffer_to_chunks(Glib::RefPtr<Gtk::TextBuffer> rTextBuffer,
+                                                                const int start_offset,
+                                                                const int end_offset)
+{
+    std::vector<CtNodeStateChunk> chunks;
+    for (int chunk_start = start_offset; chunk_start < end_offset; chunk_start += ChunkChars) {
+        const int chunk_end = std::min(chunk_start + ChunkChars, end_offset);
+        xmlpp::Document xml_doc;
+        CtStorageXmlHelper{_pCtMainWin}.save_buffer_no_widgets_to_xml(xml_doc.create_root_node("c"),
+                                                                      rTextBuffer, chunk_start, chunk_end, 'n');
+        // keep only the rich_text slots, they are concatenated into one xml on load
+        const std::string xml_str = xml_doc.write_to_string();
+        const size_t posOpen = xml_str.find("<c>");
+        const size_t posClose = xml_str.rfind("</c>");
+        std::string slots_str;
+        if (std::string::npos != posOpen and std::string::npos != posClose and posClose > posOpen) {
+            slots_str = xml_str.substr(posOpen + 3u, posClose - posOpen - 3u);
+        }
+        chunks.push_back(CtNodeStateChunk{chunk_end - chunk_start, std::make_shared<const std::string>(std::move(slots_str))});
+    }
+    return chunks;
+}
+
+bool CtStateMachine::_buffer_to_chunks_from_dirty(CtNodeStates& node_states,
+                                                  const std::vector<CtNodeStateChunk>& prev_chunks,
+                                                  std::vector<CtNodeStateChunk>& new_chunks)
+{
+    auto on_scope_exit = scope_guard([&node_states](void*) {
+        node_states.dirtyStart = -1;
+        node_states.dirtyEnd = -1;
+    });
+    if (node_states.dirtyStart < 0) {
+        new_chunks = prev_chunks;
+        return false;
+    }
+    int prev_char_count{0};
+    for (const auto& chunk : prev_chunks) prev_char_count += chunk.charLen;
+    const int new_char_count = node_states.rTrackedBuffer->get_char_count();
+    const int delta_chars = new_char_count - prev_char_count;
+    const int dirty_start = std::clamp(node_states.dirtyStart, 0, new_char_count);
+    const int dirty_end = std::clamp(node_states.dirtyEnd, dirty_start, new_char_count);
+    const int prev_dirty_end = dirty_end - delta_chars;
+    if (prev_dirty_end < dirty_start or prev_dirty_end > prev_char_count) {
+        spdlog::debug("?? {} out of sync", __FUNCTION__);
+        new_chunks = _buffer_to_chunks(node_states.rTrackedBuffer, 0, new_char_count);
+        return true;
+    }
+
+    // chunks before and after the modified range are shared, the chunks overlapping it are serialized again;
+    // the range is extended to the char preceding it so that typing at the end of a chunk grows that chunk
+    const int left = dirty_start > 0 ? dirty_start - 1 : 0;
+    const int right = std::max(prev_dirty_end, left + 1);
+    int offset{0};
+    size_t i{0};
+    for (; i < prev_chunks.size() and offset + prev_chunks[i].charLen <= left; ++i) {
+        new_chunks.push_back(prev_chunks[i]);
+        offset += prev_chunks[i].charLen;
+    }
+    const int range_start = offset;
+    std::string prev_range_xml;
+    for (; i < prev_chunks.size() and offset < right; ++i) {
+        prev_range_xml += *prev_chunks[i].rXml;
+        offset += prev_chunks[i].charLen;
+    }
+    const int range_end = offset + delta_chars;
+
+    std::vector<CtNodeStateChunk> range_chunks = _buffer_to_chunks(node_states.rTrackedBuffer, range_start, range_end);
+    if (0 == delta_chars) {
+        std::string range_xml;
+        for (const auto& chunk : range_chunks) range_xml += *chunk.rXml;
+        if (range_xml == prev_range_xml) {
+            new_chunks = prev_chunks;
+            return false;
+        }
+    }
+    new_chunks.insert(new_chunks.end(), range_chunks.begin(), range_chunks.end());
+    new_chunks.insert(new_chunks.end(), prev_chunks.begin() + i, prev_chunks.end());
+    return true;
+}
+
+void CtStateMachine::_state_push(CtNodeStates& node_states, std::shared_ptr<CtNodeState> state)
+{
+    node_states.lastStateBytes = 0;
+    for (const auto& chunk : state->bufferChunks) {
+        node_states.lastStateBytes += chunk.rXml->size();
+        if (1 == ++node_states.chunksRefCount[chunk.rXml.get()]) {
+            node_states.chunksBytes += chunk.rXml->size();
+        }
+    }
+    node_states.states.push_back(state);
+}
+
+void CtStateMachine::_states_erase(CtNodeStates& node_states, const size_t first, const size_t last)
+{
+    for (size_t i = first; i < last; ++i) {
+        for (const auto& chunk : node_states.states[i]->bufferChunks) {
+            const auto iterRefCount = node_states.chunksRefCount.find(chunk.rXml.get());
+            if (iterRefCount != node_states.chunksRefCount.end() and 0 == --iterRefCount->second) {
+                node_states.chunksBytes -= chunk.rXml->size();
+                node_states.chunksRefCount.erase(iterRefCount);
+            }
+        }
+    }
+    node_states.states.erase(node_states.states.begin() + first, node_states.states.begin() + last);
+}
@@ -29,6 +29,7 @@
 #include "ct_table.h"
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <glibmm/regex.h>
 #include <memory>
 
@@ -62,6 +63,7 @@ public:
 public:
     Glib::ustring link;
     Glib::RefPtr<Gdk::Pixbuf> pixbuf;
+    std::shared_ptr<const std::string> pRawBlob;
 };
 
 class CtAnchoredWidgetState_Anchor : public CtAnchoredWidgetState
@@ -158,22 +160,48 @@ public:
     }
 };
 
+struct CtNodeStateChunk
+{
+    int charLen{0};
+    std::shared_ptr<const std::string> rXml; // serialized rich_text slots of this range of the buffer
+};
+
 struct CtNodeState
 {
-    CtNodeState()  { buffer_xml.create_root_node("buffer"); }
+    CtNodeState();
+    ~CtNodeState();
 
-    std::list<std::shared_ptr<CtAnchoredWidgetState>> widgetStates;
-    xmlpp::Document buffer_xml;
-    Glib::ustring   buffer_xml_string;
+    /**
+     * @brief Get the buffer as xml, parsed from the chunks on first request
+     */
+    xmlpp::Element* get_buffer_xml_root();
+    void buffer_xml_release();
+
+    std::list<std::shared_ptr<CtAnchoredWidgetState>> widgetStates; // unchanged widget states are shared with the previous state
+    std::vector<CtNodeStateChunk> bufferChunks;                      // unchanged chunks are shared with the previous state
     int             cursor_pos{0};
     int             v_adj_val{0};
+
+private:
+    std::unique_ptr<xmlpp::DomParser> _pBufferXmlParser;
 };
 
 struct CtNodeStates
 {
     std::vector<std::shared_ptr<CtNodeState>> states;
-    int index;
-    int indicator;
+    int index{0};
+    int indicator{0};
+
+    // buffer the states are taken from, with the range modified since the latest state
+    Glib::RefPtr<Gtk::TextBuffer> rTrackedBuffer;
+    std::vector<sigc::connection> trackedBufferConns;
+    int dirtyStart{-1};
+    int dirtyEnd{-1};
+
+    // chunks referenced by the states, for the memory limit
+    std::unordered_map<const std::string*, int> chunksRefCount;
+    size_t chunksBytes{0};
+    size_t lastStateBytes{0};
 
     std::shared_ptr<CtNodeState> get_state() { return states[index]; }
 };
@@ -182,10 +210,16 @@ class CtStateMachine
 {
 public:
     CtStateMachine(CtMainWin* pCtMainWin);
+    ~CtStateMachine();
+
+    // size of the buffer ranges serialized independently, so that a step only serializes the modified range
+    static constexpr int ChunkChars{4096};
 
     void reset();
     gint64 requested_visited_previous();
     gint64 requested_visited_next();
+    // the previous and next visited nodes, without moving in the visited list
+    std::vector<gint64> get_visited_adjacent() const;
     void node_selected_changed(const gint64 node_id_data_holder);
     void text_variation(const gint64 node_id_data_holder, const Glib::ustring& varied_text);
     std::shared_ptr<CtNodeState> requested_state_previous(const gint64 node_id_data_holder);
@@ -199,6 +233,10 @@ public:
     void update_state(CtTreeIter tree_iter);
     void update_curr_state_cursor_pos(const gint64 node_id_data_holder);
     void update_curr_state_v_adj_val(const gint64 node_id_data_holder);
+    void buffer_loaded_from_state(const gint64 node_id_data_holder, Glib::RefPtr<Gtk::TextBuffer> rTextBuffer);
+    bool has_undoable_states(const gint64 node_id_data_holder) const;
+    // the loaded buffer of the node is dropped, its first state is taken again at the next selection
+    void buffer_released(const gint64 node_id_data_holder);
 
     void set_go_bk_fw_active(bool val) { _go_bk_fw_active = val; }
 
@@ -208,6 +246,16 @@ public:
         _visited_nodes_idx = _visited_nodes_list.size() - 1;
     }
 
+private:
+    void _buffer_track(CtNodeStates& node_states, Glib::RefPtr<Gtk::TextBuffer> rTextBuffer);
+    void _buffer_untrack(CtNodeStates& node_states);
+    std::vector<CtNodeStateChunk> _buffer_to_chunks(Glib::RefPtr<Gtk::TextBuffer> rTextBuffer, const int start_offset, const int end_offset);
+    bool _buffer_to_chunks_from_dirty(CtNodeStates& node_states,
+                                      const std::vector<CtNodeStateChunk>& prev_chunks,
+                                      std::vector<CtNodeStateChunk>& new_chunks);
+    void _state_push(CtNodeStates& node_states, std::shared_ptr<CtNodeState> state);
+    void _states_erase(CtNodeStates& node_states, const size_t first, const size_t last);
+
 private:
     CtMainWin*                  _pCtMainWin;
     Glib::RefPtr<Glib::Regex>   _word_regex;
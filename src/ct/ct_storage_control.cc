@@ -29,6 +29,7 @@
 #include "ct_p7za_iface.h"
 #include "ct_main_win.h"
 #include "ct_logging.h"
+#include "ct_trace.h"
 #include <glib/gstdio.h>
 
 //#define DEBUG_BACKUP_ENCRYPT
@@ -111,6 +112,7 @@ static bool _move_dir_with_fallback(const fs::path& dir_from, const fs::path& di
                                                         Glib::ustring& error,
                                                         Glib::ustring password)
 {
+    CtTrace::Span ctTraceSpan{"document_open"};
     fs::path extracted_file_path{file_path};
 
     try {
@@ -119,24 +121,30 @@ static bool _move_dir_with_fallback(const fs::path& dir_from, const fs::path& di
         }
         else {
             if (not fs::is_regular_file(file_path)) throw std::runtime_error("no file");
-
-            // unpack file if need
-            if (fs::get_doc_encrypt_from_file_ext(file_path) == CtDocEncrypt::True) {
-                extracted_file_path = _extract_file(pCtMainWin, file_path, password);
-                if (extracted_file_path.empty()) {
-                    // user canceled operation
-                    return nullptr;
-                }
-                if (extracted_file_path.string() == BAD_ARCHIVE) {
-                    throw std::runtime_error(str::format(_("'%s' is Not a Valid Archive"), file_path.string()));
-                }
-            }
         }
 
         // detect storage type
         std::unique_ptr<CtStorageEntity> pStorage = CtStorageControl::_get_entity_by_type(pCtMainWin, doc_type);
         if (not pStorage) throw std::runtime_error("no storage");
 
+        // unpack file if need
+        if (CtDocType::MultiFile != doc_type and fs::get_doc_encrypt_from_file_ext(file_path) == CtDocEncrypt::True) {
+            // the xml is parsed straight from memory, sqlite needs a file
+            std::string docData;
+            const bool inMemory = CtDocType::XML == doc_type;
+            extracted_file_path = _extract_file(pCtMainWin, file_path, password, inMemory ? &docData : nullptr);
+            if (extracted_file_path.empty()) {
+                // user canceled operation
+                return nullptr;
+            }
+            if (extracted_file_path.string() == BAD_ARCHIVE) {
+                throw std::runtime_error(str::format(_("'%s' is Not a Valid Archive"), file_path.string()));
+            }
+            if (inMemory) {
+                static_cast<CtStorageXml*>(pStorage.get())->set_encrypted(password, std::move(docData));
+            }
+        }
+
         // load from file / folder
         if (not pStorage->populate_treestore(extracted_file_path, error)) throw std::runtime_error(error);
 
@@ -147,6 +155,14 @@ static bool _move_dir_with_fallback(const fs::path& dir_from, const fs::path& di
         doc->_password = password;
         doc->_extracted_file_path = extracted_file_path;
         doc->_storage.swap(pStorage);
+        try {
+            doc->_storage->search_index_load(doc->_searchIndex);
+        }
+        catch (std::exception& e) {
+            // the index is only an accelerator, the search will rebuild it
+            spdlog::warn("search index not loaded: {}", e.what());
+            doc->_searchIndex.clear();
+        }
         return doc;
     }
     catch (std::exception& e) {
@@ -282,14 +298,20 @@ static bool _move_dir_with_fallback(const fs::path& dir_from, const fs::path& di
     }
 
     try {
+        std::unique_ptr<CtStorageEntity> storage = CtStorageControl::_get_entity_by_type(pCtMainWin, doc_type);
+        if (not storage) throw std::runtime_error("no storage");
+
         if (fs::get_doc_encrypt_from_file_ext(file_path) == CtDocEncrypt::True) {
-            extracted_file_path = pCtMainWin->get_ct_tmp()->getHiddenFilePath(file_path);
+            if (CtDocType::XML == doc_type) {
+                // the xml is streamed to the archiver by the storage itself
+                static_cast<CtStorageXml*>(storage.get())->set_encrypted(password);
+            }
+            else {
+                extracted_file_path = pCtMainWin->get_ct_tmp()->getHiddenFilePath(file_path);
+            }
         }
         f_cleanup();
 
-        std::unique_ptr<CtStorageEntity> storage = CtStorageControl::_get_entity_by_type(pCtMainWin, doc_type);
-        if (not storage) throw std::runtime_error("no storage");
-
         // will save all data because it's the first time
         CtStorageSyncPending fakePending;
         if (not storage->save_treestore(extracted_file_path,
@@ -349,8 +371,204 @@ static bool _move_dir_with_fallback(const fs::path& dir_from, const fs::path& di
     return ret_list;
 }
 
+void CtStorageControl::_search_index_update_pending()
+{
+    CtTreeStore& ctTreeStore = _pCtMainWin->get_tree_store();
+    for (const gint64 node_id : _syncPending.nodes_to_rm_set) {
+        _searchIndex.remove_entry(node_id);
+    }
+    for (const auto& curr_pair : _syncPending.nodes_to_write_dict) {
+        if (not curr_pair.second.buff) continue;
+        CtTreeIter ctTreeIter = ctTreeStore.get_node_from_node_id(curr_pair.first);
+        if (ctTreeIter and ctTreeIter.get_node_buffer_already_loaded()) {
+            _searchIndex.update_from_tree_iter(ctTreeIter);
+        }
+        else {
+            _searchIndex.remove_entry(curr_pair.first);
+        }
+    }
+}
+
+bool CtStorageControl::_search_index_save(const CtSearchIndex& searchIndex)
+{
+    try {
+        _storage->search_index_save(searchIndex);
+        return true;
+    }
+    catch (std::exception& e) {
+        // never fail the document save because of the index
+        spdlog::warn("search index not saved: {}", e.what());
+        return false;
+    }
+}
+
+bool CtStorageControl::_write_snapshot(CtStorageWriter& writer,
+                                       const CtSearchIndex& searchIndex,
+                                       const CtStorageSyncPending& syncPending,
+                                       const CtDocType doc_type,
+                                       const std::string& main_backup,
+                                       const std::string& extracted_copy)
+{
+    CtTrace::Span ctTraceSpan{"save_write"};
+    bool retVal{true};
+    try {
+        const size_t numSteps = std::max<size_t>(1u, writer.get_num_steps());
+        _saveStepsDone = 0u;
+        _saveStepsTotal = numSteps;
+        size_t lastPercent{0};
+        writer.write([&](const size_t stepsDone){
+            _saveStepsDone = stepsDone;
+            // no need to wake up the UI thread more than once per percent
+            const size_t percent = 100u * stepsDone / numSteps;
+            if (percent != lastPercent) {
+                lastPercent = percent;
+                _dispatcherSaveProgress.emit();
+            }
+        });
+#if defined(DEBUG_BACKUP_ENCRYPT)
+        spdlog::debug("saved {}", _extracted_file_path.string());
+#endif // DEBUG_BACKUP_ENCRYPT
+        _search_index_save(searchIndex);
+        if (not extracted_copy.empty()) {
+            if (not fs::copy_file(_extracted_file_path, extracted_copy)) {
+                throw std::runtime_error(str::format(_("You Have No Write Access to %s"), _extracted_file_path.parent_path().string()));
+            }
+#if defined(DEBUG_BACKUP_ENCRYPT)
+            spdlog::debug("{} ++ {}", _extracted_file_path.string(), extracted_copy);
+#endif // DEBUG_BACKUP_ENCRYPT
+        }
+        else {
+            _mod_time = fs::getmtime(_file_path);
+        }
+    }
+    catch (std::exception& e) {
+        spdlog::error("{} {}", __FUNCTION__, e.what());
+        // recover from backup, the sqlite changes were rolled back so its copy is just dropped
+        if (not main_backup.empty() and fs::is_regular_file(main_backup)) {
+            if (CtDocType::SQLite == doc_type) {
+                (void)fs::remove(main_backup);
+            }
+            else {
+                _storage->close_connect(); // the xml nodes not loaded yet keep the file mapped
+                (void)fs::move_file(main_backup, _file_path);
+                if (extracted_copy.empty()) {
+                    _storage->doc_moved(_file_path);
+                }
+            }
+        }
+        _pCtMainWin->errorsDEQueue.push_back(e.what());
+        _pCtMainWin->dispatcherErrorMsg.emit();
+        retVal = false;
+    }
+    {
+        std::lock_guard<std::mutex> lock{_saveMutex};
+        if (not retVal) {
+            _saveFailedPending = syncPending;
+        }
+        _saveInProgress = false;
+    }
+    _saveCondVar.notify_all();
+    _dispatcherSaveDone.emit();
+    return retVal;
+}
+
+bool CtStorageControl::_save_in_progress_wait()
+{
+    {
+        std::unique_lock<std::mutex> lock{_saveMutex};
+        _saveCondVar.wait(lock, [this](){ return not _saveInProgress; });
+    }
+    return _save_failed_pending_restore();
+}
+
+bool CtStorageControl::_save_failed_pending_restore()
+{
+    std::optional<CtStorageSyncPending> failedPending;
+    {
+        std::lock_guard<std::mutex> lock{_saveMutex};
+        failedPending.swap(_saveFailedPending);
+    }
+    if (not failedPending) {
+        return false;
+    }
+    _sync_pending_merge(*failedPending);
+    return true;
+}
+
+void CtStorageControl::_sync_pending_merge(const CtStorageSyncPending& syncPending)
+{
+    _syncPending.fix_db_tables = _syncPending.fix_db_tables or syncPending.fix_db_tables;
+    _syncPending.bookmarks_to_write = _syncPending.bookmarks_to_write or syncPending.bookmarks_to_write;
+    for (const auto& curr_pair : syncPending.nodes_to_write_dict) {
+        if (0 != _syncPending.nodes_to_rm_set.count(curr_pair.first)) {
+            // removed in the meantime
+            continue;
+        }
+        const auto it = _syncPending.nodes_to_write_dict.find(curr_pair.first);
+        if (it == _syncPending.nodes_to_write_dict.end()) {
+            _syncPending.nodes_to_write_dict[curr_pair.first] = curr_pair.second;
+            continue;
+        }
+        CtStorageNodeState& node_state = it->second;
+        // a node that failed to be created is still not in the document
+        node_state.is_update_of_existing = node_state.is_update_of_existing and curr_pair.second.is_update_of_existing;
+        node_state.prop = node_state.prop or curr_pair.second.prop;
+        node_state.buff = node_state.buff or curr_pair.second.buff;
+        node_state.hier = node_state.hier or curr_pair.second.hier;
+    }
+    _syncPending.nodes_to_rm_set.insert(syncPending.nodes_to_rm_set.begin(), syncPending.nodes_to_rm_set.end());
+}
+
+void CtStorageControl::_on_save_progress()
+{
+    const size_t stepsTotal = _saveStepsTotal;
+    if (stepsTotal > 0u) {
+        CtStatusBar& ctStatusBar = _pCtMainWin->get_status_bar();
+        ctStatusBar.progressBar.set_fraction(static_cast<double>(_saveStepsDone) / stepsTotal);
+        ctStatusBar.progressBar.show();
+    }
+}
+
+void CtStorageControl::_on_save_done()
+{
+    CtStatusBar& ctStatusBar = _pCtMainWin->get_status_bar();
+    ctStatusBar.pop();
+    bool saveInProgress;
+    {
+        std::lock_guard<std::mutex> lock{_saveMutex};
+        saveInProgress = _saveInProgress;
+    }
+    if (not saveInProgress) {
+        ctStatusBar.progressBar.hide();
+    }
+    if (_save_failed_pending_restore()) {
+        _pCtMainWin->update_window_save_needed();
+    }
+    if (_saveCoalesced and not saveInProgress) {
+        _saveCoalesced = false;
+        if (_pCtMainWin->get_file_save_needed()) {
+            spdlog::debug("autosave coalesced");
+            _pCtMainWin->get_ct_actions()->file_save();
+        }
+    }
+}
+
+bool CtStorageControl::save_coalesce_if_in_progress()
+{
+    std::lock_guard<std::mutex> lock{_saveMutex};
+    if (not _saveInProgress) {
+        return false;
+    }
+    _saveCoalesced = true;
+    return true;
+}
+
 bool CtStorageControl::try_reopen(Glib::ustring& error)
 {
+    _prefetch.clear();
+    if (_save_in_progress_wait()) {
+        _pCtMainWin->update_window_save_needed();
+    }
     try {
         _storage->try_reopen();
         return true;
@@ -364,6 +582,10 @@ bool CtStorageControl::try_reopen(Glib::ustring& error)
 
 bool CtStorageControl::save(bool need_vacuum, Glib::ustring& error)
 {
+    CtTrace::Span ctTraceSpan{"save"};
+    // the previous save could still be writing
+    (void)_save_in_progress_wait();
+    _prefetch.clear();
     _mod_time = 0;
     _pCtMainWin->get_status_bar().push(_("Writing to Disk..."));
     #if GTKMM_MAJOR_VERSION < 4 && !defined(GTKMM_DISABLE_DEPRECATED)
@@ -383,9 +605,19 @@ bool CtStorageControl::save(bool need_vacuum, Glib::ustring& error)
     const CtDocType doc_type = fs::is_directory(_file_path) ? CtDocType::MultiFile : fs::get_doc_type_from_file_ext(_file_path);
     // CtDocType::MultiFile backups are elsewhere, at node (folder) level rather than whole tree level (file)
     const bool need_main_backup = CtDocType::MultiFile != doc_type and _pCtConfig->backupCopy and _pCtConfig->backupNum > 0;
+    // an encrypted xml is kept in memory, only an extracted copy needs to be encrypted
+    const bool is_encrypted = CtDocType::MultiFile != doc_type and CtDocEncrypt::True == fs::get_doc_encrypt_from_file_ext(_file_path);
     const bool need_encrypt = _file_path != _extracted_file_path;
 
-    auto on_scope_exit = scope_guard([this, need_encrypt](void*) {
+    // the storage has to be closed for the vacuum and for the sqlite copy to encrypt
+    const bool need_sync_write = need_vacuum or (need_encrypt and CtDocType::SQLite == doc_type);
+    bool is_write_in_background{false};
+
+    auto on_scope_exit = scope_guard([this, need_encrypt, &is_write_in_background](void*) {
+        if (is_write_in_background) {
+            // status bar and modification time are updated at the end of the write
+            return;
+        }
         _pCtMainWin->get_status_bar().pop();
         if (not need_encrypt) {
             _mod_time = fs::getmtime(_file_path);
@@ -412,15 +644,67 @@ bool CtStorageControl::save(bool need_vacuum, Glib::ustring& error)
                 _storage->reopen_connect();
             }
             else {
+                if (CtDocType::SQLite != doc_type) {
+                    _storage->close_connect(); // the xml nodes not loaded yet keep the file mapped
+                }
                 if (not fs::move_file(_file_path, main_backup)) {
                     throw std::runtime_error(str::format(_("You Have No Write Access to %s"), _file_path.parent_path().string()));
                 }
 #if defined(DEBUG_BACKUP_ENCRYPT)
                 spdlog::debug("{} -> {}", _file_path.string(), main_backup.string());
 #endif // DEBUG_BACKUP_ENCRYPT
+                if (not need_encrypt) {
+                    _storage->doc_moved(main_backup);
+                }
             }
         }
         // save changes
+        std::shared_ptr<CtStorageWriter> pWriter;
+        if (not need_sync_write) {
+            pWriter = _storage->save_treestore_snapshot(_extracted_file_path, _syncPending);
+        }
+        if (pWriter) {
+            // the nodes are snapshotted, serialize and write them off the UI thread
+            _search_index_update_pending();
+            auto pSearchIndex = std::make_shared<CtSearchIndex>(_searchIndex);
+            _searchIndex.clear_dirty();
+
+            auto pBackupEncryptData = std::make_shared<CtBackupEncryptData>();
+            pBackupEncryptData->backupType = need_main_backup ? CtBackupType::SingleFile : CtBackupType::None;
+            pBackupEncryptData->needEncrypt = need_encrypt;
+            pBackupEncryptData->isEncrypted = is_encrypted;
+            pBackupEncryptData->file_path = _file_path.string();
+            pBackupEncryptData->main_backup = main_backup.string();
+            if (need_encrypt) {
+                pBackupEncryptData->extracted_copy = _extracted_file_path.string() + (str_timestamp + _extracted_file_path.extension());
+                pBackupEncryptData->password = _password;
+            }
+            pBackupEncryptData->p_mod_time = &_mod_time;
+            pBackupEncryptData->f_write = [this,
+                                           pWriter,
+                                           pSearchIndex,
+                                           syncPending = _syncPending,
+                                           doc_type,
+                                           main_backup = need_main_backup ? main_backup.string() : std::string{},
+                                           extracted_copy = pBackupEncryptData->extracted_copy]() {
+                return _write_snapshot(*pWriter, *pSearchIndex, syncPending, doc_type, main_backup, extracted_copy);
+            };
+            {
+                std::lock_guard<std::mutex> lock{_saveMutex};
+                _saveInProgress = true;
+            }
+            _saveStepsDone = 0u;
+            _saveStepsTotal = 0u;
+            backupEncryptDEQueue.push_back(pBackupEncryptData);
+            is_write_in_background = true;
+
+            _syncPending.fix_db_tables = false;
+            _syncPending.bookmarks_to_write = false;
+            _syncPending.nodes_to_rm_set.clear();
+            _syncPending.nodes_to_write_dict.clear();
+
+            return true;
+        }
         if (not _storage->save_treestore(_extracted_file_path,
                                          _syncPending,
                                          error,
@@ -431,6 +715,10 @@ bool CtStorageControl::save(bool need_vacuum, Glib::ustring& error)
 #if defined(DEBUG_BACKUP_ENCRYPT)
         spdlog::debug("saved {}", _extracted_file_path.string());
 #endif // DEBUG_BACKUP_ENCRYPT
+        _search_index_update_pending();
+        if (_search_index_save(_searchIndex)) {
+            _searchIndex.clear_dirty();
+        }
         if (need_vacuum) {
             _storage->vacuum();
         }
@@ -438,6 +726,7 @@ bool CtStorageControl::save(bool need_vacuum, Glib::ustring& error)
             auto pBackupEncryptData = std::make_shared<CtBackupEncryptData>();
             pBackupEncryptData->backupType = need_main_backup ? CtBackupType::SingleFile : CtBackupType::None;
             pBackupEncryptData->needEncrypt = need_encrypt;
+            pBackupEncryptData->isEncrypted = is_encrypted;
             pBackupEncryptData->file_path = _file_path.string();
             pBackupEncryptData->main_backup = main_backup.string();
             if (need_encrypt) {
@@ -466,7 +755,9 @@ bool CtStorageControl::save(bool need_vacuum, Glib::ustring& error)
         // recover from backup
         try {
             _storage->close_connect();
-            if (need_main_backup and fs::is_regular_file(main_backup)) fs::move_file(main_backup, _file_path);
+            if (need_main_backup and fs::is_regular_file(main_backup) and fs::move_file(main_backup, _file_path) and not need_encrypt) {
+                _storage->doc_moved(_file_path);
+            }
             _storage->reopen_connect();
         }
         catch (std::exception& e2) { spdlog::error(e2.what()); }
@@ -479,13 +770,59 @@ bool CtStorageControl::save(bool need_vacuum, Glib::ustring& error)
 
 Glib::RefPtr<Gtk::TextBuffer> CtStorageControl::get_delayed_text_buffer(const gint64 node_id,
                                                                         const std::string& syntax,
-                                                                        std::list<CtAnchoredWidget*>& widgets) const
+                                                                        std::list<CtAnchoredWidget*>& widgets)
 {
+    CtTrace::Span ctTraceSpan{"get_delayed_text_buffer"};
     if (not _storage) {
         spdlog::error("!! {} storage is not initialized", __FUNCTION__);
         return Glib::RefPtr<Gtk::TextBuffer>{};
     }
-    return _storage->get_delayed_text_buffer(node_id, syntax, widgets);
+    // the storage builds the buffer from the prefetched body, so that it knows the node is loaded
+    CtPrefetchedBody prefetchedBody;
+    const bool isPrefetched = _prefetch.take(node_id, prefetchedBody) and prefetchedBody.isRichText == (CtConst::RICH_TEXT_ID == syntax);
+    return _storage->get_delayed_text_buffer(node_id, syntax, widgets, isPrefetched ? &prefetchedBody : nullptr);
+}
+
+void CtStorageControl::prefetch_text_buffers(const std::vector<std::pair<gint64, bool/*isRichText*/>>& nodes)
+{
+    if (not _storage or _file_path.empty()) {
+        return;
+    }
+    {
+        // the stored bodies are being written
+        std::lock_guard<std::mutex> lock{_saveMutex};
+        if (_saveInProgress or _saveFailedPending) {
+            return;
+        }
+    }
+    std::vector<std::pair<gint64, CtPrefetchedBodyReader>> nodeReaders;
+    for (const auto& node : nodes) {
+        if (0u != _syncPending.nodes_to_write_dict.count(node.first)) {
+            continue;
+        }
+        if (CtPrefetchedBodyReader reader = _storage->get_body_reader(node.first, node.second)) {
+            nodeReaders.emplace_back(node.first, std::move(reader));
+        }
+    }
+    _prefetch.request(std::move(nodeReaders));
+}
+
+bool CtStorageControl::release_text_buffer(const gint64 node_id)
+{
+    if (not _storage or _file_path.empty()) {
+        return false;
+    }
+    {
+        // a save being written may still fail and put back its pending changes
+        std::lock_guard<std::mutex> lock{_saveMutex};
+        if (_saveInProgress or _saveFailedPending) {
+            return false;
+        }
+    }
+    if (0u != _syncPending.nodes_to_write_dict.count(node_id)) {
+        return false;
+    }
+    return _storage->release_text_buffer(node_id);
 }
 
 fs::path CtStorageControl::get_embedded_filepath(const CtTreeIter& ct_tree_iter, const std::string& filename) const
@@ -497,10 +834,11 @@ fs::path CtStorageControl::get_embedded_filepath(const CtTreeIter& ct_tree_iter,
     return _storage->get_embedded_filepath(ct_tree_iter, filename);
 }
 
-/*static*/fs::path CtStorageControl::_extract_file(CtMainWin* pCtMainWin, const fs::path& file_path, Glib::ustring& password)
+/*static*/fs::path CtStorageControl::_extract_file(CtMainWin* pCtMainWin,
+                                                  const fs::path& file_path,
+                                                  Glib::ustring& password,
+                                                  std::string* pDocData/*= nullptr*/)
 {
-    fs::path temp_dir = pCtMainWin->get_ct_tmp()->getHiddenDirPath(file_path);
-    fs::path temp_file_path = pCtMainWin->get_ct_tmp()->getHiddenFilePath(file_path);
     Glib::ustring title = str::format(_("Enter Password for %s"), file_path.filename().string());
     while (true) {
         if (password.empty()) {
@@ -529,6 +867,26 @@ fs::path CtStorageControl::get_embedded_filepath(const CtTreeIter& ct_tree_iter,
             }
             password = dialogTextEntry.get_entry_text();
         }
+        if (pDocData) {
+            pDocData->clear();
+            const int retVal = CtP7zaIface::p7za_extract_to_stream(file_path.c_str(), password.c_str(), false,
+                [pDocData](const char* pData, const size_t dataSize){
+                    pDocData->append(pData, dataSize);
+                    return true;
+                });
+            if (0 == retVal and not pDocData->empty()) {
+                return file_path;
+            }
+            pDocData->clear();
+            spdlog::debug("!! CtP7zaIface::p7za_extract_to_stream retVal={}", retVal);
+            if (0 == retVal or 3 == retVal) {
+                return fs::path{BAD_ARCHIVE};
+            }
+            password.clear();
+            continue;
+        }
+        fs::path temp_dir = pCtMainWin->get_ct_tmp()->getHiddenDirPath(file_path);
+        fs::path temp_file_path = pCtMainWin->get_ct_tmp()->getHiddenFilePath(file_path);
         const int retVal = CtP7zaIface::p7za_extract(file_path.c_str(), temp_dir.c_str(), password.c_str(), false);
         if (0 == retVal) {
             if (fs::is_regular_file(temp_file_path)) {
@@ -588,13 +946,15 @@ CtStorageControl::CtStorageControl(CtMainWin* pCtMainWin)
  : _pCtMainWin{pCtMainWin}
  , _pCtConfig{pCtMainWin->get_ct_config()}
 {
+    _dispatcherSaveProgress.connect(sigc::mem_fun(*this, &CtStorageControl::_on_save_progress));
+    _dispatcherSaveDone.connect(sigc::mem_fun(*this, &CtStorageControl::_on_save_done));
     _pThreadBackupEncrypt = std::make_unique<std::thread>(std::bind(&CtStorageControl::_backupEncryptThread, this));
 }
 
 CtStorageControl::~CtStorageControl()
 {
     if (_pThreadBackupEncrypt) {
-        _backupEncryptKeepGoing = false;
+        // the writes queued before the nullptr are completed
         backupEncryptDEQueue.push_back(nullptr);
         _pThreadBackupEncrypt->join();
     }
@@ -602,13 +962,18 @@ CtStorageControl::~CtStorageControl()
 
 void CtStorageControl::_backupEncryptThread()
 {
-    while (_backupEncryptKeepGoing) {
+    while (true) {
         std::shared_ptr<CtBackupEncryptData> pBackupEncryptData = backupEncryptDEQueue.pop_front();
         if (not pBackupEncryptData) {
             // a nullptr is passed on purpose in order to exit the loop at app quit
             break;
         }
 
+        // write the document snapshot
+        if (pBackupEncryptData->f_write and not pBackupEncryptData->f_write()) {
+            continue;
+        }
+
         // encrypt the file
         if (pBackupEncryptData->needEncrypt) {
             Glib::ustring error;
@@ -651,7 +1016,8 @@ void CtStorageControl::_backupEncryptThread()
             continue;
         }
 
-        if (CtBackupType::SingleFile == pBackupEncryptData->backupType and not pBackupEncryptData->needEncrypt) {
+        // an encrypted backup is an archive, its document was checked before encrypting it
+        if (CtBackupType::SingleFile == pBackupEncryptData->backupType and not pBackupEncryptData->isEncrypted) {
             Glib::ustring error;
             if (not CtStorageControl::document_integrity_check_pass(_pCtMainWin, pBackupEncryptData->main_backup, error)) {
                 spdlog::error("{} {}", __FUNCTION__, error.raw());
@@ -765,7 +1131,7 @@ void CtStorageControl::_backupEncryptThread()
 #endif // DEBUG_BACKUP_ENCRYPT
             }
         }
-    } // while (_backupEncryptKeepGoing)
+    } // while (true)
 #if defined(DEBUG_BACKUP_ENCRYPT)
     spdlog::debug("out _backupEncryptThread");
 #endif // DEBUG_BACKUP_ENCRYPT
@@ -880,9 +1246,17 @@ void CtStorageControl::add_nodes_from_storage(const fs::path& file_path,
     _pCtMainWin->update_window_save_needed();
 }
 
-void CtStorageCache::generate_cache(CtMainWin* pCtMainWin, const CtStorageSyncPending* pending, bool for_xml)
+void CtStorageCache::generate_cache(CtMainWin* pCtMainWin, const CtStorageSyncPending* pending, bool for_xml, bool for_multifile/*= false*/)
 {
-    std::vector<CtImagePng*> image_list;
+    std::vector<CtAnchoredWidget*> widgets;
+    auto f_add_widgets = [&](const CtTreeIter& ct_tree_iter) {
+        for (auto widget : ct_tree_iter.get_anchored_widgets_fast()) {
+            // important to check type
+            if (widget->get_type() == CtAnchWidgType::ImagePng or widget->get_type() == CtAnchWidgType::ImageEmbFile) {
+                widgets.push_back(widget);
+            }
+        }
+    };
     auto& store = pCtMainWin->get_tree_store();
     if (not pending) {
         // all nodes
@@ -894,10 +1268,7 @@ void CtStorageCache::generate_cache(CtMainWin* pCtMainWin, const CtStorageSyncPe
                 error = str::format(_("Failed to retrieve the content of the node '%s'"), ct_tree_iter.get_node_name().raw());
                 return true; /* true for stop */
             }
-            for (auto widget : ct_tree_iter.get_anchored_widgets_fast())
-                if (widget->get_type() == CtAnchWidgType::ImagePng) // important to check type
-                    if (auto image = dynamic_cast<CtImagePng*>(widget))
-                        image_list.emplace_back(image);
+            f_add_widgets(ct_tree_iter);
             return false; /* false for continue */
         });
         if (not error.empty()) throw std::runtime_error(error);
@@ -910,46 +1281,76 @@ void CtStorageCache::generate_cache(CtMainWin* pCtMainWin, const CtStorageSyncPe
                 if (not pTextBuffer) {
                     throw std::runtime_error(str::format(_("Failed to retrieve the content of the node '%s'"), ct_tree_iter.get_node_name().raw()));
                 }
-                for (auto widget : ct_tree_iter.get_anchored_widgets_fast())
-                    if (widget->get_type() == CtAnchWidgType::ImagePng) // important to check type
-                        if (auto image = dynamic_cast<CtImagePng*>(widget))
-                            image_list.emplace_back(image);
+                f_add_widgets(ct_tree_iter);
             }
         }
     }
-    _parallel_fetch_pixbufers(image_list, for_xml);
+    CtThreadPool::TaskGroup taskGroup{CtThreadPool::get_global()};
+    generate_cache_async(widgets, for_xml, for_multifile, taskGroup);
+    taskGroup.wait();
 }
 
-void CtStorageCache::_parallel_fetch_pixbufers(const std::vector<CtImagePng*>& image_widgets, bool for_xml)
+void CtStorageCache::generate_cache_async(const std::vector<CtAnchoredWidget*>& widgets,
+                                          const bool for_xml,
+                                          const bool for_multifile,
+                                          CtThreadPool::TaskGroup& taskGroup)
 {
-    _cached_images.clear();
-
-    // auto start = std::chrono::steady_clock::now();
-
-    std::vector<std::pair<CtImagePng*, std::string>> image_pair(image_widgets.size());
-    for (size_t i = 0; i < image_widgets.size(); ++i)
-        image_pair[i].first = image_widgets[i];
-
-    // replacement for tbb::parallel_for
-    CtMiscUtil::parallel_for(0, image_pair.size(), [&](size_t index) {
-        auto& pair = image_pair[index];
-        pair.second = pair.first->get_raw_blob();
-        if (for_xml) pair.second = Glib::Base64::encode(pair.second);
-    });
-
-    for (auto& pair : image_pair) {
-        _cached_images.emplace(pair);
+    _cached_blobs.clear();
+    // all the keys are inserted upfront, then every task writes only the value of its widget
+    for (CtAnchoredWidget* pWidget : widgets) {
+        _cached_blobs.emplace(pWidget, CachedBlob{});
+    }
+    for (auto& curr_pair : _cached_blobs) {
+        taskGroup.run([&curr_pair, for_xml, for_multifile](){
+            CachedBlob& cachedBlob = curr_pair.second;
+            if (CtAnchWidgType::ImagePng == curr_pair.first->get_type()) {
+                // the png is kept by the image, encoded here only if it was never at hand
+                auto pImagePng = static_cast<CtImagePng*>(curr_pair.first);
+                const std::string& rawBlob = pImagePng->get_raw_blob();
+                if (for_multifile) {
+                    cachedBlob.sha256sum = pImagePng->get_raw_blob_sha256sum();
+                }
+                if (for_xml and not for_multifile) {
+                    cachedBlob.blob = Glib::Base64::encode(rawBlob);
+                }
+            }
+            else {
+                // the embedded file blob is at hand (unless on multifile disk), only encoding and hashing are cached
+                const std::string& rawBlob = static_cast<CtImageEmbFile*>(curr_pair.first)->get_raw_blob();
+                if (rawBlob.empty()) {
+                    return;
+                }
+                if (for_multifile) {
+                    cachedBlob.sha256sum = CtStorageMultiFile::get_blob_sha256sum(rawBlob);
+                }
+                if (for_xml) {
+                    cachedBlob.blob = Glib::Base64::encode(rawBlob);
+                }
+            }
+        });
     }
-
-    //auto end = std::chrono::steady_clock::now();
-    //std::chrono::duration<double> elapsed_seconds = end-start;
-    //spdlog::debug("{} amount: , {} sec.", __FUNCTION__, elapsed_seconds.count());
 }
 
 bool CtStorageCache::get_cached_image(CtImagePng* image, std::string& cached_image)
 {
-    auto it = _cached_images.find(image);
-    if (it == _cached_images.end()) return false;
-    cached_image = it->second;
+    auto it = _cached_blobs.find(image);
+    if (it == _cached_blobs.end() or it->second.blob.empty()) return false;
+    cached_image = it->second.blob;
+    return true;
+}
+
+bool CtStorageCache::get_cached_embfile(CtImageEmbFile* embfile, std::string& encoded_blob)
+{
+    auto it = _cached_blobs.find(embfile);
+    if (it == _cached_blobs.end() or it->second.blob.empty()) return false;
+    encoded_blob = it->second.blob;
+    return true;
+}
+
+bool CtStorageCache::get_cached_sha256sum(CtAnchoredWidget* widget, std::string& sha256sum)
+{
+    auto it = _cached_blobs.find(widget);
+    if (it == _cached_blobs.end() or it->second.sha256sum.empty()) return false;
+    sha256sum = it->second.sha256sum;
     return true;
 }
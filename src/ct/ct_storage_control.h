@@ -25,8 +25,13 @@
 
 #include "ct_types.h"
 #include "ct_widgets.h"
+#include "ct_search_index.h"
+#include "ct_storage_prefetch.h"
+#include "ct_misc_utils.h"
 #include <glibmm/miscutils.h>
+#include <glibmm/dispatcher.h>
 #include <thread>
+#include <atomic>
 
 class CtMainWin;
 class CtTreeStore;
@@ -63,10 +68,25 @@ public:
     ThreadSafeDEQueue<std::shared_ptr<CtBackupEncryptData>,1000> backupEncryptDEQueue;
 
     bool save(bool need_vacuum, Glib::ustring& error);
+    /**
+     * @brief If the previous save is still being written, save again once it is done
+     * @return false if no save is in progress so the caller can save right away
+     */
+    bool save_coalesce_if_in_progress();
     bool try_reopen(Glib::ustring& error);
     Glib::RefPtr<Gtk::TextBuffer> get_delayed_text_buffer(const gint64 node_id,
                                                           const std::string& syntax,
-                                                          std::list<CtAnchoredWidget*>& widgets) const;
+                                                          std::list<CtAnchoredWidget*>& widgets);
+    /**
+     * @brief Read and decode on the thread pool the bodies of these nodes, not loaded yet,
+     * for a following get_delayed_text_buffer() to only build the text buffer
+     */
+    void prefetch_text_buffers(const std::vector<std::pair<gint64, bool/*isRichText*/>>& nodes);
+    /**
+     * @brief The loaded text buffer of the node can be dropped and later loaded again through get_delayed_text_buffer()
+     * @return false if the node has changes not yet written to the document
+     */
+    bool release_text_buffer(const gint64 node_id);
     fs::path get_embedded_filepath(const CtTreeIter& ct_tree_iter, const std::string& filename) const;
     const fs::path& get_file_path() { return _file_path; }
     time_t get_mod_time() { return _mod_time; }
@@ -74,6 +94,7 @@ public:
     fs::path get_file_dir()  { return _file_path.empty() ? "" : _file_path.parent_path(); }
 
     const CtStorageSyncPending* get_storage_sync_pending() { return &_syncPending; }
+    CtSearchIndex& get_search_index() { return _searchIndex; }
 
     void pending_edit_db_node_prop(const gint64 node_id);
     void pending_edit_db_node_buff(const gint64 node_id);
@@ -92,11 +113,38 @@ public:
 
 private:
     static std::unique_ptr<CtStorageEntity> _get_entity_by_type(CtMainWin* pCtMainWin, CtDocType file_type);
-    static fs::path _extract_file(CtMainWin* pCtMainWin, const fs::path& file_path, Glib::ustring& password);
+    /**
+     * @brief Extract the encrypted document into a temporary file or, if pDocData is given, into memory
+     * @return the extracted file path (file_path itself if in memory), empty if canceled, BAD_ARCHIVE
+     */
+    static fs::path _extract_file(CtMainWin* pCtMainWin,
+                                  const fs::path& file_path,
+                                  Glib::ustring& password,
+                                  std::string* pDocData = nullptr);
     static bool     _package_file(const fs::path& file_from, const fs::path& file_to, const Glib::ustring& password);
 
     CtStorageControl(CtMainWin* pCtMainWin);
 
+    void _search_index_update_pending();
+    bool _search_index_save(const CtSearchIndex& searchIndex);
+
+    // runs on the backup/encrypt thread
+    bool _write_snapshot(CtStorageWriter& writer,
+                         const CtSearchIndex& searchIndex,
+                         const CtStorageSyncPending& syncPending,
+                         const CtDocType doc_type,
+                         const std::string& main_backup,
+                         const std::string& extracted_copy);
+    /**
+     * @brief Wait for the write of the previous save, putting back its pending changes if it failed
+     * @return true if pending changes were put back
+     */
+    bool _save_in_progress_wait();
+    bool _save_failed_pending_restore();
+    void _sync_pending_merge(const CtStorageSyncPending& syncPending);
+    void _on_save_progress();
+    void _on_save_done();
+
     CtMainWin*                 const _pCtMainWin;
     CtConfig*                  const _pCtConfig;
     fs::path                         _file_path;
@@ -105,21 +153,47 @@ private:
     fs::path                         _extracted_file_path;
     std::unique_ptr<CtStorageEntity> _storage;
     CtStorageSyncPending             _syncPending;
+    CtSearchIndex                    _searchIndex;
+    CtStoragePrefetch                _prefetch;
 
     std::unique_ptr<std::thread> _pThreadBackupEncrypt;
     void _backupEncryptThread();
-    bool _backupEncryptKeepGoing{true};
+
+    std::mutex                          _saveMutex;
+    std::condition_variable             _saveCondVar;
+    bool                                _saveInProgress{false};   // guarded by _saveMutex
+    std::optional<CtStorageSyncPending> _saveFailedPending;       // guarded by _saveMutex
+    bool                                _saveCoalesced{false};
+    std::atomic<size_t>                 _saveStepsDone{0};
+    std::atomic<size_t>                 _saveStepsTotal{0};
+    Glib::Dispatcher                    _dispatcherSaveProgress;
+    Glib::Dispatcher                    _dispatcherSaveDone;
 };
 
 class CtImagePng;
+class CtImageEmbFile;
 class CtStorageCache
 {
 public:
-    void generate_cache(CtMainWin* pCtMainWin, const CtStorageSyncPending* pending, bool for_xml);
+    /**
+     * @brief Encode on the thread pool the images and embedded files of the nodes to write
+     * @param for_multifile: also compute the sha256sum naming the blob files
+     */
+    void generate_cache(CtMainWin* pCtMainWin, const CtStorageSyncPending* pending, bool for_xml, bool for_multifile = false);
+    // the cache can be used after taskGroup.wait()
+    void generate_cache_async(const std::vector<CtAnchoredWidget*>& widgets,
+                              const bool for_xml,
+                              const bool for_multifile,
+                              CtThreadPool::TaskGroup& taskGroup);
     bool get_cached_image(CtImagePng* image, std::string& cached_image);
+    bool get_cached_embfile(CtImageEmbFile* embfile, std::string& encoded_blob);
+    bool get_cached_sha256sum(CtAnchoredWidget* widget, std::string& sha256sum);
 
 private:
-    void _parallel_fetch_pixbufers(const std::vector<CtImagePng*>& image_widgets, bool for_xml);
-
-    std::unordered_map<CtImagePng*, std::string> _cached_images;
+    struct CachedBlob
+    {
+        std::string blob;
+        std::string sha256sum;
+    };
+    std::unordered_map<CtAnchoredWidget*, CachedBlob> _cached_blobs;
 };
@@ -24,14 +24,56 @@
 #include "ct_storage_multifile.h"
 #include "ct_storage_xml.h"
 #include "ct_storage_control.h"
+#include "ct_search_index.h"
+#include "ct_storage_prefetch.h"
 #include "ct_main_win.h"
 #include "ct_logging.h"
+#include "ct_trace.h"
 #include <glib/gstdio.h>
 
 /*static*/const std::string CtStorageMultiFile::SUBNODES_LST{"subnodes.lst"};
 /*static*/const std::string CtStorageMultiFile::BOOKMARKS_LST{"bookmarks.lst"};
 /*static*/const std::string CtStorageMultiFile::NODE_XML{"node.xml"};
 /*static*/const std::string CtStorageMultiFile::BEFORE_SAVE{".before"};
+/*static*/const std::string CtStorageMultiFile::SEARCH_INDEX{".search_index.ctidx"};
+
+static bool is_same_or_sub_path(const std::string& sub_path, const std::string& dir_path)
+{
+    return sub_path.size() >= dir_path.size() and
+           0 == sub_path.compare(0, dir_path.size(), dir_path) and
+           (sub_path.size() == dir_path.size() or G_DIR_SEPARATOR == sub_path[dir_path.size()]);
+}
+
+void CtMultiFileIndex::move_dir(const fs::path& dir_path_from, const fs::path& dir_path_to)
+{
+    const std::string from = dir_path_from.string();
+    const std::string to = dir_path_to.string();
+    auto f_rebase = [&](fs::path& curr_path){
+        const std::string curr = curr_path.string();
+        if (is_same_or_sub_path(curr, from)) {
+            curr_path = fs::path{to + curr.substr(from.size())};
+        }
+    };
+    for (auto& pairIdDir : nodeDirs) {
+        f_rebase(pairIdDir.second);
+    }
+    for (auto& pairSumPath : blobPaths) {
+        f_rebase(pairSumPath.second);
+    }
+}
+
+void CtMultiFileIndex::remove_dir(const fs::path& dir_path)
+{
+    const std::string dir = dir_path.string();
+    for (auto it = nodeDirs.begin(); it != nodeDirs.end(); ) {
+        if (is_same_or_sub_path(it->second.string(), dir)) it = nodeDirs.erase(it);
+        else ++it;
+    }
+    for (auto it = blobPaths.begin(); it != blobPaths.end(); ) {
+        if (is_same_or_sub_path(it->second.string(), dir)) it = blobPaths.erase(it);
+        else ++it;
+    }
+}
 
 CtStorageMultiFile::CtStorageMultiFile(CtMainWin* pCtMainWin)
  : _pCtMainWin{pCtMainWin}
@@ -69,7 +111,7 @@ bool CtStorageMultiFile::save_treestore(const fs::path& dir_path,
             node_state.hier = true;
 
             CtStorageCache storage_cache;
-            storage_cache.generate_cache(_pCtMainWin, nullptr/*all nodes*/, false/*for_xml*/);
+            storage_cache.generate_cache(_pCtMainWin, nullptr/*all nodes*/, false/*for_xml*/, true/*for_multifile*/);
 
             std::list<gint64> subnodes_list;
 
@@ -121,7 +163,7 @@ bool CtStorageMultiFile::save_treestore(const fs::path& dir_path,
         else {
             // or need just update some info
             CtStorageCache storage_cache;
-            storage_cache.generate_cache(_pCtMainWin, &syncPending, false/*for_xml*/);
+            storage_cache.generate_cache(_pCtMainWin, &syncPending, false/*for_xml*/, true/*for_multifile*/);
 
             // update bookmarks
             if (syncPending.bookmarks_to_write) {
@@ -130,6 +172,14 @@ bool CtStorageMultiFile::save_treestore(const fs::path& dir_path,
             // update changed nodes
             const std::list<std::pair<CtTreeIter, CtStorageNodeState>> nodes_to_write = CtStorageControl::get_sorted_by_level_nodes_to_write(
                 &_pCtMainWin->get_tree_store(), syncPending.nodes_to_write_dict);
+            // the text of a node not visited yet is read from its node.xml, that is moved to BEFORE_SAVE
+            // as the node is written, so all the text to be written is loaded before any file is moved
+            for (const std::pair<CtTreeIter, CtStorageNodeState>& node_pair : nodes_to_write) {
+                if ((node_pair.second.buff or node_pair.second.prop) and not node_pair.first.get_node_text_buffer()) {
+                    error = fmt::format("failed to load the text of node {}", node_pair.first.get_node_id());
+                    return false;
+                }
+            }
             // at the time of saving, an embedded file could be cut and pasted from one node text buffer to another
             // so only after all the nodes are saved we can remove the files that belong to a node and are no longer referenced
             std::list<fs::path> embFiles_referenced;
@@ -250,6 +300,16 @@ bool CtStorageMultiFile::_found_node_dirpath(const fs::path& node_id, const fs::
     return false;
 }
 
+bool CtStorageMultiFile::_get_indexed_node_dirpath(const gint64 node_id, fs::path& hierarchical_path) const
+{
+    const auto it = _index.nodeDirs.find(node_id);
+    if (_index.nodeDirs.end() != it and fs::is_directory(it->second)) {
+        hierarchical_path = it->second;
+        return true;
+    }
+    return _found_node_dirpath(std::to_string(node_id), _dir_path, hierarchical_path);
+}
+
 fs::path CtStorageMultiFile::_get_node_dirpath(const CtTreeIter& ct_tree_iter) const
 {
     fs::path hierarchical_path{std::to_string(ct_tree_iter.get_node_id())};
@@ -266,6 +326,29 @@ fs::path CtStorageMultiFile::get_embedded_filepath(const CtTreeIter& ct_tree_ite
     return _get_node_dirpath(ct_tree_iter) / filename;
 }
 
+void CtStorageMultiFile::search_index_load(CtSearchIndex& searchIndex)
+{
+    searchIndex.clear();
+    if (_isDryRun or _dir_path.empty()) return;
+    (void)searchIndex.load_from_sidecar(_dir_path / SEARCH_INDEX, _get_doc_stamp());
+}
+
+void CtStorageMultiFile::search_index_save(const CtSearchIndex& searchIndex)
+{
+    if (_dir_path.empty()) return;
+    (void)searchIndex.save_to_sidecar(_dir_path / SEARCH_INDEX, _get_doc_stamp());
+}
+
+CtSearchIndex::DocStamp CtStorageMultiFile::_get_doc_stamp() const
+{
+    std::vector<fs::path> node_xml_paths;
+    node_xml_paths.reserve(_index.nodeDirs.size());
+    for (const auto& currPair : _index.nodeDirs) {
+        node_xml_paths.push_back(currPair.second / NODE_XML);
+    }
+    return CtSearchIndex::get_doc_stamp(node_xml_paths);
+}
+
 void CtStorageMultiFile::_remove_disk_node_with_children(const gint64 node_id)
 {
     // the nodes must be passed to the BackupEncrypt thread from the leaves towards the root
@@ -292,8 +375,9 @@ void CtStorageMultiFile::_remove_disk_node_with_children(const gint64 node_id)
         _already_queued_for_removal.insert(curr_node_id);
     };
     fs::path node_dirpath;
-    if (_found_node_dirpath(std::to_string(node_id), _dir_path, node_dirpath) and not node_dirpath.empty()) {
+    if (_get_indexed_node_dirpath(node_id, node_dirpath) and not node_dirpath.empty()) {
         f_iterative_queue_nodes_for_removal(node_dirpath);
+        _index.remove_dir(node_dirpath);
     }
 }
 
@@ -309,27 +393,13 @@ void CtStorageMultiFile::_write_bookmarks_to_disk(const std::list<gint64>& bookm
 
 void CtStorageMultiFile::_hier_try_move_existing_node_to_path(const fs::path& dir_path_to)
 {
-    const fs::path dir_name = dir_path_to.filename();
+    const gint64 node_id = CtStrUtil::gint64_from_gstring(dir_path_to.filename().c_str());
     fs::path dir_path_from;
-    std::function<void(const fs::path parent_path)> f_find_dir_from = [&](const fs::path parent_path){
-        for (const fs::path& p : fs::get_dir_entries(parent_path)) {
-            if (not dir_path_from.empty()) {
-                return;
-            }
-            if (fs::is_directory(p)) {
-                if (p.filename() == dir_name) {
-                    dir_path_from = p;
-                }
-                else {
-                    f_find_dir_from(p);
-                }
-            }
-        }
-    };
-    f_find_dir_from(_dir_path);
-    if (not dir_path_from.empty()) {
+    if (_get_indexed_node_dirpath(node_id, dir_path_from) and not dir_path_from.empty()) {
         spdlog::debug("{} -> {}", dir_path_from.string(), dir_path_to.string());
         fs::move_file(dir_path_from, dir_path_to);
+        _index.move_dir(dir_path_from, dir_path_to);
+        _index.nodeDirs[node_id] = dir_path_to;
     }
 }
 
@@ -350,11 +420,12 @@ bool CtStorageMultiFile::_nodes_to_multifile(const CtTreeIter* ct_tree_iter,
     {
         _hier_try_move_existing_node_to_path(dir_path);
     }
-    if (not fs::is_directory(dir_path) and
-        g_mkdir(dir_path.c_str(), 0755) < 0)
-    {
-        error = Glib::ustring{"!! mkdir "} + dir_path.string();
-        return false;
+    if (not fs::is_directory(dir_path)) {
+        if (g_mkdir(dir_path.c_str(), 0755) < 0) {
+            error = Glib::ustring{"!! mkdir "} + dir_path.string();
+            return false;
+        }
+        _index.nodeDirs[ct_tree_iter->get_node_id()] = dir_path;
     }
     if (node_state.buff or node_state.prop) {
         fs::path dir_before_save;
@@ -468,15 +539,21 @@ bool CtStorageMultiFile::_nodes_to_multifile(const CtTreeIter* ct_tree_iter,
     return true;
 }
 
-/*static*/std::string CtStorageMultiFile::save_blob(const std::string& rawBlob,
-                                                    const std::string& dir_path,
-                                                    const std::string& file_ext)
+/*static*/std::string CtStorageMultiFile::get_blob_sha256sum(const std::string& rawBlob)
 {
 #if GTKMM_MAJOR_VERSION >= 4
-    const std::string sha256sum = Glib::Checksum::compute_checksum(Glib::Checksum::Type::SHA256, rawBlob);
+    return Glib::Checksum::compute_checksum(Glib::Checksum::Type::SHA256, rawBlob);
 #else
-    const std::string sha256sum = Glib::Checksum::compute_checksum(Glib::Checksum::ChecksumType::CHECKSUM_SHA256, rawBlob);
+    return Glib::Checksum::compute_checksum(Glib::Checksum::ChecksumType::CHECKSUM_SHA256, rawBlob);
 #endif
+}
+
+/*static*/std::string CtStorageMultiFile::save_blob(const std::string& rawBlob,
+                                                    const std::string& dir_path,
+                                                    const std::string& file_ext,
+                                                    const std::string& sha256sum_precomputed/*= ""*/)
+{
+    const std::string sha256sum = sha256sum_precomputed.empty() ? get_blob_sha256sum(rawBlob) : sha256sum_precomputed;
     const std::string sha256sum_ext = sha256sum + file_ext;
     const std::string filepath = Glib::build_filename(dir_path, sha256sum_ext);
     if (not Glib::file_test(filepath, Glib::FILE_TEST_IS_REGULAR)) {
@@ -493,8 +570,21 @@ bool CtStorageMultiFile::_nodes_to_multifile(const CtTreeIter* ct_tree_iter,
 
 /*static*/bool CtStorageMultiFile::read_blob(const std::string& dir_path,
                                              const std::string& sha256sum,
-                                             std::string& rawBlob)
+                                             std::string& rawBlob,
+                                             const CtMultiFileIndex* pIndex/*= nullptr*/)
 {
+    if (pIndex) {
+        const auto it = pIndex->blobPaths.find(sha256sum);
+        if (pIndex->blobPaths.end() != it) {
+            try {
+                rawBlob = Glib::file_get_contents(it->second.string());
+                return true;
+            }
+            catch (Glib::Error&) {
+                // moved or removed since indexed, look for it in dir_path
+            }
+        }
+    }
     try {
         Glib::Dir gdir{dir_path};
         std::list<std::string> dir_entries{gdir.begin(), gdir.end()};
@@ -524,14 +614,125 @@ bool CtStorageMultiFile::_nodes_to_multifile(const CtTreeIter* ct_tree_iter,
     return ret_list;
 }
 
+// a node directory as read on a worker thread, the tree store is only touched on the main thread
+struct CtStorageMultiFile::LoadedNodeDir
+{
+    fs::path                         nodedir;
+    size_t                           parentIdx{std::string::npos}; // npos for a top level node
+    gint64                           sequence{0};
+    CtNodeData                       nodeData{}; // the properties only, the text buffer is created when the node is visited
+    std::shared_ptr<xmlpp::Document> pNodeDoc;   // only if node.xml could not be read through without the dom parser
+    std::vector<fs::path>            childDirs;
+    std::vector<fs::path>            blobPaths;
+    std::string                      restoredXmlPath;
+    std::string                      loadError;
+};
+
+void CtStorageMultiFile::_load_node_dir(LoadedNodeDir& loadedNodeDir) const
+{
+    const fs::path& nodedir = loadedNodeDir.nodedir;
+    const fs::path node_xml_path = nodedir / NODE_XML;
+    try {
+        loadedNodeDir.childDirs = CtStorageMultiFile::get_child_nodes_dirs(nodedir);
+        try {
+            Glib::Dir gdir{nodedir.string()};
+            for (const std::string& filename : gdir) {
+                const fs::path filepath = nodedir / filename;
+                if (CtStrUtil::is_256sum(filepath.stem())) {
+                    loadedNodeDir.blobPaths.push_back(filepath);
+                }
+            }
+        }
+        catch (Glib::Error& error) {
+            spdlog::error("{} {}", __FUNCTION__, std::string(error.what()));
+        }
+        // usually just the properties, the node text is parsed when the node is visited
+        try {
+            if (CtStorageXml::node_data_from_xml_data(Glib::file_get_contents(node_xml_path.string()), loadedNodeDir.nodeData)) {
+                return;
+            }
+        }
+        catch (Glib::Error& error) {
+            spdlog::error("{} {}", __FUNCTION__, std::string(error.what()));
+        }
+
+        std::unique_ptr<xmlpp::DomParser> pParser;
+        bool parsingOk{false};
+        try {
+            pParser = CtStorageXml::get_parser(node_xml_path);
+            parsingOk = true;
+        }
+        catch (std::exception& ex) {
+            spdlog::error("parse {} : {} - trying first backup...", node_xml_path.string(), ex.what());
+        }
+        if (not parsingOk) {
+            std::string first_backup_dir;
+            CtStorageControl::get_first_backup_file_or_dir(first_backup_dir, _dir_path.string(), _pCtMainWin->get_ct_config());
+            int missing_backup{0};
+            for (int b = 0; b < 100; ++b) {
+                const fs::path curr_backup_dir = first_backup_dir + str::repeat(CtConst::CHAR_TILDE, b).raw();
+                if (fs::is_directory(curr_backup_dir)) {
+                    missing_backup = 0;
+                    spdlog::debug("backed up data, {} found", curr_backup_dir.string());
+                    const fs::path backup_node_xml_path = curr_backup_dir / nodedir.filename() / NODE_XML;
+                    try {
+                        pParser = CtStorageXml::get_parser(backup_node_xml_path);
+                        parsingOk = true;
+                    }
+                    catch (std::exception& ex) {
+                        spdlog::error("parse {} : {} - trying backup {}...", node_xml_path.string(), ex.what(), b+2);
+                    }
+                    if (parsingOk) {
+                        if (fs::exists(node_xml_path)) {
+                            fs::move_file(node_xml_path, node_xml_path.parent_path() / (node_xml_path.stem() + std::string{"_BAD.xml"}));
+                        }
+                        spdlog::debug("parse backed up data ok, copying {} -> {}", backup_node_xml_path.string(), node_xml_path.string());
+                        fs::copy_file(backup_node_xml_path, node_xml_path);
+                        loadedNodeDir.restoredXmlPath = node_xml_path.string();
+                        break;
+                    }
+                }
+                else {
+                    spdlog::debug("?? backed up data, {} missing", curr_backup_dir.string());
+                    if (++missing_backup > 3) break;
+                }
+            }
+        }
+
+        // All backups failed to load: skip the node's content and open it in read-only mode
+        if (not parsingOk)
+        {
+            spdlog::error("node_xml_path: {} - Omiting file content", node_xml_path);
+            pParser = CtStorageXml::get_parser_header_only(node_xml_path);
+        }
+
+        xmlpp::Node* xml_node = pParser->get_document()->get_root_node()->get_first_child("node");
+        auto xml_element = static_cast<xmlpp::Element*>(xml_node);
+        loadedNodeDir.nodeData.nodeId = CtStrUtil::gint64_from_gstring(xml_element->get_attribute_value("unique_id").c_str());
+        CtStorageXmlHelper::node_data_from_attributes(loadedNodeDir.nodeData, [xml_element](const char* attr_name){ return xml_element->get_attribute_value(attr_name); });
+        // the dom is kept, the file on disk may not be the one parsed
+        loadedNodeDir.pNodeDoc = std::make_shared<xmlpp::Document>();
+        loadedNodeDir.pNodeDoc->create_root_node("root")->import_node(xml_element);
+    }
+    catch (std::exception& ex) {
+        loadedNodeDir.loadError = fmt::format("{}: {}", node_xml_path.string(), ex.what());
+    }
+    catch (Glib::Error& error) {
+        loadedNodeDir.loadError = fmt::format("{}: {}", node_xml_path.string(), std::string(error.what()));
+    }
+}
+
 bool CtStorageMultiFile::populate_treestore(const fs::path& dir_path, Glib::ustring& error)
 {
+    CtTrace::Span ctTraceSpan{"populate_treestore"};
     try {
         if (not fs::is_directory(dir_path)) {
             error = Glib::ustring{"missing "} + dir_path.string();
             return false;
         }
         _dir_path = dir_path;
+        _index.clear();
+        _delayed_node_ids.clear();
 
         CtTreeStore& ct_tree_store = _pCtMainWin->get_tree_store();
 
@@ -546,92 +747,89 @@ bool CtStorageMultiFile::populate_treestore(const fs::path& dir_path, Glib::ustr
             }
         }
 
-        // load node tree
+        // walk and read the node directories on the thread pool, a tree level at a time
+        std::vector<LoadedNodeDir> loadedNodeDirs;
+        gint64 sequence{0};
+        for (const fs::path& node_dirpath : CtStorageMultiFile::get_child_nodes_dirs(_dir_path)) {
+            LoadedNodeDir loadedNodeDir;
+            loadedNodeDir.nodedir = node_dirpath;
+            loadedNodeDir.sequence = ++sequence;
+            loadedNodeDirs.push_back(std::move(loadedNodeDir));
+        }
+        size_t levelFirst{0};
+        while (levelFirst < loadedNodeDirs.size()) {
+            const size_t levelLast = loadedNodeDirs.size();
+            CtMiscUtil::parallel_for(levelFirst, levelLast, [&](const size_t idx){
+                _load_node_dir(loadedNodeDirs[idx]);
+            });
+            for (size_t idx = levelFirst; idx < levelLast; ++idx) {
+                if (not loadedNodeDirs[idx].loadError.empty()) {
+                    throw std::runtime_error(loadedNodeDirs[idx].loadError);
+                }
+                gint64 child_sequence{0};
+                for (fs::path& subnode_dirpath : loadedNodeDirs[idx].childDirs) {
+                    LoadedNodeDir loadedNodeDir;
+                    loadedNodeDir.nodedir = std::move(subnode_dirpath);
+                    loadedNodeDir.parentIdx = idx;
+                    loadedNodeDir.sequence = ++child_sequence;
+                    loadedNodeDirs.push_back(std::move(loadedNodeDir));
+                }
+            }
+            levelFirst = levelLast;
+        }
+
+        // then into the tree store in one go, the parents come before their children
+        std::vector<Gtk::TreeModel::iterator> iters(loadedNodeDirs.size());
         std::list<CtTreeIter> nodes_with_duplicated_id;
         std::list<CtTreeIter> nodes_shared_non_master;
-        std::function<void(const fs::path&, const gint64, Gtk::TreeModel::iterator)> f_nodes_from_multifile;
-        f_nodes_from_multifile = [&](const fs::path& nodedir, const gint64 sequence, Gtk::TreeModel::iterator parent_iter) {
-            bool has_duplicated_id{false};
-            bool is_shared_non_master{false};
-            std::unique_ptr<xmlpp::DomParser> pParser;
-            fs::path node_xml_path = nodedir / NODE_XML;
-            bool parsingOk{false};
-            try {
-                pParser = CtStorageXml::get_parser(node_xml_path);
-                parsingOk = true;
+        for (size_t idx = 0; idx < loadedNodeDirs.size(); ++idx) {
+            LoadedNodeDir& loadedNodeDir = loadedNodeDirs[idx];
+            _index.nodeDirs.emplace(CtStrUtil::gint64_from_gstring(loadedNodeDir.nodedir.filename().c_str()), loadedNodeDir.nodedir);
+            for (const fs::path& blob_path : loadedNodeDir.blobPaths) {
+                _index.blobPaths.emplace(blob_path.stem(), blob_path);
             }
-            catch (std::exception& ex) {
-                spdlog::error("parse {} : {} - trying first backup...", node_xml_path.string(), ex.what());
-            }
-            if (not parsingOk) {
-                std::string first_backup_dir;
-                CtStorageControl::get_first_backup_file_or_dir(first_backup_dir, _dir_path.string(), _pCtMainWin->get_ct_config());
-                int missing_backup{0};
-                for (int b = 0; b < 100; ++b) {
-                    const fs::path curr_backup_dir = first_backup_dir + str::repeat(CtConst::CHAR_TILDE, b).raw();
-                    if (fs::is_directory(curr_backup_dir)) {
-                        missing_backup = 0;
-                        spdlog::debug("backed up data, {} found", curr_backup_dir.string());
-                        const fs::path backup_node_xml_path = curr_backup_dir / nodedir.filename() / NODE_XML;
-                        try {
-                            pParser = CtStorageXml::get_parser(backup_node_xml_path);
-                            parsingOk = true;
-                        }
-                        catch (std::exception& ex) {
-                            spdlog::error("parse {} : {} - trying backup {}...", node_xml_path.string(), ex.what(), b+2);
-                        }
-                        if (parsingOk) {
-                            if (fs::exists(node_xml_path)) {
-                                fs::move_file(node_xml_path, node_xml_path.parent_path() / (node_xml_path.stem() + std::string{"_BAD.xml"}));
-                            }
-                            spdlog::debug("parse backed up data ok, copying {} -> {}", backup_node_xml_path.string(), node_xml_path.string());
-                            fs::copy_file(backup_node_xml_path, node_xml_path);
-                            if (error.empty()) error += _("A Restore From Backup Was Necessary For:");
-                            error += "\n\n" + node_xml_path.string();
-                            break;
-                        }
-                    }
-                    else {
-                        spdlog::debug("?? backed up data, {} missing", curr_backup_dir.string());
-                        if (++missing_backup > 3) break;
-                    }
+            if (not loadedNodeDir.restoredXmlPath.empty()) {
+                if (error.empty()) error += _("A Restore From Backup Was Necessary For:");
+                error += "\n\n" + loadedNodeDir.restoredXmlPath;
+            }
+            if (_isDryRun) {
+                continue;
+            }
+            CtNodeData& node_data = loadedNodeDir.nodeData;
+            node_data.sequence = loadedNodeDir.sequence;
+            const bool has_duplicated_id = 0u != _delayed_node_ids.count(node_data.nodeId) or
+                                           0u != _delayed_text_buffers.count(node_data.nodeId);
+            if (has_duplicated_id) {
+                spdlog::debug("node has duplicated id {}, will be fixed", node_data.nodeId);
+                // create buffer now because we cannot have a duplicate id among the delayed ones
+                // the id will be fixed below
+                std::unique_ptr<xmlpp::DomParser> pParser;
+                std::shared_ptr<xmlpp::Document> pNodeDoc = loadedNodeDir.pNodeDoc;
+                if (not pNodeDoc) {
+                    pParser = CtStorageXml::get_parser(loadedNodeDir.nodedir / NODE_XML);
                 }
+                xmlpp::Element* xml_element = pNodeDoc ?
+                    static_cast<xmlpp::Element*>(pNodeDoc->get_root_node()->get_first_child()) :
+                    static_cast<xmlpp::Element*>(pParser->get_document()->get_root_node()->get_first_child("node"));
+                node_data.pTextBuffer = CtStorageXmlHelper{_pCtMainWin, &_index}.create_buffer_and_widgets_from_xml(
+                    xml_element, node_data.syntax, node_data.anchoredWidgets, nullptr, -1, loadedNodeDir.nodedir.string());
+            }
+            else if (loadedNodeDir.pNodeDoc) {
+                _delayed_text_buffers[node_data.nodeId] = loadedNodeDir.pNodeDoc;
+            }
+            else {
+                // parsed from node.xml when the node is visited, as for sqlite
+                _delayed_node_ids.insert(node_data.nodeId);
+            }
+            const Gtk::TreeModel::iterator parent_iter = std::string::npos == loadedNodeDir.parentIdx ?
+                Gtk::TreeModel::iterator{} : iters[loadedNodeDir.parentIdx];
+            iters[idx] = ct_tree_store.append_node(&node_data, &parent_iter);
+            if (has_duplicated_id) {
+                nodes_with_duplicated_id.push_back(ct_tree_store.to_ct_tree_iter(iters[idx]));
+            }
+            if (node_data.sharedNodesMasterId > 0) {
+                nodes_shared_non_master.push_back(ct_tree_store.to_ct_tree_iter(iters[idx]));
             }
-
-            // All backups failed to load: skip the node's content and open it in read-only mode
-            if (not parsingOk)
-            {
-                spdlog::error("node_xml_path: {} - Omiting file content", node_xml_path);
-                pParser = CtStorageXml::get_parser_header_only(node_xml_path);
-            }
-
-            xmlpp::Node* xml_node = pParser->get_document()->get_root_node()->get_first_child("node");
-            auto xml_element = static_cast<xmlpp::Element*>(xml_node);
-            Gtk::TreeModel::iterator new_iter = CtStorageXmlHelper{_pCtMainWin}.node_from_xml(
-                xml_element,
-                sequence,
-                parent_iter,
-                -1/*new_id*/,
-                &has_duplicated_id,
-                &is_shared_non_master,
-                nullptr/*pImportedIdsRemap*/,
-                _delayed_text_buffers,
-                _isDryRun,
-                nodedir.string());
-            if (has_duplicated_id and not _isDryRun) {
-                nodes_with_duplicated_id.push_back(ct_tree_store.to_ct_tree_iter(new_iter));
-            }
-            if (is_shared_non_master and not _isDryRun) {
-                nodes_shared_non_master.push_back(ct_tree_store.to_ct_tree_iter(new_iter));
-            }
-            gint64 child_sequence{0};
-            for (const fs::path& subnode_dirpath : CtStorageMultiFile::get_child_nodes_dirs(nodedir)) {
-                f_nodes_from_multifile(subnode_dirpath, ++child_sequence, new_iter);
-            }
-        };
-        gint64 sequence{0};
-        for (const fs::path& node_dirpath : CtStorageMultiFile::get_child_nodes_dirs(_dir_path)) {
-            f_nodes_from_multifile(node_dirpath, ++sequence, Gtk::TreeModel::iterator{});
         }
         // fix duplicated ids by allocating new ids
         // new ids can be allocated only after the whole tree is parsed
@@ -710,8 +908,37 @@ void CtStorageMultiFile::import_nodes(const fs::path& dir_path, const Gtk::TreeM
 
 Glib::RefPtr<Gtk::TextBuffer> CtStorageMultiFile::get_delayed_text_buffer(const gint64 node_id,
                                                                           const std::string& syntax,
-                                                                          std::list<CtAnchoredWidget*>& widgets) const
+                                                                          std::list<CtAnchoredWidget*>& widgets,
+                                                                          const CtPrefetchedBody* pPrefetchedBody) const
 {
+    if (0u != _delayed_node_ids.count(node_id)) {
+        if (pPrefetchedBody) {
+            if (auto ret_buffer = CtStorageXmlHelper{_pCtMainWin, &_index}.create_buffer_from_prefetched(node_id, *pPrefetchedBody)) {
+                _delayed_node_ids.erase(node_id);
+                return ret_buffer;
+            }
+        }
+        // the directory on disk, the node may have been moved in the tree since the last save
+        fs::path node_dirpath;
+        if (not _get_indexed_node_dirpath(node_id, node_dirpath)) {
+            spdlog::error("!! {} node_id {} not in {}", __FUNCTION__, node_id, _dir_path.string());
+            return Glib::RefPtr<Gtk::TextBuffer>{};
+        }
+        std::unique_ptr<xmlpp::DomParser> pParser;
+        try {
+            pParser = CtStorageXml::get_parser(node_dirpath / NODE_XML);
+        }
+        catch (std::exception& ex) {
+            spdlog::error("!! {} parse {} : {}", __FUNCTION__, (node_dirpath / NODE_XML).string(), ex.what());
+            return Glib::RefPtr<Gtk::TextBuffer>{};
+        }
+        auto xml_element = static_cast<xmlpp::Element*>(pParser->get_document()->get_root_node()->get_first_child("node"));
+        auto ret_buffer = CtStorageXmlHelper{_pCtMainWin, &_index}.create_buffer_and_widgets_from_xml(xml_element, syntax, widgets, nullptr, -1, node_dirpath.string());
+        if (ret_buffer) {
+            _delayed_node_ids.erase(node_id);
+        }
+        return ret_buffer;
+    }
     if (_delayed_text_buffers.count(node_id) == 0) {
         spdlog::error("!! {} node_id {}", __FUNCTION__, node_id);
         return Glib::RefPtr<Gtk::TextBuffer>{};
@@ -719,9 +946,37 @@ Glib::RefPtr<Gtk::TextBuffer> CtStorageMultiFile::get_delayed_text_buffer(const
     std::shared_ptr<xmlpp::Document> node_buffer = _delayed_text_buffers[node_id];
     auto xml_element = dynamic_cast<xmlpp::Element*>(node_buffer->get_root_node()->get_first_child());
     const fs::path multifile_dir = _get_node_dirpath(_pCtMainWin->get_tree_store().get_node_from_node_id(node_id));
-    auto ret_buffer = CtStorageXmlHelper{_pCtMainWin}.create_buffer_and_widgets_from_xml(xml_element, syntax, widgets, nullptr, -1, multifile_dir.string());
+    auto ret_buffer = CtStorageXmlHelper{_pCtMainWin, &_index}.create_buffer_and_widgets_from_xml(xml_element, syntax, widgets, nullptr, -1, multifile_dir.string());
     if (ret_buffer) {
         _delayed_text_buffers.erase(node_id);
     }
     return ret_buffer;
 }
+
+bool CtStorageMultiFile::release_text_buffer(const gint64 node_id)
+{
+    // the node directory is up to date once the node has no pending changes
+    fs::path node_dirpath;
+    if (not _get_indexed_node_dirpath(node_id, node_dirpath) or not fs::is_regular_file(node_dirpath / NODE_XML)) {
+        return false;
+    }
+    _delayed_node_ids.insert(node_id);
+    return true;
+}
+
+CtPrefetchedBodyReader CtStorageMultiFile::get_body_reader(const gint64 node_id, const bool isRichText) const
+{
+    fs::path node_dirpath;
+    if (0u == _delayed_node_ids.count(node_id) or not _get_indexed_node_dirpath(node_id, node_dirpath)) {
+        return CtPrefetchedBodyReader{};
+    }
+    return [node_xml_path = node_dirpath / NODE_XML, isRichText](CtPrefetchedBody& body) {
+        std::unique_ptr<xmlpp::DomParser> pParser = CtStorageXml::get_parser(node_xml_path);
+        auto xml_element = static_cast<xmlpp::Element*>(pParser->get_document()->get_root_node()->get_first_child("node"));
+        if (not xml_element) {
+            return false;
+        }
+        CtStoragePrefetch::body_from_node_element(xml_element, isRichText, body);
+        return true;
+    };
+}
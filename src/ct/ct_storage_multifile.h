@@ -26,6 +26,7 @@
 #include "ct_types.h"
 #include "ct_widgets.h"
 #include "ct_filesystem.h"
+#include "ct_search_index.h"
 #include <glibmm/refptr.h>
 #include <gtkmm/textbuffer.h>
 #include <gtkmm/treeiter.h>
@@ -36,6 +37,19 @@ class CtAnchoredWidget;
 class CtTreeIter;
 class CtStorageCache;
 
+// where the node directories and the blobs of a multifile document are, built once when the
+// document is loaded so that a lookup does not need to list or walk the directories
+struct CtMultiFileIndex
+{
+    std::unordered_map<gint64, fs::path>      nodeDirs;  // node id -> hierarchical directory
+    std::unordered_map<std::string, fs::path> blobPaths; // sha256sum -> a blob file with that content
+
+    void clear() { nodeDirs.clear(); blobPaths.clear(); }
+    // the directory with all its subdirectories
+    void move_dir(const fs::path& dir_path_from, const fs::path& dir_path_to);
+    void remove_dir(const fs::path& dir_path);
+};
+
 class CtStorageMultiFile : public CtStorageEntity
 {
 public:
@@ -43,13 +57,26 @@ public:
     static const std::string BOOKMARKS_LST;
     static const std::string NODE_XML;
     static const std::string BEFORE_SAVE;
+    static const std::string SEARCH_INDEX;
 
+    static std::string get_blob_sha256sum(const std::string& rawBlob);
+    /**
+     * @brief Write the blob in dir_path named after its sha256sum, unless already there
+     * @param sha256sum: the precomputed sha256sum of the blob, computed here if empty
+     * @return the sha256sum of the blob
+     */
     static std::string save_blob(const std::string& rawBlob,
                                  const std::string& dir_path,
-                                 const std::string& file_ext);
+                                 const std::string& file_ext,
+                                 const std::string& sha256sum = "");
+    /**
+     * @brief Read the blob named after its sha256sum in dir_path
+     * @param pIndex: if given, an indexed file with the same content is read instead of listing dir_path
+     */
     static bool read_blob(const std::string& dir_path,
                           const std::string& sha256sum,
-                          std::string& rawBlob);
+                          std::string& rawBlob,
+                          const CtMultiFileIndex* pIndex = nullptr);
 
     static std::list<fs::path> get_child_nodes_dirs(const fs::path& dir_path);
 
@@ -73,19 +100,35 @@ public:
 
     Glib::RefPtr<Gtk::TextBuffer> get_delayed_text_buffer(const gint64 node_id,
                                                           const std::string& syntax,
-                                                          std::list<CtAnchoredWidget*>& widgets) const override;
+                                                          std::list<CtAnchoredWidget*>& widgets,
+                                                          const CtPrefetchedBody* pPrefetchedBody) const override;
+    bool release_text_buffer(const gint64 node_id) override;
+    CtPrefetchedBodyReader get_body_reader(const gint64 node_id, const bool isRichText) const override;
 
     fs::path get_embedded_filepath(const CtTreeIter& ct_tree_iter, const std::string& filename) const override;
 
+    void search_index_load(CtSearchIndex& searchIndex) override;
+    void search_index_save(const CtSearchIndex& searchIndex) override;
+
 private:
     CtMainWin* const _pCtMainWin;
     CtConfig*  const _pCtConfig;
     fs::path         _dir_path;
     mutable CtDelayedTextBufferMap _delayed_text_buffers;
+    mutable std::unordered_set<gint64> _delayed_node_ids; // parsed from node.xml when the node is visited
     std::unordered_set<gint64> _already_queued_for_removal;
+    CtMultiFileIndex _index;
+
+    struct LoadedNodeDir;
+    // on a worker thread, reads subnodes.lst, the node properties and the blob names
+    void _load_node_dir(LoadedNodeDir& loadedNodeDir) const;
 
     fs::path _get_node_dirpath(const CtTreeIter& ct_tree_iter) const;
+    // of the node.xml of all the indexed nodes
+    CtSearchIndex::DocStamp _get_doc_stamp() const;
     bool _found_node_dirpath(const fs::path& node_id, const fs::path parent_path, fs::path& hierarchical_path) const;
+    // from the index, walking the directories only if the index has no such node
+    bool _get_indexed_node_dirpath(const gint64 node_id, fs::path& hierarchical_path) const;
     void _remove_disk_node_with_children(const gint64 node_id);
     void _verify_update_hierarchy(const CtTreeIter* ct_tree_iter_parent, const fs::path& dir_path);
     void _hier_try_move_existing_node_to_path(const fs::path& dir_path);
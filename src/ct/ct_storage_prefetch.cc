@@ -0,0 +1,167 @@
+/*
+ * ct_storage_prefetch.cc
+ *
+ * Copyright 2009-2026
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+
+#include "ct_storage_prefetch.h"
+#include "ct_rich_text_bin.h"
+#include "ct_logging.h"
+#include <libxml++/libxml++.h>
+
+/*static*/const size_t CtStoragePrefetch::MaxConcurrentReads{2};
+
+/*static*/void CtStoragePrefetch::body_from_node_element(const xmlpp::Element* pNodeElement,
+                                                         const bool isRichText,
+                                                         CtPrefetchedBody& body)
+{
+    body.isRichText = isRichText;
+    body.data = CtRichTextBin::from_xml_element(pNodeElement);
+    if (not isRichText) {
+        // the text of the single slot
+        CtRichTextBin::Body binBody;
+        if (not CtRichTextBin::decode(body.data, binBody)) {
+            throw std::runtime_error("rich text bin decode failed");
+        }
+        body.data = std::string{binBody.text};
+    }
+}
+
+/*static*/void CtStoragePrefetch::body_from_node_xml(const std::string& nodeXml,
+                                                     const bool isRichText,
+                                                     CtPrefetchedBody& body)
+{
+    xmlpp::DomParser parser;
+    parser.set_parser_options(xmlParserOption::XML_PARSE_HUGE);
+    parser.parse_memory_raw(reinterpret_cast<const unsigned char*>(nodeXml.data()), nodeXml.size());
+    if (not parser.get_document() or not parser.get_document()->get_root_node()) {
+        throw std::runtime_error("node xml parse failed");
+    }
+    body_from_node_element(parser.get_document()->get_root_node(), isRichText, body);
+}
+
+CtStoragePrefetch::CtStoragePrefetch()
+ : _taskGroup{CtThreadPool::get_global(), MaxConcurrentReads}
+{
+}
+
+CtStoragePrefetch::~CtStoragePrefetch()
+{
+    // the reads not started yet return right away
+    clear();
+}
+
+void CtStoragePrefetch::request(std::vector<std::pair<gint64, CtPrefetchedBodyReader>> nodeReaders)
+{
+    std::vector<std::pair<std::shared_ptr<Entry>, size_t>> newEntries;
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        std::unordered_map<gint64, std::shared_ptr<Entry>> entries;
+        for (size_t i = 0; i < nodeReaders.size(); ++i) {
+            const gint64 node_id = nodeReaders[i].first;
+            const auto itEntry = _entries.find(node_id);
+            if (_entries.end() != itEntry) {
+                // already requested, kept
+                entries[node_id] = itEntry->second;
+                _entries.erase(itEntry);
+            }
+            else if (0u == entries.count(node_id)) {
+                auto pEntry = std::make_shared<Entry>();
+                entries[node_id] = pEntry;
+                newEntries.emplace_back(pEntry, i);
+            }
+        }
+        for (auto& idAndEntry : _entries) {
+            idAndEntry.second->state = State::Dropped;
+        }
+        _entries.swap(entries);
+    }
+    _condVar.notify_all();
+    for (auto& entryAndIdx : newEntries) {
+        _taskGroup.run([this, pEntry = entryAndIdx.first, nodeReader = std::move(nodeReaders[entryAndIdx.second])](){
+            _read(pEntry, nodeReader.second, nodeReader.first);
+        });
+    }
+}
+
+void CtStoragePrefetch::_read(std::shared_ptr<Entry> pEntry, const CtPrefetchedBodyReader& reader, const gint64 node_id)
+{
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        if (State::Queued != pEntry->state) {
+            return;
+        }
+        pEntry->state = State::Reading;
+    }
+    CtPrefetchedBody body;
+    bool readOk{false};
+    try {
+        readOk = reader(body);
+    }
+    catch (std::exception& e) {
+        // i.e. anchored widgets, left to the synchronous load
+        spdlog::debug("{} {} {}", __FUNCTION__, node_id, e.what());
+    }
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        if (State::Reading == pEntry->state) {
+            pEntry->state = readOk ? State::Done : State::Failed;
+            if (readOk) {
+                pEntry->body = std::move(body);
+            }
+        }
+    }
+    _condVar.notify_all();
+}
+
+bool CtStoragePrefetch::take(const gint64 node_id, CtPrefetchedBody& body)
+{
+    std::unique_lock<std::mutex> lock{_mutex};
+    const auto itEntry = _entries.find(node_id);
+    if (_entries.end() == itEntry) {
+        return false;
+    }
+    std::shared_ptr<Entry> pEntry = itEntry->second;
+    _entries.erase(itEntry);
+    if (State::Queued == pEntry->state) {
+        // not started, reading it now is faster than waiting for the other reads
+        pEntry->state = State::Dropped;
+        return false;
+    }
+    _condVar.wait(lock, [&pEntry](){ return State::Reading != pEntry->state; });
+    if (State::Done != pEntry->state) {
+        return false;
+    }
+    body = std::move(pEntry->body);
+    return true;
+}
+
+void CtStoragePrefetch::clear()
+{
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        for (auto& idAndEntry : _entries) {
+            idAndEntry.second->state = State::Dropped;
+        }
+        _entries.clear();
+    }
+    _condVar.notify_all();
+}
@@ -0,0 +1,82 @@
+/*
+ * ct_storage_prefetch.h
+ *
+ * Copyright 2009-2026
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+
+#pragma once
+
+#include "ct_types.h"
+#include "ct_misc_utils.h"
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace xmlpp {
+class Element;
+}
+
+/**
+ * @brief Read and decode on the thread pool the bodies of the nodes likely to be selected next
+ * The bodies are kept in a form without any toolkit object, so that the main thread only has to
+ * build the text buffer. Only the bodies made of rich text slots, without anchored widgets, are prefetched.
+ */
+class CtStoragePrefetch
+{
+public:
+    static const size_t MaxConcurrentReads;
+
+    // throw std::runtime_error on a body with anchored widgets
+    static void body_from_node_element(const xmlpp::Element* pNodeElement, const bool isRichText, CtPrefetchedBody& body);
+    static void body_from_node_xml(const std::string& nodeXml, const bool isRichText, CtPrefetchedBody& body);
+
+    CtStoragePrefetch();
+    ~CtStoragePrefetch();
+    CtStoragePrefetch(const CtStoragePrefetch&) = delete;
+    CtStoragePrefetch& operator=(const CtStoragePrefetch&) = delete;
+
+    // the previous requests not among these are dropped
+    void request(std::vector<std::pair<gint64, CtPrefetchedBodyReader>> nodeReaders);
+    /**
+     * @brief Get the prefetched body of the node, waiting for it if it is being read
+     * @return false if the body was not prefetched
+     */
+    bool take(const gint64 node_id, CtPrefetchedBody& body);
+    // the stored bodies are going to change, the prefetched ones are dropped
+    void clear();
+
+private:
+    enum class State { Queued, Reading, Done, Failed, Dropped };
+    struct Entry
+    {
+        State            state{State::Queued};
+        CtPrefetchedBody body;
+    };
+
+    void _read(std::shared_ptr<Entry> pEntry, const CtPrefetchedBodyReader& reader, const gint64 node_id);
+
+    std::mutex                                         _mutex;
+    std::condition_variable                            _condVar;
+    std::unordered_map<gint64, std::shared_ptr<Entry>> _entries; // guarded by _mutex
+    CtThreadPool::TaskGroup                            _taskGroup; // destroyed first, waiting for the running reads
+};
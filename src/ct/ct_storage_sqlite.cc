@@ -24,8 +24,12 @@
 #include "ct_storage_sqlite.h"
 #include "ct_storage_xml.h"
 #include "ct_storage_control.h"
+#include "ct_search_index.h"
+#include "ct_rich_text_bin.h"
+#include "ct_storage_prefetch.h"
 #include "ct_main_win.h"
 #include "ct_logging.h"
+#include "ct_trace.h"
 #include <unistd.h>
 #include <optional>
 
@@ -117,6 +121,15 @@ const char CtStorageSqlite::TABLE_BOOKMARK_CREATE[]{"CREATE TABLE bookmark ("
 const char CtStorageSqlite::TABLE_BOOKMARK_INSERT[]{"INSERT INTO bookmark VALUES(?,?)"};
 const char CtStorageSqlite::TABLE_BOOKMARK_DELETE[]{"DELETE FROM bookmark"};
 
+const char CtStorageSqlite::TABLE_SEARCH_INDEX_CREATE[]{"CREATE TABLE IF NOT EXISTS search_index ("
+"node_id INTEGER UNIQUE,"
+"ts_lastsave INTEGER,"
+"bloom BLOB"
+")"
+};
+const char CtStorageSqlite::TABLE_SEARCH_INDEX_INSERT[]{"INSERT OR REPLACE INTO search_index VALUES(?,?,?)"};
+const char CtStorageSqlite::TABLE_SEARCH_INDEX_DELETE[]{"DELETE FROM search_index WHERE node_id=?"};
+
 /*static*/const std::string CtStorageSqlite::ERR_SQLITE_PREPV2{"!! sqlite3_prepare_v2: "};
 /*static*/const std::string CtStorageSqlite::ERR_SQLITE_STEP{"!! sqlite3_step: "};
 
@@ -135,6 +148,73 @@ private:
     sqlite3_stmt* _pStmt{nullptr};
 };
 
+sqlite3_stmt* CtSqliteStmtCache::get(const char* sql)
+{
+    auto itStmt = _stmts.find(sql);
+    if (_stmts.end() != itStmt) {
+        sqlite3_reset(itStmt->second);
+        sqlite3_clear_bindings(itStmt->second);
+        return itStmt->second;
+    }
+    sqlite3_stmt* pStmt{nullptr};
+    if (sqlite3_prepare_v2(_pDb, sql, -1, &pStmt, nullptr) != SQLITE_OK) {
+        sqlite3_finalize(pStmt);
+        return nullptr;
+    }
+    _stmts[sql] = pStmt;
+    return pStmt;
+}
+
+void CtSqliteStmtCache::clear()
+{
+    for (auto& pairSqlStmt : _stmts) {
+        sqlite3_finalize(pairSqlStmt.second);
+    }
+    _stmts.clear();
+}
+
+// wraps a statement owned by the cache, resetting it for the next use on scope exit
+class Sqlite3StmtCached
+{
+public:
+    Sqlite3StmtCached(sqlite3_stmt* pStmt) : _pStmt{pStmt} {}
+    ~Sqlite3StmtCached() {
+        if (_pStmt) {
+            sqlite3_reset(_pStmt);
+            sqlite3_clear_bindings(_pStmt);
+        }
+    }
+
+    operator sqlite3_stmt*() { return _pStmt; }
+    bool is_bad() { return not _pStmt; }
+
+private:
+    sqlite3_stmt* _pStmt;
+};
+
+// columns name, syntax, tags, is_ro, is_richtxt, level, ts_creation, ts_lastsave starting from firstCol
+static void node_data_props_from_stmt(sqlite3_stmt* pStmt, const int firstCol, CtNodeData& nodeData)
+{
+    nodeData.name = CtStorageSqlite::safe_sqlite3_column_text(pStmt, firstCol);
+    nodeData.syntax = CtStorageSqlite::safe_sqlite3_column_text(pStmt, firstCol+1);
+    nodeData.tags = CtStorageSqlite::safe_sqlite3_column_text(pStmt, firstCol+2);
+    const gint64 readonly_n_custom_icon_id = sqlite3_column_int64(pStmt, firstCol+3);
+    nodeData.isReadOnly = static_cast<bool>(readonly_n_custom_icon_id & 0x01);
+    nodeData.customIconId = readonly_n_custom_icon_id >> 1;
+    const gint64 richtxt_bold_foreground = sqlite3_column_int64(pStmt, firstCol+4);
+    nodeData.isBold = static_cast<bool>((richtxt_bold_foreground >> 1) & 0x01);
+    if (static_cast<bool>((richtxt_bold_foreground >> 2) & 0x01)) {
+        char foregroundRgb24[8];
+        CtRgbUtil::set_rgb24str_from_rgb24int((richtxt_bold_foreground >> 3) & 0xffffff, foregroundRgb24);
+        nodeData.foregroundRgb24 = foregroundRgb24;
+    }
+    const gint64 exclude_from_search = sqlite3_column_int64(pStmt, firstCol+5);
+    nodeData.excludeMeFromSearch = exclude_from_search & 0x01;
+    nodeData.excludeChildrenFromSearch = exclude_from_search & 0x02;
+    nodeData.tsCreation = sqlite3_column_int64(pStmt, firstCol+6);
+    nodeData.tsLastSave = sqlite3_column_int64(pStmt, firstCol+7);
+}
+
 std::optional<std::vector<std::string>> get_quick_check_issues(sqlite3* db)
 {
     if (not db) throw std::logic_error("get_quick_check_issues passed invalid database object");
@@ -239,6 +319,7 @@ void CtStorageSqlite::try_reopen()
 
 bool CtStorageSqlite::populate_treestore(const fs::path& file_path, Glib::ustring& error)
 {
+    CtTrace::Span ctTraceSpan{"populate_treestore"};
     _close_db();
     try {
         // open db
@@ -260,6 +341,10 @@ bool CtStorageSqlite::populate_treestore(const fs::path& file_path, Glib::ustrin
         }
 
         // load node tree
+        if (_nodes_from_db_bulk()) {
+            // keep db open for lazy node buffer loading
+            return true;
+        }
         std::function<void(const std::pair<gint64,gint64>& id_pair, const gint64 sequence, Gtk::TreeModel::iterator parent_iter)> f_nodes_from_db;
         f_nodes_from_db = [this, &f_nodes_from_db](const std::pair<gint64,gint64>& id_pair, const gint64 sequence, Gtk::TreeModel::iterator parent_iter) {
             Gtk::TreeModel::iterator new_iter = _node_from_db(id_pair.first,
@@ -297,10 +382,14 @@ bool CtStorageSqlite::save_treestore(const fs::path& file_path,
 {
     try {
         // it's the first time (or an export), a new file will be created
-        if (_pDb == nullptr) {
+        const bool is_new_db = _pDb == nullptr;
+        if (is_new_db) {
             _open_db(file_path);
             _file_path = file_path;
-
+        }
+        // the whole save in a single transaction, rather than one journal sync per statement
+        _exec_no_callback("BEGIN TRANSACTION");
+        if (is_new_db) {
             _create_all_tables_in_db();
             if ( CtExporting::NONESAVEAS == export_type or
                  CtExporting::ALL_TREE == export_type )
@@ -391,14 +480,158 @@ bool CtStorageSqlite::save_treestore(const fs::path& file_path,
                 _remove_db_node_with_children(node_id);
             }
         }
+        _exec_no_callback("COMMIT");
         return true;
     }
     catch (std::exception& e) {
+        if (_pDb and not sqlite3_get_autocommit(_pDb)) {
+            (void)sqlite3_exec(_pDb, "ROLLBACK", nullptr, nullptr, nullptr);
+        }
         error = e.what();
         return false;
     }
 }
 
+// the nodes gathered on the UI thread, their widgets are staged into an in-memory database
+class CtStorageSqliteWriter : public CtStorageWriter
+{
+public:
+    CtStorageSqliteWriter(CtStorageSqlite* pCtStorageSqlite)
+     : _pCtStorageSqlite{pCtStorageSqlite}
+    {}
+    ~CtStorageSqliteWriter() override { sqlite3_close(pDbStaging); }
+
+    size_t get_num_steps() const override { return nodeRows.size() + nodesToRm.size() + 1u; }
+    void write(const std::function<void(const size_t)>& f_progress) override;
+
+    sqlite3* pDbStaging{nullptr};
+    bool fixDbTables{false};
+    std::optional<std::list<gint64>> bookmarks;
+    std::vector<CtStorageSqlite::NodeRow> nodeRows;
+    std::vector<gint64> nodesToRm;
+
+private:
+    void _copy_staged_table_rows(const char* tableName);
+
+    CtStorageSqlite* const _pCtStorageSqlite;
+};
+
+void CtStorageSqliteWriter::write(const std::function<void(const size_t)>& f_progress)
+{
+    if (not _pCtStorageSqlite->_pDb) {
+        throw std::runtime_error("storage not initialized");
+    }
+    // check db tables columns (for document created with old version)
+    if (fixDbTables) {
+        _pCtStorageSqlite->_fix_db_tables();
+    }
+    // all or nothing, so that a failure can just put back the pending changes
+    _pCtStorageSqlite->_exec_no_callback("BEGIN TRANSACTION");
+    try {
+        size_t stepsDone{0};
+        if (bookmarks) {
+            _pCtStorageSqlite->_write_bookmarks_to_db(*bookmarks);
+        }
+        for (const CtStorageSqlite::NodeRow& nodeRow : nodeRows) {
+            _pCtStorageSqlite->_write_node_row_to_db(nodeRow);
+            f_progress(++stepsDone);
+        }
+        _copy_staged_table_rows("codebox");
+        _copy_staged_table_rows("grid");
+        _copy_staged_table_rows("image");
+        for (const gint64 node_id : nodesToRm) {
+            _pCtStorageSqlite->_remove_db_node_with_children(node_id);
+            f_progress(++stepsDone);
+        }
+        _pCtStorageSqlite->_exec_no_callback("COMMIT");
+        f_progress(++stepsDone);
+    }
+    catch (std::exception&) {
+        (void)sqlite3_exec(_pCtStorageSqlite->_pDb, "ROLLBACK", nullptr, nullptr, nullptr);
+        throw;
+    }
+}
+
+void CtStorageSqliteWriter::_copy_staged_table_rows(const char* tableName)
+{
+    sqlite3* pDb = _pCtStorageSqlite->_pDb;
+    Sqlite3StmtAuto stmtFrom{pDbStaging, (std::string{"SELECT * FROM "} + tableName).c_str()};
+    if (stmtFrom.is_bad()) {
+        throw std::runtime_error(CtStorageSqlite::ERR_SQLITE_PREPV2 + sqlite3_errmsg(pDbStaging));
+    }
+    // by column name as the columns order of a document created with an old version may differ
+    const int numCols = sqlite3_column_count(stmtFrom);
+    std::string sqlInsert = std::string{"INSERT INTO "} + tableName + " (";
+    for (int i = 0; i < numCols; ++i) {
+        sqlInsert += std::string{i > 0 ? "," : ""} + sqlite3_column_name(stmtFrom, i);
+    }
+    sqlInsert += ") VALUES (";
+    for (int i = 0; i < numCols; ++i) {
+        sqlInsert += i > 0 ? ",?" : "?";
+    }
+    sqlInsert += ")";
+    std::unique_ptr<Sqlite3StmtAuto> uStmtTo;
+    while (sqlite3_step(stmtFrom) == SQLITE_ROW) {
+        if (not uStmtTo) {
+            uStmtTo = std::make_unique<Sqlite3StmtAuto>(pDb, sqlInsert.c_str());
+            if (uStmtTo->is_bad()) {
+                throw std::runtime_error(CtStorageSqlite::ERR_SQLITE_PREPV2 + sqlite3_errmsg(pDb));
+            }
+        }
+        for (int i = 0; i < numCols; ++i) {
+            sqlite3_bind_value(*uStmtTo, i+1, sqlite3_column_value(stmtFrom, i));
+        }
+        if (sqlite3_step(*uStmtTo) != SQLITE_DONE) {
+            throw std::runtime_error(CtStorageSqlite::ERR_SQLITE_STEP + sqlite3_errmsg(pDb));
+        }
+        sqlite3_reset(*uStmtTo);
+    }
+}
+
+std::unique_ptr<CtStorageWriter> CtStorageSqlite::save_treestore_snapshot(const fs::path&/*file_path*/,
+                                                                         const CtStorageSyncPending& syncPending)
+{
+    if (_pDb == nullptr) {
+        // the first save creates the database, keep it synchronous
+        return nullptr;
+    }
+    auto pWriter = std::make_unique<CtStorageSqliteWriter>(this);
+    if (sqlite3_open(":memory:", &pWriter->pDbStaging) != SQLITE_OK) {
+        throw std::runtime_error(std::string("sqlite3_open: ") + sqlite3_errmsg(pWriter->pDbStaging));
+    }
+    for (const char* sqlCreate : {TABLE_CODEBOX_CREATE, TABLE_TABLE_CREATE, TABLE_IMAGE_CREATE}) {
+        if (SQLITE_OK != sqlite3_exec(pWriter->pDbStaging, sqlCreate, nullptr, nullptr, nullptr)) {
+            throw std::runtime_error(std::string("!! sqlite3 '") + sqlCreate + "': " + sqlite3_errmsg(pWriter->pDbStaging));
+        }
+    }
+
+    CtStorageCache storage_cache;
+    storage_cache.generate_cache(_pCtMainWin, &syncPending, false/*for_xml*/);
+    CtSqliteStmtCache stagingStmts{pWriter->pDbStaging};
+
+    pWriter->fixDbTables = syncPending.fix_db_tables;
+    if (syncPending.bookmarks_to_write) {
+        pWriter->bookmarks = _pCtMainWin->get_tree_store().bookmarks_get();
+    }
+    const std::list<std::pair<CtTreeIter, CtStorageNodeState>> nodes_to_write = CtStorageControl::get_sorted_by_level_nodes_to_write(
+        &_pCtMainWin->get_tree_store(), syncPending.nodes_to_write_dict);
+    pWriter->nodeRows.reserve(nodes_to_write.size());
+    for (const auto& node_pair : nodes_to_write) {
+        CtTreeIter ct_tree_iter_parent = node_pair.first.parent();
+        pWriter->nodeRows.push_back(_node_row_from_tree_iter(&node_pair.first,
+                                                             node_pair.first.get_node_sequence(),
+                                                             ct_tree_iter_parent ? ct_tree_iter_parent.get_node_id() : 0,
+                                                             node_pair.second,
+                                                             0,
+                                                             -1,
+                                                             CtExporting::NONESAVE,
+                                                             nullptr));
+        _write_node_widgets_to_db(&stagingStmts, &node_pair.first, pWriter->nodeRows.back(), 0, -1, &storage_cache);
+    }
+    pWriter->nodesToRm.assign(syncPending.nodes_to_rm_set.begin(), syncPending.nodes_to_rm_set.end());
+    return pWriter;
+}
+
 void CtStorageSqlite::vacuum()
 {
     spdlog::debug("VACUUM");
@@ -409,17 +642,23 @@ void CtStorageSqlite::vacuum()
 void CtStorageSqlite::_open_db(const fs::path& path)
 {
     if (_pDb) return;
-    if (sqlite3_open(path.c_str(), &_pDb) != SQLITE_OK) {
+    // serialized, the background save writes while the UI thread may load a node
+    if (sqlite3_open_v2(path.c_str(), &_pDb, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_FULLMUTEX, nullptr) != SQLITE_OK) {
         std::string error = sqlite3_errmsg(_pDb);
         sqlite3_close(_pDb); // even after error, _pDb is initialized
         _pDb = nullptr;
         throw std::runtime_error(std::string("sqlite3_open: ") + error);
     }
+    _uReadStmts = std::make_unique<CtSqliteStmtCache>(_pDb);
+    _uWriteStmts = std::make_unique<CtSqliteStmtCache>(_pDb);
 }
 
 void CtStorageSqlite::_close_db()
 {
     if (not _pDb) return;
+    // the statements must be finalized before the database can be closed
+    _uReadStmts.reset();
+    _uWriteStmts.reset();
     sqlite3_close(_pDb);
     _pDb = nullptr;
     //_file_path = ""; we need file_path for reconnection
@@ -455,24 +694,7 @@ Gtk::TreeModel::iterator CtStorageSqlite::_node_from_db(const gint64 node_id,
     nodeData.sharedNodesMasterId = master_id;
     nodeData.sequence = sequence;
 
-    nodeData.name = safe_sqlite3_column_text(*uStmt, 0);
-    nodeData.syntax = safe_sqlite3_column_text(*uStmt, 1);
-    nodeData.tags = safe_sqlite3_column_text(*uStmt, 2);
-    const gint64 readonly_n_custom_icon_id = sqlite3_column_int64(*uStmt, 3);
-    nodeData.isReadOnly = static_cast<bool>(readonly_n_custom_icon_id & 0x01);
-    nodeData.customIconId = readonly_n_custom_icon_id >> 1;
-    const gint64 richtxt_bold_foreground = sqlite3_column_int64(*uStmt, 4);
-    nodeData.isBold = static_cast<bool>((richtxt_bold_foreground >> 1) & 0x01);
-    if (static_cast<bool>((richtxt_bold_foreground >> 2) & 0x01)) {
-        char foregroundRgb24[8];
-        CtRgbUtil::set_rgb24str_from_rgb24int((richtxt_bold_foreground >> 3) & 0xffffff, foregroundRgb24);
-        nodeData.foregroundRgb24 = foregroundRgb24;
-    }
-    const gint64 exclude_from_search = sqlite3_column_int64(*uStmt, 5);
-    nodeData.excludeMeFromSearch = exclude_from_search & 0x01;
-    nodeData.excludeChildrenFromSearch = exclude_from_search & 0x02;
-    nodeData.tsCreation = sqlite3_column_int64(*uStmt, 6);
-    nodeData.tsLastSave = sqlite3_column_int64(*uStmt, 7);
+    node_data_props_from_stmt(*uStmt, 0/*firstCol*/, nodeData);
 
     if (_isDryRun) {
         return Gtk::TreeModel::iterator{};
@@ -480,17 +702,89 @@ Gtk::TreeModel::iterator CtStorageSqlite::_node_from_db(const gint64 node_id,
 
     // buffer for imported node should be loaded now because file will be closed
     if (new_id != -1 and master_id <= 0/*no need for shared non master*/) {
-        nodeData.pTextBuffer = get_delayed_text_buffer(node_id, nodeData.syntax, nodeData.anchoredWidgets);
+        nodeData.pTextBuffer = get_delayed_text_buffer(node_id, nodeData.syntax, nodeData.anchoredWidgets, nullptr/*pPrefetchedBody*/);
     }
 
     return _pCtMainWin->get_tree_store().append_node(&nodeData, &parent_iter);
 }
 
+bool CtStorageSqlite::_nodes_from_db_bulk()
+{
+    // one scan instead of two queries per node; older databases without master_id
+    // or ts_creation/ts_lastsave fail to prepare and go through the per node path
+    Sqlite3StmtAuto stmt{_pDb, "SELECT c.node_id, c.father_id, c.master_id, n.node_id, n.name, n.syntax, n.tags, n.is_ro, n.is_richtxt, n.level, n.ts_creation, n.ts_lastsave "
+                               "FROM children AS c LEFT JOIN node AS n ON n.node_id=(CASE WHEN c.master_id>0 THEN c.master_id ELSE c.node_id END) "
+                               "ORDER BY c.father_id ASC, c.sequence ASC"};
+    if (stmt.is_bad()) {
+        spdlog::debug("{} fallback: {}", __FUNCTION__, sqlite3_errmsg(_pDb));
+        return false;
+    }
+
+    struct NodeRow {
+        gint64 node_id;
+        gint64 master_id;
+        bool has_props;
+        CtNodeData nodeData;
+    };
+    std::unordered_map<gint64, std::vector<NodeRow>> rowsByFather;
+    int retStep;
+    while (SQLITE_ROW == (retStep = sqlite3_step(stmt))) {
+        NodeRow row{};
+        row.node_id = sqlite3_column_int64(stmt, 0);
+        const gint64 father_id = sqlite3_column_int64(stmt, 1);
+        row.master_id = sqlite3_column_int64(stmt, 2);
+        row.has_props = SQLITE_NULL != sqlite3_column_type(stmt, 3);
+        if (row.has_props) {
+            node_data_props_from_stmt(stmt, 4/*firstCol*/, row.nodeData);
+        }
+        rowsByFather[father_id].push_back(std::move(row));
+    }
+    if (SQLITE_DONE != retStep) {
+        throw std::runtime_error(ERR_SQLITE_STEP + sqlite3_errmsg(_pDb));
+    }
+
+    std::function<void(const gint64 father_id, Gtk::TreeModel::iterator parent_iter)> f_children_from_rows;
+    f_children_from_rows = [this, &rowsByFather, &f_children_from_rows](const gint64 father_id, Gtk::TreeModel::iterator parent_iter) {
+        auto itRows = rowsByFather.find(father_id);
+        if (rowsByFather.end() == itRows) return;
+        std::vector<NodeRow> rows = std::move(itRows->second);
+        rowsByFather.erase(itRows);
+        gint64 sequence{0};
+        for (NodeRow& row : rows) {
+            if (not row.has_props) {
+                throw std::runtime_error(std::string("CtDocSqliteStorage: missing node properties for id ") + std::to_string(row.master_id > 0 ? row.master_id : row.node_id));
+            }
+            CtNodeData& nodeData = row.nodeData;
+            nodeData.nodeId = row.node_id;
+            nodeData.sharedNodesMasterId = row.master_id;
+            nodeData.sequence = ++sequence;
+            Gtk::TreeModel::iterator new_iter;
+            if (not _isDryRun) {
+                new_iter = _pCtMainWin->get_tree_store().append_node(&nodeData, &parent_iter);
+            }
+            f_children_from_rows(row.node_id, new_iter);
+        }
+    };
+    f_children_from_rows(0/*father_id*/, Gtk::TreeModel::iterator{});
+    return true;
+}
+
+sqlite3_stmt* CtStorageSqlite::_get_cached_stmt(const char* sql) const
+{
+    return _uReadStmts ? _uReadStmts->get(sql) : nullptr;
+}
+
 Glib::RefPtr<Gtk::TextBuffer> CtStorageSqlite::get_delayed_text_buffer(const gint64 node_id,
                                                                        const std::string& syntax,
-                                                                       std::list<CtAnchoredWidget*>& widgets) const
+                                                                       std::list<CtAnchoredWidget*>& widgets,
+                                                                       const CtPrefetchedBody* pPrefetchedBody) const
 {
-    Sqlite3StmtAuto stmt{_pDb, "SELECT txt, has_codebox, has_table, has_image FROM node WHERE node_id=?"};
+    if (pPrefetchedBody) {
+        if (auto rRetTextBuffer = CtStorageXmlHelper{_pCtMainWin}.create_buffer_from_prefetched(node_id, *pPrefetchedBody)) {
+            return rRetTextBuffer;
+        }
+    }
+    Sqlite3StmtCached stmt{_get_cached_stmt("SELECT txt, has_codebox, has_table, has_image FROM node WHERE node_id=?")};
     if (stmt.is_bad()) {
         spdlog::error("{}: {}", ERR_SQLITE_PREPV2, sqlite3_errmsg(_pDb));
         return Glib::RefPtr<Gtk::TextBuffer>{};
@@ -503,15 +797,28 @@ Glib::RefPtr<Gtk::TextBuffer> CtStorageSqlite::get_delayed_text_buffer(const gin
     }
 
     Glib::RefPtr<Gtk::TextBuffer> rRetTextBuffer;
-    const char* textContent = safe_sqlite3_column_text(stmt, 0);
     if (CtConst::RICH_TEXT_ID != syntax) {
-        rRetTextBuffer = _pCtMainWin->get_new_text_buffer(textContent);
+        rRetTextBuffer = _pCtMainWin->get_new_text_buffer(safe_sqlite3_column_text(stmt, 0));
     }
     else {
-        rRetTextBuffer = CtStorageXmlHelper{_pCtMainWin}.create_buffer_no_widgets(syntax, textContent);
-        if (not rRetTextBuffer) {
-            spdlog::error("!! xml read: {}", textContent);
-            return rRetTextBuffer;
+        // the type is read before any conversion of the value
+        const bool isBlob = SQLITE_BLOB == sqlite3_column_type(stmt, 0);
+        const auto pBlob = isBlob ? static_cast<const char*>(sqlite3_column_blob(stmt, 0)) : nullptr;
+        const int blobSize = isBlob ? sqlite3_column_bytes(stmt, 0) : 0;
+        if (CtRichTextBin::is_bin(pBlob, blobSize)) {
+            rRetTextBuffer = CtRichTextBin::create_buffer(_pCtMainWin, std::string_view{pBlob, static_cast<size_t>(blobSize)});
+            if (not rRetTextBuffer) {
+                spdlog::error("!! rich text bin read node {}", node_id);
+                return rRetTextBuffer;
+            }
+        }
+        else {
+            const char* textContent = safe_sqlite3_column_text(stmt, 0);
+            rRetTextBuffer = CtStorageXmlHelper{_pCtMainWin}.create_buffer_no_widgets(syntax, textContent);
+            if (not rRetTextBuffer) {
+                spdlog::error("!! xml read: {}", textContent);
+                return rRetTextBuffer;
+            }
         }
         if (sqlite3_column_int64(stmt, 1)) _codebox_from_db(node_id, widgets);
         if (sqlite3_column_int64(stmt, 2)) _table_from_db(node_id, widgets);
@@ -531,9 +838,61 @@ Glib::RefPtr<Gtk::TextBuffer> CtStorageSqlite::get_delayed_text_buffer(const gin
     return rRetTextBuffer;
 }
 
+bool CtStorageSqlite::release_text_buffer(const gint64/*node_id*/)
+{
+    // the node row is read again on the next get_delayed_text_buffer()
+    return nullptr != _pDb;
+}
+
+CtPrefetchedBodyReader CtStorageSqlite::get_body_reader(const gint64 node_id, const bool isRichText) const
+{
+    const char* dbFilepath = _pDb ? sqlite3_db_filename(_pDb, "main") : nullptr;
+    if (not dbFilepath or '\0' == *dbFilepath) {
+        return CtPrefetchedBodyReader{};
+    }
+    // a connection of its own, the one of the main thread may be closed or reopened meanwhile
+    return [dbFilepath = std::string{dbFilepath}, node_id, isRichText](CtPrefetchedBody& body) {
+        sqlite3* pDb{nullptr};
+        sqlite3_stmt* pStmt{nullptr};
+        auto on_scope_exit = scope_guard([&](void*) {
+            sqlite3_finalize(pStmt);
+            sqlite3_close(pDb);
+        });
+        if (SQLITE_OK != sqlite3_open_v2(dbFilepath.c_str(), &pDb, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, nullptr) or
+            SQLITE_OK != sqlite3_prepare_v2(pDb, "SELECT txt, has_codebox, has_table, has_image FROM node WHERE node_id=?", -1, &pStmt, nullptr))
+        {
+            return false;
+        }
+        sqlite3_bind_int64(pStmt, 1, node_id);
+        if (SQLITE_ROW != sqlite3_step(pStmt)) {
+            return false;
+        }
+        if (sqlite3_column_int64(pStmt, 1) or sqlite3_column_int64(pStmt, 2) or sqlite3_column_int64(pStmt, 3)) {
+            return false; // the anchored widgets are built on the main thread
+        }
+        body.isRichText = isRichText;
+        if (not isRichText) {
+            body.data = safe_sqlite3_column_text(pStmt, 0);
+            return true;
+        }
+        // the type is read before any conversion of the value
+        if (SQLITE_BLOB == sqlite3_column_type(pStmt, 0)) {
+            const auto pBlob = static_cast<const char*>(sqlite3_column_blob(pStmt, 0));
+            const int blobSize = sqlite3_column_bytes(pStmt, 0);
+            if (not CtRichTextBin::is_bin(pBlob, blobSize)) {
+                return false;
+            }
+            body.data.assign(pBlob, static_cast<size_t>(blobSize));
+            return true;
+        }
+        body.data = CtRichTextBin::from_xml(safe_sqlite3_column_text(pStmt, 0));
+        return true;
+    };
+}
+
 void CtStorageSqlite::_image_from_db(const gint64& nodeId, std::list<CtAnchoredWidget*>& anchoredWidgets) const
 {
-    Sqlite3StmtAuto stmt{_pDb, "SELECT * FROM image WHERE node_id=? ORDER BY offset ASC"};
+    Sqlite3StmtCached stmt{_get_cached_stmt("SELECT * FROM image WHERE node_id=? ORDER BY offset ASC")};
     if (stmt.is_bad()) {
         spdlog::error("{}: {}", ERR_SQLITE_PREPV2, sqlite3_errmsg(_pDb));
         return;
@@ -591,7 +950,7 @@ void CtStorageSqlite::_image_from_db(const gint64& nodeId, std::list<CtAnchoredW
 
 void CtStorageSqlite::_codebox_from_db(const gint64& nodeId ,std::list<CtAnchoredWidget*>& anchoredWidgets) const
 {
-    Sqlite3StmtAuto stmt{_pDb, "SELECT * FROM codebox WHERE node_id=? ORDER BY offset ASC"};
+    Sqlite3StmtCached stmt{_get_cached_stmt("SELECT * FROM codebox WHERE node_id=? ORDER BY offset ASC")};
     if (stmt.is_bad()) {
         spdlog::error("{}: {}", ERR_SQLITE_PREPV2, sqlite3_errmsg(_pDb));
         return;
@@ -626,7 +985,7 @@ void CtStorageSqlite::_codebox_from_db(const gint64& nodeId ,std::list<CtAnchore
 
 void CtStorageSqlite::_table_from_db(const gint64& nodeId, std::list<CtAnchoredWidget*>& anchoredWidgets) const
 {
-    Sqlite3StmtAuto stmt{_pDb, "SELECT * FROM grid WHERE node_id=? ORDER BY offset ASC"};
+    Sqlite3StmtCached stmt{_get_cached_stmt("SELECT * FROM grid WHERE node_id=? ORDER BY offset ASC")};
     if (stmt.is_bad()) {
         spdlog::error("{}: {}", ERR_SQLITE_PREPV2, sqlite3_errmsg(_pDb));
         return;
@@ -676,8 +1035,8 @@ void CtStorageSqlite::_write_bookmarks_to_db(const std::list<gint64>& bookmarks)
 {
     _exec_no_callback(TABLE_BOOKMARK_DELETE);
 
-    Sqlite3StmtAuto stmt{_pDb, TABLE_BOOKMARK_INSERT};
-    if (stmt.is_bad())
+    sqlite3_stmt* stmt = _uWriteStmts->get(TABLE_BOOKMARK_INSERT);
+    if (not stmt)
         throw std::runtime_error(ERR_SQLITE_PREPV2 + sqlite3_errmsg(_pDb));
 
     gint64 sequence{0};
@@ -701,7 +1060,32 @@ void CtStorageSqlite::_write_node_to_db(const CtTreeIter* ct_tree_iter,
                                         const CtExporting export_type,
                                         const std::map<gint64, gint64>* pExpoMasterReassign)
 {
-    const gint64 node_id = ct_tree_iter->get_node_id();
+    const NodeRow nodeRow = _node_row_from_tree_iter(ct_tree_iter,
+                                                     sequence,
+                                                     node_father_id,
+                                                     node_state,
+                                                     start_offset,
+                                                     end_offset,
+                                                     export_type,
+                                                     pExpoMasterReassign);
+    _write_node_row_to_db(nodeRow);
+    _write_node_widgets_to_db(_uWriteStmts.get(), ct_tree_iter, nodeRow, start_offset, end_offset, storage_cache);
+}
+
+CtStorageSqlite::NodeRow CtStorageSqlite::_node_row_from_tree_iter(const CtTreeIter* ct_tree_iter,
+                                                                   const gint64 sequence,
+                                                                   const gint64 node_father_id,
+                                                                   const CtStorageNodeState& node_state,
+                                                                   const int start_offset,
+                                                                   const int end_offset,
+                                                                   const CtExporting export_type,
+                                                                   const std::map<gint64, gint64>* pExpoMasterReassign)
+{
+    NodeRow nodeRow;
+    nodeRow.node_id = ct_tree_iter->get_node_id();
+    nodeRow.father_id = node_father_id;
+    nodeRow.sequence = sequence;
+    nodeRow.node_state = node_state;
     gint64 master_id = ct_tree_iter->get_node_shared_master_id();
     if (CtExporting::SELECTED_TEXT == export_type or
         CtExporting::CURRENT_NODE == export_type)
@@ -714,7 +1098,7 @@ void CtStorageSqlite::_write_node_to_db(const CtTreeIter* ct_tree_iter,
     else if (CtExporting::CURRENT_NODE_AND_SUBNODES == export_type) {
         if (master_id > 0 and pExpoMasterReassign and 0u != pExpoMasterReassign->count(master_id)) {
             const gint64 reassigned_master_id = pExpoMasterReassign->at(master_id);
-            if (reassigned_master_id != node_id) {
+            if (reassigned_master_id != nodeRow.node_id) {
                 master_id = reassigned_master_id;
             }
             else {
@@ -723,159 +1107,174 @@ void CtStorageSqlite::_write_node_to_db(const CtTreeIter* ct_tree_iter,
             }
         }
     }
-
-    // write hier
-    if (node_state.hier) {
-        if (node_state.is_update_of_existing) {
-            // clear old hierarchy
-            _exec_bind_int64(TABLE_CHILDREN_DELETE, node_id);
-        }
-        Sqlite3StmtAuto stmt{_pDb, TABLE_CHILDREN_INSERT};
-        if (stmt.is_bad()) {
-            throw std::runtime_error(ERR_SQLITE_PREPV2 + sqlite3_errmsg(_pDb));
-        }
-        sqlite3_bind_int64(stmt, 1, node_id);
-        sqlite3_bind_int64(stmt, 2, node_father_id);
-        sqlite3_bind_int64(stmt, 3, sequence);
-        sqlite3_bind_int64(stmt, 4, master_id);
-        if (sqlite3_step(stmt) != SQLITE_DONE) {
-            throw std::runtime_error(ERR_SQLITE_STEP + sqlite3_errmsg(_pDb));
-        }
-    }
-
+    nodeRow.master_id = master_id;
     if (master_id > 0) {
         // shared non master nodes do not have a node row
-        return;
+        return nodeRow;
     }
 
     /* is_ro is bitfield [ custom_icon_id | is_readonly ] */
-    gint64 is_ro = ct_tree_iter->get_node_read_only();
-    is_ro |= (ct_tree_iter->get_node_custom_icon_id() << 1);
+    nodeRow.is_ro = ct_tree_iter->get_node_read_only();
+    nodeRow.is_ro |= (ct_tree_iter->get_node_custom_icon_id() << 1);
     /* is_richtxt is bitfield [ foreground_rgb24 | foreground_set | is_bold | is_rich ] */
-    gint64 is_richtxt = ct_tree_iter->get_node_is_rich_text();
+    nodeRow.is_richtxt = ct_tree_iter->get_node_is_rich_text();
     if (ct_tree_iter->get_node_is_bold()) {
-        is_richtxt |= 0x02;
+        nodeRow.is_richtxt |= 0x02;
     }
     if (not ct_tree_iter->get_node_foreground().empty()) {
-        is_richtxt |= 0x04;
-        is_richtxt |= CtRgbUtil::get_rgb24int_from_str_any(ct_tree_iter->get_node_foreground().c_str()+1) << 3;
+        nodeRow.is_richtxt |= 0x04;
+        nodeRow.is_richtxt |= CtRgbUtil::get_rgb24int_from_str_any(ct_tree_iter->get_node_foreground().c_str()+1) << 3;
     }
     /* level is bitfield [ ... | exclude_child_from_search | exclude_me_from_search ] */
-    gint64 exclude_from_search = ct_tree_iter->get_node_is_excluded_from_search();
+    nodeRow.level = ct_tree_iter->get_node_is_excluded_from_search();
     if (ct_tree_iter->get_node_children_are_excluded_from_search()) {
-        exclude_from_search |= 0x02;
+        nodeRow.level |= 0x02;
     }
+    nodeRow.name = ct_tree_iter->get_node_name();
+    nodeRow.syntax = ct_tree_iter->get_node_syntax_highlighting();
+    nodeRow.tags = ct_tree_iter->get_node_tags();
+    nodeRow.ts_creation = ct_tree_iter->get_node_creating_time();
+    nodeRow.ts_lastsave = ct_tree_iter->get_node_modification_time();
 
-    // write widgets
-    bool has_codebox{false};
-    bool has_table{false};
-    bool has_image{false};
     if (node_state.buff) {
-        if (node_state.is_update_of_existing and ((is_richtxt & 0x01) or node_state.prop)) {
-            // if it's a rich text or has property changed (maybe was a rich text) clear old widgets
-            _exec_bind_int64(TABLE_CODEBOX_DELETE, node_id);
-            _exec_bind_int64(TABLE_TABLE_DELETE, node_id);
-            _exec_bind_int64(TABLE_IMAGE_DELETE, node_id);
-        }
-        if (is_richtxt & 0x01) {
+        if (nodeRow.is_richtxt & 0x01) {
             for (CtAnchoredWidget* pAnchoredWidget : ct_tree_iter->get_anchored_widgets(start_offset, end_offset)) {
-                if (not pAnchoredWidget->to_sqlite(_pDb, node_id, start_offset >= 0 ? -start_offset : 0, storage_cache))
-                    throw std::runtime_error("couldn't save widget");
                 switch (pAnchoredWidget->get_type()) {
-                    case CtAnchWidgType::CodeBox: has_codebox = true; break;
+                    case CtAnchWidgType::CodeBox: nodeRow.has_codebox = true; break;
                     case CtAnchWidgType::TableLight: [[fallthrough]];
-                    case CtAnchWidgType::TableHeavy: has_table = true; break;
-                    default: has_image = true;
+                    case CtAnchWidgType::TableHeavy: nodeRow.has_table = true; break;
+                    default: nodeRow.has_image = true;
                 }
             }
+            if (_pCtMainWin->get_ct_config()->sqliteRichTextBin) {
+                nodeRow.txt = CtRichTextBin::from_buffer(_pCtMainWin->get_ct_config(),
+                    ct_tree_iter->get_node_text_buffer(), start_offset, end_offset);
+                nodeRow.txt_is_bin = true;
+            }
+            else {
+                xmlpp::Document xml_doc;
+                xml_doc.create_root_node("node");
+                CtStorageXmlHelper{_pCtMainWin}.save_buffer_no_widgets_to_xml(xml_doc.get_root_node(),
+                    ct_tree_iter->get_node_text_buffer(), start_offset, end_offset, 'n');
+                nodeRow.txt = xml_doc.write_to_string();
+            }
+        }
+        else {
+            const auto text_buffer = ct_tree_iter->get_node_text_buffer();
+            if (end_offset < 0) {
+                nodeRow.txt = text_buffer->get_text();
+            }
+            else {
+                nodeRow.txt = text_buffer->get_iter_at_offset(start_offset).get_text(text_buffer->get_iter_at_offset(end_offset));
+            }
         }
     }
+    return nodeRow;
+}
+
+/*static*/void CtStorageSqlite::_bind_node_txt(sqlite3_stmt* stmt, const int idx, const NodeRow& nodeRow)
+{
+    if (nodeRow.txt_is_bin) {
+        sqlite3_bind_blob(stmt, idx, nodeRow.txt.c_str(), nodeRow.txt.size(), SQLITE_STATIC);
+    }
+    else {
+        sqlite3_bind_text(stmt, idx, nodeRow.txt.c_str(), nodeRow.txt.size(), SQLITE_STATIC);
+    }
+}
+
+void CtStorageSqlite::_write_node_row_to_db(const NodeRow& nodeRow)
+{
+    const CtStorageNodeState& node_state = nodeRow.node_state;
+    // write hier
+    if (node_state.hier) {
+        if (node_state.is_update_of_existing) {
+            // clear old hierarchy
+            _exec_bind_int64(TABLE_CHILDREN_DELETE, nodeRow.node_id);
+        }
+        sqlite3_stmt* stmt = _uWriteStmts->get(TABLE_CHILDREN_INSERT);
+        if (not stmt) {
+            throw std::runtime_error(ERR_SQLITE_PREPV2 + sqlite3_errmsg(_pDb));
+        }
+        sqlite3_bind_int64(stmt, 1, nodeRow.node_id);
+        sqlite3_bind_int64(stmt, 2, nodeRow.father_id);
+        sqlite3_bind_int64(stmt, 3, nodeRow.sequence);
+        sqlite3_bind_int64(stmt, 4, nodeRow.master_id);
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            throw std::runtime_error(ERR_SQLITE_STEP + sqlite3_errmsg(_pDb));
+        }
+    }
+
+    if (nodeRow.master_id > 0) {
+        // shared non master nodes do not have a node row
+        return;
+    }
+
+    if (node_state.buff and node_state.is_update_of_existing and ((nodeRow.is_richtxt & 0x01) or node_state.prop)) {
+        // if it's a rich text or has property changed (maybe was a rich text) clear old widgets
+        _exec_bind_int64(TABLE_CODEBOX_DELETE, nodeRow.node_id);
+        _exec_bind_int64(TABLE_TABLE_DELETE, nodeRow.node_id);
+        _exec_bind_int64(TABLE_IMAGE_DELETE, nodeRow.node_id);
+    }
 
     // if only node prop to write / no buffer
     if (node_state.prop and not node_state.buff) {
-        Sqlite3StmtAuto stmt{_pDb, "UPDATE node SET name=?, syntax=?, tags=?, is_ro=?, is_richtxt=?, level=? WHERE node_id=?"};
-        if (stmt.is_bad()) {
+        sqlite3_stmt* stmt = _uWriteStmts->get("UPDATE node SET name=?, syntax=?, tags=?, is_ro=?, is_richtxt=?, level=? WHERE node_id=?");
+        if (not stmt) {
             throw std::runtime_error(ERR_SQLITE_PREPV2 + sqlite3_errmsg(_pDb));
         }
-        const std::string node_name = ct_tree_iter->get_node_name();
-        const std::string node_syntax = ct_tree_iter->get_node_syntax_highlighting();
-        const std::string node_tags = ct_tree_iter->get_node_tags();
-        sqlite3_bind_text(stmt, 1, node_name.c_str(), node_name.size(), SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 2, node_syntax.c_str(), node_syntax.size(), SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 3, node_tags.c_str(), node_tags.size(), SQLITE_STATIC);
-        sqlite3_bind_int64(stmt, 4, is_ro);
-        sqlite3_bind_int64(stmt, 5, is_richtxt);
-        sqlite3_bind_int64(stmt, 6, exclude_from_search);
-        sqlite3_bind_int64(stmt, 7, node_id);
+        sqlite3_bind_text(stmt, 1, nodeRow.name.c_str(), nodeRow.name.size(), SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, nodeRow.syntax.c_str(), nodeRow.syntax.size(), SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 3, nodeRow.tags.c_str(), nodeRow.tags.size(), SQLITE_STATIC);
+        sqlite3_bind_int64(stmt, 4, nodeRow.is_ro);
+        sqlite3_bind_int64(stmt, 5, nodeRow.is_richtxt);
+        sqlite3_bind_int64(stmt, 6, nodeRow.level);
+        sqlite3_bind_int64(stmt, 7, nodeRow.node_id);
         if (sqlite3_step(stmt) != SQLITE_DONE) {
             throw std::runtime_error(ERR_SQLITE_STEP + sqlite3_errmsg(_pDb));
         }
     }
     // write node buffer (with or without node prop)
     else if (node_state.buff) {
-        // get buffer content
-        std::string node_txt;
-        if (is_richtxt & 0x01) {
-            xmlpp::Document xml_doc;
-            xml_doc.create_root_node("node");
-            CtStorageXmlHelper{_pCtMainWin}.save_buffer_no_widgets_to_xml(xml_doc.get_root_node(),
-                ct_tree_iter->get_node_text_buffer(), start_offset, end_offset, 'n');
-            node_txt = xml_doc.write_to_string();
-        }
-        else {
-            const auto text_buffer = ct_tree_iter->get_node_text_buffer();
-            if (end_offset < 0) {
-                node_txt = text_buffer->get_text();
-            }
-            else {
-                node_txt = text_buffer->get_iter_at_offset(start_offset).get_text(text_buffer->get_iter_at_offset(end_offset));
-            }
-        }
-
         // full node rewrite (buf + prop)
         if (node_state.prop) {
             if (node_state.is_update_of_existing) {
-                _exec_bind_int64(TABLE_NODE_DELETE, node_id);
+                _exec_bind_int64(TABLE_NODE_DELETE, nodeRow.node_id);
             }
-            Sqlite3StmtAuto stmt{_pDb, TABLE_NODE_INSERT};
-            if (stmt.is_bad()) {
+            sqlite3_stmt* stmt = _uWriteStmts->get(TABLE_NODE_INSERT);
+            if (not stmt) {
                 throw std::runtime_error(ERR_SQLITE_PREPV2 + sqlite3_errmsg(_pDb));
             }
-            const std::string node_name = ct_tree_iter->get_node_name();
-            const std::string node_syntax = ct_tree_iter->get_node_syntax_highlighting();
-            const std::string node_tags = ct_tree_iter->get_node_tags();
-            sqlite3_bind_int64(stmt, 1, node_id);
-            sqlite3_bind_text(stmt, 2, node_name.c_str(), node_name.size(), SQLITE_STATIC);
-            sqlite3_bind_text(stmt, 3, node_txt.c_str(), node_txt.size(), SQLITE_STATIC);
-            sqlite3_bind_text(stmt, 4, node_syntax.c_str(), node_syntax.size(), SQLITE_STATIC);
-            sqlite3_bind_text(stmt, 5, node_tags.c_str(), node_tags.size(), SQLITE_STATIC);
-            sqlite3_bind_int64(stmt, 6, is_ro);
-            sqlite3_bind_int64(stmt, 7, is_richtxt);
-            sqlite3_bind_int64(stmt, 8, has_codebox);
-            sqlite3_bind_int64(stmt, 9, has_table);
-            sqlite3_bind_int64(stmt, 10, has_image);
-            sqlite3_bind_int64(stmt, 11, exclude_from_search);
-            sqlite3_bind_int64(stmt, 12, ct_tree_iter->get_node_creating_time());
-            sqlite3_bind_int64(stmt, 13, ct_tree_iter->get_node_modification_time());
+            sqlite3_bind_int64(stmt, 1, nodeRow.node_id);
+            sqlite3_bind_text(stmt, 2, nodeRow.name.c_str(), nodeRow.name.size(), SQLITE_STATIC);
+            _bind_node_txt(stmt, 3, nodeRow);
+            sqlite3_bind_text(stmt, 4, nodeRow.syntax.c_str(), nodeRow.syntax.size(), SQLITE_STATIC);
+            sqlite3_bind_text(stmt, 5, nodeRow.tags.c_str(), nodeRow.tags.size(), SQLITE_STATIC);
+            sqlite3_bind_int64(stmt, 6, nodeRow.is_ro);
+            sqlite3_bind_int64(stmt, 7, nodeRow.is_richtxt);
+            sqlite3_bind_int64(stmt, 8, nodeRow.has_codebox);
+            sqlite3_bind_int64(stmt, 9, nodeRow.has_table);
+            sqlite3_bind_int64(stmt, 10, nodeRow.has_image);
+            sqlite3_bind_int64(stmt, 11, nodeRow.level);
+            sqlite3_bind_int64(stmt, 12, nodeRow.ts_creation);
+            sqlite3_bind_int64(stmt, 13, nodeRow.ts_lastsave);
             if (sqlite3_step(stmt) != SQLITE_DONE) {
                 throw std::runtime_error(ERR_SQLITE_STEP + sqlite3_errmsg(_pDb));
             }
         }
         // only node buff rewrite
         else {
-            Sqlite3StmtAuto stmt{_pDb, "UPDATE node SET txt=?, syntax=?, is_richtxt=?, has_codebox=?, has_table=?, has_image=?, ts_lastsave=? WHERE node_id=?"};
-            if (stmt.is_bad()) {
+            sqlite3_stmt* stmt = _uWriteStmts->get("UPDATE node SET txt=?, syntax=?, is_richtxt=?, has_codebox=?, has_table=?, has_image=?, ts_lastsave=? WHERE node_id=?");
+            if (not stmt) {
                 throw std::runtime_error(ERR_SQLITE_PREPV2 + sqlite3_errmsg(_pDb));
             }
-            const std::string node_syntax = ct_tree_iter->get_node_syntax_highlighting();
-            sqlite3_bind_text(stmt, 1, node_txt.c_str(), node_txt.size(), SQLITE_STATIC);
-            sqlite3_bind_text(stmt, 2, node_syntax.c_str(), node_syntax.size(), SQLITE_STATIC);
-            sqlite3_bind_int64(stmt, 3, is_richtxt);
-            sqlite3_bind_int64(stmt, 4, has_codebox);
-            sqlite3_bind_int64(stmt, 5, has_table);
-            sqlite3_bind_int64(stmt, 6, has_image);
-            sqlite3_bind_int64(stmt, 7, ct_tree_iter->get_node_modification_time());
-            sqlite3_bind_int64(stmt, 8, node_id);
+            _bind_node_txt(stmt, 1, nodeRow);
+            sqlite3_bind_text(stmt, 2, nodeRow.syntax.c_str(), nodeRow.syntax.size(), SQLITE_STATIC);
+            sqlite3_bind_int64(stmt, 3, nodeRow.is_richtxt);
+            sqlite3_bind_int64(stmt, 4, nodeRow.has_codebox);
+            sqlite3_bind_int64(stmt, 5, nodeRow.has_table);
+            sqlite3_bind_int64(stmt, 6, nodeRow.has_image);
+            sqlite3_bind_int64(stmt, 7, nodeRow.ts_lastsave);
+            sqlite3_bind_int64(stmt, 8, nodeRow.node_id);
             if (sqlite3_step(stmt) != SQLITE_DONE) {
                 throw std::runtime_error(ERR_SQLITE_STEP + sqlite3_errmsg(_pDb));
             }
@@ -883,6 +1282,22 @@ void CtStorageSqlite::_write_node_to_db(const CtTreeIter* ct_tree_iter,
     }
 }
 
+void CtStorageSqlite::_write_node_widgets_to_db(CtSqliteStmtCache* pStmtCache,
+                                                const CtTreeIter* ct_tree_iter,
+                                                const NodeRow& nodeRow,
+                                                const int start_offset,
+                                                const int end_offset,
+                                                CtStorageCache* storage_cache)
+{
+    if (nodeRow.master_id > 0 or not nodeRow.node_state.buff or not (nodeRow.is_richtxt & 0x01)) {
+        return;
+    }
+    for (CtAnchoredWidget* pAnchoredWidget : ct_tree_iter->get_anchored_widgets(start_offset, end_offset)) {
+        if (not pAnchoredWidget->to_sqlite(pStmtCache, nodeRow.node_id, start_offset >= 0 ? -start_offset : 0, storage_cache))
+            throw std::runtime_error("couldn't save widget");
+    }
+}
+
 std::list<std::pair<gint64,gint64>> CtStorageSqlite::_get_children_node_ids_from_db(const gint64 father_id)
 {
     auto uStmt = std::make_unique<Sqlite3StmtAuto>(_pDb, "SELECT node_id, master_id FROM children WHERE father_id=? ORDER BY sequence ASC");
@@ -903,14 +1318,54 @@ std::list<std::pair<gint64,gint64>> CtStorageSqlite::_get_children_node_ids_from
 
 void CtStorageSqlite::_remove_db_node_with_children(const gint64 node_id)
 {
-    _exec_bind_int64(TABLE_CODEBOX_DELETE, node_id);
-    _exec_bind_int64(TABLE_TABLE_DELETE, node_id);
-    _exec_bind_int64(TABLE_IMAGE_DELETE, node_id);
-    _exec_bind_int64(TABLE_NODE_DELETE, node_id);
-    _exec_bind_int64(TABLE_CHILDREN_DELETE, node_id);
+    std::vector<gint64> node_ids;
+    {
+        sqlite3_stmt* stmt = _uWriteStmts->get("WITH RECURSIVE subtree(node_id) AS ("
+                                                 "SELECT ? UNION SELECT children.node_id FROM children JOIN subtree ON children.father_id=subtree.node_id"
+                                               ") SELECT node_id FROM subtree");
+        if (not stmt) {
+            throw std::runtime_error(ERR_SQLITE_PREPV2 + sqlite3_errmsg(_pDb));
+        }
+        sqlite3_bind_int64(stmt, 1, node_id);
+        int rc;
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+            node_ids.push_back(sqlite3_column_int64(stmt, 0));
+        }
+        if (rc != SQLITE_DONE) {
+            throw std::runtime_error(ERR_SQLITE_STEP + sqlite3_errmsg(_pDb));
+        }
+    }
 
-    for (const std::pair<gint64,gint64>& child_id_pair : _get_children_node_ids_from_db(node_id)) {
-        _remove_db_node_with_children(child_id_pair.first);
+    // children last, it is what the subtree was collected from
+    constexpr size_t MaxIdsPerDelete{256};
+    for (const char* tableName : {"codebox", "grid", "image", "node", "children"}) {
+        for (size_t first = 0; first < node_ids.size(); first += MaxIdsPerDelete) {
+            const size_t numIds = std::min(MaxIdsPerDelete, node_ids.size() - first);
+            std::string sqlDelete = std::string{"DELETE FROM "} + tableName + " WHERE node_id IN (?";
+            for (size_t i = 1; i < numIds; ++i) {
+                sqlDelete += ",?";
+            }
+            sqlDelete += ")";
+            // only the full chunks are worth keeping prepared
+            std::unique_ptr<Sqlite3StmtAuto> uStmtRemainder;
+            sqlite3_stmt* stmt{nullptr};
+            if (MaxIdsPerDelete == numIds) {
+                stmt = _uWriteStmts->get(sqlDelete.c_str());
+            }
+            else {
+                uStmtRemainder = std::make_unique<Sqlite3StmtAuto>(_pDb, sqlDelete.c_str());
+                stmt = *uStmtRemainder;
+            }
+            if (not stmt) {
+                throw std::runtime_error(ERR_SQLITE_PREPV2 + sqlite3_errmsg(_pDb));
+            }
+            for (size_t i = 0; i < numIds; ++i) {
+                sqlite3_bind_int64(stmt, static_cast<int>(i+1), node_ids[first+i]);
+            }
+            if (sqlite3_step(stmt) != SQLITE_DONE) {
+                throw std::runtime_error(ERR_SQLITE_STEP + sqlite3_errmsg(_pDb));
+            }
+        }
     }
 }
 
@@ -926,8 +1381,8 @@ void CtStorageSqlite::_exec_no_callback(const char* sqlCmd)
 
 void CtStorageSqlite::_exec_bind_int64(const char* sqlCmd, const gint64 bind_int64)
 {
-    Sqlite3StmtAuto stmt{_pDb, sqlCmd};
-    if (stmt.is_bad()) {
+    sqlite3_stmt* stmt = _uWriteStmts->get(sqlCmd);
+    if (not stmt) {
         throw std::runtime_error(ERR_SQLITE_PREPV2 + sqlite3_errmsg(_pDb));
     }
     sqlite3_bind_int64(stmt, 1, bind_int64);
@@ -936,6 +1391,64 @@ void CtStorageSqlite::_exec_bind_int64(const char* sqlCmd, const gint64 bind_int
     }
 }
 
+void CtStorageSqlite::search_index_load(CtSearchIndex& searchIndex)
+{
+    searchIndex.clear();
+    if (_isDryRun or not _pDb) return;
+    Sqlite3StmtAuto stmtExists{_pDb, "SELECT name FROM sqlite_master WHERE type='table' AND name='search_index'"};
+    if (stmtExists.is_bad()) {
+        throw std::runtime_error(ERR_SQLITE_PREPV2 + sqlite3_errmsg(_pDb));
+    }
+    if (sqlite3_step(stmtExists) != SQLITE_ROW) {
+        return; // document never indexed
+    }
+    Sqlite3StmtAuto stmt{_pDb, "SELECT node_id, ts_lastsave, bloom FROM search_index"};
+    if (stmt.is_bad()) {
+        throw std::runtime_error(ERR_SQLITE_PREPV2 + sqlite3_errmsg(_pDb));
+    }
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        CtSearchIndex::Entry entry;
+        entry.tsLastSave = sqlite3_column_int64(stmt, 1);
+        if (CtSearchIndex::bloom_from_blob(sqlite3_column_blob(stmt, 2), sqlite3_column_bytes(stmt, 2), entry.bloom)) {
+            searchIndex.set_entry(sqlite3_column_int64(stmt, 0), std::move(entry));
+        }
+    }
+    searchIndex.clear_dirty();
+}
+
+void CtStorageSqlite::search_index_save(const CtSearchIndex& searchIndex)
+{
+    if (not _pDb or (searchIndex.get_dirty_ids().empty() and searchIndex.get_removed_ids().empty())) return;
+    _exec_no_callback(TABLE_SEARCH_INDEX_CREATE);
+    _exec_no_callback("BEGIN TRANSACTION");
+    try {
+        for (const gint64 node_id : searchIndex.get_removed_ids()) {
+            _exec_bind_int64(TABLE_SEARCH_INDEX_DELETE, node_id);
+        }
+        sqlite3_stmt* stmt = _uWriteStmts->get(TABLE_SEARCH_INDEX_INSERT);
+        if (not stmt) {
+            throw std::runtime_error(ERR_SQLITE_PREPV2 + sqlite3_errmsg(_pDb));
+        }
+        for (const gint64 node_id : searchIndex.get_dirty_ids()) {
+            const CtSearchIndex::Entry* pEntry = searchIndex.get_entry(node_id);
+            if (not pEntry) continue;
+            const std::string blob = CtSearchIndex::bloom_to_blob(pEntry->bloom);
+            sqlite3_bind_int64(stmt, 1, node_id);
+            sqlite3_bind_int64(stmt, 2, pEntry->tsLastSave);
+            sqlite3_bind_blob(stmt, 3, blob.c_str(), blob.size(), SQLITE_STATIC);
+            if (sqlite3_step(stmt) != SQLITE_DONE) {
+                throw std::runtime_error(ERR_SQLITE_STEP + sqlite3_errmsg(_pDb));
+            }
+            sqlite3_reset(stmt);
+        }
+    }
+    catch (std::exception&) {
+        _exec_no_callback("ROLLBACK");
+        throw;
+    }
+    _exec_no_callback("COMMIT");
+}
+
 void CtStorageSqlite::import_nodes(const fs::path& path, const Gtk::TreeModel::iterator& parent_iter)
 {
     _open_db(path); // storage is temp so can just open db
@@ -30,6 +30,7 @@
 #include <glibmm/refptr.h>
 #include <gtkmm/textbuffer.h>
 #include <gtkmm/treeiter.h>
+#include <unordered_map>
 #include <unordered_set>
 
 class CtMainWin;
@@ -37,6 +38,34 @@ class CtAnchoredWidget;
 class CtTreeIter;
 class CtStorageCache;
 
+/**
+ * @brief Prepared statements of a database, compiled once and reused until the cache is destroyed
+ * Not thread safe, a thread using the database at the same time needs its own cache.
+ */
+class CtSqliteStmtCache
+{
+public:
+    CtSqliteStmtCache(sqlite3* pDb)
+     : _pDb{pDb}
+    {}
+    ~CtSqliteStmtCache() { clear(); }
+    CtSqliteStmtCache(const CtSqliteStmtCache&) = delete;
+    CtSqliteStmtCache& operator=(const CtSqliteStmtCache&) = delete;
+
+    /**
+     * @brief Get the statement reset and with no bindings, ready to be bound and stepped
+     * @return nullptr if the statement could not be prepared
+     */
+    sqlite3_stmt* get(const char* sql);
+    void clear();
+
+    sqlite3* get_db() const { return _pDb; }
+
+private:
+    sqlite3* const _pDb;
+    std::unordered_map<std::string, sqlite3_stmt*> _stmts;
+};
+
 class CtStorageSqlite : public CtStorageEntity
 {
 public:
@@ -58,16 +87,49 @@ public:
                         const std::map<gint64, gint64>* pExpoMasterReassign = nullptr,
                         const int start_offset = 0,
                         const int end_offset = -1) override;
+    std::unique_ptr<CtStorageWriter> save_treestore_snapshot(const fs::path& file_path,
+                                                            const CtStorageSyncPending& syncPending) override;
     void vacuum() override;
     void import_nodes(const fs::path& path, const Gtk::TreeModel::iterator& parent_iter) override;
 
     Glib::RefPtr<Gtk::TextBuffer> get_delayed_text_buffer(const gint64 node_id,
                                                           const std::string& syntax,
-                                                          std::list<CtAnchoredWidget*>& widgets) const override;
+                                                          std::list<CtAnchoredWidget*>& widgets,
+                                                          const CtPrefetchedBody* pPrefetchedBody) const override;
+    bool release_text_buffer(const gint64 node_id) override;
+    CtPrefetchedBodyReader get_body_reader(const gint64 node_id, const bool isRichText) const override;
 
     fs::path get_embedded_filepath(const CtTreeIter&/*ct_tree_iter*/, const std::string&/*filename*/) const override { return ""; }
 
+    void search_index_load(CtSearchIndex& searchIndex) override;
+    void search_index_save(const CtSearchIndex& searchIndex) override;
+
+    // the columns of a node to write, gathered from the tree store on the UI thread
+    struct NodeRow
+    {
+        gint64 node_id{0};
+        gint64 master_id{0};
+        gint64 father_id{0};
+        gint64 sequence{0};
+        CtStorageNodeState node_state;
+        std::string name;
+        std::string txt;
+        bool txt_is_bin{false}; // CtRichTextBin body, written as a blob
+        std::string syntax;
+        std::string tags;
+        gint64 is_ro{0};
+        gint64 is_richtxt{0};
+        bool has_codebox{false};
+        bool has_table{false};
+        bool has_image{false};
+        gint64 level{0};
+        gint64 ts_creation{0};
+        gint64 ts_lastsave{0};
+    };
+
 private:
+    friend class CtStorageSqliteWriter;
+
     void _open_db(const fs::path& path);
     void _close_db();
     bool _check_database_integrity();
@@ -77,6 +139,16 @@ private:
                                 const gint64 sequence,
                                 Gtk::TreeModel::iterator parent_iter,
                                 const gint64 new_id);
+    /**
+     * @brief Load the whole tree with a single ordered scan of children joined with node
+     * @return false if the database schema is too old for the bulk query
+     */
+    bool _nodes_from_db_bulk();
+    /**
+     * @brief Get a prepared statement kept alive until the database is closed
+     * @return nullptr if the statement could not be prepared
+     */
+    sqlite3_stmt* _get_cached_stmt(const char* sql) const;
 
     /**
      * @brief Check that the database contains the required tables
@@ -107,8 +179,30 @@ private:
                                           CtStorageCache* storage_cache,
                                           const CtExporting export_type,
                                           const std::map<gint64, gint64>* pExpoMasterReassign);
+    NodeRow             _node_row_from_tree_iter(const CtTreeIter* ct_tree_iter,
+                                                 const gint64 sequence,
+                                                 const gint64 node_father_id,
+                                                 const CtStorageNodeState& node_state,
+                                                 const int start_offset,
+                                                 const int end_offset,
+                                                 const CtExporting export_type,
+                                                 const std::map<gint64, gint64>* pExpoMasterReassign);
+    static void         _bind_node_txt(sqlite3_stmt* stmt, const int idx, const NodeRow& nodeRow);
+    /**
+     * @brief Write the children and node rows, clearing the old widgets, touches only the database
+     */
+    void                _write_node_row_to_db(const NodeRow& nodeRow);
+    void                _write_node_widgets_to_db(CtSqliteStmtCache* pStmtCache,
+                                                  const CtTreeIter* ct_tree_iter,
+                                                  const NodeRow& nodeRow,
+                                                  const int start_offset,
+                                                  const int end_offset,
+                                                  CtStorageCache* storage_cache);
 
     std::list<std::pair<gint64,gint64>> _get_children_node_ids_from_db(const gint64 father_id);
+    /**
+     * @brief Remove the node and all its descendants, collected with a single query and deleted in chunks
+     */
     void                _remove_db_node_with_children(const gint64 node_id);
 
     void                _exec_no_callback(const char* sqlCmd);
@@ -133,6 +227,9 @@ public:
     static const char TABLE_BOOKMARK_CREATE[];
     static const char TABLE_BOOKMARK_INSERT[];
     static const char TABLE_BOOKMARK_DELETE[];
+    static const char TABLE_SEARCH_INDEX_CREATE[];
+    static const char TABLE_SEARCH_INDEX_INSERT[];
+    static const char TABLE_SEARCH_INDEX_DELETE[];
     static const std::string ERR_SQLITE_PREPV2;
     static const std::string ERR_SQLITE_STEP;
     static const char* safe_sqlite3_column_text(sqlite3_stmt* stmt, int iCol);
@@ -141,4 +238,6 @@ private:
     CtMainWin*    _pCtMainWin;
     sqlite3*      _pDb{nullptr};
     fs::path      _file_path;
+    mutable std::unique_ptr<CtSqliteStmtCache> _uReadStmts;  // lazy node loading, UI thread
+    std::unique_ptr<CtSqliteStmtCache>         _uWriteStmts; // saves, also from the background writer
 };
@@ -26,13 +26,22 @@
 #include "ct_misc_utils.h"
 #include <libxml++/libxml++.h>
 #include <libxml2/libxml/parser.h>
+#include <libxml2/libxml/xmlreader.h>
+#include <climits>
+#include <cstring>
+#include <string_view>
 #include "ct_image.h"
 #include "ct_codebox.h"
 #include "ct_table.h"
 #include "ct_main_win.h"
 #include "ct_storage_control.h"
 #include "ct_storage_multifile.h"
+#include "ct_search_index.h"
+#include "ct_storage_prefetch.h"
+#include "ct_rich_text_bin.h"
+#include "ct_p7za_iface.h"
 #include "ct_logging.h"
+#include "ct_trace.h"
 
 // GtkSourceView 5 removed begin/end_not_undoable_action
 #if GTK_SOURCE_CHECK_VERSION(5, 0, 0)
@@ -45,9 +54,28 @@
 
 bool CtStorageXml::populate_treestore(const fs::path& file_path, Glib::ustring& error)
 {
+    CtTrace::Span ctTraceSpan{"populate_treestore"};
+    _delayed_text_buffers.clear();
+    _delayed_node_ids.clear();
+    _pDocLayout->clear();
+    std::shared_ptr<const std::string> pDocData;
+    pDocData.swap(_pDecryptedDoc);
+    try {
+        if (_populate_treestore_stream(file_path, pDocData)) {
+            _file_path = file_path;
+            return true;
+        }
+    }
+    catch (std::exception& e) {
+        spdlog::debug("{} {}", __FUNCTION__, e.what());
+    }
+    spdlog::debug("{} {} loading through the dom parser", __FUNCTION__, file_path.string());
     try {
         // open file
-        std::unique_ptr<xmlpp::DomParser> parser = CtStorageXml::get_parser(file_path);
+        bool isSanitised{false};
+        std::unique_ptr<xmlpp::DomParser> parser = pDocData ?
+            CtStorageXml::get_parser_memory(*pDocData, &isSanitised) : CtStorageXml::get_parser(file_path, &isSanitised);
+        _file_path = file_path;
 
         CtTreeStore& ct_tree_store = _pCtMainWin->get_tree_store();
 
@@ -64,6 +92,7 @@ bool CtStorageXml::populate_treestore(const fs::path& file_path, Glib::ustring&
         // load node tree
         std::list<CtTreeIter> nodes_with_duplicated_id;
         std::list<CtTreeIter> nodes_shared_non_master;
+        std::vector<gint64> node_ids_doc_order;
         std::function<void(xmlpp::Element*, const gint64, Gtk::TreeModel::iterator)> f_nodes_from_xml;
         f_nodes_from_xml = [&](xmlpp::Element* xml_element, const gint64 sequence, Gtk::TreeModel::iterator parent_iter) {
             bool has_duplicated_id{false};
@@ -85,6 +114,10 @@ bool CtStorageXml::populate_treestore(const fs::path& file_path, Glib::ustring&
             if (is_shared_non_master and not _isDryRun) {
                 nodes_shared_non_master.push_back(ct_tree_store.to_ct_tree_iter(new_iter));
             }
+            if (not _isDryRun) {
+                // the duplicated id is about to change, no range for the node under its new id
+                node_ids_doc_order.push_back(has_duplicated_id ? -1 : ct_tree_store.to_ct_tree_iter(new_iter).get_node_id());
+            }
             gint64 child_sequence{0};
             for (xmlpp::Node* xml_node : xml_element->get_children("node")) {
                 f_nodes_from_xml(static_cast<xmlpp::Element*>(xml_node), ++child_sequence, new_iter);
@@ -94,6 +127,10 @@ bool CtStorageXml::populate_treestore(const fs::path& file_path, Glib::ustring&
         for (xmlpp::Node* xml_node : parser->get_document()->get_root_node()->get_children("node")) {
             f_nodes_from_xml(static_cast<xmlpp::Element*>(xml_node), ++sequence, Gtk::TreeModel::iterator{});
         }
+        if (not _isDryRun and not isSanitised) {
+            // the bytes on disk are the ones parsed, they can be copied into the next save
+            _doc_layout_load(file_path, pDocData, node_ids_doc_order);
+        }
         // fix duplicated ids by allocating new ids
         // new ids can be allocated only after the whole tree is parsed
         for (CtTreeIter& ctTreeIter : nodes_with_duplicated_id) {
@@ -114,8 +151,263 @@ bool CtStorageXml::populate_treestore(const fs::path& file_path, Glib::ustring&
     }
 }
 
+// the bytes of a document, mapped from its file or decrypted in memory
+class CtXmlDocBytes
+{
+public:
+    CtXmlDocBytes(const fs::path& file_path, std::shared_ptr<const std::string> pDocData)
+     : _pDocData{std::move(pDocData)}
+    {
+        if (not _pDocData) {
+            GError* pError{nullptr};
+            _pMapped = g_mapped_file_new(file_path.c_str(), FALSE/*writable*/, &pError);
+            if (not _pMapped) {
+                spdlog::debug("{} {} {}", __FUNCTION__, file_path.string(), pError ? pError->message : "");
+                if (pError) g_error_free(pError);
+            }
+        }
+    }
+    ~CtXmlDocBytes() { release(); }
+    CtXmlDocBytes(const CtXmlDocBytes&) = delete;
+    CtXmlDocBytes& operator=(const CtXmlDocBytes&) = delete;
+
+    explicit operator bool() const { return _pDocData or _pMapped; }
+    const char* data() const { return _pDocData ? _pDocData->data() : (_pMapped ? g_mapped_file_get_contents(_pMapped) : nullptr); }
+    size_t size() const { return _pDocData ? _pDocData->size() : (_pMapped ? g_mapped_file_get_length(_pMapped) : 0u); }
+    void release()
+    {
+        if (_pMapped) {
+            g_mapped_file_unref(_pMapped);
+            _pMapped = nullptr;
+        }
+        _pDocData.reset();
+    }
+
+private:
+    std::shared_ptr<const std::string> _pDocData;
+    GMappedFile*                       _pMapped{nullptr};
+};
+
+namespace {
+
+// encrypt the document data into the archive, without a plain text copy on disk
+int doc_data_to_archive(const std::string& doc_data,
+                        const std::string& archived_file_name,
+                        const fs::path& archive_path,
+                        const Glib::ustring& password)
+{
+    (void)fs::remove(archive_path); // the archiver would add to an existing one
+    size_t readPos{0};
+    const int retVal = CtP7zaIface::p7za_archive_from_stream([&](char* pBuf, const size_t bufSize){
+        const size_t toRead = std::min(bufSize, doc_data.size() - readPos);
+        memcpy(pBuf, doc_data.data() + readPos, toRead);
+        readPos += toRead;
+        return toRead;
+    }, archived_file_name.c_str(), archive_path.c_str(), password.c_str());
+    if (0 != retVal) {
+        spdlog::debug("!! p7za_archive_from_stream {} retVal={}", archive_path.string(), retVal);
+    }
+    return retVal;
+}
+
+// the name of the document in the archive as when encrypted from a temporary file
+std::string get_archived_file_name(const fs::path& archive_path)
+{
+    return archive_path.stem() + CtConst::CTDOC_XML_NOENC;
+}
+
+// the value of an attribute of the current element of the reader
+Glib::ustring reader_attribute(xmlTextReaderPtr pReader, const char* attr_name)
+{
+    xmlChar* pValue = xmlTextReaderGetAttribute(pReader, reinterpret_cast<const xmlChar*>(attr_name));
+    if (not pValue) {
+        return Glib::ustring{};
+    }
+    Glib::ustring retVal{reinterpret_cast<const char*>(pValue)};
+    xmlFree(pValue);
+    return retVal;
+}
+
+// a well formed <node> element with the node own slots
+std::string node_xml_from_range(const char* pData, const CtXmlDocLayout::NodeRange& nodeRange)
+{
+    std::string nodeXml{pData + nodeRange.offset, static_cast<size_t>(nodeRange.length)};
+    if (not nodeRange.isStartTagOnly or nodeRange.hadChildren) {
+        nodeXml += "</node>";
+    }
+    return nodeXml;
+}
+
+} // namespace
+
+bool CtStorageXml::_populate_treestore_stream(const fs::path& file_path, std::shared_ptr<const std::string> pDocData)
+{
+    CtXmlDocBytes docBytes{file_path, pDocData};
+    if (not docBytes) {
+        return false;
+    }
+    CtTreeStore& ct_tree_store = _pCtMainWin->get_tree_store();
+    xmlTextReaderPtr pReader{nullptr};
+    std::vector<Gtk::TreeModel::iterator> top_level_iters;
+    bool success{false};
+    auto on_scope_exit = scope_guard([&](void*) {
+        if (pReader) xmlFreeTextReader(pReader);
+        if (not success) {
+            // roll back, the document is going to be loaded through the dom parser
+            for (Gtk::TreeModel::iterator& iter : top_level_iters) {
+                ct_tree_store.node_erase(iter);
+            }
+            _delayed_node_ids.clear();
+            _pDocLayout->clear();
+        }
+    });
+
+    // the byte ranges of the nodes first, the reader then meets the nodes in the same order
+    const char* pData = docBytes.data();
+    const size_t dataSize = docBytes.size();
+    std::vector<CtXmlDocLayout::NodeRange> nodeRanges;
+    if (not pData or not CtStorageXml::scan_node_ranges(pData, dataSize, nodeRanges)) {
+        return false;
+    }
+    if (dataSize <= static_cast<size_t>(INT_MAX)) {
+        pReader = xmlReaderForMemory(pData, static_cast<int>(dataSize), file_path.c_str(), nullptr/*encoding*/, XML_PARSE_HUGE);
+    }
+    else if (not pDocData) {
+        pReader = xmlReaderForFile(file_path.c_str(), nullptr/*encoding*/, XML_PARSE_HUGE);
+    }
+    if (not pReader) {
+        return false;
+    }
+    auto f_attribute = [&pReader](const char* attr_name){ return reader_attribute(pReader, attr_name); };
+
+    struct OpenNode
+    {
+        Gtk::TreeModel::iterator iter;
+        gint64 childSequence{0};
+    };
+    std::vector<OpenNode> openNodes;
+    gint64 topSequence{0};
+    size_t nodeIdx{0};
+    std::vector<gint64> bookmarks;
+    std::list<CtTreeIter> nodes_with_duplicated_id;
+    std::list<CtTreeIter> nodes_shared_non_master;
+    int readRet = xmlTextReaderRead(pReader);
+    while (1 == readRet) {
+        const int nodeType = xmlTextReaderNodeType(pReader);
+        const int depth = xmlTextReaderDepth(pReader);
+        const char* pName = reinterpret_cast<const char*>(xmlTextReaderConstName(pReader));
+        if (XML_READER_TYPE_ELEMENT == nodeType) {
+            if (0 == depth) {
+                if (0 != strcmp(pName, CtConst::APP_NAME)) {
+                    return false;
+                }
+            }
+            else if (0 == strcmp(pName, "node")) {
+                if (nodeIdx >= nodeRanges.size()) {
+                    return false;
+                }
+                const CtXmlDocLayout::NodeRange& nodeRange = nodeRanges[nodeIdx++];
+                const bool isEmptyElement = 1 == xmlTextReaderIsEmptyElement(pReader);
+                if (_isDryRun) {
+                    if (not isEmptyElement) openNodes.emplace_back();
+                    readRet = xmlTextReaderRead(pReader);
+                    continue;
+                }
+                CtNodeData node_data{};
+                node_data.nodeId = CtStrUtil::gint64_from_gstring(f_attribute("unique_id").c_str());
+                node_data.sequence = openNodes.empty() ? ++topSequence : ++openNodes.back().childSequence;
+                CtStorageXmlHelper::node_data_from_attributes(node_data, f_attribute);
+                const bool hasDuplicatedId = 0u != _delayed_node_ids.count(node_data.nodeId);
+                if (hasDuplicatedId) {
+                    spdlog::debug("node has duplicated id {}, will be fixed", node_data.nodeId);
+                    // the buffer now as the range is under the id of the first node
+                    node_data.pTextBuffer = _text_buffer_from_node_xml(node_xml_from_range(pData, nodeRange), node_data.syntax, node_data.anchoredWidgets);
+                    if (not node_data.pTextBuffer) {
+                        return false;
+                    }
+                }
+                else {
+                    // parsed from the file when the node is visited, as for sqlite
+                    _delayed_node_ids.insert(node_data.nodeId);
+                    _pDocLayout->nodeRanges[node_data.nodeId] = nodeRange;
+                }
+                const Gtk::TreeModel::iterator parent_iter = openNodes.empty() ? Gtk::TreeModel::iterator{} : openNodes.back().iter;
+                Gtk::TreeModel::iterator new_iter = ct_tree_store.append_node(&node_data, &parent_iter);
+                if (openNodes.empty()) {
+                    top_level_iters.push_back(new_iter);
+                }
+                if (hasDuplicatedId) {
+                    nodes_with_duplicated_id.push_back(ct_tree_store.to_ct_tree_iter(new_iter));
+                }
+                if (node_data.sharedNodesMasterId > 0) {
+                    nodes_shared_non_master.push_back(ct_tree_store.to_ct_tree_iter(new_iter));
+                }
+                if (not isEmptyElement) {
+                    openNodes.push_back(OpenNode{new_iter});
+                }
+            }
+            else if (1 == depth and 0 == strcmp(pName, "bookmarks")) {
+                bookmarks = CtStrUtil::gstring_split_to_int64(f_attribute("list").c_str(), ",");
+            }
+            else if (depth >= 2) {
+                // a slot of a node, skipped until the node text buffer is needed
+                readRet = xmlTextReaderNext(pReader);
+                continue;
+            }
+        }
+        else if (XML_READER_TYPE_END_ELEMENT == nodeType and 0 == strcmp(pName, "node")) {
+            if (openNodes.empty()) {
+                return false;
+            }
+            openNodes.pop_back();
+        }
+        readRet = xmlTextReaderRead(pReader);
+    }
+    if (0 != readRet or nodeIdx != nodeRanges.size() or not openNodes.empty()) {
+        return false;
+    }
+    if (_isDryRun) {
+        success = true;
+        return true;
+    }
+    // fix duplicated ids by allocating new ids
+    // new ids can be allocated only after the whole tree is parsed
+    for (CtTreeIter& ctTreeIter : nodes_with_duplicated_id) {
+        ctTreeIter.set_node_id(ct_tree_store.node_id_get());
+    }
+    // populate shared non master nodes now that the master nodes
+    // are in the tree
+    for (CtTreeIter& ctTreeIter : nodes_shared_non_master) {
+        CtNodeData nodeData{};
+        ct_tree_store.get_node_data(ctTreeIter, nodeData, false/*loadTextBuffer*/);
+        ct_tree_store.update_node_data(ctTreeIter, nodeData);
+    }
+    for (const gint64 nodeId : bookmarks) {
+        ct_tree_store.bookmarks_add(nodeId);
+    }
+    _pDocLayout->filePath = file_path;
+    _pDocLayout->fileSize = fs::file_size(file_path);
+    _pDocLayout->mtime = fs::getmtime(file_path);
+    _pDocLayout->pDocData = pDocData;
+    _pDocLayout->pDocBytes.reset();
+    success = true;
+    return true;
+}
+
+Glib::RefPtr<Gtk::TextBuffer> CtStorageXml::_text_buffer_from_node_xml(const std::string& node_xml,
+                                                                       const std::string& syntax,
+                                                                       std::list<CtAnchoredWidget*>& widgets) const
+{
+    xmlpp::DomParser parser;
+    parser.set_parser_options(xmlParserOption::XML_PARSE_HUGE);
+    if (not CtXmlHelper::safe_parse_memory(parser, node_xml)) {
+        return Glib::RefPtr<Gtk::TextBuffer>{};
+    }
+    return CtStorageXmlHelper{_pCtMainWin}.create_buffer_and_widgets_from_xml(parser.get_document()->get_root_node(), syntax, widgets, nullptr, -1, "");
+}
+
 bool CtStorageXml::save_treestore(const fs::path& file_path,
-                                  const CtStorageSyncPending&,
+                                  const CtStorageSyncPending& syncPending,
                                   Glib::ustring& error,
                                   const CtExporting export_type,
                                   const std::map<gint64, gint64>* pExpoMasterReassign/*= nullptr*/,
@@ -123,40 +415,544 @@ bool CtStorageXml::save_treestore(const fs::path& file_path,
                                   const int end_offset/*=-1*/)
 {
     try {
+        if (CtExporting::NONESAVE == export_type or CtExporting::NONESAVEAS == export_type) {
+            // the document itself rather than an export, only the changed nodes of a plain save are serialized
+            std::unique_ptr<CtStorageXmlSpliceWriter> pWriter = _doc_snapshot(file_path, CtExporting::NONESAVE == export_type ? &syncPending : nullptr);
+            pWriter->write([](const size_t){});
+            _file_path = file_path;
+            return true;
+        }
+
         xmlpp::Document xml_doc;
-        xml_doc.create_root_node(CtConst::APP_NAME);
+        _treestore_to_xml(xml_doc, export_type, pExpoMasterReassign, start_offset, end_offset);
 
-        if ( CtExporting::NONESAVE == export_type or
-             CtExporting::NONESAVEAS == export_type or
-             CtExporting::ALL_TREE == export_type )
-        {
-            // save bookmarks
-            xmlpp::Element* p_bookmarks_node = xml_doc.get_root_node()->add_child("bookmarks");
-            p_bookmarks_node->set_attribute("list", str::join_numbers(_pCtMainWin->get_tree_store().bookmarks_get(), ","));
+        // write file
+        if (_password.empty()) {
+            xml_doc.write_to_file_formatted(file_path.string());
+        }
+        else if (0 != doc_data_to_archive(xml_doc.write_to_string_formatted().raw(), get_archived_file_name(file_path), file_path, _password)) {
+            throw std::runtime_error(fmt::format("{} archive fail", file_path.string()));
+        }
+        _file_path = file_path;
+
+        return true;
+    }
+    catch (std::exception& e) {
+        error = e.what();
+        return false;
+    }
+}
+
+namespace {
+
+// libxml2 formatted output indentation, capped by its indent buffer of 60 chars
+std::string xml_indent(const int depth)
+{
+    return std::string(2u * static_cast<size_t>(std::min(depth, 30)), ' ');
+}
+
+std::string xml_node_dump(xmlpp::Document& xml_doc, xmlpp::Node* p_node, const int depth)
+{
+    xmlOutputBufferPtr pOutBuf = xmlAllocOutputBuffer(nullptr);
+    xmlNodeDumpOutput(pOutBuf, xml_doc.cobj(), p_node->cobj(), depth, 1/*format*/, "UTF-8");
+    (void)xmlOutputBufferFlush(pOutBuf);
+    std::string retStr{reinterpret_cast<const char*>(xmlOutputBufferGetContent(pOutBuf)), xmlOutputBufferGetSize(pOutBuf)};
+    (void)xmlOutputBufferClose(pOutBuf);
+    return retStr;
+}
+
+// as write_to_file_formatted() does, for the attributes not to be written as character references
+void xml_doc_set_utf8(xmlpp::Document& xml_doc)
+{
+    xmlDocPtr pDoc = xml_doc.cobj();
+    if (pDoc->encoding) xmlFree(const_cast<xmlChar*>(pDoc->encoding));
+    pDoc->encoding = xmlStrdup(reinterpret_cast<const xmlChar*>("UTF-8"));
+}
+
+bool is_xml_space(const char c)
+{
+    return ' ' == c or '\n' == c or '\t' == c or '\r' == c;
+}
+
+} // namespace
+
+// writes a document made of new text and of byte ranges of the previous document
+class CtStorageXmlSpliceWriter : public CtStorageWriter
+{
+public:
+    CtStorageXmlSpliceWriter(CtMainWin* pCtMainWin, const fs::path& file_path, std::shared_ptr<CtXmlDocLayout> pDocLayout)
+     : _pCtMainWin{pCtMainWin}
+     , _file_path{file_path}
+     , _pDocLayout{std::move(pDocLayout)}
+    {}
+
+    void set_source(const CtXmlDocLayout& docLayout)
+    {
+        _srcFilePath = docLayout.filePath;
+        _srcFileSize = docLayout.fileSize;
+        _srcMtime = docLayout.mtime;
+        _pSrcDocData = docLayout.pDocData;
+    }
+    void set_encrypted(const Glib::ustring& password, const std::string& archived_file_name)
+    {
+        _password = password;
+        _archivedFileName = archived_file_name;
+    }
+    void append_text(const std::string& text)
+    {
+        if (_pieces.empty() or 0u != _pieces.back().srcLength) {
+            _pieces.emplace_back();
         }
+        _pieces.back().text += text;
+        _outSize += text.size();
+    }
+    void append_copy(const std::uintmax_t src_offset, const std::uintmax_t src_length)
+    {
+        _pieces.emplace_back();
+        _pieces.back().srcOffset = src_offset;
+        _pieces.back().srcLength = src_length;
+        _outSize += src_length;
+        ++_numCopies;
+    }
+    std::uintmax_t get_out_size() const { return _outSize; }
+    size_t get_num_copies() const { return _numCopies; }
+    CtXmlDocLayout& get_new_layout() { return _newLayout; }
+
+    size_t get_num_steps() const override { return _pieces.size(); }
+    void write(const std::function<void(const size_t)>& f_progress) override;
+
+private:
+    struct Piece
+    {
+        std::string    text;
+        std::uintmax_t srcOffset{0};
+        std::uintmax_t srcLength{0}; // 0 for a text piece
+    };
+    CtMainWin* const                _pCtMainWin;
+    const fs::path                  _file_path;
+    std::shared_ptr<CtXmlDocLayout> _pDocLayout;
+    CtXmlDocLayout                  _newLayout;
+    std::vector<Piece>              _pieces;
+    std::uintmax_t                  _outSize{0};
+    size_t                          _numCopies{0};
+    fs::path                        _srcFilePath;
+    std::uintmax_t                  _srcFileSize{0};
+    time_t                          _srcMtime{0};
+    std::shared_ptr<const std::string> _pSrcDocData;
+    Glib::ustring                   _password;
+    std::string                     _archivedFileName;
+};
+
+void CtStorageXmlSpliceWriter::write(const std::function<void(const size_t)>& f_progress)
+{
+    // the source can be the file to replace, so write aside and move once complete
+    const fs::path tmp_file_path{_file_path.string() + ".tmp"};
+    // an encrypted document is composed in memory and streamed to the archiver
+    const bool isEncrypted = not _password.empty();
+    GError* pError{nullptr};
+    std::unique_ptr<CtXmlDocBytes> pSrcBytes;
+    GFile* pGFile{nullptr};
+    GFileOutputStream* pOutStream{nullptr};
+    bool success{false};
+    auto on_scope_exit = scope_guard([&](void*) {
+        if (pOutStream) g_object_unref(pOutStream);
+        if (pGFile) g_object_unref(pGFile);
+        if (pError) g_error_free(pError);
+        if (not success) {
+            // the previous document and its layout are left as they were
+            (void)fs::remove(tmp_file_path);
+        }
+    });
+    auto f_throw_if = [&](const bool is_error, const fs::path& path) {
+        if (is_error) {
+            throw std::runtime_error(fmt::format("{} {}", path.string(), pError ? pError->message : "i/o error"));
+        }
+    };
+
+    const char* pSrcData{nullptr};
+    std::uintmax_t srcSize{0};
+    if (_numCopies > 0u) {
+        if (not _pSrcDocData) {
+            f_throw_if(fs::file_size(_srcFilePath) != _srcFileSize or fs::getmtime(_srcFilePath) != _srcMtime, _srcFilePath);
+        }
+        pSrcBytes = std::make_unique<CtXmlDocBytes>(_srcFilePath, _pSrcDocData);
+        f_throw_if(not *pSrcBytes, _srcFilePath);
+        pSrcData = pSrcBytes->data();
+        srcSize = pSrcBytes->size();
+    }
+    std::string docData;
+    if (isEncrypted) {
+        docData.reserve(_outSize);
+    }
+    else {
+        pGFile = g_file_new_for_path(tmp_file_path.c_str());
+        pOutStream = g_file_replace(pGFile, nullptr/*etag*/, FALSE/*make_backup*/, G_FILE_CREATE_NONE, nullptr/*cancellable*/, &pError);
+        f_throw_if(not pOutStream, tmp_file_path);
+    }
+
+    std::string outBuffer;
+    constexpr size_t outBufferMax{1u << 20};
+    auto f_write_all = [&](const char* pData, const size_t dataSize) {
+        if (isEncrypted) {
+            docData.append(pData, dataSize);
+            return;
+        }
+        gsize bytesWritten{0};
+        f_throw_if(not g_output_stream_write_all(G_OUTPUT_STREAM(pOutStream), pData, dataSize, &bytesWritten, nullptr/*cancellable*/, &pError), tmp_file_path);
+    };
+    for (size_t i = 0; i < _pieces.size(); ++i) {
+        const Piece& piece = _pieces[i];
+        if (0u == piece.srcLength) {
+            outBuffer += piece.text;
+        }
+        else {
+            f_throw_if(piece.srcOffset + piece.srcLength > srcSize, _srcFilePath);
+            if (piece.srcLength < outBufferMax) {
+                outBuffer.append(pSrcData + piece.srcOffset, piece.srcLength);
+            }
+            else {
+                f_write_all(outBuffer.data(), outBuffer.size());
+                outBuffer.clear();
+                f_write_all(pSrcData + piece.srcOffset, piece.srcLength);
+            }
+        }
+        if (outBuffer.size() >= outBufferMax) {
+            f_write_all(outBuffer.data(), outBuffer.size());
+            outBuffer.clear();
+        }
+        f_progress(i + 1u);
+    }
+    f_write_all(outBuffer.data(), outBuffer.size());
+    // the source has to be released before replacing it, on Windows a mapped file cannot be replaced
+    pSrcBytes.reset();
+    std::shared_ptr<const std::string> pDocData;
+    if (isEncrypted) {
+        // the archive cannot be checked from its file afterwards, the composed document is checked before
+        pDocData = std::make_shared<const std::string>(std::move(docData));
+        Glib::ustring error;
+        if (not CtStorageXml::doc_data_integrity_check_pass(_pCtMainWin, pDocData, error)) {
+            throw std::runtime_error(fmt::format("{} integrity check fail {}", _file_path.string(), error.raw()));
+        }
+        const int retVal = doc_data_to_archive(*pDocData, _archivedFileName, tmp_file_path, _password);
+        f_throw_if(0 != retVal or not fs::is_regular_file(tmp_file_path), tmp_file_path);
+    }
+    else {
+        f_throw_if(not g_output_stream_close(G_OUTPUT_STREAM(pOutStream), nullptr/*cancellable*/, &pError), tmp_file_path);
+    }
+    {
+        // the nodes not loaded yet are read from the document by the UI thread
+        std::lock_guard<std::mutex> lock{_pDocLayout->mutex};
+        _pDocLayout->pDocBytes.reset();
+        f_throw_if(not fs::move_file(tmp_file_path, _file_path), _file_path);
+        _pDocLayout->filePath = _file_path;
+        _pDocLayout->fileSize = fs::file_size(_file_path);
+        _pDocLayout->mtime = fs::getmtime(_file_path);
+        _pDocLayout->pDocData = pDocData;
+        _pDocLayout->nodeRanges.swap(_newLayout.nodeRanges);
+    }
+    success = true;
+}
+
+std::string CtXmlDocLayout::get_node_xml(const gint64 node_id)
+{
+    const auto itRange = nodeRanges.find(node_id);
+    if (nodeRanges.end() == itRange) {
+        return std::string{};
+    }
+    if (not pDocBytes) {
+        pDocBytes = std::make_shared<CtXmlDocBytes>(filePath, pDocData);
+    }
+    if (not *pDocBytes or itRange->second.offset + itRange->second.length > pDocBytes->size()) {
+        pDocBytes.reset();
+        return std::string{};
+    }
+    return node_xml_from_range(pDocBytes->data(), itRange->second);
+}
+
+/*static*/bool CtStorageXml::doc_data_integrity_check_pass(CtMainWin* pCtMainWin,
+                                                            std::shared_ptr<const std::string> pDocData,
+                                                            Glib::ustring& error)
+{
+    CtStorageXml storage{pCtMainWin};
+    storage.set_is_dry_run();
+    storage._pDecryptedDoc = std::move(pDocData);
+    return storage.populate_treestore(fs::path{}, error);
+}
 
-        CtStorageCache storage_cache;
+bool CtXmlDocLayout::is_intact() const
+{
+    if (pDocData) {
+        return true;
+    }
+    return not filePath.empty() and
+           fs::is_regular_file(filePath) and
+           fs::file_size(filePath) == fileSize and
+           fs::getmtime(filePath) == mtime;
+}
+
+std::unique_ptr<CtStorageWriter> CtStorageXml::save_treestore_snapshot(const fs::path& file_path,
+                                                                      const CtStorageSyncPending& syncPending)
+{
+    std::unique_ptr<CtStorageXmlSpliceWriter> pWriter = _doc_snapshot(file_path, &syncPending);
+    _file_path = file_path;
+    return pWriter;
+}
+
+void CtStorageXml::doc_moved(const fs::path& new_file_path)
+{
+    std::lock_guard<std::mutex> lock{_pDocLayout->mutex};
+    if (not _pDocLayout->filePath.empty()) {
+        _pDocLayout->filePath = new_file_path;
+    }
+}
+
+void CtStorageXml::close_connect()
+{
+    // the document is about to be moved, on Windows a mapped file cannot be
+    std::lock_guard<std::mutex> lock{_pDocLayout->mutex};
+    _pDocLayout->pDocBytes.reset();
+}
+
+std::unique_ptr<CtStorageXmlSpliceWriter> CtStorageXml::_doc_snapshot(const fs::path& file_path,
+                                                                      const CtStorageSyncPending* pSyncPending)
+{
+    // without the sync pending or an intact previous document, every node is serialized
+    const bool canSplice = pSyncPending and _pDocLayout->is_intact();
+    auto pWriter = std::make_unique<CtStorageXmlSpliceWriter>(_pCtMainWin, file_path, _pDocLayout);
+    if (canSplice) {
+        pWriter->set_source(*_pDocLayout);
+    }
+    if (not _password.empty()) {
+        pWriter->set_encrypted(_password, get_archived_file_name(file_path));
+    }
+    CtStorageCache storage_cache;
+    if (not canSplice) {
         storage_cache.generate_cache(_pCtMainWin, nullptr, true/*for_xml*/);
+    }
+    CtXmlDocLayout& newLayout = pWriter->get_new_layout();
 
-        // save nodes
-        if ( CtExporting::NONESAVE == export_type or
-             CtExporting::NONESAVEAS == export_type or
-             CtExporting::ALL_TREE == export_type )
-        {
-            auto ct_tree_iter = _pCtMainWin->get_tree_store().get_ct_iter_first();
-            while (ct_tree_iter) {
-                _nodes_to_xml(&ct_tree_iter,
-                              xml_doc.get_root_node(),
-                              &storage_cache,
-                              export_type,
-                              pExpoMasterReassign,
-                              start_offset,
-                              end_offset);
-                ++ct_tree_iter;
+    // byte compatible with write_to_file_formatted() of the whole document
+    pWriter->append_text(std::string{"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<"} + CtConst::APP_NAME + ">");
+    {
+        xmlpp::Document xml_doc;
+        xml_doc_set_utf8(xml_doc);
+        xmlpp::Element* p_bookmarks_node = xml_doc.create_root_node("bookmarks");
+        p_bookmarks_node->set_attribute("list", str::join_numbers(_pCtMainWin->get_tree_store().bookmarks_get(), ","));
+        pWriter->append_text("\n" + xml_indent(1) + xml_node_dump(xml_doc, p_bookmarks_node, 1));
+    }
+    const std::string nodeEndTag{"</node>"};
+    std::function<void(CtTreeIter&, const int)> f_node_to_xml;
+    f_node_to_xml = [&](CtTreeIter& ct_tree_iter, const int depth) {
+        const gint64 node_id = ct_tree_iter.get_node_id();
+        CtTreeIter ct_tree_iter_child = ct_tree_iter.first_child();
+        const bool hasChildren = static_cast<bool>(ct_tree_iter_child);
+        pWriter->append_text("\n" + xml_indent(depth));
+        CtXmlDocLayout::NodeRange newRange;
+        newRange.offset = pWriter->get_out_size();
+        newRange.depth = depth;
+        newRange.hadChildren = hasChildren;
+
+        bool isCopied{false};
+        if (canSplice) {
+            const auto itPending = pSyncPending->nodes_to_write_dict.find(node_id);
+            const bool isChanged = pSyncPending->nodes_to_write_dict.end() != itPending and (itPending->second.prop or itPending->second.buff);
+            const auto itRange = _pDocLayout->nodeRanges.find(node_id);
+            if (not isChanged and
+                _pDocLayout->nodeRanges.end() != itRange and
+                itRange->second.depth == depth and
+                (not itRange->second.isStartTagOnly or itRange->second.hadChildren == hasChildren))
+            {
+                pWriter->append_copy(itRange->second.offset, itRange->second.length);
+                newRange.length = itRange->second.length;
+                newRange.isStartTagOnly = itRange->second.isStartTagOnly;
+                isCopied = true;
+            }
+        }
+        if (not isCopied) {
+            Glib::RefPtr<Gtk::TextBuffer> pTextBuffer = ct_tree_iter.get_node_text_buffer();
+            if (not pTextBuffer) {
+                throw std::runtime_error(str::format(_("Failed to retrieve the content of the node '%s'"), ct_tree_iter.get_node_name().raw()));
+            }
+            xmlpp::Document xml_doc;
+            xml_doc_set_utf8(xml_doc);
+            xmlpp::Element* p_node_node = CtStorageXmlHelper{_pCtMainWin}.node_to_xml(
+                &ct_tree_iter,
+                xml_doc.create_root_node(CtConst::APP_NAME),
+                std::string{}/*multifile_dir*/,
+                canSplice ? nullptr : &storage_cache,
+                CtExporting::NONESAVE);
+            std::string nodeText = xml_node_dump(xml_doc, p_node_node, depth);
+            const std::string closingText = "\n" + xml_indent(depth) + nodeEndTag;
+            if (str::endswith(nodeText, "/>")) {
+                newRange.isStartTagOnly = true;
+                if (hasChildren) {
+                    nodeText.replace(nodeText.size() - 2u, 2u, ">");
+                }
+            }
+            else if (str::endswith(nodeText, closingText)) {
+                nodeText.resize(nodeText.size() - closingText.size());
+            }
+            else {
+                throw std::runtime_error(fmt::format("unexp node {} xml dump", node_id));
+            }
+            pWriter->append_text(nodeText);
+            newRange.length = nodeText.size();
+        }
+        newLayout.nodeRanges[node_id] = newRange;
+
+        while (ct_tree_iter_child) {
+            f_node_to_xml(ct_tree_iter_child, depth + 1);
+            ++ct_tree_iter_child;
+        }
+        if (not newRange.isStartTagOnly or hasChildren) {
+            pWriter->append_text("\n" + xml_indent(depth) + nodeEndTag);
+        }
+    };
+    CtTreeIter ct_tree_iter = _pCtMainWin->get_tree_store().get_ct_iter_first();
+    while (ct_tree_iter) {
+        f_node_to_xml(ct_tree_iter, 1);
+        ++ct_tree_iter;
+    }
+    pWriter->append_text(std::string{"\n</"} + CtConst::APP_NAME + ">\n");
+    spdlog::debug("{} {} nodes, {} copied", __FUNCTION__, newLayout.nodeRanges.size(), pWriter->get_num_copies());
+    return pWriter;
+}
+
+void CtStorageXml::_doc_layout_load(const fs::path& file_path,
+                                    std::shared_ptr<const std::string> pDocData,
+                                    const std::vector<gint64>& node_ids_doc_order)
+{
+    std::vector<CtXmlDocLayout::NodeRange> nodeRanges;
+    bool scanOk{false};
+    {
+        CtXmlDocBytes docBytes{file_path, pDocData};
+        if (not docBytes) {
+            return;
+        }
+        scanOk = CtStorageXml::scan_node_ranges(docBytes.data(), docBytes.size(), nodeRanges);
+    }
+    if (not scanOk or nodeRanges.size() != node_ids_doc_order.size()) {
+        spdlog::debug("{} {} unexp layout, next save in full", __FUNCTION__, file_path.string());
+        return;
+    }
+    for (size_t i = 0; i < nodeRanges.size(); ++i) {
+        if (node_ids_doc_order[i] >= 0) {
+            _pDocLayout->nodeRanges[node_ids_doc_order[i]] = nodeRanges[i];
+        }
+    }
+    _pDocLayout->filePath = file_path;
+    _pDocLayout->fileSize = fs::file_size(file_path);
+    _pDocLayout->mtime = fs::getmtime(file_path);
+    _pDocLayout->pDocData = pDocData;
+    _pDocLayout->pDocBytes.reset();
+}
+
+/*static*/bool CtStorageXml::scan_node_ranges(const char* pData, const size_t dataSize, std::vector<CtXmlDocLayout::NodeRange>& nodeRanges)
+{
+    nodeRanges.clear();
+    // index in nodeRanges and end of the start tag of the nodes not closed yet
+    std::vector<std::pair<size_t, size_t>> openNodes;
+    auto f_starts_with = [&](const size_t pos, const std::string_view prefix) {
+        return dataSize - pos >= prefix.size() and 0 == memcmp(pData + pos, prefix.data(), prefix.size());
+    };
+    auto f_find = [&](const size_t pos, const std::string_view toFind)->size_t {
+        const std::string_view data{pData, dataSize};
+        return data.find(toFind, pos);
+    };
+    // the own slots of the innermost open node end before its first child node or its end tag
+    auto f_own_end = [&](const size_t pos) {
+        if (openNodes.empty()) return;
+        CtXmlDocLayout::NodeRange& nodeRange = nodeRanges[openNodes.back().first];
+        if (0u != nodeRange.length) return;
+        size_t ownEnd{pos};
+        while (ownEnd > nodeRange.offset and is_xml_space(pData[ownEnd - 1])) --ownEnd;
+        nodeRange.length = ownEnd - nodeRange.offset;
+        nodeRange.isStartTagOnly = ownEnd == openNodes.back().second;
+    };
+    size_t pos{0};
+    while (pos < dataSize) {
+        const char* pLt = static_cast<const char*>(memchr(pData + pos, '<', dataSize - pos));
+        if (not pLt) {
+            break;
+        }
+        pos = pLt - pData;
+        // skip what could contain a "<node" which is not a tag
+        std::string_view skipUntil;
+        if (f_starts_with(pos, "<!--")) skipUntil = "-->";
+        else if (f_starts_with(pos, "<![CDATA[")) skipUntil = "]]>";
+        else if (f_starts_with(pos, "<?")) skipUntil = "?>";
+        if (not skipUntil.empty()) {
+            const size_t skipPos = f_find(pos, skipUntil);
+            if (std::string_view::npos == skipPos) return false;
+            pos = skipPos + skipUntil.size();
+            continue;
+        }
+        const bool isNodeStart = f_starts_with(pos, "<node") and pos + 5u < dataSize and
+                                 (is_xml_space(pData[pos + 5u]) or '>' == pData[pos + 5u] or '/' == pData[pos + 5u]);
+        const bool isNodeEnd = f_starts_with(pos, "</node") and pos + 6u < dataSize and
+                               (is_xml_space(pData[pos + 6u]) or '>' == pData[pos + 6u]);
+        if (not isNodeStart and not isNodeEnd) {
+            ++pos;
+            continue;
+        }
+        // the attribute values have '>' escaped
+        const char* pGt = static_cast<const char*>(memchr(pData + pos, '>', dataSize - pos));
+        if (not pGt) return false;
+        const size_t tagEnd = pGt - pData + 1u;
+        f_own_end(pos);
+        if (isNodeStart) {
+            if (not openNodes.empty()) {
+                nodeRanges[openNodes.back().first].hadChildren = true;
+            }
+            CtXmlDocLayout::NodeRange nodeRange;
+            nodeRange.offset = pos;
+            nodeRange.depth = static_cast<int>(openNodes.size()) + 1;
+            if ('/' == pData[tagEnd - 2u]) {
+                nodeRange.length = tagEnd - pos;
+                nodeRange.isStartTagOnly = true;
+                nodeRanges.push_back(nodeRange);
+            }
+            else {
+                nodeRanges.push_back(nodeRange);
+                openNodes.emplace_back(nodeRanges.size() - 1u, tagEnd);
             }
         }
         else {
-            CtTreeIter ct_tree_iter = _pCtMainWin->curr_tree_iter();
+            if (openNodes.empty()) return false;
+            openNodes.pop_back();
+        }
+        pos = tagEnd;
+    }
+    return openNodes.empty();
+}
+
+void CtStorageXml::_treestore_to_xml(xmlpp::Document& xml_doc,
+                                     const CtExporting export_type,
+                                     const std::map<gint64, gint64>* pExpoMasterReassign,
+                                     const int start_offset,
+                                     const int end_offset)
+{
+    xml_doc.create_root_node(CtConst::APP_NAME);
+
+    if ( CtExporting::NONESAVE == export_type or
+         CtExporting::NONESAVEAS == export_type or
+         CtExporting::ALL_TREE == export_type )
+    {
+        // save bookmarks
+        xmlpp::Element* p_bookmarks_node = xml_doc.get_root_node()->add_child("bookmarks");
+        p_bookmarks_node->set_attribute("list", str::join_numbers(_pCtMainWin->get_tree_store().bookmarks_get(), ","));
+    }
+
+    CtStorageCache storage_cache;
+    storage_cache.generate_cache(_pCtMainWin, nullptr, true/*for_xml*/);
+
+    // save nodes
+    if ( CtExporting::NONESAVE == export_type or
+         CtExporting::NONESAVEAS == export_type or
+         CtExporting::ALL_TREE == export_type )
+    {
+        auto ct_tree_iter = _pCtMainWin->get_tree_store().get_ct_iter_first();
+        while (ct_tree_iter) {
             _nodes_to_xml(&ct_tree_iter,
                           xml_doc.get_root_node(),
                           &storage_cache,
@@ -164,19 +960,42 @@ bool CtStorageXml::save_treestore(const fs::path& file_path,
                           pExpoMasterReassign,
                           start_offset,
                           end_offset);
+            ++ct_tree_iter;
         }
-
-        // write file
-        xml_doc.write_to_file_formatted(file_path.string());
-
-        return true;
     }
-    catch (std::exception& e) {
-        error = e.what();
-        return false;
+    else {
+        CtTreeIter ct_tree_iter = _pCtMainWin->curr_tree_iter();
+        _nodes_to_xml(&ct_tree_iter,
+                      xml_doc.get_root_node(),
+                      &storage_cache,
+                      export_type,
+                      pExpoMasterReassign,
+                      start_offset,
+                      end_offset);
     }
 }
 
+void CtStorageXml::set_encrypted(const Glib::ustring& password, std::string doc_data/*= std::string{}*/)
+{
+    _password = password;
+    _pDecryptedDoc = doc_data.empty() ? nullptr : std::make_shared<const std::string>(std::move(doc_data));
+}
+
+void CtStorageXml::search_index_load(CtSearchIndex& searchIndex)
+{
+    searchIndex.clear();
+    // the sidecar would leak the content of an encrypted document
+    if (_isDryRun or _file_path.empty() or not _password.empty()) return;
+    (void)searchIndex.load_from_sidecar(CtSearchIndex::get_sidecar_path(_file_path), CtSearchIndex::get_doc_stamp({_file_path}));
+}
+
+void CtStorageXml::search_index_save(const CtSearchIndex& searchIndex)
+{
+    if (_file_path.empty() or not _password.empty()) return;
+    // the sidecar is next to the document
+    (void)searchIndex.save_to_sidecar(CtSearchIndex::get_sidecar_path(_file_path), CtSearchIndex::get_doc_stamp({_file_path}));
+}
+
 void CtStorageXml::import_nodes(const fs::path& filepath, const Gtk::TreeModel::iterator& parent_iter)
 {
     std::unique_ptr<xmlpp::DomParser> parser = CtStorageXml::get_parser(filepath);
@@ -233,8 +1052,32 @@ void CtStorageXml::import_nodes(const fs::path& filepath, const Gtk::TreeModel::
 
 Glib::RefPtr<Gtk::TextBuffer> CtStorageXml::get_delayed_text_buffer(const gint64 node_id,
                                                                     const std::string& syntax,
-                                                                    std::list<CtAnchoredWidget*>& widgets) const
+                                                                    std::list<CtAnchoredWidget*>& widgets,
+                                                                    const CtPrefetchedBody* pPrefetchedBody) const
 {
+    if (0u != _delayed_node_ids.count(node_id)) {
+        if (pPrefetchedBody) {
+            if (auto ret_buffer = CtStorageXmlHelper{_pCtMainWin}.create_buffer_from_prefetched(node_id, *pPrefetchedBody)) {
+                _delayed_node_ids.erase(node_id);
+                return ret_buffer;
+            }
+        }
+        std::string nodeXml;
+        {
+            // a save in progress may be replacing the document
+            std::lock_guard<std::mutex> lock{_pDocLayout->mutex};
+            nodeXml = _pDocLayout->get_node_xml(node_id);
+        }
+        if (nodeXml.empty()) {
+            spdlog::error("!! {} node_id {} not in {}", __FUNCTION__, node_id, _pDocLayout->filePath.string());
+            return Glib::RefPtr<Gtk::TextBuffer>{};
+        }
+        auto ret_buffer = _text_buffer_from_node_xml(nodeXml, syntax, widgets);
+        if (ret_buffer) {
+            _delayed_node_ids.erase(node_id);
+        }
+        return ret_buffer;
+    }
     if (_delayed_text_buffers.count(node_id) == 0) {
         spdlog::error("!! {} node_id {}", __FUNCTION__, node_id);
         return Glib::RefPtr<Gtk::TextBuffer>{};
@@ -248,6 +1091,35 @@ Glib::RefPtr<Gtk::TextBuffer> CtStorageXml::get_delayed_text_buffer(const gint64
     return ret_buffer;
 }
 
+bool CtStorageXml::release_text_buffer(const gint64 node_id)
+{
+    std::lock_guard<std::mutex> lock{_pDocLayout->mutex};
+    if (0u == _pDocLayout->nodeRanges.count(node_id) or not _pDocLayout->is_intact()) {
+        return false;
+    }
+    _delayed_node_ids.insert(node_id);
+    return true;
+}
+
+CtPrefetchedBodyReader CtStorageXml::get_body_reader(const gint64 node_id, const bool isRichText) const
+{
+    if (0u == _delayed_node_ids.count(node_id)) {
+        return CtPrefetchedBodyReader{};
+    }
+    return [pDocLayout = _pDocLayout, node_id, isRichText](CtPrefetchedBody& body) {
+        std::string nodeXml;
+        {
+            std::lock_guard<std::mutex> lock{pDocLayout->mutex};
+            nodeXml = pDocLayout->get_node_xml(node_id);
+        }
+        if (nodeXml.empty()) {
+            return false;
+        }
+        CtStoragePrefetch::body_from_node_xml(nodeXml, isRichText, body);
+        return true;
+    };
+}
+
 void CtStorageXml::_nodes_to_xml(CtTreeIter* ct_tree_iter,
                                  xmlpp::Element* p_node_parent,
                                  CtStorageCache* storage_cache,
@@ -287,7 +1159,7 @@ void CtStorageXml::_nodes_to_xml(CtTreeIter* ct_tree_iter,
     }
 }
 
-/*static*/std::unique_ptr<xmlpp::DomParser> CtStorageXml::get_parser(const fs::path& file_path)
+/*static*/std::unique_ptr<xmlpp::DomParser> CtStorageXml::get_parser(const fs::path& file_path, bool* pIsSanitised/*= nullptr*/)
 {
     if (not fs::exists(file_path)) {
         throw std::runtime_error(fmt::format("{} missing", file_path.string()));
@@ -305,6 +1177,7 @@ void CtStorageXml::_nodes_to_xml(CtTreeIter* ct_tree_iter,
         std::string buffer = Glib::file_get_contents(file_path.string());
         CtStrUtil::convert_if_not_utf8(buffer, true/*sanitise*/);
         parseOk = CtXmlHelper::safe_parse_memory(*parser, buffer);
+        if (pIsSanitised) *pIsSanitised = true;
     }
 
     if (not parseOk) {
@@ -319,6 +1192,65 @@ void CtStorageXml::_nodes_to_xml(CtTreeIter* ct_tree_iter,
     return parser;
 }
 
+/*static*/std::unique_ptr<xmlpp::DomParser> CtStorageXml::get_parser_memory(const std::string& doc_data, bool* pIsSanitised/*= nullptr*/)
+{
+    auto parser = std::make_unique<xmlpp::DomParser>();
+    bool parseOk{true};
+    try {
+        parser->set_parser_options(xmlParserOption::XML_PARSE_HUGE);
+        parser->parse_memory_raw(reinterpret_cast<const unsigned char*>(doc_data.data()), doc_data.size());
+    }
+    catch (xmlpp::exception& e) {
+        spdlog::error("{} {}", __FUNCTION__, e.what());
+
+        std::string buffer = doc_data;
+        CtStrUtil::convert_if_not_utf8(buffer, true/*sanitise*/);
+        parseOk = CtXmlHelper::safe_parse_memory(*parser, buffer);
+        if (pIsSanitised) *pIsSanitised = true;
+    }
+
+    if (not parseOk) {
+        throw std::runtime_error("xml parse fail");
+    }
+    if (not parser->get_document()) {
+        throw std::runtime_error("document is null");
+    }
+    if (parser->get_document()->get_root_node()->get_name() != CtConst::APP_NAME) {
+        throw std::runtime_error("document contains the wrong node root");
+    }
+    return parser;
+}
+
+
+/*static*/bool CtStorageXml::node_data_from_xml_data(const std::string& xml_data, CtNodeData& node_data)
+{
+    if (xml_data.size() > static_cast<size_t>(INT_MAX)) {
+        return false;
+    }
+    xmlTextReaderPtr pReader = xmlReaderForMemory(xml_data.data(), static_cast<int>(xml_data.size()), nullptr/*URL*/, nullptr/*encoding*/, XML_PARSE_HUGE);
+    if (not pReader) {
+        return false;
+    }
+    auto on_scope_exit = scope_guard([&](void*) { xmlFreeTextReader(pReader); });
+    bool gotNode{false};
+    int readRet;
+    while (1 == (readRet = xmlTextReaderRead(pReader))) {
+        if (gotNode or XML_READER_TYPE_ELEMENT != xmlTextReaderNodeType(pReader)) {
+            continue;
+        }
+        const int depth = xmlTextReaderDepth(pReader);
+        const char* pName = reinterpret_cast<const char*>(xmlTextReaderConstName(pReader));
+        if (0 == depth and 0 != strcmp(pName, CtConst::APP_NAME)) {
+            return false;
+        }
+        if (1 == depth and 0 == strcmp(pName, "node")) {
+            node_data.nodeId = CtStrUtil::gint64_from_gstring(reader_attribute(pReader, "unique_id").c_str());
+            CtStorageXmlHelper::node_data_from_attributes(node_data, [&pReader](const char* attr_name){ return reader_attribute(pReader, attr_name); });
+            gotNode = true;
+        }
+    }
+    return 0 == readRet and gotNode;
+}
 
 // Remove the body from the XML file before parsing.
 // Last chance for a node file we definitely can't parse. 
@@ -387,16 +1319,55 @@ xmlpp::Element* CtStorageXmlHelper::node_to_xml(const CtTreeIter* ct_tree_iter,
         p_node_node->set_attribute("ts_creation", std::to_string(ct_tree_iter->get_node_creating_time()));
         p_node_node->set_attribute("ts_lastsave", std::to_string(ct_tree_iter->get_node_modification_time()));
 
+        const std::list<CtAnchoredWidget*> anchoredWidgets = ct_tree_iter->get_anchored_widgets(start_offset, end_offset);
+        // without a cache from the caller, the images and embedded files get encoded on the
+        // thread pool while the text buffer (GTK, so UI thread only) is serialized
+        CtStorageCache node_storage_cache;
+        CtThreadPool::TaskGroup taskGroup{CtThreadPool::get_global()};
+        if (not storage_cache) {
+            std::vector<CtAnchoredWidget*> blobWidgets;
+            for (CtAnchoredWidget* pAnchoredWidget : anchoredWidgets) {
+                if (CtAnchWidgType::ImagePng == pAnchoredWidget->get_type() or
+                    CtAnchWidgType::ImageEmbFile == pAnchoredWidget->get_type())
+                {
+                    blobWidgets.push_back(pAnchoredWidget);
+                }
+            }
+            if (not blobWidgets.empty()) {
+                node_storage_cache.generate_cache_async(blobWidgets, multifile_dir.empty()/*for_xml*/, not multifile_dir.empty()/*for_multifile*/, taskGroup);
+                storage_cache = &node_storage_cache;
+            }
+        }
+
         Glib::RefPtr<Gtk::TextBuffer> buffer = ct_tree_iter->get_node_text_buffer();
         save_buffer_no_widgets_to_xml(p_node_node, buffer, start_offset, end_offset, 'n');
 
-        for (CtAnchoredWidget* pAnchoredWidget : ct_tree_iter->get_anchored_widgets(start_offset, end_offset)) {
+        taskGroup.wait();
+        for (CtAnchoredWidget* pAnchoredWidget : anchoredWidgets) {
             pAnchoredWidget->to_xml(p_node_node, start_offset > 0 ? -start_offset : 0, storage_cache, multifile_dir);
         }
     }
     return p_node_node;
 }
 
+/*static*/void CtStorageXmlHelper::node_data_from_attributes(CtNodeData& node_data, const std::function<Glib::ustring(const char*)>& f_attribute)
+{
+    node_data.sharedNodesMasterId = CtStrUtil::gint64_from_gstring(f_attribute("master_id").c_str());
+    if (node_data.sharedNodesMasterId <= 0) {
+        node_data.name = f_attribute("name");
+        node_data.syntax = f_attribute("prog_lang");
+        node_data.tags = f_attribute("tags");
+        node_data.isReadOnly = CtStrUtil::is_str_true(f_attribute("readonly"));
+        node_data.excludeMeFromSearch = CtStrUtil::is_str_true(f_attribute("nosearch_me"));
+        node_data.excludeChildrenFromSearch = CtStrUtil::is_str_true(f_attribute("nosearch_ch"));
+        node_data.customIconId = (guint32)CtStrUtil::gint64_from_gstring(f_attribute("custom_icon_id").c_str());
+        node_data.isBold = CtStrUtil::is_str_true(f_attribute("is_bold"));
+        node_data.foregroundRgb24 = f_attribute("foreground");
+        node_data.tsCreation = CtStrUtil::gint64_from_gstring(f_attribute("ts_creation").c_str());
+        node_data.tsLastSave = CtStrUtil::gint64_from_gstring(f_attribute("ts_lastsave").c_str());
+    }
+}
+
 Gtk::TreeModel::iterator CtStorageXmlHelper::node_from_xml(const xmlpp::Element* xml_element,
                                                 const gint64 sequence,
                                                 const Gtk::TreeModel::iterator parent_iter,
@@ -419,22 +1390,9 @@ Gtk::TreeModel::iterator CtStorageXmlHelper::node_from_xml(const xmlpp::Element*
         node_data.nodeId = new_id;
         if (pImportedIdsRemap) (*pImportedIdsRemap)[readNodeId] = new_id;
     }
-    node_data.sharedNodesMasterId = CtStrUtil::gint64_from_gstring(xml_element->get_attribute_value("master_id").c_str());
     node_data.sequence = sequence;
-    if (node_data.sharedNodesMasterId <= 0) {
-        node_data.name = xml_element->get_attribute_value("name");
-        node_data.syntax = xml_element->get_attribute_value("prog_lang");
-        node_data.tags = xml_element->get_attribute_value("tags");
-        node_data.isReadOnly = CtStrUtil::is_str_true(xml_element->get_attribute_value("readonly"));
-        node_data.excludeMeFromSearch = CtStrUtil::is_str_true(xml_element->get_attribute_value("nosearch_me"));
-        node_data.excludeChildrenFromSearch = CtStrUtil::is_str_true(xml_element->get_attribute_value("nosearch_ch"));
-        node_data.customIconId = (guint32)CtStrUtil::gint64_from_gstring(xml_element->get_attribute_value("custom_icon_id").c_str());
-        node_data.isBold = CtStrUtil::is_str_true(xml_element->get_attribute_value("is_bold"));
-        node_data.foregroundRgb24 = xml_element->get_attribute_value("foreground");
-        node_data.tsCreation = CtStrUtil::gint64_from_gstring(xml_element->get_attribute_value("ts_creation").c_str());
-        node_data.tsLastSave = CtStrUtil::gint64_from_gstring(xml_element->get_attribute_value("ts_lastsave").c_str());
-    }
-    else if (pIsSharedNonMaster) {
+    node_data_from_attributes(node_data, [xml_element](const char* attr_name){ return xml_element->get_attribute_value(attr_name); });
+    if (node_data.sharedNodesMasterId > 0 and pIsSharedNonMaster) {
         *pIsSharedNonMaster = true;
     }
 
@@ -547,6 +1505,16 @@ Glib::RefPtr<Gtk::TextBuffer> CtStorageXmlHelper::create_buffer_no_widgets(const
     return Glib::RefPtr<Gtk::TextBuffer>{};
 }
 
+Glib::RefPtr<Gtk::TextBuffer> CtStorageXmlHelper::create_buffer_from_prefetched(const gint64 node_id, const CtPrefetchedBody& prefetchedBody)
+{
+    Glib::RefPtr<Gtk::TextBuffer> rTextBuffer = prefetchedBody.isRichText ?
+        CtRichTextBin::create_buffer(_pCtMainWin, prefetchedBody.data) : _pCtMainWin->get_new_text_buffer(prefetchedBody.data);
+    if (not rTextBuffer) {
+        spdlog::debug("{} prefetched {} not used", __FUNCTION__, node_id);
+    }
+    return rTextBuffer;
+}
+
 bool CtStorageXmlHelper::populate_table_matrix(CtTableMatrix& tableMatrix,
                                                const char* xml_content,
                                                CtTableColWidths& tableColWidths,
@@ -601,7 +1569,7 @@ void CtStorageXmlHelper::save_buffer_no_widgets_to_xml(xmlpp::Element* p_node_pa
 {
     CtTextIterUtil::SerializeFunc rich_txt_serialize = [&](Gtk::TextIter& start_iter,
                                                            Gtk::TextIter& end_iter,
-                                                           CtCurrAttributesMap& curr_attributes,
+                                                           CtCurrAttributes& curr_attributes,
                                                            CtListInfo*/*pCurrListInfo*/)
     {
         xmlpp::Element* p_rich_text_node = p_node_parent->add_child("rich_text");
@@ -682,7 +1650,7 @@ CtAnchoredWidget* CtStorageXmlHelper::_create_image_from_xml(xmlpp::Element* xml
             }
             // if file name is non empty, it is ok since this is a multifile type and it means file name is constant on disk
         }
-        else if (not CtStorageMultiFile::read_blob(multifile_dir, sha256sum, rawBlob)) {
+        else if (not CtStorageMultiFile::read_blob(multifile_dir, sha256sum, rawBlob, _pMultiFileIndex)) {
             spdlog::warn("!! {} unexp not found {} in {}", __FUNCTION__, sha256sum, multifile_dir);
             return nullptr;
         }
@@ -30,6 +30,8 @@
 #include <gtkmm/treeiter.h>
 #include <gtkmm/textbuffer.h>
 #include <libxml++/libxml++.h>
+#include <mutex>
+#include <unordered_set>
 
 namespace xmlpp {
 
@@ -42,6 +44,37 @@ class CtAnchoredWidget;
 class CtMainWin;
 class CtTreeIter;
 class CtStorageCache;
+class CtStorageXmlSpliceWriter;
+struct CtNodeData;
+struct CtMultiFileIndex;
+class CtXmlDocBytes;
+
+// where the <node> elements are in the last loaded or written document, so that
+// the next save can copy the bytes of the unchanged ones instead of serializing them
+struct CtXmlDocLayout
+{
+    struct NodeRange
+    {
+        std::uintmax_t offset{0};
+        std::uintmax_t length{0}; // from "<node" to the end of the node own slots, child nodes excluded
+        int            depth{0};  // 1 for the top level nodes
+        bool           isStartTagOnly{false}; // no slots, either <node .../> or <node ...> followed by child nodes
+        bool           hadChildren{false};
+    };
+
+    fs::path                              filePath; // the main backup while a save is in progress
+    std::uintmax_t                        fileSize{0};
+    time_t                                mtime{0};
+    std::shared_ptr<const std::string>    pDocData; // an encrypted document, only decrypted in memory
+    std::unordered_map<gint64, NodeRange> nodeRanges;
+    std::shared_ptr<CtXmlDocBytes>        pDocBytes; // mapped on the first node load, dropped when the document changes
+    std::mutex                            mutex; // the writer replaces the document while the nodes are lazily loaded
+
+    void clear() { filePath.clear(); fileSize = 0; mtime = 0; pDocData.reset(); nodeRanges.clear(); pDocBytes.reset(); }
+    bool is_intact() const;
+    // with the mutex locked, the node own slots sliced from the document
+    std::string get_node_xml(const gint64 node_id);
+};
 
 class CtStorageXml : public CtStorageEntity
 {
@@ -50,14 +83,21 @@ public:
      : _pCtMainWin{pCtMainWin}
     {}
 
-    void close_connect() override {}
+    void close_connect() override;
     void reopen_connect() override {}
     void test_connection() override {}
     void try_reopen() override {}
     void vacuum() override {}
 
-    static std::unique_ptr<xmlpp::DomParser> get_parser(const fs::path& file_path);
+    static std::unique_ptr<xmlpp::DomParser> get_parser(const fs::path& file_path, bool* pIsSanitised = nullptr);
+    static std::unique_ptr<xmlpp::DomParser> get_parser_memory(const std::string& doc_data, bool* pIsSanitised = nullptr);
     static std::unique_ptr<xmlpp::DomParser> get_parser_header_only(const fs::path &file_path);
+    /**
+     * @brief Read the properties of the first node of a document, without a dom
+     * The whole document is still read through, so that a malformed node text is found now
+     * rather than when the node is visited and its text buffer created.
+     */
+    static bool node_data_from_xml_data(const std::string& xml_data, CtNodeData& node_data);
 
     bool populate_treestore(const fs::path& file_path, Glib::ustring& error) override;
     bool save_treestore(const fs::path& file_path,
@@ -67,15 +107,55 @@ public:
                         const std::map<gint64, gint64>* pExpoMasterReassign = nullptr,
                         const int start_offset = 0,
                         const int end_offset = -1) override;
+    std::unique_ptr<CtStorageWriter> save_treestore_snapshot(const fs::path& file_path,
+                                                            const CtStorageSyncPending& syncPending) override;
     void import_nodes(const fs::path& path, const Gtk::TreeModel::iterator& parent_iter) override;
+    void doc_moved(const fs::path& new_file_path) override;
+
+    /**
+     * @brief The .ctz document is loaded from its decrypted data in memory and saved
+     * encrypted with the password, so that it is never in plain text on disk
+     */
+    void set_encrypted(const Glib::ustring& password, std::string doc_data = std::string{});
+
+    // the dry run load of a document decrypted in memory, whose archive cannot be checked from its file
+    static bool doc_data_integrity_check_pass(CtMainWin* pCtMainWin,
+                                              std::shared_ptr<const std::string> pDocData,
+                                              Glib::ustring& error);
+    /**
+     * @brief Scan the byte ranges of the <node> elements of a document, in document order
+     * @return false if the tags are not balanced
+     */
+    static bool scan_node_ranges(const char* pData, const size_t dataSize, std::vector<CtXmlDocLayout::NodeRange>& nodeRanges);
 
     Glib::RefPtr<Gtk::TextBuffer> get_delayed_text_buffer(const gint64 node_id,
                                                           const std::string& syntax,
-                                                          std::list<CtAnchoredWidget*>& widgets) const override;
+                                                          std::list<CtAnchoredWidget*>& widgets,
+                                                          const CtPrefetchedBody* pPrefetchedBody) const override;
+    bool release_text_buffer(const gint64 node_id) override;
+    CtPrefetchedBodyReader get_body_reader(const gint64 node_id, const bool isRichText) const override;
 
     fs::path get_embedded_filepath(const CtTreeIter&/*ct_tree_iter*/, const std::string&/*filename*/) const override { return ""; }
 
+    void search_index_load(CtSearchIndex& searchIndex) override;
+    void search_index_save(const CtSearchIndex& searchIndex) override;
+
 private:
+    // the rows are appended as the nodes are read, the tree view shows them at the end of file_open
+    bool _populate_treestore_stream(const fs::path& file_path, std::shared_ptr<const std::string> pDocData);
+    Glib::RefPtr<Gtk::TextBuffer> _text_buffer_from_node_xml(const std::string& node_xml,
+                                                             const std::string& syntax,
+                                                             std::list<CtAnchoredWidget*>& widgets) const;
+    std::unique_ptr<CtStorageXmlSpliceWriter> _doc_snapshot(const fs::path& file_path,
+                                                            const CtStorageSyncPending* pSyncPending);
+    void _doc_layout_load(const fs::path& file_path,
+                          std::shared_ptr<const std::string> pDocData,
+                          const std::vector<gint64>& node_ids_doc_order);
+    void _treestore_to_xml(xmlpp::Document& xml_doc,
+                           const CtExporting export_type,
+                           const std::map<gint64, gint64>* pExpoMasterReassign,
+                           const int start_offset,
+                           const int end_offset);
     void _nodes_to_xml(CtTreeIter* ct_tree_iter,
                        xmlpp::Element* p_node_parent,
                        CtStorageCache* storage_cache,
@@ -86,14 +166,21 @@ private:
 
 private:
     CtMainWin* const _pCtMainWin;
+    fs::path         _file_path;
+    Glib::ustring    _password; // not empty for an encrypted document
+    std::shared_ptr<const std::string> _pDecryptedDoc; // until populate_treestore()
     mutable CtDelayedTextBufferMap _delayed_text_buffers;
+    mutable std::unordered_set<gint64> _delayed_node_ids; // text buffers to parse from the node range in the document
+    // shared with the writer of a save in progress, which updates it once done
+    std::shared_ptr<CtXmlDocLayout> _pDocLayout{std::make_shared<CtXmlDocLayout>()};
 };
 
 class CtStorageXmlHelper
 {
 public:
-    CtStorageXmlHelper(CtMainWin* pCtMainWin)
+    CtStorageXmlHelper(CtMainWin* pCtMainWin, const CtMultiFileIndex* pMultiFileIndex = nullptr)
      : _pCtMainWin{pCtMainWin}
+     , _pMultiFileIndex{pMultiFileIndex}
     {}
 
     xmlpp::Element* node_to_xml(const CtTreeIter* ct_tree_iter,
@@ -115,6 +202,9 @@ public:
                                 const bool isDryRun,
                                 const std::string& multifile_dir);
 
+    // the node properties in the attributes of its <node> element
+    static void node_data_from_attributes(CtNodeData& node_data, const std::function<Glib::ustring(const char*)>& f_attribute);
+
     Glib::RefPtr<Gtk::TextBuffer> create_buffer_and_widgets_from_xml(const xmlpp::Element* parent_xml_element,
                                                                      const Glib::ustring& syntax,
                                                                      std::list<CtAnchoredWidget*>& widgets,
@@ -130,6 +220,8 @@ public:
                                            const std::string& multifile_dir);
 
     Glib::RefPtr<Gtk::TextBuffer> create_buffer_no_widgets(const Glib::ustring& syntax, const char* xml_content);
+    // null if the body read on a worker thread can not be used
+    Glib::RefPtr<Gtk::TextBuffer> create_buffer_from_prefetched(const gint64 node_id, const CtPrefetchedBody& prefetchedBody);
 
     bool populate_table_matrix(CtTableMatrix& tableMatrix,
                                const char* xml_content,
@@ -153,6 +245,7 @@ private:
 
 private:
     CtMainWin* const _pCtMainWin;
+    const CtMultiFileIndex* const _pMultiFileIndex;
 };
 
 namespace CtXmlHelper {
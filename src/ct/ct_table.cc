@@ -278,12 +278,12 @@ void CtTableCommon::to_xml(xmlpp::Element* p_node_parent, const int offset_adjus
                               CtAnchWidgType::TableLight == get_type());
 }
 
-bool CtTableCommon::to_sqlite(sqlite3* pDb, const gint64 node_id, const int offset_adjustment, CtStorageCache*)
+bool CtTableCommon::to_sqlite(CtSqliteStmtCache* pStmtCache, const gint64 node_id, const int offset_adjustment, CtStorageCache*)
 {
     bool retVal{true};
-    sqlite3_stmt *p_stmt;
-    if (sqlite3_prepare_v2(pDb, CtStorageSqlite::TABLE_TABLE_INSERT, -1, &p_stmt, nullptr) != SQLITE_OK) {
-        spdlog::error("{}: {}", CtStorageSqlite::ERR_SQLITE_PREPV2, sqlite3_errmsg(pDb));
+    sqlite3_stmt* p_stmt = pStmtCache->get(CtStorageSqlite::TABLE_TABLE_INSERT);
+    if (not p_stmt) {
+        spdlog::error("{}: {}", CtStorageSqlite::ERR_SQLITE_PREPV2, sqlite3_errmsg(pStmtCache->get_db()));
         retVal = false;
     }
     else {
@@ -302,10 +302,9 @@ bool CtTableCommon::to_sqlite(sqlite3* pDb, const gint64 node_id, const int offs
         sqlite3_bind_int64(p_stmt, 5, _colWidthDefault); // todo get rid of column min
         sqlite3_bind_int64(p_stmt, 6, _colWidthDefault);
         if (sqlite3_step(p_stmt) != SQLITE_DONE) {
-            spdlog::error("{}: {}", CtStorageSqlite::ERR_SQLITE_STEP, sqlite3_errmsg(pDb));
+            spdlog::error("{}: {}", CtStorageSqlite::ERR_SQLITE_STEP, sqlite3_errmsg(pStmtCache->get_db()));
             retVal = false;
         }
-        sqlite3_finalize(p_stmt);
     }
     return retVal;
 }
@@ -58,7 +58,7 @@ public:
         return colWidths;
     }
     void to_xml(xmlpp::Element* p_node_parent, const int offset_adjustment, CtStorageCache* cache, const std::string& multifile_dir) override;
-    bool to_sqlite(sqlite3* pDb, const gint64 node_id, const int offset_adjustment, CtStorageCache* cache) override;
+    bool to_sqlite(CtSqliteStmtCache* pStmtCache, const gint64 node_id, const int offset_adjustment, CtStorageCache* cache) override;
 
     // Build a table from csv; The input csv should be compatable with the excel csv format
     static void populate_table_matrix_from_csv(const std::string& filepath,
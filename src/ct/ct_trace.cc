@@ -0,0 +1,102 @@
+/*
+ * ct_trace.cc
+ *
+ * Copyright 2009-2026
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "ct_trace.h"
+#include "ct_logging.h"
+#include <glib.h>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> CtTrace::_enabled{false};
+
+namespace {
+
+struct CtTraceEvent {
+    const char* name;
+    int64_t     startUs;
+    int64_t     durUs;
+    uint32_t    tid;
+};
+
+std::mutex                                  traceMutex;
+std::vector<CtTraceEvent>                   traceEvents;
+std::string                                 traceFilepath;
+const std::chrono::steady_clock::time_point traceEpoch = std::chrono::steady_clock::now();
+std::atomic<uint32_t>                       traceNextTid{1};
+
+uint32_t trace_thread_id()
+{
+    // small sequential ids read better than the native ones in the trace viewers
+    thread_local const uint32_t tid = traceNextTid++;
+    return tid;
+}
+
+} // namespace
+
+/*static*/void CtTrace::start(const std::string& filepath)
+{
+    std::lock_guard<std::mutex> lock{traceMutex};
+    traceFilepath = filepath;
+    traceEvents.clear();
+    traceEvents.reserve(4096);
+    _enabled.store(true, std::memory_order_relaxed);
+    spdlog::info("Tracing into {}", traceFilepath);
+}
+
+/*static*/bool CtTrace::stop()
+{
+    if (not _enabled.exchange(false)) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock{traceMutex};
+    std::string json{"{\"traceEvents\":["};
+    bool first{true};
+    for (const CtTraceEvent& event : traceEvents) {
+        json += fmt::format("{}\n{{\"name\":\"{}\",\"cat\":\"ct\",\"ph\":\"X\",\"ts\":{},\"dur\":{},\"pid\":1,\"tid\":{}}}",
+                            first ? "" : ",", event.name, event.startUs, event.durUs, event.tid);
+        first = false;
+    }
+    json += "\n],\"displayTimeUnit\":\"ms\"}\n";
+    traceEvents.clear();
+    if (not g_file_set_contents(traceFilepath.c_str(), json.c_str(), (gssize)json.size(), nullptr)) {
+        spdlog::error("{} failed writing {}", __FUNCTION__, traceFilepath);
+        return false;
+    }
+    spdlog::info("Trace written into {}", traceFilepath);
+    return true;
+}
+
+/*static*/int64_t CtTrace::_now_us()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - traceEpoch).count();
+}
+
+/*static*/void CtTrace::_record(const char* name, const int64_t startUs, const int64_t durUs)
+{
+    const uint32_t tid = trace_thread_id();
+    std::lock_guard<std::mutex> lock{traceMutex};
+    if (is_enabled()) {
+        traceEvents.push_back(CtTraceEvent{name, startUs, durUs, tid});
+    }
+}
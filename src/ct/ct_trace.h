@@ -0,0 +1,77 @@
+/*
+ * ct_trace.h
+ *
+ * Copyright 2009-2026
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Performance tracing into a Chrome/Perfetto trace json (chrome://tracing, ui.perfetto.dev)
+ * Enabled by the command line option --trace=<file.json> or the environment variable CHERRYTREE_TRACE=<file.json>;
+ * when disabled a span costs a relaxed atomic load.
+ */
+class CtTrace
+{
+public:
+    static void start(const std::string& filepath);
+    // writes the recorded spans into the file given to start()
+    static bool stop();
+    static bool is_enabled() { return _enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Scoped span, recorded as a complete event on destruction or end()
+     * The name must outlive the trace, i.e. be a string literal
+     */
+    class Span
+    {
+    public:
+        explicit Span(const char* name)
+         : _name{name}
+        {
+            if (is_enabled()) _startUs = _now_us();
+        }
+        ~Span() { end(); }
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+        void end()
+        {
+            if (_startUs >= 0) {
+                _record(_name, _startUs, _now_us() - _startUs);
+                _startUs = -1;
+            }
+        }
+
+    private:
+        const char* _name;
+        int64_t     _startUs{-1};
+    };
+
+private:
+    static int64_t _now_us();
+    static void _record(const char* name, const int64_t startUs, const int64_t durUs);
+
+    static std::atomic<bool> _enabled;
+};
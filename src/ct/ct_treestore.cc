@@ -26,6 +26,7 @@
 #include "ct_treestore.h"
 #include "ct_misc_utils.h"
 #include "ct_storage_control.h"
+#include "ct_codebox.h"
 #include "ct_actions.h"
 #include "ct_logging.h"
 
@@ -151,7 +152,9 @@ gint64 CtTreeIter::get_node_id() const
 void CtTreeIter::set_node_id(const gint64 new_id)
 {
     if (*this) {
+        const gint64 prev_id = (*this)->get_value(_pColumns->colNodeUniqueId);
         (*this)->set_value(_pColumns->colNodeUniqueId, new_id);
+        _pCtMainWin->get_tree_store().nodes_index_update(*this, prev_id);
     }
     else {
         spdlog::error("!! {}", __FUNCTION__);
@@ -355,6 +358,7 @@ void CtTreeIter::set_node_name(const Glib::ustring& node_name)
             (*this)->set_value(_pColumns->colSharedNodesMasterId, static_cast<gint64>(0));
         }
         (*this)->set_value(_pColumns->colNodeName, node_name);
+        _pCtMainWin->get_tree_store().nodes_index_update(*this);
     }
     else {
         spdlog::error("!! {}", __FUNCTION__);
@@ -559,6 +563,9 @@ Glib::RefPtr<Gtk::TextBuffer> CtTreeIter::get_node_text_buffer() const
                 }
                 row.set_value(_pColumns->colAnchoredWidgets, anchoredWidgetList);
                 row.set_value(_pColumns->rColTextBuffer, rRetTextBuffer);
+                if (rRetTextBuffer) {
+                    _pCtMainWin->get_tree_store().loaded_buffer_touch(*this);
+                }
             }
         }
         return rRetTextBuffer;
@@ -1064,6 +1071,92 @@ int CtTreeStore::get_tree_icon_size() const
     return _cached_icon_size;
 }
 
+void CtTreeStore::loaded_buffer_touch(const CtTreeIter& treeIter)
+{
+    const gint64 nodeIdDataHolder = treeIter.get_node_id_data_holder();
+    CtTreeIter dataHolderIter = nodeIdDataHolder == treeIter.get_node_id() ? treeIter : get_node_from_node_id(nodeIdDataHolder);
+    if (not dataHolderIter) {
+        return;
+    }
+    Glib::RefPtr<Gtk::TextBuffer> rTextBuffer = dataHolderIter->get_value(_columns.rColTextBuffer);
+    if (rTextBuffer) {
+        _loadedBuffersLru.touch(nodeIdDataHolder, _loaded_buffer_bytes_estimate(rTextBuffer, dataHolderIter->get_value(_columns.colAnchoredWidgets)));
+    }
+}
+
+void CtTreeStore::loaded_buffers_limit()
+{
+    const size_t limitBytes = static_cast<size_t>(std::max(0, _pCtMainWin->get_ct_config()->loadedNodesMemMb)) * 1024u * 1024u;
+    if (0u == limitBytes or _loadedBuffersLru.get_bytes() <= limitBytes) {
+        return;
+    }
+    CtTreeIter currTreeIter = _pCtMainWin->curr_tree_iter();
+    const gint64 currNodeIdDataHolder = currTreeIter ? currTreeIter.get_node_id_data_holder() : -1;
+    size_t releasedCount{0};
+    for (const gint64 nodeId : _loadedBuffersLru.get_keys()) {
+        if (_loadedBuffersLru.get_bytes() <= limitBytes) {
+            break;
+        }
+        // the buffers that can not be released now keep their place and are tried again next time
+        if (nodeId != currNodeIdDataHolder and _loaded_buffer_release(nodeId)) {
+            _loadedBuffersLru.remove(nodeId);
+            ++releasedCount;
+        }
+    }
+    spdlog::debug("{} released {}, loaded {} ~{} KB", __FUNCTION__, releasedCount, _loadedBuffersLru.size(), _loadedBuffersLru.get_bytes()/1024u);
+}
+
+/*static*/size_t CtTreeStore::_loaded_buffer_bytes_estimate(const Glib::RefPtr<Gtk::TextBuffer>& rTextBuffer,
+                                                           const std::list<CtAnchoredWidget*>& anchoredWidgets)
+{
+    // roughly the text plus the btree line and segment structures
+    size_t bytes = 2u * static_cast<size_t>(rTextBuffer->get_char_count()) + 64u * static_cast<size_t>(rTextBuffer->get_line_count());
+    for (CtAnchoredWidget* pCtAnchoredWidget : anchoredWidgets) {
+        bytes += 1024u; // the widget itself
+        if (auto pCtImage = dynamic_cast<CtImage*>(pCtAnchoredWidget)) {
+            // not forcing the render of a latex formula still pending
+            Glib::RefPtr<Gdk::Pixbuf> rPixbuf = pCtImage->CtImage::get_pixbuf();
+            if (rPixbuf) {
+                bytes += rPixbuf->get_byte_length();
+            }
+        }
+        else if (auto pCtCodebox = dynamic_cast<CtCodebox*>(pCtAnchoredWidget)) {
+            bytes += 2u * static_cast<size_t>(pCtCodebox->get_buffer()->get_char_count());
+        }
+        else if (auto pCtTable = dynamic_cast<CtTableCommon*>(pCtAnchoredWidget)) {
+            bytes += 256u * pCtTable->get_num_rows() * pCtTable->get_num_columns();
+        }
+    }
+    return bytes;
+}
+
+bool CtTreeStore::_loaded_buffer_release(const gint64 nodeId)
+{
+    CtTreeIter treeIter = get_node_from_node_id(nodeId);
+    if (not treeIter) {
+        return true; // the node was removed
+    }
+    Glib::RefPtr<Gtk::TextBuffer> rTextBuffer = treeIter->get_value(_columns.rColTextBuffer);
+    if (not rTextBuffer) {
+        return true;
+    }
+    // the buffer is dropped only if loading it again from the document gives it back as it is
+    CtStateMachine& ctStateMachine = _pCtMainWin->get_state_machine();
+    if (rTextBuffer->get_modified() or
+        ctStateMachine.has_undoable_states(nodeId) or
+        not _pCtMainWin->get_ct_storage()->release_text_buffer(nodeId))
+    {
+        return false;
+    }
+    ctStateMachine.buffer_released(nodeId);
+    for (CtAnchoredWidget* pCtAnchoredWidget : treeIter->get_value(_columns.colAnchoredWidgets)) {
+        delete pCtAnchoredWidget;
+    }
+    treeIter->set_value(_columns.colAnchoredWidgets, std::list<CtAnchoredWidget*>{});
+    treeIter->set_value(_columns.rColTextBuffer, Glib::RefPtr<Gtk::TextBuffer>{});
+    return true;
+}
+
 Glib::RefPtr<Gdk::Pixbuf> CtTreeStore::_get_node_icon(int nodeDepth, const std::string &syntax, guint32 customIconId)
 {
     const char* stock_id = get_node_icon(nodeDepth, syntax, customIconId);
@@ -1148,6 +1241,7 @@ void CtTreeStore::update_node_data(const Gtk::TreeModel::iterator& treeIter, con
 {
     Gtk::TreeRow row = *treeIter;
 
+    const gint64 prevNodeId = row[_columns.colNodeUniqueId];
     row[_columns.colNodeUniqueId] = nodeData.nodeId;
     row[_columns.colSharedNodesMasterId] = nodeData.sharedNodesMasterId;
     row[_columns.colNodeSequence] = nodeData.sequence;
@@ -1169,7 +1263,54 @@ void CtTreeStore::update_node_data(const Gtk::TreeModel::iterator& treeIter, con
 
     update_node_aux_icon(treeIter);
     add_used_tags(nodeData.tags);
-    _nodes_names_dict[nodeData.nodeId] = nodeData.name;
+    nodes_index_update(treeIter, prevNodeId);
+}
+
+void CtTreeStore::nodes_index_update(const Gtk::TreeModel::iterator& treeIter, const gint64 prevNodeId/*= 0*/)
+{
+    const gint64 node_id = treeIter->get_value(_columns.colNodeUniqueId);
+    if (prevNodeId > 0 and prevNodeId != node_id) {
+        // no entry left to this row under its previous id, once the row is removed
+        auto itPrevIdx = _nodes_ids_index.find(prevNodeId);
+        if (itPrevIdx != _nodes_ids_index.end() and itPrevIdx->second == treeIter) {
+            _nodes_ids_index.erase(itPrevIdx);
+        }
+    }
+    const Glib::ustring node_name = treeIter->get_value(_columns.colNodeName);
+    auto itPrevName = _nodes_names_dict.find(node_id);
+    if (itPrevName != _nodes_names_dict.end() and itPrevName->second != node_name) {
+        auto itNameIds = _nodes_names_index.find(itPrevName->second.raw());
+        if (itNameIds != _nodes_names_index.end()) {
+            itNameIds->second.erase(node_id);
+            if (itNameIds->second.empty()) {
+                _nodes_names_index.erase(itNameIds);
+            }
+        }
+    }
+    _nodes_names_dict[node_id] = node_name;
+    _nodes_names_index[node_name.raw()].insert(node_id);
+    _nodes_ids_index.insert_or_assign(node_id, treeIter);
+    if (node_id > _nodes_max_id) {
+        _nodes_max_id = node_id;
+    }
+}
+
+void CtTreeStore::node_erase(const Gtk::TreeModel::iterator& treeIter)
+{
+    _nodes_index_remove(treeIter);
+    _rTreeStore->erase(treeIter);
+}
+
+void CtTreeStore::_nodes_index_remove(Gtk::TreeModel::iterator treeIter)
+{
+    // a node moved in the tree is copied to its new row before the old one is removed
+    auto itIdx = _nodes_ids_index.find(treeIter->get_value(_columns.colNodeUniqueId));
+    if (itIdx != _nodes_ids_index.end() and itIdx->second == treeIter) {
+        _nodes_ids_index.erase(itIdx);
+    }
+    for (Gtk::TreeModel::iterator childIter = treeIter->children().begin(); childIter; ++childIter) {
+        _nodes_index_remove(childIter);
+    }
 }
 
 void CtTreeStore::update_node_icon(const Gtk::TreeModel::iterator& treeIter)
@@ -1389,13 +1530,9 @@ gint64 CtTreeStore::node_id_get(gint64 original_id/*=-1*/,
 
     // (@txe) this function works differently from python code
     // it's easer to find max than check every id is not used through all tree
-    gint64 max_node_id{0};
-    _rTreeStore->foreach_iter([&max_node_id, this](const Gtk::TreeModel::iterator& iter){
-        if (iter->get_value(_columns.colNodeUniqueId) > max_node_id) {
-            max_node_id = iter->get_value(_columns.colNodeUniqueId);
-        }
-        return false; /* continue */
-    });
+    // the max is kept up to date while populating the tree and never decreases
+    // within the session, so an id is never reused before a reload
+    gint64 max_node_id{_nodes_max_id};
     for (const gint64 curr_id : allocated_for_remapping_ids) {
         if (curr_id > max_node_id) {
             max_node_id = curr_id;
@@ -1442,23 +1579,42 @@ std::string CtTreeStore::get_node_name_from_node_id(const gint64 node_id)
 
 CtTreeIter CtTreeStore::get_node_from_node_id(const gint64 node_id)
 {
-    Gtk::TreeModel::iterator find_iter;
-    _rTreeStore->foreach_iter([&node_id, &find_iter, this](const Gtk::TreeModel::iterator& iter) {
-        if (iter->get_value(_columns.colNodeUniqueId) != node_id) return false; /* continue */
-        find_iter = iter;
-        return true;
-    });
-    return to_ct_tree_iter(find_iter);
+    auto itIdx = _nodes_ids_index.find(node_id);
+    if (itIdx != _nodes_ids_index.end()) {
+        if (itIdx->second->get_value(_columns.colNodeUniqueId) == node_id) {
+            return to_ct_tree_iter(itIdx->second);
+        }
+        // the id of the row changed
+        _nodes_ids_index.erase(itIdx);
+    }
+    return to_ct_tree_iter(Gtk::TreeModel::iterator{});
 }
 
 CtTreeIter CtTreeStore::get_node_from_node_name(const Glib::ustring& node_name)
 {
+    auto itNameIds = _nodes_names_index.find(node_name.raw());
+    if (itNameIds == _nodes_names_index.end()) {
+        return to_ct_tree_iter(Gtk::TreeModel::iterator{});
+    }
+    // with more nodes with the same name, return the first in tree order
     Gtk::TreeModel::iterator find_iter;
-    _rTreeStore->foreach_iter([&node_name, &find_iter, this](const Gtk::TreeModel::iterator& iter) {
-        if (iter->get_value(_columns.colNodeName) != node_name) return false; /* continue */
-        find_iter = iter;
-        return true;
-    });
+    Gtk::TreePath find_path;
+    for (auto itId = itNameIds->second.begin(); itId != itNameIds->second.end(); ) {
+        CtTreeIter ctTreeIter = get_node_from_node_id(*itId);
+        if (not ctTreeIter or ctTreeIter->get_value(_columns.colNodeName) != node_name) {
+            itId = itNameIds->second.erase(itId); // stale
+            continue;
+        }
+        Gtk::TreePath currPath = _rTreeStore->get_path(ctTreeIter);
+        if (not find_iter or currPath < find_path) {
+            find_iter = ctTreeIter;
+            find_path = currPath;
+        }
+        ++itId;
+    }
+    if (itNameIds->second.empty()) {
+        _nodes_names_index.erase(itNameIds);
+    }
     return to_ct_tree_iter(find_iter);
 }
 
@@ -27,6 +27,7 @@
 #include <gtkmm.h>
 #include <set>
 #include <unordered_map>
+#include <unordered_set>
 
 class CtMainWin;
 class CtAnchoredWidget;
@@ -195,6 +196,9 @@ public:
     std::string                    get_node_name_from_node_id(const gint64 node_id);
     CtTreeIter                     get_node_from_node_id(const gint64 node_id);
     CtTreeIter                     get_node_from_node_name(const Glib::ustring& node_name);
+    void                           nodes_index_update(const Gtk::TreeModel::iterator& treeIter, const gint64 prevNodeId = 0);
+    // removes the row with its children, keeping the index by id valid
+    void                           node_erase(const Gtk::TreeModel::iterator& treeIter);
 
     bool                           bookmarks_add(gint64 nodeId);
     bool                           bookmarks_remove(gint64 nodeId);
@@ -218,9 +222,19 @@ public:
     const char* get_node_icon(int nodeDepth, const std::string &syntax, guint32 customIconId);
     int get_tree_icon_size() const;
 
+    // the node text buffers loaded on demand, least recently used released first above the memory limit
+    void   loaded_buffer_touch(const CtTreeIter& treeIter);
+    void   loaded_buffers_limit();
+    size_t loaded_buffers_count() const { return _loadedBuffersLru.size(); }
+    size_t loaded_buffers_bytes() const { return _loadedBuffersLru.get_bytes(); }
+
 protected:
     Glib::RefPtr<Gdk::Pixbuf> _get_node_icon(int nodeDepth, const std::string &syntax, guint32 customIconId);
     void                      _iter_delete_anchored_widgets(const Gtk::TreeModel::Children& children);
+    static size_t             _loaded_buffer_bytes_estimate(const Glib::RefPtr<Gtk::TextBuffer>& rTextBuffer,
+                                                            const std::list<CtAnchoredWidget*>& anchoredWidgets);
+    bool                      _loaded_buffer_release(const gint64 nodeId);
+    void                      _nodes_index_remove(Gtk::TreeModel::iterator treeIter);
 
     void _on_textbuffer_modified_changed(Glib::RefPtr<Gtk::TextBuffer> pTextBuffer);
     void _on_textbuffer_insert(const Gtk::TextBuffer::iterator& pos, const Glib::ustring& text, int bytes);
@@ -233,8 +247,12 @@ private:
     std::list<gint64>               _bookmarks;
     std::set<Glib::ustring>         _usedTags;
     std::map<gint64, Glib::ustring> _nodes_names_dict; // for link tooltips
+    std::unordered_map<gint64, Gtk::TreeModel::iterator> _nodes_ids_index; // the tree store iters persist until the row is removed
+    std::unordered_map<std::string, std::unordered_set<gint64>> _nodes_names_index;
+    gint64                          _nodes_max_id{0};
     std::list<sigc::connection>     _curr_node_sigc_conn;
     CtMainWin*                      _pCtMainWin;
     mutable int                     _cached_icon_size{-1};
     mutable Glib::ustring           _cached_tree_font;
+    CtSizedLru<gint64>              _loadedBuffersLru;
 };
@@ -32,8 +32,13 @@
 #include <optional>
 #include <condition_variable>
 #include <type_traits>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
 #include <array>
 #include <vector>
+#include <functional>
+#include <iterator>
 #include <glibmm/ustring.h>
 #include <gtkmm/liststore.h>
 #include <gtkmm/textbuffer.h>
@@ -110,6 +115,43 @@ struct CtLinkEntry
     }
 };
 
+// the rich text attributes, in the order of CtConst::TAG_PROPERTIES
+enum class CtTagAttr : int { Weight, Foreground, Background, Style, Underline, Strikethrough, Scale, Invisible, Family, Justification, Link, Indent, None };
+
+/**
+ * @brief Rich text attributes of a slot, one per CtConst::TAG_PROPERTIES, empty when not set
+ * Iterated as (tag property, value) pairs, in the order of CtConst::TAG_PROPERTIES
+ */
+class CtCurrAttributes
+{
+public:
+    using Pair = std::pair<std::string_view, std::string>;
+    static constexpr size_t Size{static_cast<size_t>(CtTagAttr::None)};
+    static_assert(Size == std::tuple_size<decltype(CtConst::TAG_PROPERTIES)>::value);
+
+    CtCurrAttributes() {
+        for (size_t i = 0; i < Size; ++i) _attrs[i].first = CtConst::TAG_PROPERTIES[i];
+    }
+    std::string&       operator[](const CtTagAttr attr) { return _attrs[static_cast<size_t>(attr)].second; }
+    const std::string& operator[](const CtTagAttr attr) const { return _attrs[static_cast<size_t>(attr)].second; }
+    std::string&       operator[](const size_t idx) { return _attrs[idx].second; }
+    const std::string& operator[](const size_t idx) const { return _attrs[idx].second; }
+    // throws std::out_of_range if tag_property is not one of CtConst::TAG_PROPERTIES
+    const std::string& at(const std::string_view tag_property) const {
+        for (const Pair& attr : _attrs) {
+            if (attr.first == tag_property) return attr.second;
+        }
+        throw std::out_of_range{"unexp tag property " + std::string{tag_property}};
+    }
+    void clear() { for (Pair& attr : _attrs) attr.second.clear(); }
+
+    std::array<Pair, Size>::const_iterator begin() const { return _attrs.cbegin(); }
+    std::array<Pair, Size>::const_iterator end() const { return _attrs.cend(); }
+
+private:
+    std::array<Pair, Size> _attrs;
+};
+
 struct CtListInfo
 {
     CtListType type{CtListType::None};
@@ -179,6 +221,44 @@ private:
     }
 };
 
+// keys in least recently used order, with the sum of their sizes for a memory limit
+template<class KEY>
+class CtSizedLru
+{
+public:
+    void touch(const KEY& key, const size_t bytes)
+    {
+        remove(key);
+        _elements.emplace_back(key, bytes);
+        _index[key] = std::prev(_elements.end());
+        _bytes += bytes;
+    }
+    void remove(const KEY& key)
+    {
+        const auto it = _index.find(key);
+        if (_index.end() != it) {
+            _bytes -= it->second->second;
+            _elements.erase(it->second);
+            _index.erase(it);
+        }
+    }
+    bool   contains(const KEY& key) const { return 0u != _index.count(key); }
+    size_t size() const { return _elements.size(); }
+    size_t get_bytes() const { return _bytes; }
+    // least recently used first
+    std::vector<KEY> get_keys() const
+    {
+        std::vector<KEY> keys;
+        keys.reserve(_elements.size());
+        for (const auto& element : _elements) keys.push_back(element.first);
+        return keys;
+    }
+private:
+    std::list<std::pair<KEY, size_t>> _elements; // least recently used first
+    std::unordered_map<KEY, typename std::list<std::pair<KEY, size_t>>::iterator> _index;
+    size_t _bytes{0};
+};
+
 struct CtScalableTag
 {
     const std::string sep{";"};
@@ -303,16 +383,27 @@ struct CtStorageSyncPending
     std::unordered_set<gint64>                     nodes_to_rm_set;
 };
 
+// the body of a node read and decoded off the main thread, without any toolkit object
+struct CtPrefetchedBody
+{
+    bool        isRichText{false};
+    std::string data; // CtRichTextBin body for rich text, the text otherwise
+};
+// runs on a worker thread, false if the body can not be prefetched
+using CtPrefetchedBodyReader = std::function<bool(CtPrefetchedBody&)>;
+
 enum class CtBackupType { None, SingleFile, MultiFile };
 struct CtBackupEncryptData
 {
     CtBackupType backupType;
     bool needEncrypt;
+    bool isEncrypted; // also when encrypted in memory, without an extracted copy to check
     std::string main_backup;
     std::string file_path;
     std::string password;
     std::string extracted_copy;
     time_t* p_mod_time;
+    std::function<bool()> f_write; // write the document snapshot before encrypt/backup, false on failure
 };
 
 struct CtStockIcon
@@ -335,6 +426,7 @@ struct CtExportOptions
     bool new_node_page{false};
     bool index_in_page{true};
     bool single_file{false};
+    bool dedup_assets{false}; // images and embedded files named after their sha256sum, written once
 };
 
 struct CtSummaryInfo
@@ -30,6 +30,7 @@
 #include <sqlite3.h>
 
 #include <unordered_map>
+#include <functional>
 #include <memory>
 
 class CtMDParser;
@@ -50,6 +51,7 @@ protected:
 class CtMainWin;
 class CtAnchoredWidgetState;
 class CtStorageCache;
+class CtSqliteStmtCache;
 
 #if GTKMM_MAJOR_VERSION >= 4
 class CtAnchoredWidget : public Gtk::Frame
@@ -67,7 +69,7 @@ public:
     virtual void apply_width_height(const int parentTextWidth) = 0;
     virtual void apply_syntax_highlighting(const bool forceReApply) = 0;
     virtual void to_xml(xmlpp::Element* p_node_parent, const int offset_adjustment, CtStorageCache* cache, const std::string& multifile_dir) = 0;
-    virtual bool to_sqlite(sqlite3* pDb, const gint64 node_id, const int offset_adjustment, CtStorageCache* cache) = 0;
+    virtual bool to_sqlite(CtSqliteStmtCache* pStmtCache, const gint64 node_id, const int offset_adjustment, CtStorageCache* cache) = 0;
     virtual void set_modified_false() = 0;
     virtual CtAnchWidgType get_type() const = 0;
     virtual std::shared_ptr<CtAnchoredWidgetState> get_state() = 0;
@@ -120,7 +122,7 @@ public:
     void to_xml(xmlpp::Element*/*p_node_parent*/, const int/*offset_adjustment*/, CtStorageCache*/*cache*/, const std::string&/*multifile_dir*/) override {
         spdlog::warn("!! {} UNEXP", __FUNCTION__);
     }
-    bool to_sqlite(sqlite3*/*pDb*/, const gint64/*node_id*/, const int/*offset_adjustment*/, CtStorageCache*/*cache*/) override {
+    bool to_sqlite(CtSqliteStmtCache*/*pStmtCache*/, const gint64/*node_id*/, const int/*offset_adjustment*/, CtStorageCache*/*cache*/) override {
         spdlog::warn("!! {} UNEXP", __FUNCTION__);
         return false;
     }
@@ -179,6 +181,23 @@ private:
 #endif /* GTKMM_MAJOR_VERSION < 4 && !defined(GTKMM_DISABLE_DEPRECATED) */
 
 class CtTreeIter;
+class CtSearchIndex;
+/**
+ * @brief Data of a save snapshotted on the UI thread, written to disk by the backup/encrypt worker thread
+ */
+class CtStorageWriter
+{
+public:
+    virtual ~CtStorageWriter() = default;
+
+    virtual size_t get_num_steps() const = 0;
+    /**
+     * @brief Write the snapshot, throws on failure leaving the document as before the write
+     * @param f_progress: called with the number of steps done so far
+     */
+    virtual void write(const std::function<void(const size_t)>& f_progress) = 0;
+};
+
 class CtStorageEntity
 {
 public:
@@ -198,14 +217,41 @@ public:
                                 const std::map<gint64, gint64>* pExpoMasterReassign = nullptr,
                                 const int start_offset = 0,
                                 const int end_offset = -1) = 0;
+    /**
+     * @brief Snapshot on the UI thread what save_treestore() would write for a plain save
+     * @return nullptr if the storage can only save synchronously through save_treestore()
+     */
+    virtual std::unique_ptr<CtStorageWriter> save_treestore_snapshot(const fs::path&/*file_path*/,
+                                                                    const CtStorageSyncPending&/*syncPending*/) { return nullptr; }
     virtual void vacuum() = 0;
+    /**
+     * @brief The last written document was moved, i.e. to the main backup, before the next save
+     */
+    virtual void doc_moved(const fs::path&/*new_file_path*/) {}
     virtual void import_nodes(const fs::path& path, const Gtk::TreeModel::iterator& parent_iter) = 0;
 
+    /**
+     * @brief The text buffer of a node not loaded yet, built from pPrefetchedBody if not null
+     */
     virtual Glib::RefPtr<Gtk::TextBuffer> get_delayed_text_buffer(const gint64 node_id,
                                                                   const std::string& syntax,
-                                                                  std::list<CtAnchoredWidget*>& widgets) const = 0;
+                                                                  std::list<CtAnchoredWidget*>& widgets,
+                                                                  const CtPrefetchedBody* pPrefetchedBody) const = 0;
+    /**
+     * @brief The loaded text buffer of an unmodified node is dropped, get_delayed_text_buffer() loads it again
+     * @return false if the node can not be loaded again from the document
+     */
+    virtual bool release_text_buffer(const gint64/*node_id*/) { return false; }
+    /**
+     * @brief A reader of the stored body of a node not loaded yet, to run on a worker thread
+     * @return an empty function if the body can not be read off the main thread
+     */
+    virtual CtPrefetchedBodyReader get_body_reader(const gint64/*node_id*/, const bool/*isRichText*/) const { return {}; }
     virtual fs::path get_embedded_filepath(const CtTreeIter& ct_tree_iter, const std::string& filename) const = 0;
 
+    virtual void search_index_load(CtSearchIndex&/*searchIndex*/) {}
+    virtual void search_index_save(const CtSearchIndex&/*searchIndex*/) {}
+
     void set_is_dry_run() { _isDryRun = true; }
 
 protected:
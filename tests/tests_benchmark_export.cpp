@@ -0,0 +1,136 @@
+/*
+ * tests_benchmark_export.cpp
+ *
+ * Copyright 2009-2026
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "ct_main_win.h"
+#include "ct_export2html.h"
+#include "ct_export2pdf.h"
+#include "ct_misc_utils.h"
+#include "tests_common.h"
+
+namespace {
+
+constexpr int BenchNumFunctions{2000};
+
+Glib::ustring create_large_source()
+{
+    Glib::ustring source{"#include <string>\n#include <vector>\n\n"};
+    for (int i = 0; i < BenchNumFunctions; ++i) {
+        const std::string num = std::to_string(i);
+        source += "// function number " + num + " <of> the \"benchmark\"\n"
+                  "static int function_" + num + "(const std::vector<int>& values, const char* pName)\n"
+                  "{\n"
+                  "\tint sum{" + num + "};\n"
+                  "\tfor (const int value : values) {\n"
+                  "\t\tif (value > 0x" + num + " && pName != nullptr) sum += value * 3.14;\n"
+                  "\t}\n"
+                  "\treturn sum; /* done */\n"
+                  "}\n\n";
+    }
+    return source;
+}
+
+// the exporter before the tag runs, a character at a time
+Glib::ustring html_from_code_buffer_per_char(const Glib::RefPtr<Gtk::TextBuffer>& code_buffer)
+{
+    Gtk::TextIter curr_iter = code_buffer->begin();
+    Glib::ustring html_text;
+    Glib::ustring former_tag_str = CtConst::COLOR_48_BLACK;
+    bool span_opened = false;
+    for (;;) {
+        std::vector<Glib::RefPtr<Gtk::TextTag>> curr_tags = curr_iter.get_tags();
+        if (curr_tags.size() > 0) {
+            Glib::ustring curr_tag_str{CtConst::COLOR_48_BLACK};
+            int font_weight = curr_tags[0]->property_weight().get_value();
+            for (auto& curr_tag : curr_tags) {
+                if (curr_tag->property_foreground_set()) {
+                    Glib::ustring tmpTagStr = curr_tag->property_foreground_rgba().get_value().to_string();
+                    if (tmpTagStr != curr_tag_str) {
+                        curr_tag_str = tmpTagStr;
+                        font_weight = curr_tag->property_weight().get_value();
+                        break;
+                    }
+                }
+            }
+            if (curr_tag_str == CtConst::COLOR_48_BLACK) {
+                if (former_tag_str != curr_tag_str) {
+                    former_tag_str = curr_tag_str;
+                    html_text += "</span>";
+                    span_opened = false;
+                }
+            }
+            else if (former_tag_str != curr_tag_str) {
+                former_tag_str = curr_tag_str;
+                if (span_opened) html_text += "</span>";
+                Glib::ustring color = CtRgbUtil::rgb_to_no_white(curr_tag_str);
+                color = CtRgbUtil::get_rgb24str_from_str_any(color);
+                html_text += "<span style=\"color:" + color + ";font-weight:" + std::to_string(font_weight) + "\">";
+                span_opened = true;
+            }
+        }
+        else if (span_opened) {
+            span_opened = false;
+            former_tag_str = CtConst::COLOR_48_BLACK;
+            html_text += "</span>";
+        }
+        html_text += str::xml_escape(Glib::ustring(1, curr_iter.get_char()));
+        if (not curr_iter.forward_char()) {
+            if (span_opened) html_text += "</span>";
+            break;
+        }
+    }
+    html_text = str::replace(html_text, CtConst::CHAR_NEWLINE, "<br />");
+    return "<pre>" + html_text + "</pre>";
+}
+
+} // namespace
+
+TEST(BenchmarkExportGroup, CodeBufferTagRuns)
+{
+    UT::run_on_window("_test_benchmark_export", [](CtMainWin* pWin, const std::string&/*tmp_dirpath*/){
+        const Glib::ustring source = create_large_source();
+        Glib::RefPtr<Gtk::TextBuffer> pTextBuffer = pWin->get_new_text_buffer(source);
+        pWin->apply_syntax_highlighting(pTextBuffer, "cpp", false/*forceReApply*/);
+        gtk_source_buffer_ensure_highlight(GTK_SOURCE_BUFFER(pTextBuffer->gobj()), pTextBuffer->begin().gobj(), pTextBuffer->end().gobj());
+
+        Glib::ustring htmlPerChar, htmlRuns, pangoRuns;
+        const double elapsedPerChar = UT::Bench::seconds([&](){
+            htmlPerChar = html_from_code_buffer_per_char(pTextBuffer);
+        });
+        const double elapsedHtml = UT::Bench::seconds([&](){
+            htmlRuns = CtExport2Html{pWin}.selection_export_to_html(pTextBuffer, pTextBuffer->begin(), pTextBuffer->end(), "cpp");
+        });
+        const double elapsedPango = UT::Bench::seconds([&](){
+            pangoRuns = CtExport2Pango{pWin}.pango_get_from_code_buffer(pTextBuffer, -1, -1, "cpp");
+        });
+        UT::Bench::report("code buffer of " + std::to_string(pTextBuffer->get_char_count()) + " chars to html per char in " +
+                          std::to_string(elapsedPerChar) + " s, by tag runs in " + std::to_string(elapsedHtml) +
+                          " s, to pango by tag runs in " + std::to_string(elapsedPango) + " s");
+
+        // same spans as a character at a time
+        ASSERT_NE(std::string::npos, htmlPerChar.find("<span style=\"color:"));
+        ASSERT_NE(std::string::npos, htmlRuns.find(htmlPerChar));
+        // the tabs at the start of the lines are spaces in pango
+        ASSERT_EQ(std::string::npos, pangoRuns.find("\t"));
+        ASSERT_NE(std::string::npos, pangoRuns.find("&lt;of&gt;"));
+    });
+}
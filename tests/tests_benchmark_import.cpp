@@ -0,0 +1,259 @@
+/*
+ * tests_benchmark_import.cpp
+ *
+ * Copyright 2009-2026
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "ct_imports.h"
+#include "ct_parser.h"
+#include "ct_config.h"
+#include "ct_filesystem.h"
+#include "tests_common.h"
+#include <glibmm.h>
+
+namespace {
+
+constexpr size_t BenchCorpusBytes{8u*1024u*1024u}; // for each of markdown and zim
+constexpr size_t BenchFileBytes{32u*1024u};
+
+using TokenStream = std::vector<std::pair<const CtTextParser::token_schema*, std::string>>;
+
+// the tokenizer before the string views, a copy of every token
+std::vector<std::string> copying_tokenize(const CtTextParser& textParser, const std::string& text)
+{
+    std::vector<std::string> tokens;
+    std::string::const_iterator last_pos = text.begin();
+    for (auto ch = text.begin(); ch != text.end(); ++ch) {
+        if (*ch == ' ') {
+            if (last_pos != ch) tokens.emplace_back(last_pos, ch);
+            last_pos = ch;
+            continue;
+        }
+        if (*ch == '\\') {
+            if (last_pos != ch) tokens.emplace_back(last_pos, ch);
+            ++ch;
+            last_pos = ch;
+            if (ch == text.end()) break;
+            continue;
+        }
+        auto pos_token = textParser.pos_tokens().find(*ch);
+        if (pos_token != textParser.pos_tokens().end()) {
+            std::string found_token;
+            for (const auto& opt : pos_token->second) {
+                std::string buff;
+                for (auto it = ch; it != text.end() && buff.size() < opt.size(); ++it) {
+                    buff += *it;
+                }
+                if (buff == opt && opt.size() > found_token.size()) found_token = std::string{opt};
+            }
+            if (not found_token.empty()) {
+                tokens.emplace_back(last_pos, ch);
+                tokens.emplace_back(found_token);
+                ch += found_token.length() - 1;
+                last_pos = ch + 1;
+            }
+        }
+    }
+    if (last_pos != text.end()) {
+        tokens.emplace_back(last_pos, text.end());
+    }
+    return tokens;
+}
+
+// the parser before the iterative one, recursing on a copy of the remaining tokens after a tag without close tag
+TokenStream recursive_parse_tokens(const CtTextParser& textParser, const std::vector<std::string>& tokens)
+{
+    TokenStream token_stream;
+    std::unordered_map<std::string_view, bool> open_tags;
+    std::pair<std::vector<const CtTextParser::token_schema*>, std::string> curr_open_tags;
+    bool keep_parsing = true;
+    int nb_open_tags = 0;
+    for (auto token = tokens.begin(); token != tokens.end(); ++token) {
+        if (token->empty()) continue;
+        auto tokens_iter = textParser.open_tokens_map().find(*token);
+        if (tokens_iter != textParser.open_tokens_map().end()) {
+            if (!curr_open_tags.first.empty() && !keep_parsing) {
+                if (tokens_iter->second->open_tag == curr_open_tags.first.front()->open_tag) ++nb_open_tags;
+            }
+            if (!(tokens_iter->second->is_symmetrical && open_tags[tokens_iter->first]) && keep_parsing) {
+                curr_open_tags.first.emplace_back(tokens_iter->second);
+                keep_parsing = !tokens_iter->second->capture_all;
+                if (!tokens_iter->second->has_closetag) {
+                    ++token;
+                    if (keep_parsing) {
+                        token_stream.emplace_back(tokens_iter->second, "");
+                        std::vector<std::string> rem_tokens(token, tokens.end());
+                        auto tokonised_stream = recursive_parse_tokens(textParser, rem_tokens);
+                        token_stream.insert(token_stream.end(), tokonised_stream.begin(), tokonised_stream.end());
+                    } else {
+                        std::string buff;
+                        for (; token != tokens.end(); ++token) buff += *token;
+                        token_stream.emplace_back(tokens_iter->second, buff);
+                    }
+                    return token_stream;
+                }
+                open_tags[tokens_iter->first] = true;
+                continue;
+            }
+        }
+        auto token_iter = textParser.close_tokens_map().find(*token);
+        if (token_iter != textParser.close_tokens_map().end()) {
+            if (curr_open_tags.first.empty()) {
+                token_stream.emplace_back(nullptr, *token);
+                continue;
+            }
+            if (!keep_parsing) {
+                if (curr_open_tags.first.front()->close_tag != *token) {
+                    curr_open_tags.second += *token;
+                    continue;
+                } else if (nb_open_tags > 1) {
+                    --nb_open_tags;
+                    curr_open_tags.second += *token;
+                    continue;
+                }
+            }
+            token_stream.emplace_back(curr_open_tags.first.front(), curr_open_tags.second);
+            for (size_t i = 1; i < curr_open_tags.first.size(); ++i) {
+                if (curr_open_tags.first[i]->open_tag != curr_open_tags.first.front()->open_tag) token_stream.emplace_back(curr_open_tags.first[i], "");
+            }
+            open_tags[token_iter->first] = false;
+            keep_parsing = true;
+            nb_open_tags = 0;
+            curr_open_tags.second.clear();
+            curr_open_tags.first.clear();
+        } else if (curr_open_tags.first.empty()) {
+            token_stream.emplace_back(nullptr, *token);
+        } else {
+            curr_open_tags.second += *token;
+        }
+    }
+    return token_stream;
+}
+
+// a markdown note: headers, lists, emphasis, links, code spans, tables and codeboxes
+std::string create_md_file(const size_t fileIdx)
+{
+    std::string text;
+    for (int line = 0; text.size() < BenchFileBytes; ++line) {
+        if (0 == line % 20) text += "## Section " + std::to_string(fileIdx) + "." + std::to_string(line) + "\n\n";
+        if (0 == line % 5) text += "* ";
+        else if (1 == line % 5) text += "- ";
+        text += "paragraph " + std::to_string(line) + " with **some bold words** and *italic* then ~~struck~~ and `code span`";
+        text += " before a [link](https://www.giuspen.net/cherrytree/) and an escaped \\* star\n";
+        if (0 == line % 30) text += "\n| one | two |\n| --- | --- |\n| a | b |\n\n";
+        if (15 == line % 30) text += "\n```cpp\nint main() { return 0; }\n```\n\n";
+    }
+    return text;
+}
+
+// a zim page: header, indented bullets, emphasis and links
+std::string create_zim_file(const size_t fileIdx)
+{
+    std::string text{"Content-Type: text/x-zim-wiki\nWiki-Format: zim 0.4\nCreation-Date: 2026-01-01T00:00:00+00:00\n\n"};
+    for (int line = 0; text.size() < BenchFileBytes; ++line) {
+        if (0 == line % 20) text += "===== Page " + std::to_string(fileIdx) + "." + std::to_string(line) + " =====\n";
+        text += std::string(static_cast<size_t>(line % 3), '\t');
+        if (0 == line % 2) text += "* ";
+        text += "line " + std::to_string(line) + " with **bold** and //italic// and __marked__ text, see https://www.giuspen.net/cherrytree/ for more\n";
+    }
+    return text;
+}
+
+} // namespace
+
+TEST(BenchmarkImportGroup, MarkdownAndZimImport)
+{
+    Glib::init();
+    gchar* pTmpDir = g_dir_make_tmp("ct_bench_import_XXXXXX", nullptr);
+    ASSERT_TRUE(pTmpDir);
+    const fs::path tmpDirpath{pTmpDir};
+    g_free(pTmpDir);
+
+    CtMDImport mdImport{CtConfig::GetCtConfig()};
+    CtZimImport zimImport{CtConfig::GetCtConfig()};
+    for (const bool isMd : {true, false}) {
+        std::vector<fs::path> filepaths;
+        for (size_t corpusBytes = 0; corpusBytes < BenchCorpusBytes; ) {
+            const std::string text = isMd ? create_md_file(filepaths.size()) : create_zim_file(filepaths.size());
+            filepaths.push_back(tmpDirpath / (std::to_string(filepaths.size()) + (isMd ? ".md" : ".txt")));
+            Glib::file_set_contents(filepaths.back().string(), text);
+            corpusBytes += text.size();
+        }
+
+        size_t readBytes{0};
+        const double secsRead = UT::Bench::seconds([&](){
+            for (const fs::path& filepath : filepaths) {
+                readBytes += Glib::file_get_contents(filepath.string()).size();
+            }
+        });
+        size_t numImported{0};
+        const double secsImport = UT::Bench::seconds([&](){
+            for (const fs::path& filepath : filepaths) {
+                std::unique_ptr<CtImportedNode> pImportedNode = isMd ? mdImport.import_file(filepath) : zimImport.import_file(filepath);
+                if (pImportedNode and pImportedNode->has_content()) ++numImported;
+            }
+        });
+        UT::Bench::report(std::string{isMd ? "markdown " : "zim "} + std::to_string(filepaths.size()) + " files of " + std::to_string(readBytes) +
+                          " bytes read in " + std::to_string(secsRead) + " s, imported in " + std::to_string(secsImport) + " s");
+        ASSERT_EQ(filepaths.size(), numImported);
+    }
+    (void)fs::remove_all(tmpDirpath);
+}
+
+TEST(BenchmarkImportGroup, TokenizeAndParseTokens)
+{
+    CtMDParser mdParser{CtConfig::GetCtConfig()};
+    const CtTextParser& textParser = *mdParser.text_parser();
+    std::vector<std::string> texts;
+    for (size_t corpusBytes = 0; corpusBytes < BenchCorpusBytes; corpusBytes += texts.back().size()) {
+        texts.push_back(create_md_file(texts.size()));
+    }
+    // a long line of tags without close tag, each one parsing the rest of the line
+    std::string zimLine;
+    for (int i = 0; i < 1000; ++i) zimLine += "\t* https://www.giuspen.net/" + std::to_string(i) + " ";
+    CtTextParser zimTextParser{std::vector<CtTextParser::token_schema>{
+        {"\t", false, false, [](const std::string&){}},
+        {"* ", false, false, [](const std::string&){}},
+        {"https://", false, false, [](const std::string&){}},
+        {"**", true, true, [](const std::string&){}}
+    }};
+
+    for (const bool isMd : {true, false}) {
+        const CtTextParser& currTextParser = isMd ? textParser : zimTextParser;
+        const std::vector<std::string> currTexts = isMd ? texts : std::vector<std::string>{zimLine};
+
+        std::vector<TokenStream> streamsCopying;
+        const double secsCopying = UT::Bench::seconds([&](){
+            for (const std::string& text : currTexts) {
+                streamsCopying.push_back(recursive_parse_tokens(currTextParser, copying_tokenize(currTextParser, text)));
+            }
+        });
+        std::vector<TokenStream> streamsViews;
+        const double secsViews = UT::Bench::seconds([&](){
+            for (const std::string& text : currTexts) {
+                streamsViews.push_back(currTextParser.parse_tokens(currTextParser.tokenize(text)));
+            }
+        });
+        UT::Bench::report(std::string{isMd ? "markdown corpus" : "zim long line"} + " tokens copied and recursive parse in " +
+                          std::to_string(secsCopying) + " s, string views and iterative parse in " + std::to_string(secsViews) + " s");
+        // the same token stream
+        ASSERT_EQ(streamsCopying, streamsViews);
+    }
+}
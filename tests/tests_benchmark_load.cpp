@@ -0,0 +1,61 @@
+/*
+ * tests_benchmark_load.cpp
+ *
+ * Copyright 2009-2026
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "ct_main_win.h"
+#include "tests_common.h"
+
+namespace {
+
+constexpr gint64 BenchNumNodes{20000};
+constexpr gint64 BenchChildrenPerNode{10};
+
+} // namespace
+
+TEST(BenchmarkLoadGroup, SqliteTreeLoad)
+{
+    UT::run_on_window("_test_benchmark_load", [](CtMainWin* pWin, const std::string& tmp_dirpath){
+        const fs::path doc_filepath = fs::path{tmp_dirpath} / "benchmark_load.ctb";
+        UT::Bench::create_synthetic_ctb(doc_filepath.string(), BenchNumNodes, BenchChildrenPerNode,
+            "<?xml version=\"1.0\" encoding=\"UTF-8\"?><node><rich_text>lorem ipsum dolor sit amet</rich_text></node>", {});
+
+        bool fileOpened{false};
+        const double elapsed = UT::Bench::seconds([&](){
+            fileOpened = pWin->file_open(doc_filepath, ""/*node_to_focus*/, ""/*anchor_to_focus*/);
+        });
+        ASSERT_TRUE(fileOpened);
+
+        gint64 numNodes{0};
+        pWin->get_tree_store().get_store()->foreach_iter([&numNodes](const Gtk::TreeModel::iterator&){
+            ++numNodes;
+            return false; /* continue */
+        });
+        ASSERT_EQ(BenchNumNodes, numNodes);
+        CtTreeIter ctTreeIter = pWin->get_tree_store().get_node_from_node_id(BenchChildrenPerNode + 1);
+        ASSERT_TRUE(ctTreeIter);
+        ASSERT_EQ(1, ctTreeIter.parent().get_node_id());
+        ASSERT_STREQ("node 11", ctTreeIter.get_node_name().c_str());
+
+        UT::Bench::report("sqlite load " + std::to_string(numNodes) + " nodes in " + std::to_string(elapsed) + " s = " +
+                          std::to_string(static_cast<gint64>(numNodes / elapsed)) + " nodes/s");
+    });
+}
@@ -0,0 +1,70 @@
+/*
+ * tests_benchmark_rich_text.cpp
+ *
+ * Copyright 2009-2026
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "ct_main_win.h"
+#include "ct_rich_text_bin.h"
+#include "ct_storage_xml.h"
+#include "tests_common.h"
+
+// the equivalence of the slots is checked by tests_rich_text_slots.cpp, here only the timing
+TEST(BenchmarkRichTextGroup, SerializeByTagToggles)
+{
+    UT::run_on_window("_test_benchmark_rich_text", [](CtMainWin* pWin, const std::string&/*tmp_dirpath*/){
+        Glib::RefPtr<Gtk::TextBuffer> pTextBuffer = UT::create_formatted_buffer(pWin, 1024u*1024u);
+        const std::string textBytes = std::to_string(pTextBuffer->get_text().bytes());
+
+        for (const bool list_info : {false, true}) {
+            size_t numSlots{0};
+            const double elapsedPerChar = UT::Bench::seconds([&](){
+                (void)UT::rich_text_slots_per_char(pWin, pTextBuffer, list_info);
+            });
+            const double elapsedToggles = UT::Bench::seconds([&](){
+                numSlots = UT::rich_text_slots_by_toggles(pWin, pTextBuffer, list_info).size();
+            });
+            UT::Bench::report("rich text of " + textBytes + " bytes, list info " + std::to_string(list_info) + ", " +
+                              std::to_string(numSlots) + " slots per char in " + std::to_string(elapsedPerChar) +
+                              " s, by tag toggles in " + std::to_string(elapsedToggles) + " s");
+        }
+
+        xmlpp::Document xml_doc;
+        xmlpp::Element* p_node_elem = xml_doc.create_root_node("node");
+        const double elapsedXml = UT::Bench::seconds([&](){
+            CtStorageXmlHelper{pWin}.save_buffer_no_widgets_to_xml(p_node_elem, pTextBuffer, 0, -1, 'n');
+        });
+        UT::Bench::report("rich text of " + textBytes + " bytes to xml in " + std::to_string(elapsedXml) + " s");
+
+        // node switch, the buffer from the xml body against the one from the binary body
+        const std::string xml_body = xml_doc.write_to_string();
+        const std::string bin_body = CtRichTextBin::from_buffer(pWin->get_ct_config(), pTextBuffer, 0, -1);
+        Glib::RefPtr<Gtk::TextBuffer> pXmlBuffer, pBinBuffer;
+        const double elapsedFromXml = UT::Bench::seconds([&](){
+            pXmlBuffer = CtStorageXmlHelper{pWin}.create_buffer_no_widgets(CtConst::RICH_TEXT_ID, xml_body.c_str());
+        });
+        const double elapsedFromBin = UT::Bench::seconds([&](){
+            pBinBuffer = CtRichTextBin::create_buffer(pWin, bin_body);
+        });
+        UT::Bench::report("rich text of " + textBytes + " bytes, buffer from xml of " + std::to_string(xml_body.size()) +
+                          " bytes in " + std::to_string(elapsedFromXml) + " s, from binary of " + std::to_string(bin_body.size()) +
+                          " bytes in " + std::to_string(elapsedFromBin) + " s");
+    });
+}
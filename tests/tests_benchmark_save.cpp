@@ -0,0 +1,121 @@
+/*
+ * tests_benchmark_save.cpp
+ *
+ * Copyright 2009-2026
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "ct_main_win.h"
+#include "ct_image.h"
+#include "ct_misc_utils.h"
+#include "ct_storage_control.h"
+#include "tests_common.h"
+#include <random>
+
+namespace {
+
+constexpr gint64 BenchNumImages{40};
+constexpr int BenchImageWidth{1280};
+constexpr int BenchImageHeight{800};
+
+// a screenshot like png: flat areas with some noise
+std::string create_png_blob(std::mt19937& randGen)
+{
+    Glib::RefPtr<Gdk::Pixbuf> rPixbuf = Gdk::Pixbuf::create(Gdk::COLORSPACE_RGB, false/*has_alpha*/, 8, BenchImageWidth, BenchImageHeight);
+    const int rowstride = rPixbuf->get_rowstride();
+    guint8* pPixels = rPixbuf->get_pixels();
+    for (int y = 0; y < BenchImageHeight; ++y) {
+        for (int x = 0; x < BenchImageWidth; ++x) {
+            guint8* pPixel = pPixels + y * rowstride + x * 3;
+            const bool noisy = (y / 40) % 3 == 0;
+            pPixel[0] = noisy ? static_cast<guint8>(randGen()) : static_cast<guint8>(x / 8);
+            pPixel[1] = noisy ? static_cast<guint8>(randGen()) : static_cast<guint8>(y / 8);
+            pPixel[2] = 200;
+        }
+    }
+    g_autofree gchar* pBuffer{NULL};
+    gsize buffer_size;
+    rPixbuf->save_to_buffer(pBuffer, buffer_size, "png");
+    return std::string(pBuffer, buffer_size);
+}
+
+} // namespace
+
+TEST(BenchmarkSaveGroup, ImagesKeepPngSave)
+{
+    UT::run_on_window("_test_benchmark_save", [](CtMainWin* pWin, const std::string& tmp_dirpath){
+        const fs::path doc_filepath = fs::path{tmp_dirpath} / "benchmark_save.ctb";
+        std::vector<std::string> pngBlobs;
+        std::mt19937 randGen{1234u};
+        for (gint64 i = 0; i < BenchNumImages; ++i) {
+            pngBlobs.push_back(create_png_blob(randGen));
+        }
+        UT::Bench::create_synthetic_ctb(doc_filepath.string(), BenchNumImages, BenchNumImages/*all top level*/,
+            "<?xml version=\"1.0\" encoding=\"UTF-8\"?><node><rich_text>screenshot below\n</rich_text></node>", pngBlobs);
+
+        ASSERT_TRUE(pWin->file_open(doc_filepath, ""/*node_to_focus*/, ""/*anchor_to_focus*/));
+        // load all the images upfront, only the save is measured
+        std::vector<CtImagePng*> images;
+        pWin->get_tree_store().get_store()->foreach_iter([&](const Gtk::TreeModel::iterator& iter){
+            CtTreeIter ctTreeIter = pWin->get_tree_store().to_ct_tree_iter(iter);
+            (void)ctTreeIter.get_node_text_buffer();
+            for (CtAnchoredWidget* pAnchWidg : ctTreeIter.get_anchored_widgets_fast()) {
+                if (auto pImagePng = dynamic_cast<CtImagePng*>(pAnchWidg)) {
+                    images.push_back(pImagePng);
+                }
+            }
+            return false; /* continue */
+        });
+        ASSERT_EQ(BenchNumImages, static_cast<gint64>(images.size()));
+
+        // what every save cost before, encoding again all the pixbufs
+        const double elapsedEncode = UT::Bench::seconds([&](){
+            for (CtImagePng* pImagePng : images) {
+                g_autofree gchar* pBuffer{NULL};
+                gsize buffer_size;
+                pImagePng->get_pixbuf()->save_to_buffer(pBuffer, buffer_size, "png");
+            }
+        });
+
+        for (const char* docExt : {".ctb", ".ctd"}) {
+            const fs::path saved_filepath = fs::path{tmp_dirpath} / (std::string{"benchmark_save_as"} + docExt);
+            (void)g_remove(saved_filepath.c_str());
+            Glib::ustring error;
+            std::unique_ptr<CtStorageControl> uStorage;
+            const double elapsedSave = UT::Bench::seconds([&](){
+                uStorage.reset(CtStorageControl::save_as(pWin,
+                                                         saved_filepath,
+                                                         fs::get_doc_type_from_file_ext(saved_filepath),
+                                                         ""/*password*/,
+                                                         error,
+                                                         CtExporting::NONESAVEAS));
+            });
+            ASSERT_TRUE(uStorage) << error.raw();
+            UT::Bench::report(std::string{"save "} + docExt + " with " + std::to_string(images.size()) + " images in " +
+                              std::to_string(elapsedSave) + " s, png encoding alone was " + std::to_string(elapsedEncode) + " s");
+        }
+
+        // the bytes written are the ones loaded
+        for (size_t i = 0; i < images.size(); ++i) {
+            ASSERT_EQ(pngBlobs.at(i), images.at(i)->get_raw_blob());
+        }
+        const std::string savedXml = Glib::file_get_contents((fs::path{tmp_dirpath} / "benchmark_save_as.ctd").string());
+        ASSERT_NE(std::string::npos, savedXml.find(Glib::Base64::encode(pngBlobs.front())));
+    });
+}
@@ -0,0 +1,101 @@
+/*
+ * tests_benchmark_thread_pool.cpp
+ *
+ * Copyright 2009-2026
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "ct_misc_utils.h"
+#include "tests_common.h"
+#include <future>
+#include <list>
+
+namespace {
+
+// the implementation CtThreadPool replaced: a thread per slice at every call
+void spawning_parallel_for(size_t first, size_t last, std::function<void(size_t)> f)
+{
+    size_t concur_num = std::thread::hardware_concurrency();
+    if (concur_num == 0) concur_num = 4;
+    if (first == last) return;
+    if (last < first) return;
+    if (last - first < concur_num) // to make slice calc simpler
+        concur_num = last - first;
+    size_t slice_item_num = (last - first) / concur_num;
+    size_t slice_leftover = (last - first) % concur_num;
+
+    std::list<std::thread> td_tasks;
+    size_t td_first = first;
+    for  (size_t thread_index = 0; thread_index < concur_num; ++thread_index)
+    {
+        std::packaged_task<void(size_t, size_t)> task([f](size_t slice_start, size_t slice_end)
+        {
+            for (size_t index = slice_start; index < slice_end; ++index)
+                f(index);
+        });
+        size_t td_last = td_first + slice_item_num;
+        if (slice_leftover > 0) {
+            ++td_last;
+            --slice_leftover;
+        }
+        td_tasks.emplace_back(std::move(task), td_first, td_last);
+        td_first = td_last;
+    }
+    for (auto& td_task : td_tasks)
+        td_task.join();
+}
+
+// uneven items, the cost grows with the index like big and small images in a document
+uint64_t bench_work(const size_t index)
+{
+    uint64_t hash{14695981039346656037ull};
+    for (size_t i = 0; i < 200u + index * 20u; ++i) {
+        hash = (hash ^ i) * 1099511628211ull;
+    }
+    return hash;
+}
+
+template<typename F_PARALLEL_FOR>
+double bench_parallel_for(F_PARALLEL_FOR f_parallel_for, const size_t num_calls, const size_t num_items, uint64_t& checksum)
+{
+    std::vector<uint64_t> results(num_items);
+    return UT::Bench::seconds([&](){
+        for (size_t call = 0; call < num_calls; ++call) {
+            f_parallel_for(0, num_items, [&results](size_t index){ results[index] = bench_work(index); });
+            for (const uint64_t result : results) {
+                checksum ^= result;
+            }
+        }
+    });
+}
+
+} // namespace
+
+TEST(BenchmarkThreadPoolGroup, ParallelForVsThreadSpawn)
+{
+    for (const auto& [numCalls, numItems] : std::vector<std::pair<size_t, size_t>>{{2000, 16}, {200, 512}, {10, 20000}}) {
+        uint64_t checksumSpawn{0};
+        uint64_t checksumPool{0};
+        const double elapsedSpawn = bench_parallel_for(spawning_parallel_for, numCalls, numItems, checksumSpawn);
+        const double elapsedPool = bench_parallel_for(CtMiscUtil::parallel_for, numCalls, numItems, checksumPool);
+        ASSERT_EQ(checksumSpawn, checksumPool);
+        UT::Bench::report("parallel_for " + std::to_string(numCalls) + " x " + std::to_string(numItems) + " items: thread spawn " +
+                          std::to_string(elapsedSpawn) + " s, thread pool " + std::to_string(elapsedPool) + " s");
+    }
+}
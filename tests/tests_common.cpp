@@ -0,0 +1,290 @@
+/*
+ * tests_common.cpp
+ *
+ * Copyright 2009-2026
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "ct_app.h"
+#include "ct_main_win.h"
+#include "ct_list.h"
+#include "ct_misc_utils.h"
+#include "ct_storage_sqlite.h"
+#include "tests_common.h"
+#include <chrono>
+#include <iostream>
+
+namespace {
+
+class WindowCtApp : public CtApp
+{
+public:
+    WindowCtApp(const std::string& app_id_postfix, const std::function<void(CtMainWin*, const std::string&)>& f)
+#if GTKMM_MAJOR_VERSION >= 4
+     : CtApp{app_id_postfix, Gio::Application::Flags::NON_UNIQUE}
+#else
+     : CtApp{app_id_postfix, Gio::APPLICATION_NON_UNIQUE}
+#endif
+     , _f{f}
+    {
+        _no_gui = true;
+    }
+
+private:
+    void on_activate() final
+    {
+        _on_startup();
+        CtMainWin* pWin = _create_window(true/*start_hidden*/);
+        _f(pWin, _uCtTmp->getHiddenDirPath("UT").string());
+        pWin->force_exit() = true;
+        remove_window(*pWin);
+    }
+
+    const std::function<void(CtMainWin*, const std::string&)> _f;
+};
+
+std::string slot_to_str(const CtCurrAttributes& curr_attributes, const CtListInfo* pCurrListInfo, Gtk::TextIter& start_iter, Gtk::TextIter& end_iter)
+{
+    std::string slot;
+    for (const auto& currPair : curr_attributes) {
+        slot += std::string{currPair.first} + "=" + currPair.second + ";";
+    }
+    slot += std::to_string(static_cast<int>(pCurrListInfo->type)) + "," + std::to_string(pCurrListInfo->level) + "|";
+    return slot + start_iter.get_text(end_iter).raw();
+}
+
+} // namespace
+
+void UT::run_on_window(const std::string& app_id_postfix, const std::function<void(CtMainWin*, const std::string&)>& f)
+{
+    const std::vector<std::string> vec_args{"cherrytree"};
+    gchar** pp_args = CtStrUtil::vector_to_array(vec_args);
+    WindowCtApp windowCtApp{app_id_postfix, f};
+    windowCtApp.run(vec_args.size(), pp_args);
+    g_strfreev(pp_args);
+}
+
+Glib::RefPtr<Gtk::TextBuffer> UT::create_formatted_buffer(CtMainWin* pWin, const size_t textBytes)
+{
+    struct TagRange
+    {
+        std::string propertyName;
+        std::string propertyValue;
+        int         startOffset;
+        int         endOffset;
+    };
+    std::vector<TagRange> tagRanges;
+    Glib::ustring text;
+    int offset{0};
+    auto f_append = [&](const Glib::ustring& chunk, const char* propertyName = nullptr, const std::string& propertyValue = ""){
+        if (propertyName) tagRanges.push_back(TagRange{propertyName, propertyValue, offset, offset + static_cast<int>(chunk.size())});
+        text += chunk;
+        offset += static_cast<int>(chunk.size());
+    };
+    for (int line = 0; text.bytes() < textBytes; ++line) {
+        const int lineStart = offset;
+        if (0 == line % 4) f_append("• ");
+        f_append("paragraph " + std::to_string(line) + " with ");
+        f_append("some bold words", CtConst::TAG_WEIGHT, CtConst::TAG_PROP_VAL_HEAVY);
+        f_append(" and a ");
+        f_append("coloured one", CtConst::TAG_FOREGROUND, 0 == line % 2 ? "#ffff00000000" : "#00000000ffff");
+        f_append(" then ");
+        f_append("italic text", CtConst::TAG_STYLE, CtConst::TAG_PROP_VAL_ITALIC);
+        f_append(" before a ");
+        f_append("link", CtConst::TAG_LINK, "webs https://www.giuspen.net/cherrytree/");
+        f_append(" to serialize\n");
+        if (0 == line % 10) tagRanges.push_back(TagRange{CtConst::TAG_SCALE, CtConst::TAG_PROP_VAL_H2, lineStart, offset});
+        if (0 == line % 7) tagRanges.push_back(TagRange{CtConst::TAG_INDENT, "1", lineStart, offset});
+    }
+    Glib::RefPtr<Gtk::TextBuffer> pTextBuffer = pWin->get_new_text_buffer(text);
+    for (const TagRange& tagRange : tagRanges) {
+        pTextBuffer->apply_tag_by_name(pWin->get_text_tag_name_exist_or_create(tagRange.propertyName, tagRange.propertyValue),
+                                       pTextBuffer->get_iter_at_offset(tagRange.startOffset),
+                                       pTextBuffer->get_iter_at_offset(tagRange.endOffset));
+    }
+    return pTextBuffer;
+}
+
+std::vector<std::string> UT::rich_text_slots_per_char(CtMainWin* pWin, const Glib::RefPtr<Gtk::TextBuffer>& pTextBuffer, const bool list_info)
+{
+    const std::array<std::pair<const Glib::ustring*, CtTagAttr>, CtCurrAttributes::Size> prefixes{{
+        {&CtConst::TAG_WEIGHT_PREFIX, CtTagAttr::Weight},
+        {&CtConst::TAG_FOREGROUND_PREFIX, CtTagAttr::Foreground},
+        {&CtConst::TAG_BACKGROUND_PREFIX, CtTagAttr::Background},
+        {&CtConst::TAG_STYLE_PREFIX, CtTagAttr::Style},
+        {&CtConst::TAG_UNDERLINE_PREFIX, CtTagAttr::Underline},
+        {&CtConst::TAG_STRIKETHROUGH_PREFIX, CtTagAttr::Strikethrough},
+        {&CtConst::TAG_SCALE_PREFIX, CtTagAttr::Scale},
+        {&CtConst::TAG_INVISIBLE_PREFIX, CtTagAttr::Invisible},
+        {&CtConst::TAG_FAMILY_PREFIX, CtTagAttr::Family},
+        {&CtConst::TAG_JUSTIFICATION_PREFIX, CtTagAttr::Justification},
+        {&CtConst::TAG_LINK_PREFIX, CtTagAttr::Link},
+        {&CtConst::TAG_INDENT_PREFIX, CtTagAttr::Indent},
+    }};
+    std::unordered_map<CtTagAttr, std::string> delta_attributes;
+    auto f_attributes_update = [&](const Gtk::TextIter& text_iter, const CtCurrAttributes& curr_attributes)->bool{
+        delta_attributes.clear();
+        for (const bool toggled_on : {false, true}) {
+            for (const auto& r_curr_tag : text_iter.get_toggled_tags(toggled_on)) {
+                const Glib::ustring tag_name = r_curr_tag->property_name();
+                if (tag_name.empty() or CtConst::GTKSPELLCHECK_TAG_NAME == tag_name) {
+                    continue;
+                }
+                for (const auto& prefix : prefixes) {
+                    if (str::startswith(tag_name, *prefix.first)) {
+                        delta_attributes[prefix.second] = toggled_on ? tag_name.substr(prefix.first->size()).raw() : "";
+                        break;
+                    }
+                }
+            }
+        }
+        for (const auto& currDelta : delta_attributes) {
+            if (curr_attributes[currDelta.first] != currDelta.second) return true;
+        }
+        return false;
+    };
+    std::vector<std::string> slots;
+    CtCurrAttributes curr_attributes;
+    CtListInfo curr_list_info;
+    Gtk::TextIter curr_start_iter = pTextBuffer->begin();
+    Gtk::TextIter curr_end_iter = curr_start_iter;
+    if (f_attributes_update(curr_end_iter, curr_attributes)) {
+        for (const auto& currDelta : delta_attributes) curr_attributes[currDelta.first] = currDelta.second;
+    }
+    bool last_was_newline{true};
+    while (curr_end_iter.forward_char()) {
+        if (curr_end_iter.is_end()) {
+            break;
+        }
+        if (list_info and last_was_newline) {
+            curr_list_info = CtList{pWin->get_ct_config(), pTextBuffer}.get_paragraph_list_info(curr_end_iter);
+        }
+        last_was_newline = '\n' == curr_end_iter.get_char();
+        if (f_attributes_update(curr_end_iter, curr_attributes) or (list_info and last_was_newline)) {
+            slots.push_back(slot_to_str(curr_attributes, &curr_list_info, curr_start_iter, curr_end_iter));
+            for (const auto& currDelta : delta_attributes) curr_attributes[currDelta.first] = currDelta.second;
+            curr_start_iter = curr_end_iter;
+        }
+    }
+    Gtk::TextIter real_end_iter = pTextBuffer->end();
+    if (curr_start_iter.compare(real_end_iter) < 0) {
+        slots.push_back(slot_to_str(curr_attributes, &curr_list_info, curr_start_iter, real_end_iter));
+    }
+    return slots;
+}
+
+std::vector<std::string> UT::rich_text_slots_by_toggles(CtMainWin* pWin, const Glib::RefPtr<Gtk::TextBuffer>& pTextBuffer, const bool list_info)
+{
+    std::vector<std::string> slots;
+    CtTextIterUtil::SerializeFunc f_slot = [&slots](Gtk::TextIter& start_iter,
+                                                    Gtk::TextIter& end_iter,
+                                                    CtCurrAttributes& curr_attributes,
+                                                    CtListInfo* pCurrListInfo)
+    {
+        slots.push_back(slot_to_str(curr_attributes, pCurrListInfo, start_iter, end_iter));
+    };
+    CtTextIterUtil::generic_process_slot(pWin->get_ct_config(), 0, -1, pTextBuffer, f_slot, list_info);
+    return slots;
+}
+
+double UT::Bench::seconds(const std::function<void()>& f)
+{
+    const auto timeStart = std::chrono::steady_clock::now();
+    f();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - timeStart;
+    return elapsed.count();
+}
+
+void UT::Bench::report(const std::string& line)
+{
+    std::cout << "[ BENCH    ] " << line << std::endl;
+}
+
+void UT::Bench::create_synthetic_ctb(const std::string& doc_filepath,
+                                     const gint64 numNodes,
+                                     const gint64 childrenPerNode,
+                                     const std::string& nodeXml,
+                                     const std::vector<std::string>& pngBlobs)
+{
+    (void)g_remove(doc_filepath.c_str());
+    sqlite3* pDb{nullptr};
+    ASSERT_EQ(SQLITE_OK, sqlite3_open(doc_filepath.c_str(), &pDb));
+    for (const char* sqlCreate : {CtStorageSqlite::TABLE_NODE_CREATE,
+                                  CtStorageSqlite::TABLE_CODEBOX_CREATE,
+                                  CtStorageSqlite::TABLE_TABLE_CREATE,
+                                  CtStorageSqlite::TABLE_IMAGE_CREATE,
+                                  CtStorageSqlite::TABLE_CHILDREN_CREATE,
+                                  CtStorageSqlite::TABLE_BOOKMARK_CREATE,
+                                  "BEGIN TRANSACTION"})
+    {
+        ASSERT_EQ(SQLITE_OK, sqlite3_exec(pDb, sqlCreate, nullptr, nullptr, nullptr));
+    }
+    sqlite3_stmt* pStmtNode{nullptr};
+    sqlite3_stmt* pStmtImage{nullptr};
+    sqlite3_stmt* pStmtChildren{nullptr};
+    ASSERT_EQ(SQLITE_OK, sqlite3_prepare_v2(pDb, CtStorageSqlite::TABLE_NODE_INSERT, -1, &pStmtNode, nullptr));
+    ASSERT_EQ(SQLITE_OK, sqlite3_prepare_v2(pDb, CtStorageSqlite::TABLE_IMAGE_INSERT, -1, &pStmtImage, nullptr));
+    ASSERT_EQ(SQLITE_OK, sqlite3_prepare_v2(pDb, CtStorageSqlite::TABLE_CHILDREN_INSERT, -1, &pStmtChildren, nullptr));
+    for (gint64 node_id = 1; node_id <= numNodes; ++node_id) {
+        // breadth first ids: with 10 children per node, nodes 1..10 are top level, then 11..20 are children of 1 and so on
+        const std::string name = "node " + std::to_string(node_id);
+        const bool hasImage = static_cast<size_t>(node_id) <= pngBlobs.size();
+        sqlite3_bind_int64(pStmtNode, 1, node_id);
+        sqlite3_bind_text(pStmtNode, 2, name.c_str(), name.size(), SQLITE_TRANSIENT);
+        sqlite3_bind_text(pStmtNode, 3, nodeXml.c_str(), nodeXml.size(), SQLITE_STATIC);
+        sqlite3_bind_text(pStmtNode, 4, "custom-colors", -1, SQLITE_STATIC);
+        sqlite3_bind_text(pStmtNode, 5, "", -1, SQLITE_STATIC);
+        sqlite3_bind_int64(pStmtNode, 6, 0);
+        sqlite3_bind_int64(pStmtNode, 7, 1);
+        sqlite3_bind_int64(pStmtNode, 8, 0);
+        sqlite3_bind_int64(pStmtNode, 9, 0);
+        sqlite3_bind_int64(pStmtNode, 10, hasImage ? 1 : 0);
+        sqlite3_bind_int64(pStmtNode, 11, 0);
+        sqlite3_bind_int64(pStmtNode, 12, 1700000000);
+        sqlite3_bind_int64(pStmtNode, 13, 1700000000);
+        ASSERT_EQ(SQLITE_DONE, sqlite3_step(pStmtNode));
+        sqlite3_reset(pStmtNode);
+
+        if (hasImage) {
+            const std::string& pngBlob = pngBlobs.at(node_id - 1);
+            sqlite3_bind_int64(pStmtImage, 1, node_id);
+            sqlite3_bind_int64(pStmtImage, 2, 17); // offset
+            sqlite3_bind_text(pStmtImage, 3, "left", -1, SQLITE_STATIC);
+            sqlite3_bind_text(pStmtImage, 4, "", -1, SQLITE_STATIC); // anchor
+            sqlite3_bind_blob(pStmtImage, 5, pngBlob.c_str(), pngBlob.size(), SQLITE_STATIC);
+            sqlite3_bind_text(pStmtImage, 6, "", -1, SQLITE_STATIC); // filename
+            sqlite3_bind_text(pStmtImage, 7, "", -1, SQLITE_STATIC); // link
+            sqlite3_bind_int64(pStmtImage, 8, 0);
+            ASSERT_EQ(SQLITE_DONE, sqlite3_step(pStmtImage));
+            sqlite3_reset(pStmtImage);
+        }
+
+        sqlite3_bind_int64(pStmtChildren, 1, node_id);
+        sqlite3_bind_int64(pStmtChildren, 2, (node_id - 1) / childrenPerNode);
+        sqlite3_bind_int64(pStmtChildren, 3, (node_id - 1) % childrenPerNode + 1);
+        sqlite3_bind_int64(pStmtChildren, 4, 0);
+        ASSERT_EQ(SQLITE_DONE, sqlite3_step(pStmtChildren));
+        sqlite3_reset(pStmtChildren);
+    }
+    sqlite3_finalize(pStmtNode);
+    sqlite3_finalize(pStmtImage);
+    sqlite3_finalize(pStmtChildren);
+    ASSERT_EQ(SQLITE_OK, sqlite3_exec(pDb, "COMMIT", nullptr, nullptr, nullptr));
+    sqlite3_close(pDb);
+}
@@ -29,8 +29,13 @@
 
 #include <string>
 #include <list>
+#include <vector>
+#include <functional>
 #include <glib/gstdio.h>
 #include <glibmm/miscutils.h>
+#include <gtkmm/textbuffer.h>
+
+class CtMainWin;
 
 #define _NL "\n"
 
@@ -59,4 +64,31 @@ const std::string testImageGif{Glib::build_filename(unitTestsDataDir, "testimage
 const std::string testImageWebp{Glib::build_filename(unitTestsDataDir, "testimage.webp")};
 const std::string testImageSvg{Glib::build_filename(_CMAKE_SOURCE_DIR, "icons", "cherrytree.svg")};
 
+// defined in tests_common.cpp, built by the targets with x and by run_benchmarks
+
+// runs f on a hidden window of a cherrytree app with no gui, tmp_dirpath is for the generated documents
+void run_on_window(const std::string& app_id_postfix, const std::function<void(CtMainWin* pWin, const std::string& tmp_dirpath)>& f);
+// a rich text buffer of about textBytes bytes with bullets, bold, italic, colours, links, headers and indents on every few lines
+Glib::RefPtr<Gtk::TextBuffer> create_formatted_buffer(CtMainWin* pWin, const size_t textBytes);
+// the serializer slots with their attributes, a character at a time with the tag names parsed at every position
+std::vector<std::string> rich_text_slots_per_char(CtMainWin* pWin, const Glib::RefPtr<Gtk::TextBuffer>& pTextBuffer, const bool list_info);
+// the same from CtTextIterUtil::generic_process_slot()
+std::vector<std::string> rich_text_slots_by_toggles(CtMainWin* pWin, const Glib::RefPtr<Gtk::TextBuffer>& pTextBuffer, const bool list_info);
+
+namespace Bench {
+
+// the seconds taken by f
+double seconds(const std::function<void()>& f);
+// a line of results, next to the gtest output
+void report(const std::string& line);
+// sqlite document of numNodes nodes with the same rich text, numbered breadth first with childrenPerNode
+// children per node (all top level if childrenPerNode >= numNodes); pngBlobs empty or with one image per node
+void create_synthetic_ctb(const std::string& doc_filepath,
+                          const gint64 numNodes,
+                          const gint64 childrenPerNode,
+                          const std::string& nodeXml,
+                          const std::vector<std::string>& pngBlobs);
+
+} // namespace Bench
+
 } // namespace UT
@@ -23,6 +23,7 @@
 
 #include "ct_app.h"
 #include "ct_misc_utils.h"
+#include "ct_export_headless.h"
 #include "tests_common.h"
 
 class TestCtApp : public CtApp
@@ -144,3 +145,29 @@ INSTANTIATE_TEST_CASE_P(
             std::make_tuple(UT::testCtdDocPath, "--export_to_html_dir"),
             std::make_tuple(UT::testMultiFileSourCherry, "--export_to_txt_dir"))
 );
+
+TEST(ExportsGroup, HeadlessTxtMultipleFiles)
+{
+    gchar* pTmpDir = g_dir_make_tmp("test_headless_XXXXXX", nullptr);
+    ASSERT_NE(nullptr, pTmpDir);
+    const fs::path tmpDirpath{pTmpDir};
+    g_free(pTmpDir);
+    const std::vector<fs::path> docPaths{UT::testCtbDocPath, UT::testCtdDocPath, UT::testCtzDocPath, UT::testCtxDocPath};
+    CtExportHeadless ctExportHeadless{CtConst::HORIZONTAL_RULE_DEFAULT, UT::testPassword};
+    for (const fs::path& docPath : docPaths) {
+        ASSERT_TRUE(ctExportHeadless.is_supported(docPath));
+    }
+    ASSERT_FALSE(ctExportHeadless.is_supported(UT::testMultiFilePath));
+    ASSERT_TRUE(ctExportHeadless.files_export_to_txt(docPaths, tmpDirpath, false/*overwrite*/, true/*single_file*/).empty());
+
+    const std::string expectTxt = Glib::file_get_contents(Glib::build_filename(UT::unitTestsDataDir, "test.export.txt"));
+    for (const fs::path& docPath : docPaths) {
+        const std::string resultTxt = Glib::file_get_contents((tmpDirpath / (docPath.filename().string() + ".txt")).string());
+#if defined(_WIN32)
+        ASSERT_STREQ(str::replace(expectTxt, "\n", "\r\n").c_str(), resultTxt.c_str());
+#else
+        ASSERT_STREQ(expectTxt.c_str(), resultTxt.c_str());
+#endif
+    }
+    (void)fs::remove_all(tmpDirpath);
+}
@@ -22,6 +22,7 @@
  */
 
 #include "ct_imports.h"
+#include "ct_parser.h"
 #include "ct_config.h"
 #include "ct_filesystem.h"
 #include "tests_common.h"
@@ -74,3 +75,112 @@ TEST(ImportsGroup, TomboyEmptyTagDoesNotCrash)
       ASSERT_STREQ("Harmless Meeting Note", importedNode->node_name.c_str());
     }
 }
+
+namespace {
+
+// the same markdown importer, without clones for the worker threads
+class SerialMDImport : public CtImporterInterface
+{
+public:
+    SerialMDImport() : _mdImport{CtConfig::GetCtConfig()} {}
+    std::unique_ptr<CtImportedNode> import_file(const fs::path& file) override { return _mdImport.import_file(file); }
+
+private:
+    CtMDImport _mdImport;
+};
+
+std::string imported_tree_to_str(const CtImportedNode* pNode)
+{
+    std::string str = pNode->node_name.raw() + (pNode->xml_content->get_root_node() ? "*" : "") + "(";
+    for (const auto& pChild : pNode->children) {
+        str += imported_tree_to_str(pChild.get()) + ",";
+    }
+    return str + ")";
+}
+
+} // namespace
+
+TEST(ImportsGroup, TraverseDirParallelAsSerial)
+{
+    Glib::init();
+    gchar* pTmpDir = g_dir_make_tmp("ct_test_import_XXXXXX", nullptr);
+    ASSERT_TRUE(pTmpDir);
+    const fs::path tmpDirpath{pTmpDir};
+    g_free(pTmpDir);
+    for (const std::string subdir : {"sub", "keep", "empty"}) {
+        ASSERT_EQ(0, g_mkdir_with_parents((tmpDirpath / subdir).c_str(), 0755));
+    }
+    for (const std::string filename : {"a.md", "b.md", "sub.md", "sub/c.md", "keep/keep.md", "keep/d.md", "keep/e.txt"}) {
+        Glib::file_set_contents((tmpDirpath / filename).string(), "# " + filename + "\ntext with **bold**\n");
+    }
+
+    CtMDImport mdImport{CtConfig::GetCtConfig()};
+    size_t lastFilesDone{0}, lastFilesTotal{0};
+    std::unique_ptr<CtImportedNode> pParallel = CtImports::traverse_dir(tmpDirpath, &mdImport, [&](const size_t files_done, const size_t files_total){
+        lastFilesDone = files_done;
+        lastFilesTotal = files_total;
+        return true;
+    });
+    SerialMDImport serialMdImport;
+    std::unique_ptr<CtImportedNode> pSerial = CtImports::traverse_dir(tmpDirpath, &serialMdImport);
+    ASSERT_TRUE(pParallel);
+    ASSERT_TRUE(pSerial);
+    ASSERT_EQ(7u, lastFilesTotal);
+    ASSERT_EQ(7u, lastFilesDone);
+    ASSERT_EQ(imported_tree_to_str(pSerial.get()), imported_tree_to_str(pParallel.get()));
+
+    // the note joins the dir with its name, the dir takes the content of the note with its name
+    const std::string treeStr = imported_tree_to_str(pParallel.get());
+    ASSERT_NE(std::string::npos, treeStr.find("sub*(c*,)"));
+    ASSERT_NE(std::string::npos, treeStr.find("keep*(d*,)"));
+    ASSERT_EQ(std::string::npos, treeStr.find("empty"));
+    ASSERT_EQ(4u, pParallel->children.size());
+
+    ASSERT_FALSE(CtImports::traverse_dir(tmpDirpath, &mdImport, [](const size_t, const size_t){ return false; }));
+
+    (void)fs::remove_all(tmpDirpath);
+}
+
+namespace {
+
+std::vector<std::string> tokens_to_strs(const std::vector<std::string_view>& tokens)
+{
+    return std::vector<std::string>(tokens.begin(), tokens.end());
+}
+
+// the open tag of each parsed token, empty for plain text, with its contents
+std::vector<std::pair<std::string, std::string>> token_stream_to_strs(const std::vector<std::pair<const CtTextParser::token_schema*, std::string>>& tokenStream)
+{
+    std::vector<std::pair<std::string, std::string>> strs;
+    for (const auto& token : tokenStream) {
+        strs.emplace_back(token.first ? token.first->open_tag : "", token.second);
+    }
+    return strs;
+}
+
+} // namespace
+
+TEST(ImportsGroup, TokenizeAndParseTokens)
+{
+    // markdown: symmetrical tags, a capture all tag with another tag inside and an escaped char
+    CtMDParser mdParser{CtConfig::GetCtConfig()};
+    const CtTextParser& mdTextParser = *mdParser.text_parser();
+    const std::string mdText{"**bo** `a*b` \\_x"};
+    const std::vector<std::string_view> mdTokens = mdTextParser.tokenize(mdText);
+    ASSERT_EQ((std::vector<std::string>{"", "**", "bo", "**", " ", "`", "a", "*", "b", "`", " ", "_x"}), tokens_to_strs(mdTokens));
+    ASSERT_EQ((std::vector<std::pair<std::string, std::string>>{{"**", "bo"}, {"", " "}, {"`", "a*b"}, {"", " "}, {"", "_x"}}),
+              token_stream_to_strs(mdTextParser.parse_tokens(mdTokens)));
+
+    // zim like: tags without close tag, each one parsing the rest of the line
+    CtTextParser zimTextParser{std::vector<CtTextParser::token_schema>{
+        {"\t", false, false, [](const std::string&){}},
+        {"* ", false, false, [](const std::string&){}},
+        {"https://", false, false, [](const std::string&){}},
+        {"**", true, true, [](const std::string&){}}
+    }};
+    const std::string zimText{"\t* https://x **b** y"};
+    const std::vector<std::string_view> zimTokens = zimTextParser.tokenize(zimText);
+    ASSERT_EQ((std::vector<std::string>{"", "\t", "", "* ", "", "https://", "x", " ", "**", "b", "**", " y"}), tokens_to_strs(zimTokens));
+    ASSERT_EQ((std::vector<std::pair<std::string, std::string>>{{"\t", ""}, {"* ", ""}, {"https://", ""}, {"", "x"}, {"", " "}, {"**", "b"}, {"", " y"}}),
+              token_stream_to_strs(zimTextParser.parse_tokens(zimTokens)));
+}
@@ -23,6 +23,7 @@
 
 #include "gtest/gtest.h"
 #include "ct_filesystem.h"
+#include <curl/curl.h>
 
 #ifdef _WIN32
 static void _glib_log_handler(const gchar*, GLogLevelFlags, const gchar*, gpointer)
@@ -36,6 +37,9 @@ int main(int argc, char** argv)
     g_log_set_default_handler(_glib_log_handler, NULL);
 #endif // _WIN32
     fs::register_exe_path_detect_if_portable(argv[0]);
+    curl_global_init(CURL_GLOBAL_ALL);
     ::testing::InitGoogleTest(&argc, argv);
-    return RUN_ALL_TESTS();
+    const int ret_val = RUN_ALL_TESTS();
+    curl_global_cleanup();
+    return ret_val;
 }
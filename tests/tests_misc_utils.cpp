@@ -608,6 +608,70 @@ TEST(MiscUtilsGroup, parallel_for)
         }
 }
 
+TEST(MiscUtilsGroup, thread_pool_task_group)
+{
+    CtThreadPool threadPool{4};
+    ASSERT_EQ(4u, threadPool.get_num_threads());
+
+    // nested groups, waiting inside a task must not starve the pool
+    std::atomic<size_t> numRun{0};
+    threadPool.parallel_for(0, 32, [&](size_t){
+        threadPool.parallel_for(0, 32, [&](size_t){ ++numRun; });
+    });
+    ASSERT_EQ(32u*32u, numRun);
+
+    // waiting from outside of the pool does not run the tasks on the waiting thread
+    const std::thread::id callerThreadId = std::this_thread::get_id();
+    std::atomic<bool> ranOnCaller{false};
+    threadPool.parallel_for(0, 256, [&](size_t){
+        if (std::this_thread::get_id() == callerThreadId) ranOnCaller = true;
+    });
+    ASSERT_FALSE(ranOnCaller);
+
+    // bounded concurrency
+    std::atomic<size_t> numRunning{0};
+    std::atomic<size_t> maxRunning{0};
+    {
+        CtThreadPool::TaskGroup taskGroup{threadPool, 2/*max_concurrency*/};
+        for (int i = 0; i < 40; ++i) {
+            taskGroup.run([&](){
+                const size_t running = ++numRunning;
+                size_t prevMax = maxRunning;
+                while (running > prevMax and not maxRunning.compare_exchange_weak(prevMax, running)) {}
+                std::this_thread::sleep_for(std::chrono::microseconds{200});
+                --numRunning;
+            });
+        }
+        taskGroup.wait();
+    }
+    ASSERT_GE(2u, maxRunning);
+
+    // an exception cancels the tasks not started yet and is rethrown by wait
+    numRun = 0;
+    CtThreadPool::TaskGroup taskGroupEx{threadPool, 1/*max_concurrency*/};
+    for (int i = 0; i < 20; ++i) {
+        taskGroupEx.run([&numRun, i](){
+            ++numRun;
+            if (3 == i) throw std::runtime_error("task failure");
+        });
+    }
+    ASSERT_THROW(taskGroupEx.wait(), std::runtime_error);
+    ASSERT_EQ(4u, numRun);
+    ASSERT_TRUE(taskGroupEx.is_cancelled());
+
+    // explicit cancellation
+    numRun = 0;
+    CtThreadPool::TaskGroup taskGroupCancel{threadPool, 1/*max_concurrency*/};
+    for (int i = 0; i < 20; ++i) {
+        taskGroupCancel.run([&](){
+            ++numRun;
+            taskGroupCancel.cancel();
+        });
+    }
+    taskGroupCancel.wait();
+    ASSERT_EQ(1u, numRun);
+}
+
 TEST(MiscUtilsGroup, get_link_entry_from_property)
 {
     ASSERT_EQ(CtLinkType::Webs, CtMiscUtil::get_link_entry_from_property("webs https://example.com").type);
@@ -24,6 +24,7 @@
 #include "ct_app.h"
 #include "ct_misc_utils.h"
 #include "ct_storage_control.h"
+#include "ct_storage_xml.h"
 #include "tests_common.h"
 
 class TestCtApp : public CtApp
@@ -183,7 +184,7 @@ void TestCtApp::_process_rich_text_buffer(CtMainWin* pWin, std::list<ExpectedTag
 {
     CtTextIterUtil::SerializeFunc test_slot = [&expectedTags](Gtk::TextIter& start_iter,
                                                               Gtk::TextIter& end_iter,
-                                                              CtCurrAttributesMap& curr_attributes,
+                                                              CtCurrAttributes& curr_attributes,
                                                               CtListInfo*/*pCurrListInfo*/)
     {
         const Glib::ustring slot_text = start_iter.get_text(end_iter);
@@ -678,6 +679,80 @@ void TestCtApp::_assert_tree_data(CtMainWin* pWin, const bool after_mods)
     }
 }
 
+TEST(ReadWriteGroup, XmlScanNodeRanges)
+{
+    const std::string xmlDoc{"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                             "<cherrytree>\n"
+                             "  <bookmarks list=\"\"/>\n"
+                             "  <node unique_id=\"1\" name=\"a&lt;node&gt;\">\n"
+                             "    <rich_text>&lt;node&gt;</rich_text>\n"
+                             "    <node unique_id=\"2\"/>\n"
+                             "    <node unique_id=\"3\">\n"
+                             "      <node unique_id=\"4\">\n"
+                             "        <rich_text>x</rich_text>\n"
+                             "      </node>\n"
+                             "    </node>\n"
+                             "  </node>\n"
+                             "</cherrytree>\n"};
+    std::vector<CtXmlDocLayout::NodeRange> nodeRanges;
+    ASSERT_TRUE(CtStorageXml::scan_node_ranges(xmlDoc.c_str(), xmlDoc.size(), nodeRanges));
+    ASSERT_EQ(4u, nodeRanges.size());
+    auto f_range_text = [&](const size_t i){ return xmlDoc.substr(nodeRanges[i].offset, nodeRanges[i].length); };
+    ASSERT_EQ("<node unique_id=\"1\" name=\"a&lt;node&gt;\">\n    <rich_text>&lt;node&gt;</rich_text>", f_range_text(0));
+    ASSERT_EQ(1, nodeRanges[0].depth);
+    ASSERT_TRUE(nodeRanges[0].hadChildren);
+    ASSERT_FALSE(nodeRanges[0].isStartTagOnly);
+    ASSERT_EQ("<node unique_id=\"2\"/>", f_range_text(1));
+    ASSERT_TRUE(nodeRanges[1].isStartTagOnly);
+    ASSERT_FALSE(nodeRanges[1].hadChildren);
+    ASSERT_EQ("<node unique_id=\"3\">", f_range_text(2));
+    ASSERT_TRUE(nodeRanges[2].isStartTagOnly);
+    ASSERT_TRUE(nodeRanges[2].hadChildren);
+    ASSERT_EQ(3, nodeRanges[3].depth);
+    ASSERT_EQ("<node unique_id=\"4\">\n        <rich_text>x</rich_text>", f_range_text(3));
+
+    const std::string unbalancedDoc{"<cherrytree><node unique_id=\"1\"></cherrytree>"};
+    ASSERT_FALSE(CtStorageXml::scan_node_ranges(unbalancedDoc.c_str(), unbalancedDoc.size(), nodeRanges));
+}
+
+TEST(ReadWriteGroup, MultiFilePropChangeOfNotVisitedNodes)
+{
+    UT::run_on_window("_test_multifile_prop", [](CtMainWin* pWin, const std::string& tmp_dirpath){
+        auto f_node_texts = [pWin](){
+            std::map<gint64, Glib::ustring> textById;
+            pWin->get_tree_store().get_store()->foreach(
+                [&](const Gtk::TreePath&/*treePath*/, const Gtk::TreeModel::iterator& treeIter)->bool{
+                    CtTreeIter ctTreeIter = pWin->get_tree_store().to_ct_tree_iter(treeIter);
+                    Glib::RefPtr<Gtk::TextBuffer> pTextBuffer = ctTreeIter.get_node_text_buffer();
+                    textById[ctTreeIter.get_node_id()] = pTextBuffer ? pTextBuffer->get_text() : Glib::ustring{"!! not loaded"};
+                    return false; /* false for continue */
+                }
+            );
+            return textById;
+        };
+        ASSERT_TRUE(pWin->file_open(UT::testCtbDocPath, ""/*node_to_focus*/, ""/*anchor_to_focus*/));
+        const std::map<gint64, Glib::ustring> expectedTextById = f_node_texts();
+        ASSERT_FALSE(expectedTextById.empty());
+        const std::string multifile_dirpath = Glib::build_filename(tmp_dirpath, "multifile");
+        pWin->file_save_as(multifile_dirpath, CtDocType::MultiFile, ""/*password*/);
+
+        // reopened with the nodes not visited, only a property of them changes
+        ASSERT_TRUE(pWin->file_open(multifile_dirpath, ""/*node_to_focus*/, ""/*anchor_to_focus*/));
+        pWin->get_tree_store().get_store()->foreach(
+            [&](const Gtk::TreePath&/*treePath*/, const Gtk::TreeModel::iterator& treeIter)->bool{
+                CtTreeIter ctTreeIter = pWin->get_tree_store().to_ct_tree_iter(treeIter);
+                ctTreeIter.set_node_is_excluded_from_search(true);
+                pWin->update_window_save_needed(CtSaveNeededUpdType::npro, false/*new_machine_state*/, &ctTreeIter);
+                return false; /* false for continue */
+            }
+        );
+        ASSERT_TRUE(pWin->file_save(false/*need_vacuum*/));
+
+        ASSERT_TRUE(pWin->file_open(multifile_dirpath, ""/*node_to_focus*/, ""/*anchor_to_focus*/));
+        ASSERT_EQ(expectedTextById, f_node_texts());
+    });
+}
+
 class ReadWriteMultipleParametersTests : public ::testing::TestWithParam<std::tuple<std::string, std::string, bool>>
 {
 };
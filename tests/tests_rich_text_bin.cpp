@@ -0,0 +1,82 @@
+/*
+ * tests_rich_text_bin.cpp
+ *
+ * Copyright 2009-2026
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "ct_rich_text_bin.h"
+#include "tests_common.h"
+#include <cstring>
+
+namespace {
+
+const std::string BinTestXml{
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<node>"
+    "<rich_text>plain &lt;text&gt; &amp; </rich_text>"
+    "<rich_text weight=\"heavy\" foreground=\"#ffff00000000\">bold red</rich_text>"
+    "<rich_text>\nпривет мир </rich_text>"
+    "<rich_text weight=\"heavy\" foreground=\"#ffff00000000\">bold red again</rich_text>"
+    "<rich_text link=\"webs https://www.giuspen.net/cherrytree/\" indent=\"2\">link</rich_text>"
+    "<rich_text/>"
+    "</node>\n"};
+
+} // namespace
+
+TEST(RichTextBinGroup, xml_round_trip)
+{
+    const std::string binData = CtRichTextBin::from_xml(BinTestXml);
+    ASSERT_TRUE(CtRichTextBin::is_bin(binData.c_str(), binData.size()));
+
+    CtRichTextBin::Body body;
+    ASSERT_TRUE(CtRichTextBin::decode(binData, body));
+    ASSERT_EQ(6u, body.runs.size());
+    // the same attributes are interned once
+    ASSERT_EQ(3u, body.attrSets.size());
+    ASSERT_EQ(body.runs.at(1).attrSetId, body.runs.at(3).attrSetId);
+    ASSERT_EQ(body.runs.at(0).attrSetId, body.runs.at(2).attrSetId);
+    ASSERT_EQ("plain <text> & bold red\nпривет мир bold red again" "link", std::string{body.text});
+
+    // lossless both ways
+    const std::string xmlAgain = CtRichTextBin::to_xml(binData);
+    ASSERT_EQ(binData, CtRichTextBin::from_xml(xmlAgain));
+    ASSERT_NE(std::string::npos, xmlAgain.find("<rich_text weight=\"heavy\" foreground=\"#ffff00000000\">bold red</rich_text>"));
+    ASSERT_NE(std::string::npos, xmlAgain.find("<rich_text link=\"webs https://www.giuspen.net/cherrytree/\" indent=\"2\">link</rich_text>"));
+    ASSERT_NE(std::string::npos, xmlAgain.find("привет мир"));
+}
+
+TEST(RichTextBinGroup, bad_data)
+{
+    CtRichTextBin::Body body;
+    ASSERT_FALSE(CtRichTextBin::is_bin(BinTestXml.c_str(), BinTestXml.size()));
+    ASSERT_FALSE(CtRichTextBin::decode(BinTestXml, body));
+    ASSERT_EQ("", CtRichTextBin::to_xml(BinTestXml));
+
+    const std::string binData = CtRichTextBin::from_xml(BinTestXml);
+    for (size_t truncLen : {strlen(CtRichTextBin::MAGIC) + 1u, binData.size()/2u, binData.size() - 1u}) {
+        ASSERT_FALSE(CtRichTextBin::decode(binData.substr(0, truncLen), body));
+    }
+    // a newer version is not guessed at
+    std::string binNewer = binData;
+    binNewer.at(strlen(CtRichTextBin::MAGIC)) = static_cast<char>(CtRichTextBin::VERSION + 1u);
+    ASSERT_FALSE(CtRichTextBin::decode(binNewer, body));
+    // only rich text slots
+    ASSERT_THROW(CtRichTextBin::from_xml("<node><codebox char_offset=\"0\">x</codebox></node>"), std::runtime_error);
+}
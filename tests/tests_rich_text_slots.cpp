@@ -0,0 +1,56 @@
+/*
+ * tests_rich_text_slots.cpp
+ *
+ * Copyright 2009-2026
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "ct_main_win.h"
+#include "ct_rich_text_bin.h"
+#include "ct_storage_xml.h"
+#include "tests_common.h"
+
+TEST(RichTextSlotsGroup, ByTagTogglesAsPerChar)
+{
+    UT::run_on_window("_test_rich_text_slots", [](CtMainWin* pWin, const std::string&/*tmp_dirpath*/){
+        Glib::RefPtr<Gtk::TextBuffer> pTextBuffer = UT::create_formatted_buffer(pWin, 16u*1024u);
+
+        for (const bool list_info : {false, true}) {
+            // the same slots as a character at a time
+            ASSERT_EQ(UT::rich_text_slots_per_char(pWin, pTextBuffer, list_info), UT::rich_text_slots_by_toggles(pWin, pTextBuffer, list_info));
+        }
+
+        xmlpp::Document xml_doc;
+        xmlpp::Element* p_node_elem = xml_doc.create_root_node("node");
+        CtStorageXmlHelper{pWin}.save_buffer_no_widgets_to_xml(p_node_elem, pTextBuffer, 0, -1, 'n');
+        const std::string xml_body = xml_doc.write_to_string();
+        ASSERT_NE(std::string::npos, xml_body.find("<rich_text weight=\"heavy\">some bold words</rich_text>"));
+        ASSERT_NE(std::string::npos, xml_body.find("link=\"webs https://www.giuspen.net/cherrytree/\""));
+
+        // the buffer from the xml body as the one from the binary body
+        const std::string bin_body = CtRichTextBin::from_buffer(pWin->get_ct_config(), pTextBuffer, 0, -1);
+        ASSERT_EQ(bin_body, CtRichTextBin::from_xml(xml_body));
+        Glib::RefPtr<Gtk::TextBuffer> pXmlBuffer = CtStorageXmlHelper{pWin}.create_buffer_no_widgets(CtConst::RICH_TEXT_ID, xml_body.c_str());
+        Glib::RefPtr<Gtk::TextBuffer> pBinBuffer = CtRichTextBin::create_buffer(pWin, bin_body);
+        ASSERT_TRUE(pXmlBuffer);
+        ASSERT_TRUE(pBinBuffer);
+        ASSERT_EQ(UT::rich_text_slots_by_toggles(pWin, pXmlBuffer, false/*list_info*/), UT::rich_text_slots_by_toggles(pWin, pBinBuffer, false/*list_info*/));
+        ASSERT_EQ(UT::rich_text_slots_by_toggles(pWin, pTextBuffer, false/*list_info*/), UT::rich_text_slots_by_toggles(pWin, pBinBuffer, false/*list_info*/));
+    });
+}
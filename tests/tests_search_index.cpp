@@ -0,0 +1,102 @@
+/*
+ * tests_search_index.cpp
+ *
+ * Copyright 2009-2026
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "ct_search_index.h"
+#include "tests_common.h"
+
+TEST(SearchIndexGroup, text_to_trigrams)
+{
+    ASSERT_TRUE(CtSearchIndex::text_to_trigrams("ab").empty());
+    ASSERT_EQ(1u, CtSearchIndex::text_to_trigrams("abc").size());
+    // lowercase and deduplicated: abc, bca, cab
+    ASSERT_EQ(3u, CtSearchIndex::text_to_trigrams("ABCabc").size());
+    ASSERT_EQ(CtSearchIndex::text_to_trigrams("Ciao"), CtSearchIndex::text_to_trigrams("cIAO"));
+    ASSERT_EQ(3u, CtSearchIndex::text_to_trigrams("ПРИВЕ").size());
+}
+
+TEST(SearchIndexGroup, entry_may_contain)
+{
+    const CtSearchIndex::Entry entry = CtSearchIndex::entry_from_text("The quick brown fox\njumps over the lazy dog, привет мир", 1234);
+    ASSERT_EQ(1234, entry.tsLastSave);
+    ASSERT_TRUE(CtSearchIndex::entry_may_contain(entry, {"quick"}));
+    ASSERT_TRUE(CtSearchIndex::entry_may_contain(entry, {"QUICK", "Lazy Dog"}));
+    ASSERT_TRUE(CtSearchIndex::entry_may_contain(entry, {"ПРИВЕТ"}));
+    ASSERT_TRUE(CtSearchIndex::entry_may_contain(entry, {"xy"})); // too short to be excluded
+    ASSERT_FALSE(CtSearchIndex::entry_may_contain(entry, {"cherrytree"}));
+    ASSERT_FALSE(CtSearchIndex::entry_may_contain(entry, {"quick", "cherrytree"}));
+
+    const CtSearchIndex::Entry emptyEntry = CtSearchIndex::entry_from_text("", 0);
+    ASSERT_FALSE(CtSearchIndex::entry_may_contain(emptyEntry, {"abc"}));
+    ASSERT_TRUE(CtSearchIndex::entry_may_contain(emptyEntry, {}));
+}
+
+TEST(SearchIndexGroup, regex_get_required_literals)
+{
+    using Literals = std::vector<Glib::ustring>;
+    ASSERT_EQ(Literals{"hello"}, CtSearchIndex::regex_get_required_literals("hello").value());
+    ASSERT_EQ((Literals{"hello", "world"}), CtSearchIndex::regex_get_required_literals("hello.*world").value());
+    ASSERT_EQ((Literals{"hell", "world"}), CtSearchIndex::regex_get_required_literals("hello?\\sworld").value());
+    ASSERT_EQ((Literals{"hello", "world"}), CtSearchIndex::regex_get_required_literals("^hello+ [a-z]{2,3}world$").value());
+    ASSERT_EQ((Literals{"abc", "def"}), CtSearchIndex::regex_get_required_literals("abc(x|y)*def").value());
+    ASSERT_EQ((Literals{"a.b.c"}), CtSearchIndex::regex_get_required_literals("a\\.b\\.c").value());
+    ASSERT_EQ((Literals{"cd{"}), CtSearchIndex::regex_get_required_literals("[[:alpha:]]+cd{").value());
+    ASSERT_FALSE(CtSearchIndex::regex_get_required_literals("hello|world").has_value());
+    ASSERT_FALSE(CtSearchIndex::regex_get_required_literals("(?x) h e l l o").has_value());
+    ASSERT_FALSE(CtSearchIndex::regex_get_required_literals("ab.*cd").has_value());
+    ASSERT_FALSE(CtSearchIndex::regex_get_required_literals("\\x41bcd").has_value());
+    ASSERT_FALSE(CtSearchIndex::regex_get_required_literals("abc(").has_value());
+}
+
+TEST(SearchIndexGroup, sidecar_round_trip)
+{
+    const std::string sidecarPath = Glib::build_filename(Glib::get_tmp_dir(), "test_search_index.ctidx");
+    CtSearchIndex searchIndex;
+    searchIndex.set_entry(1, CtSearchIndex::entry_from_text("first node text", 100));
+    searchIndex.set_entry(7, CtSearchIndex::entry_from_text("seventh node", 700));
+    ASSERT_EQ(2u, searchIndex.get_dirty_ids().size());
+    const CtSearchIndex::DocStamp docStamp{12345, 1700000000};
+    ASSERT_TRUE(searchIndex.save_to_sidecar(sidecarPath, docStamp));
+
+    CtSearchIndex loadedIndex;
+    // the document changed since the index was saved, even within the same second
+    ASSERT_FALSE(loadedIndex.load_from_sidecar(sidecarPath, CtSearchIndex::DocStamp{12346, 1700000000}));
+    ASSERT_EQ(0u, loadedIndex.size());
+    ASSERT_FALSE(loadedIndex.load_from_sidecar(sidecarPath, CtSearchIndex::DocStamp{}));
+    ASSERT_TRUE(loadedIndex.load_from_sidecar(sidecarPath, docStamp));
+    ASSERT_EQ(2u, loadedIndex.size());
+    ASSERT_TRUE(loadedIndex.get_dirty_ids().empty());
+    const CtSearchIndex::Entry* pEntry = loadedIndex.get_entry(7);
+    ASSERT_NE(nullptr, pEntry);
+    ASSERT_EQ(700, pEntry->tsLastSave);
+    ASSERT_EQ(searchIndex.get_entry(7)->bloom, pEntry->bloom);
+    ASSERT_TRUE(CtSearchIndex::entry_may_contain(*pEntry, {"seventh"}));
+    ASSERT_FALSE(CtSearchIndex::entry_may_contain(*pEntry, {"first"}));
+
+    loadedIndex.remove_entry(7);
+    ASSERT_EQ(nullptr, loadedIndex.get_entry(7));
+    ASSERT_EQ(1u, loadedIndex.get_removed_ids().count(7));
+    ASSERT_EQ(0, g_remove(sidecarPath.c_str()));
+
+    const CtSearchIndex::DocStamp missingStamp = CtSearchIndex::get_doc_stamp({sidecarPath});
+    ASSERT_EQ(-1, missingStamp.size);
+}
@@ -0,0 +1,90 @@
+/*
+ * tests_storage_prefetch.cpp
+ *
+ * Copyright 2009-2026
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "ct_storage_prefetch.h"
+#include "ct_rich_text_bin.h"
+#include "tests_common.h"
+#include <future>
+
+namespace {
+
+// the reader signals when started, so that take() finds it reading or done and not still queued
+CtPrefetchedBodyReader get_test_reader(std::promise<void>& started, const bool readOk, const std::string& text)
+{
+    return [&started, readOk, text](CtPrefetchedBody& body){
+        started.set_value();
+        if (not readOk) {
+            throw std::runtime_error("test read failure");
+        }
+        body.data = text;
+        return true;
+    };
+}
+
+} // namespace
+
+TEST(StoragePrefetchGroup, request_and_take)
+{
+    CtStoragePrefetch storagePrefetch;
+    std::promise<void> started1, started2;
+    storagePrefetch.request({{1, get_test_reader(started1, true/*readOk*/, "one")},
+                             {2, get_test_reader(started2, false/*readOk*/, "two")}});
+    started1.get_future().wait();
+    started2.get_future().wait();
+
+    CtPrefetchedBody body;
+    ASSERT_FALSE(storagePrefetch.take(3, body));
+    ASSERT_TRUE(storagePrefetch.take(1, body));
+    ASSERT_EQ("one", body.data);
+    // taken once
+    ASSERT_FALSE(storagePrefetch.take(1, body));
+    ASSERT_FALSE(storagePrefetch.take(2, body));
+
+    std::promise<void> started3;
+    storagePrefetch.request({{3, get_test_reader(started3, true/*readOk*/, "three")}});
+    started3.get_future().wait();
+    storagePrefetch.clear();
+    ASSERT_FALSE(storagePrefetch.take(3, body));
+}
+
+TEST(StoragePrefetchGroup, body_from_node_xml)
+{
+    const std::string richTextXml{
+        "<node>"
+        "<rich_text>plain </rich_text>"
+        "<rich_text weight=\"heavy\" foreground=\"#ffff00000000\">bold red</rich_text>"
+        "<rich_text>\nпривет мир</rich_text>"
+        "</node>"};
+    CtPrefetchedBody body;
+    CtStoragePrefetch::body_from_node_xml(richTextXml, true/*isRichText*/, body);
+    ASSERT_TRUE(body.isRichText);
+    ASSERT_EQ(CtRichTextBin::from_xml(richTextXml), body.data);
+
+    CtStoragePrefetch::body_from_node_xml("<node><rich_text>int main() {}\n</rich_text></node>", false/*isRichText*/, body);
+    ASSERT_FALSE(body.isRichText);
+    ASSERT_EQ("int main() {}\n", body.data);
+
+    // the anchored widgets are left to the synchronous load
+    ASSERT_THROW(CtStoragePrefetch::body_from_node_xml("<node><rich_text>a</rich_text><codebox char_offset=\"1\">x</codebox></node>", true/*isRichText*/, body), std::runtime_error);
+    ASSERT_THROW(CtStoragePrefetch::body_from_node_xml("<node><rich_text>", true/*isRichText*/, body), std::exception);
+}
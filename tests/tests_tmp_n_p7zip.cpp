@@ -29,6 +29,8 @@
 
 #include <glib/gstdio.h>
 #include <libxml++/libxml++.h>
+#include <algorithm>
+#include <cstring>
 
 TEST(TmpP7zipGroup, CTTmp_misc)
 {
@@ -122,3 +124,42 @@ TEST(TmpP7zipGroup, P7zaExtravtWrongPasswd)
     ASSERT_TRUE(Glib::file_test(ctdTmpPath, Glib::FILE_TEST_EXISTS));
     g_remove(ctTmp.getHiddenFilePath(UT::ctzInputPath).string().c_str());
 }
+
+TEST(TmpP7zipGroup, P7zaIfaceStream)
+{
+    // extract our test archive into memory
+    std::string xml_txt;
+    ASSERT_EQ(0, CtP7zaIface::p7za_extract_to_stream(UT::ctzInputPath.c_str(), UT::testPassword, false, [&xml_txt](const char* pData, const size_t dataSize){
+        xml_txt.append(pData, dataSize);
+        return true;
+    }));
+    xmlpp::DomParser dom_parser;
+    dom_parser.parse_memory(xml_txt);
+    ASSERT_STREQ("NodeName", static_cast<xmlpp::Element*>(dom_parser.get_document()->get_root_node()->find("node")[0])->get_attribute_value("name").c_str());
+
+    // wrong password, nothing extracted
+    std::string wrong_txt;
+    ASSERT_EQ(2, CtP7zaIface::p7za_extract_to_stream(UT::ctzInputPath.c_str(), "wrongpassword", true, [&wrong_txt](const char* pData, const size_t dataSize){
+        wrong_txt.append(pData, dataSize);
+        return true;
+    }));
+    ASSERT_TRUE(wrong_txt.empty());
+
+    // archive again from memory, in small reads
+    CtTmp ctTmp;
+    const std::string ctzTmpPathBis{Glib::build_filename(ctTmp.getHiddenDirPath(UT::ctzInputPath).string(), "7zr2.ctz")};
+    size_t readPos{0};
+    ASSERT_EQ(0, CtP7zaIface::p7za_archive_from_stream([&](char* pBuf, const size_t bufSize){
+        const size_t toRead = std::min<size_t>({bufSize, 7u, xml_txt.size() - readPos});
+        memcpy(pBuf, xml_txt.data() + readPos, toRead);
+        readPos += toRead;
+        return toRead;
+    }, "7zr2.ctd", ctzTmpPathBis.c_str(), UT::testPasswordBis));
+    ASSERT_EQ(xml_txt.size(), readPos);
+
+    // the archive holds the named file with the same content
+    ASSERT_EQ(0, CtP7zaIface::p7za_extract(ctzTmpPathBis.c_str(), ctTmp.getHiddenDirPath(UT::ctzInputPath).c_str(), UT::testPasswordBis, false));
+    const fs::path expectedExtractedPath = ctTmp.getHiddenDirPath(UT::ctzInputPath) / "7zr2.ctd";
+    ASSERT_STREQ(xml_txt.c_str(), Glib::file_get_contents(expectedExtractedPath.string()).c_str());
+    ASSERT_EQ(0, g_remove(ctzTmpPathBis.c_str()));
+}
@@ -0,0 +1,61 @@
+/*
+ * tests_trace.cpp
+ *
+ * Copyright 2009-2026
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "ct_trace.h"
+#include "tests_common.h"
+#include <glibmm/fileutils.h>
+#include <thread>
+
+TEST(TraceGroup, spans_to_chrome_json)
+{
+    {
+        CtTrace::Span ctTraceSpan{"not_traced"};
+    }
+    ASSERT_FALSE(CtTrace::is_enabled());
+    ASSERT_FALSE(CtTrace::stop());
+
+    const std::string tracePath = Glib::build_filename(Glib::get_tmp_dir(), "test_trace.json");
+    CtTrace::start(tracePath);
+    ASSERT_TRUE(CtTrace::is_enabled());
+    {
+        CtTrace::Span ctTraceSpanOuter{"outer_span"};
+        std::thread{[](){ CtTrace::Span ctTraceSpan{"thread_span"}; }}.join();
+        CtTrace::Span ctTraceSpanEnded{"ended_span"};
+        ctTraceSpanEnded.end();
+    }
+    ASSERT_TRUE(CtTrace::stop());
+    ASSERT_FALSE(CtTrace::is_enabled());
+
+    const std::string json = Glib::file_get_contents(tracePath);
+    ASSERT_EQ(0u, json.find("{\"traceEvents\":["));
+    ASSERT_EQ(std::string::npos, json.find("not_traced"));
+    for (const char* name : {"outer_span", "thread_span", "ended_span"}) {
+        const size_t pos = json.find(std::string{"\"name\":\""} + name + "\"");
+        ASSERT_NE(std::string::npos, pos);
+        // recorded once, even if ended before the scope
+        ASSERT_EQ(std::string::npos, json.find(std::string{"\"name\":\""} + name + "\"", pos + 1));
+    }
+    ASSERT_NE(std::string::npos, json.find("\"ph\":\"X\""));
+    ASSERT_NE(std::string::npos, json.find("\"displayTimeUnit\":\"ms\"}"));
+    ASSERT_EQ(0, g_remove(tracePath.c_str()));
+}
@@ -127,6 +127,35 @@ TEST(TestTypesGroup, ThreadSafeDEQueue_MaxElements)
     ASSERT_EQ(3, threadSafeDEQueue.size());
 }
 
+TEST(TestTypesGroup, ctSizedLru)
+{
+    CtSizedLru<gint64> sizedLru;
+    sizedLru.touch(1, 100u);
+    sizedLru.touch(2, 200u);
+    sizedLru.touch(3, 300u);
+    ASSERT_EQ(3u, sizedLru.size());
+    ASSERT_EQ(600u, sizedLru.get_bytes());
+    ASSERT_EQ(std::vector<gint64>({1, 2, 3}), sizedLru.get_keys());
+
+    // touched again becomes the most recently used, with the updated size
+    sizedLru.touch(1, 150u);
+    ASSERT_EQ(3u, sizedLru.size());
+    ASSERT_EQ(650u, sizedLru.get_bytes());
+    ASSERT_EQ(std::vector<gint64>({2, 3, 1}), sizedLru.get_keys());
+
+    sizedLru.remove(3);
+    sizedLru.remove(4); // not there
+    ASSERT_FALSE(sizedLru.contains(3));
+    ASSERT_TRUE(sizedLru.contains(2));
+    ASSERT_EQ(350u, sizedLru.get_bytes());
+    ASSERT_EQ(std::vector<gint64>({2, 1}), sizedLru.get_keys());
+
+    sizedLru.remove(2);
+    sizedLru.remove(1);
+    ASSERT_EQ(0u, sizedLru.size());
+    ASSERT_EQ(0u, sizedLru.get_bytes());
+}
+
 TEST(TestTypesGroup, ctScalableTag)
 {
     {